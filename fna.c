@@ -44,6 +44,19 @@
 
 #include <stdint.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined(__SSE2__)
+#  include <immintrin.h>
+#endif
+#if defined(HAVE_Z)
+#  include <zlib.h>
+#endif
+#if defined(HAVE_PTHREAD)
+#  include <pthread.h>
+#endif
 #include "zf/zf.h"
 #include "lmm.h"
 #include "log.h"
@@ -57,15 +70,55 @@
 /* roundup */
 #define _roundup(x, base)			( (((x) + (base) - 1) / (base)) * (base) )
 
+/* max and min */
+#define MAX2(x, y)					( (x) > (y) ? (x) : (y) )
+#define MIN2(x, y)					( (x) < (y) ? (x) : (y) )
+
+/**
+ * SIMD kernels: this file is compiled once as the main object and once more per
+ * target ISA with -DFNA_KERNEL=<suffix> (see wscript). kernel objects contain only
+ * the buffer readers and export them as fna_kernel_<suffix>; the main object picks
+ * the best one supported by the CPU in fna_init when built with -DFNA_DISPATCH.
+ */
+#if defined(FNA_KERNEL)
+#  define FNA_KERNEL_ONLY			1
+#else
+#  define FNA_KERNEL_ONLY			0
+#  define FNA_KERNEL				generic
+#endif
+#define _fna_kernel_cat_intl(x, y)	x##y
+#define _fna_kernel_cat(x, y)		_fna_kernel_cat_intl(x, y)
+#define _fna_kernel(_name)			_fna_kernel_cat(fna_kernel_, _name)
+#define _fna_kernel_str_intl(x)		#x
+#define _fna_kernel_str(x)			_fna_kernel_str_intl(x)
+
+/* buffer window */
+#define FNA_BUF_SIZE				( 2 * 1024 * 1024 )
+#define FNA_BUF_MARGIN				( 64 )		/* sentinel and overrun area at the tail of the window */
+#define FNA_BUF_SENTINEL			( 0xff )	/* every delim table maps 0xff to DELIM_TERM */
+#define FNA_COMPACT_MIN_BLOCK		( 256 )
+#define FNA_COMPACT_MAX_BLOCK		( 64 * 1024 )
+#define FNA_BATCH_INIT_SIZE			( 1024 * 1024 )	/* initial arena size of fna_read_batch */
+#define FNA_GROW_MIN_LEN			( 1024 * 1024 )	/* bases read as usual before a sequence of unknown length is grown by steps */
+#define FNA_GROW_MAX_STEP			( 32 * 1024 * 1024 )	/* steps double up to this, both multiples of 4 */
+#define FNA_HINT_MIN_LEN			( 1024 * 1024 )	/* .fai lengths are looked up only if the index has a sequence this long */
+
 /* type aliasing for returning values */
 typedef lmm_kvec_t(uint8_t) lmm_kvec_uint8_t;
 
+/* delimiter table and packed-encoding state, defined below */
+struct fna_delim_s;
+struct fna_pack_s;
+struct fna_fai_s;
+struct fna_names_s;
+
 /**
  * @struct fna_read_ret_s
  */
 struct fna_read_ret_s {
 	int64_t len;
 	char c;
+	uint8_t const *ptr;			/** view into the window (FNA_MMAP), NULL if copied */
 };
 
 /**
@@ -81,16 +134,55 @@ struct fna_context_s {
 	uint16_t options;
 	int32_t status;
 	zf_t *fp;					/** zf context (file pointer) */
+
+	/* buffer window on the decompressed stream */
+	uint8_t *buf;				/** base pointer of the window */
+	uint8_t *p;					/** current pointer, p <= t */
+	uint8_t *t;					/** tail of the window, *t is always FNA_BUF_SENTINEL */
+	int64_t eof;				/** nonzero after zfread returned zero */
+	uint64_t map_size;			/** nonzero if buf is mmapped (FNA_MMAP) */
+	uint64_t pos;				/** offset of t in the decompressed stream, for fna_tell */
+
+	/* input source, zf unless the file is mapped, BGZF read in parallel, or read ahead */
+	int64_t (*fill)(struct fna_context_s *fna);			/** points p and t to the next chunk, returns its length */
+	void (*src_close)(struct fna_context_s *fna);
+	void *src;
+
+	/* parser thread and the record queue shared by many readers (FNA_SHARED) */
+	struct fna_queue_s *queue;
+
+	/* .fai index, loaded at init if present (length hints), or loaded (or built) on the first fna_fetch */
+	struct fna_fai_s *fai;
+	int64_t len_hint;			/** length of the sequence of the next record (fna_set_len_hint), negative if none */
+	int fai_probed;				/** <path>.fai was looked up for length hints, or is not to be */
+
+	/* GFA segment names and their ids (FNA_INTERN_NAMES), created on the first name */
+	struct fna_names_s *names;
+
 	uint16_t head_margin;		/** margin at the head of fna_seq_t */
 	uint16_t tail_margin;
 	uint16_t seq_head_margin;	/** margin at the head of seq buffer */
 	uint16_t seq_tail_margin;	/** margin at the tail of seq buffer */
+	uint16_t threads;			/** kept for fna_seek */
 
-	/* file format specific parser */
-	struct fna_seq_intl_s *(*read)(struct fna_context_s *fna);
+	/* file format specific parser, appends a record to v */
+	int (*read_head)(struct fna_context_s *fna);
+	struct fna_seq_intl_s *(*read)(struct fna_context_s *fna, lmm_kvec_uint8_t *v);
 
 	/* output sequence format specific parser */
-	struct fna_read_ret_s (*read_seq)(struct fna_context_s *fna, lmm_kvec_uint8_t *v, uint8_t const *delim_table, int64_t lim);
+	struct fna_read_ret_s (*read_seq)(struct fna_context_s *fna, lmm_kvec_uint8_t *v, struct fna_delim_s const *delim, int64_t lim);
+
+	/* field readers, taken from the same kernel as read_seq */
+	struct fna_read_ret_s (*read_ascii)(struct fna_context_s *fna, lmm_kvec_uint8_t *v, struct fna_delim_s const *delim);
+	struct fna_read_ret_s (*read_skip)(struct fna_context_s *fna, struct fna_delim_s const *delim, int64_t lim);
+	struct fna_read_ret_s (*read_count)(struct fna_context_s *fna, struct fna_delim_s const *delim);
+
+	/* FASTA / FASTQ field readers, return views into the window in the FNA_MMAP mode */
+	struct fna_read_ret_s (*view_ascii)(struct fna_context_s *fna, lmm_kvec_uint8_t *v, struct fna_delim_s const *delim);
+	struct fna_read_ret_s (*view_seq)(struct fna_context_s *fna, lmm_kvec_uint8_t *v, struct fna_delim_s const *delim, int64_t lim);
+
+	/* reverse strand for FNA_EMIT_REVCOMP */
+	void (*revcomp)(uint8_t *dst, uint8_t const *src, int64_t len, int encode);
 };
 _static_assert_offset(struct fna_s, path, struct fna_context_s, path, 0);
 _static_assert_offset(struct fna_s, file_format, struct fna_context_s, file_format, 0);
@@ -107,2171 +199,9620 @@ struct fna_seq_intl_s {
 	uint8_t type;				/** type, seq or link */
 	uint8_t seq_encode;			/** one of _fna_flag_encode */
 	uint16_t options;
+	uint32_t flags;				/** see enum fna_seq_flags */
 	union fna_seq_body_intl_u {
 		struct fna_segment_s segment;
 		struct fna_link_s link;
+		struct fna_containment_s containment;
+		struct fna_path_s path;
 	} s;
 	uint16_t head_margin;	/** margin at the head of fna_seq_t */
 	uint16_t tail_margin;
 	uint16_t seq_head_margin;	/** margin at the head of seq buffer */
 	uint16_t seq_tail_margin;	/** margin at the tail of seq buffer */
+	uint64_t size;				/** capacity of the buffer, reused by fna_read_into */
 };
+_static_assert(sizeof(struct fna_seq_s) == sizeof(struct fna_seq_intl_s));
 _static_assert_offset(struct fna_seq_s, type, struct fna_seq_intl_s, type, 0);
 _static_assert_offset(struct fna_seq_s, seq_encode, struct fna_seq_intl_s, seq_encode, 0);
 _static_assert_offset(struct fna_seq_s, options, struct fna_seq_intl_s, options, 0);
+_static_assert_offset(struct fna_seq_s, reserved2, struct fna_seq_intl_s, flags, 0);
+
+/**
+ * @enum fna_seq_flags
+ * @brief fields pointing into the mapped file (FNA_MMAP); they occupy an empty
+ * string (or an empty sequence) in the record body and are never freed.
+ * FNA_IN_BATCH marks records in the arena of fna_read_batch. FNA_NO_SEQ marks
+ * records read with FNA_SKIP_SEQ, whose seq has its length but an empty body.
+ * FNA_OUT_SEQ marks records whose seq and qual were moved out of the body by
+ * fna_append; the seq buffer is allocated with its margins.
+ */
+enum fna_seq_flags {
+	FNA_VIEW_NAME = 0x01,
+	FNA_VIEW_COMMENT = 0x02,
+	FNA_VIEW_SEQ = 0x04,
+	FNA_VIEW_QUAL = 0x08,
+	FNA_IN_BATCH = 0x10,
+	FNA_NO_SEQ = 0x20,
+	FNA_OUT_SEQ = 0x40
+};
+
+/**
+ * @struct fna_batch_intl_s
+ * @brief header of the fna_read_batch arena, followed by the records and the pointer array
+ */
+struct fna_batch_intl_s {
+	lmm_t *lmm;
+	struct fna_seq_intl_s **seq;
+	int64_t cnt;
+	int64_t size;
+};
+_static_assert_offset(struct fna_batch_s, seq, struct fna_batch_intl_s, seq, 0);
+_static_assert_offset(struct fna_batch_s, cnt, struct fna_batch_intl_s, cnt, 0);
+_static_assert_offset(struct fna_batch_s, size, struct fna_batch_intl_s, size, 0);
 
 /* segment and link objects */
 _static_assert(sizeof(struct fna_segment_s) == 64);
 _static_assert(sizeof(struct fna_link_s) == 64);
+_static_assert(sizeof(struct fna_containment_s) == 64);
+_static_assert(sizeof(struct fna_path_s) == 64);
+_static_assert_offset(struct fna_link_s, dst, struct fna_containment_s, dst, 0);
+_static_assert_offset(struct fna_link_s, dst_ori, struct fna_containment_s, dst_ori, 0);
+_static_assert_offset(struct fna_link_s, cigar, struct fna_containment_s, cigar, 0);
 _static_assert_offset(struct fna_seq_s, s, struct fna_seq_intl_s, s, 0);
 
+/**
+ * @enum fna_isa
+ * @brief instruction set extensions a kernel object requires
+ */
+enum fna_isa {
+	FNA_ISA_SSE41 = 0x01,
+	FNA_ISA_AVX2 = 0x02,
+	FNA_ISA_AVX512BW = 0x04,
+	FNA_ISA_AVX512VBMI = 0x08		/* VBMI and VBMI2 */
+};
+
+/**
+ * @struct fna_kernel_s
+ * @brief ISA-specific readers, one instance per kernel object
+ */
+struct fna_kernel_s {
+	char const *name;
+	uint32_t isa;				/** required fna_isa flags */
+
+	/* readers, read_seq is indexed by seq_encode */
+	struct fna_read_ret_s (*read_ascii)(struct fna_context_s *fna, lmm_kvec_uint8_t *v, struct fna_delim_s const *delim);
+	struct fna_read_ret_s (*read_skip)(struct fna_context_s *fna, struct fna_delim_s const *delim, int64_t lim);
+	struct fna_read_ret_s (*read_count)(struct fna_context_s *fna, struct fna_delim_s const *delim);
+	struct fna_read_ret_s (*read_seq[5])(struct fna_context_s *fna, lmm_kvec_uint8_t *v, struct fna_delim_s const *delim, int64_t lim);
+
+	/* view readers for FNA_MMAP, seq views are ASCII only */
+	struct fna_read_ret_s (*view_ascii)(struct fna_context_s *fna, lmm_kvec_uint8_t *v, struct fna_delim_s const *delim);
+	struct fna_read_ret_s (*view_seq)(struct fna_context_s *fna, lmm_kvec_uint8_t *v, struct fna_delim_s const *delim, int64_t lim);
+
+	/* transforms on record bodies */
+	void (*revcomp)(uint8_t *dst, uint8_t const *src, int64_t len, int encode);
+
+	/* bare kernels, for tests */
+	uint8_t const *(*scan)(struct fna_delim_s const *delim, uint8_t const *p);
+	uint8_t const *(*count)(struct fna_delim_s const *delim, uint8_t const *p, int64_t *skip);
+	uint8_t const *(*compact)(struct fna_delim_s const *delim, uint8_t *dst, int64_t *olen, uint8_t const *src, int64_t ilen, int64_t olim);
+	int64_t (*encode_span)(uint8_t *dst, uint8_t const *src, int64_t len, struct fna_pack_s *pack, int encode);
+};
+
+#if !FNA_KERNEL_ONLY
 /* function delcarations */
 static int fna_read_head_fasta(struct fna_context_s *fna);
 static int fna_read_head_fastq(struct fna_context_s *fna);
 static int fna_read_head_fast5(struct fna_context_s *fna);
 static int fna_read_head_gfa(struct fna_context_s *fna);
 
-static struct fna_seq_intl_s *fna_read_fasta(struct fna_context_s *fna);
-static struct fna_seq_intl_s *fna_read_fastq(struct fna_context_s *fna);
-static struct fna_seq_intl_s *fna_read_fast5(struct fna_context_s *fna);
-static struct fna_seq_intl_s *fna_read_gfa(struct fna_context_s *fna);
-
-static struct fna_read_ret_s fna_read_seq_ascii(struct fna_context_s *fna, lmm_kvec_uint8_t *v, uint8_t const *delim_table, int64_t lim);
-static struct fna_read_ret_s fna_read_seq_2bit(struct fna_context_s *fna, lmm_kvec_uint8_t *v, uint8_t const *delim_table, int64_t lim);
-static struct fna_read_ret_s fna_read_seq_2bitpacked(struct fna_context_s *fna, lmm_kvec_uint8_t *v, uint8_t const *delim_table, int64_t lim);
-static struct fna_read_ret_s fna_read_seq_4bit(struct fna_context_s *fna, lmm_kvec_uint8_t *v, uint8_t const *delim_table, int64_t lim);
-static struct fna_read_ret_s fna_read_seq_4bitpacked(struct fna_context_s *fna, lmm_kvec_uint8_t *v, uint8_t const *delim_table, int64_t lim);
+static struct fna_seq_intl_s *fna_read_fasta(struct fna_context_s *fna, lmm_kvec_uint8_t *v);
+static struct fna_seq_intl_s *fna_read_fastq(struct fna_context_s *fna, lmm_kvec_uint8_t *v);
+static struct fna_seq_intl_s *fna_read_fast5(struct fna_context_s *fna, lmm_kvec_uint8_t *v);
+static struct fna_seq_intl_s *fna_read_gfa(struct fna_context_s *fna, lmm_kvec_uint8_t *v);
+
+static struct fna_kernel_s const *fna_kernel_select(void);
+static int64_t fna_buf_fill(struct fna_context_s *fna);
+#if defined(HAVE_PTHREAD)
+static int fna_pool_open(struct fna_context_s *fna, char const *path, fna_params_t const *params, uint64_t begin);
+static int fna_queue_open(struct fna_context_s *fna);
+static void fna_queue_close(struct fna_context_s *fna);
+static struct fna_seq_intl_s *fna_queue_read(struct fna_context_s *fna, int block);
+static struct fna_seq_intl_s *fna_read_pool(struct fna_context_s *fna, lmm_kvec_uint8_t *v);
+#endif
+static void fna_fai_close(struct fna_fai_s *fai);
+static void fna_names_close(struct fna_names_s *n);
+static int fna_seek_open(struct fna_context_s *fna, char const *path, uint64_t begin);
 
 /**
- * @fn fna_init
- *
- * @brief create a sequence reader context
- *
- * @param[in] path : a path to a file to open.
- *
- * @return a pointer to the context
+ * @fn fna_open_plain
+ * @brief open an uncompressed regular file, returns the descriptor, or -1 if the
+ * file should be read through zf (compressed, pipe, or not found)
  */
-fna_t *fna_init(
+static
+int fna_open_plain(
 	char const *path,
-	fna_params_t const *params)
+	uint64_t *size)
 {
-	struct fna_context_s *fna = NULL;
-
-	/* extension determination */
-	struct _ext {
-		char const *ext;
-		int32_t file_format;
-	};
-	static struct _ext const ext[] = {
-		{".fasta", FNA_FASTA},
-		{".fas",   FNA_FASTA},
-		{".seq",   FNA_FASTA},
-		{".fna",   FNA_FASTA},
-		{".ffn",   FNA_FASTA},
-		{".fa",    FNA_FASTA},
-		{".fastq", FNA_FASTQ},
-		{".fq",    FNA_FASTQ},
-		{".fast5", FNA_FAST5},
-		{".f5",    FNA_FAST5},
-		{".gfa",   FNA_GFA},
-		{NULL,     0}
-	};
-	struct _ext const *ep;
-
-	/* read functions */
-	int (*read_head[])(
-		struct fna_context_s *fna) = {
-		[FNA_FASTA] = fna_read_head_fasta,
-		[FNA_FASTQ] = fna_read_head_fastq,
-		[FNA_FAST5] = fna_read_head_fast5,
-		[FNA_GFA]	= fna_read_head_gfa
-	};
-	struct fna_seq_intl_s *(*read[])(
-		struct fna_context_s *fna) = {
-		[FNA_FASTA] = fna_read_fasta,
-		[FNA_FASTQ] = fna_read_fastq,
-		[FNA_FAST5] = fna_read_fast5,
-		[FNA_GFA]	= fna_read_gfa
-	};
-
-	/* pack functions */
-	struct fna_read_ret_s (*read_seq[])(
-		struct fna_context_s *fna,
-		lmm_kvec_uint8_t *v,
-		uint8_t const *delim_table,
-		int64_t lim) = {
-		[FNA_ASCII] = fna_read_seq_ascii,
-		[FNA_2BIT] = fna_read_seq_2bit,
-		[FNA_2BITPACKED] = fna_read_seq_2bitpacked,
-		[FNA_4BIT] = fna_read_seq_4bit,
-		[FNA_4BITPACKED] = fna_read_seq_4bitpacked,
-	};
-
-	/* default params */
-	struct fna_params_s default_params = {
-		.lmm = NULL,
-		.seq_encode = FNA_ASCII,
-		.file_format = FNA_UNKNOWN,
-		.options = 0,
-		.head_margin = 0,
-		.tail_margin = 0,
-		.seq_head_margin = 0,
-		.seq_tail_margin = 0
-	};
-
-	if(path == NULL) { return NULL; }
-	if(params == NULL) { params = &default_params; }
-
-	/* global context is malloc'd with global malloc */
-	if((fna = (struct fna_context_s *)malloc(sizeof(struct fna_context_s))) == NULL) {
-		goto _fna_init_error_handler;
-	}
-	fna->lmm = params->lmm;
-	fna->path = NULL;
-	fna->fp = NULL;
-
-	/* copy params */
-	fna->seq_encode = params->seq_encode;	/** encode sequence to 2-bit if encode == FNA_2BITPACKED */
-	fna->file_format = params->file_format;	/** format (see enum FNA_FORMAT) */
-	fna->options = params->options;
-	fna->head_margin = _roundup(params->head_margin, 16);
-	fna->tail_margin = _roundup(params->tail_margin, 16);
-	fna->seq_head_margin = _roundup(params->seq_head_margin, 16);
-	fna->seq_tail_margin = _roundup(params->seq_tail_margin, 16);
-
-	/* restore defaults */
-	if(fna->seq_encode == 0) { fna->seq_encode = FNA_ASCII; }
-
-	/* open file */
-	fna->fp = zfopen(path, "r");
-	if(fna->fp == NULL) { goto _fna_init_error_handler; }
+	int fd = open(path, O_RDONLY);
+	if(fd < 0) { return(-1); }
 
-	/**
-	 * if fna->file_format is not specified...
-	 * 1. determine file format from the path extension
-	 */
-	if(fna->file_format == 0) {
-		uint64_t path_len = strlen(fna->fp->path);
-		char const *path_tail = fna->fp->path + path_len;
-		for(ep = ext; ep->ext != NULL; ep++) {
-			/* skip if path string is shorter than extension string */
-			if(path_len < strlen(ep->ext)) { continue; }
-
-			/* compare ext */
-			if(strncmp(path_tail - strlen(ep->ext), ep->ext, strlen(ep->ext)) == 0) {
-				fna->file_format = ep->file_format; break;
-			}
-		}
-	}
-
-	/**
-	 * 2. determine file format from the content of the file
-	 */
-	if(fna->file_format == 0) {
-		/* peek the head of the file */
-		char buf[33] = { 0 };
-		uint64_t len = zfpeek(fna->fp, buf, 32);
-		for(uint64_t i = 0; i < len; i++) {
-			switch(buf[i]) {
-				case '>': fna->file_format = FNA_FASTA; break;
-				case '@': fna->file_format = FNA_FASTQ; break;
-				case 'H':
-				if(buf[i + 1] == '\t') {
-					fna->file_format = FNA_GFA; break;
-				}
-			}
-		}
-	}
-	if(fna->file_format == 0) {
-		fna->status = FNA_ERROR_UNKNOWN_FORMAT;
-		goto _fna_init_error_handler;
-	}
-	#ifndef HAVE_HDF5
-		if(fna->file_format == FNA_FAST5) {
-			// log_error("Fast5 file format is not supported in this build.\n");
-			fna->status = FNA_ERROR_UNKNOWN_FORMAT;
-			goto _fna_init_error_handler;
-		}
-	#endif
-	fna->read = read[fna->file_format];
-	fna->read_seq = read_seq[fna->seq_encode];
-	fna->path = strdup(path);
-
-	/* parse header */
-	if(read_head[fna->file_format](fna) != FNA_SUCCESS) {
-		/* something is wrong */
-		goto _fna_init_error_handler;
+	struct stat st;
+	uint8_t magic[4] = { 0 };
+	if(fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)
+	|| pread(fd, magic, 4, 0) < 0
+	|| (magic[0] == 0x1f && magic[1] == 0x8b)						/* gzip */
+	|| (magic[0] == 'B' && magic[1] == 'Z' && magic[2] == 'h')		/* bzip2 */
+	|| (magic[0] == 0xfd && magic[1] == '7' && magic[2] == 'z')) {	/* xz */
+		close(fd);
+		return(-1);
 	}
-	return((struct fna_s *)fna);
+	*size = st.st_size;
+	return(fd);
+}
 
-_fna_init_error_handler:
-	if(fna != NULL) {
-		zfclose(fna->fp); fna->fp = NULL;
-		free(fna->path); fna->path = NULL;
-		free(fna);
+/**
+ * @fn fna_buf_map
+ * @brief map an uncompressed regular file as the buffer window (FNA_MMAP).
+ * the range is reserved with anonymous pages first so that the sentinel and
+ * FNA_BUF_MARGIN behind the tail are always backed; the file is mapped private
+ * over its head, so writing the sentinel never reaches the file.
+ * returns zero on success, nonzero if the file should be read through zf.
+ */
+static
+int fna_buf_map(
+	struct fna_context_s *fna,
+	char const *path)
+{
+	uint64_t size = 0;
+	int fd = fna_open_plain(path, &size);
+	if(fd < 0) { return(-1); }
+
+	uint64_t map_size = _roundup(size + FNA_BUF_MARGIN, sysconf(_SC_PAGESIZE));
+	uint8_t *base = (uint8_t *)mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+	if(base == MAP_FAILED) { close(fd); return(-1); }
+	if(size > 0 && mmap(base, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+		munmap(base, map_size); close(fd);
+		return(-1);
 	}
-	return(NULL);
+	close(fd);
+	if(size > 0) { madvise(base, size, MADV_SEQUENTIAL); }
+
+	/* the whole file is in the window */
+	fna->buf = fna->p = base;
+	fna->t = base + size;
+	memset(fna->t, FNA_BUF_SENTINEL, FNA_BUF_MARGIN);
+	fna->eof = 1;
+	fna->map_size = map_size;
+	fna->pos = size;
+	return(0);
 }
 
 /**
- * @fn fna_close
- *
- * @brief clean up sequence reader context
+ * @fn fna_buf_release
  */
-void fna_close(fna_t *ctx)
+static
+void fna_buf_release(
+	struct fna_context_s *fna)
 {
-	struct fna_context_s *fna = (struct fna_context_s *)ctx;
-
-	if(fna != NULL) {
-		zfclose(fna->fp); fna->fp = NULL;
-		free(fna->path); fna->path = NULL;
-		free(fna); fna = NULL;
+	if(fna->map_size != 0) {
+		munmap(fna->buf, fna->map_size);
+	} else {
+		free(fna->buf);
 	}
+	fna->buf = NULL;
+	fna->map_size = 0;
 	return;
 }
 
 /**
- * @fn fna_set_lmm
+ * @fn fna_fill_zf
+ * @brief default input source, reads the decompressed stream through zf
  */
-void *fna_set_lmm(
-	fna_t *ctx,
-	void *new)
+static
+int64_t fna_fill_zf(
+	struct fna_context_s *fna)
 {
-	struct fna_context_s *fna = (struct fna_context_s *)ctx;
-
-	lmm_t *old = fna->lmm;
-	fna->lmm = (lmm_t *)new;
-	return((void *)old);
+	int64_t len = zfread(fna->fp, fna->buf, FNA_BUF_SIZE);
+	fna->p = fna->buf;
+	fna->t = fna->buf + len;
+	return(len);
 }
 
 /**
- * miscellaneous tables and functions
+ * @struct fna_range_s
+ * @brief byte range of an uncompressed file, read with pread (fna_init_range)
  */
+struct fna_range_s {
+	int fd;
+	uint64_t pos, end;
+};
 
 /**
- * @macro _fna_pack_segment
+ * @fn fna_fill_range
  */
-#define _fna_pack_segment(_seg, _name, _name_len, _com, _com_len, _seq, _seq_len, _qual, _qual_len) ({ \
-	(_seg)->s.segment.name = (_name); \
-	(_seg)->s.segment.name_len = (_name_len); \
-	(_seg)->s.segment.comment = (_com); \
-	(_seg)->s.segment.comment_len = (_com_len); \
-	(_seg)->s.segment.seq = (_seq); \
-	(_seg)->s.segment.seq_len = (_seq_len); \
-	(_seg)->s.segment.qual = (_qual); \
-	(_seg)->s.segment.qual_len = (_qual_len); \
-	(_seg); \
-})
+static
+int64_t fna_fill_range(
+	struct fna_context_s *fna)
+{
+	struct fna_range_s *r = (struct fna_range_s *)fna->src;
+	int64_t len = pread(r->fd, fna->buf, MIN2(r->end - r->pos, FNA_BUF_SIZE), r->pos);
+	if(len < 0) { len = 0; }
+	r->pos += len;
+
+	fna->p = fna->buf;
+	fna->t = fna->buf + len;
+	return(len);
+}
 
 /**
- * @macro _fna_pack_link
+ * @fn fna_range_close
  */
-#define _fna_pack_link(_link, _from, _from_len, _from_ori, _to, _to_len, _to_ori, _cigar, _cigar_len) ({ \
-	(_link)->s.link.from = (_from); \
-	(_link)->s.link.from_len = (_from_len); \
-	(_link)->s.link.from_ori = (_from_ori); \
-	(_link)->s.link.to = (_to); \
-	(_link)->s.link.to_len = (_to_len); \
-	(_link)->s.link.to_ori = (_to_ori); \
-	(_link)->s.link.cigar = (_cigar); \
-	(_link)->s.link.cigar_len = (_cigar_len); \
-	(_link); \
-})
+static
+void fna_range_close(
+	struct fna_context_s *fna)
+{
+	struct fna_range_s *r = (struct fna_range_s *)fna->src;
+	close(r->fd);
+	free(r);
+	fna->src = NULL;
+	return;
+}
 
 /**
- * @val ascii_table, alpha_table, delim_space
+ * @fn fna_range_open
+ * @brief read [begin, end) of an uncompressed file, returns nonzero on failure
  */
-#define LIM_UNLIMITED		( INT64_MAX )
-#define DELIM_TERM			( 1 )
+static
+int fna_range_open(
+	struct fna_context_s *fna,
+	char const *path,
+	uint64_t begin,
+	uint64_t end)
+{
+	uint64_t size = 0;
+	int fd = fna_open_plain(path, &size);
+	if(fd < 0) { return(-1); }
+
+	struct fna_range_s *r = (struct fna_range_s *)malloc(sizeof(struct fna_range_s));
+	if(r == NULL) { close(fd); return(-1); }
+	*r = (struct fna_range_s){
+		.fd = fd,
+		.pos = MIN2(begin, size),
+		.end = MIN2(end, size)
+	};
+	r->end = MAX2(r->pos, r->end);
+	fna->pos = r->pos;
 
-/* non-printable, first 32 elements of the ASCII table */
-#define _non_printable(n) \
-	(n),(n),(n),(n), (n),(n),(n),(n), (n),(n),(n),(n), (n),(n),(n),(n), \
-	(n),(n),(n),(n), (n),(n),(n),(n), (n),(n),(n),(n), (n),(n),(n),(n)
+	fna->src = (void *)r;
+	fna->fill = fna_fill_range;
+	fna->src_close = fna_range_close;
+	return(0);
+}
 
-static
-uint8_t const delim_space[256] = {
-	['\0'] = DELIM_TERM,
-	[' '] = DELIM_TERM,
-	['\t'] = DELIM_TERM,
-	['\v'] = DELIM_TERM,
-	[0xff] = 0xff
-};
-static
-uint8_t const delim_line[256] = {
-	['\r'] = DELIM_TERM,
-	['\n'] = DELIM_TERM,
-	[0xff] = 0xff
-};
-static
-uint8_t const delim_fasta_fastq_name[256] = {
-	[' '] = DELIM_TERM,
-	['\r'] = DELIM_TERM,
-	['\n'] = DELIM_TERM,
-	[0xff] = 0xff
-};
-static
-uint8_t const delim_fasta_seq[256] = {
-	_non_printable(2),
-	['>'] = DELIM_TERM,
-	[0xff] = 0xff
-};
-static
-uint8_t const delim_fastq_seq[256] = {
-	_non_printable(2),
-	['+'] = DELIM_TERM,
-	[0xff] = 0xff
-};
-static
-uint8_t const delim_fastq_qual[256] = {
-	_non_printable(2),
-	[0xff] = 0xff
-};
-static
-uint8_t const delim_fastq_tail[256] = {
-	_non_printable(2),
-	['@'] = DELIM_TERM,
-	[0xff] = 0xff
-};
-static
-uint8_t const delim_gfa_field[256] = {
-	['\t'] = DELIM_TERM,
-	['\r'] = DELIM_TERM,
-	['\n'] = DELIM_TERM,
-	[0xff] = 0xff
-};
+#if defined(HAVE_Z)
+#define FNA_BGZF_BLOCK_SIZE			( 64 * 1024 )	/* max compressed and uncompressed size of a block */
 
 /**
- * @fn fna_seq_make_margin
+ * @fn fna_bgzf_is_block
+ * @brief check the gzip header has the BGZF extra field at the head (SAM spec 4.1)
  */
 static _force_inline
-void fna_seq_make_margin(
-	struct fna_context_s *fna,
-	lmm_kvec_uint8_t *v,
-	int64_t len)
+int fna_bgzf_is_block(
+	uint8_t const *h)
 {
-	uint64_t base = lmm_kv_size(*v);
-	lmm_kv_reserve(fna->lmm, *v, base + len);
-	for(int64_t i = 0; i < len; i++) {
-		lmm_kv_at(*v, base + i) = 0;
-	}
-	lmm_kv_size(*v) = base + len;
-	return;
+	return(h[0] == 0x1f && h[1] == 0x8b && h[2] == 0x08 && (h[3] & 0x04) != 0
+		&& (h[10] | (h[11]<<8)) >= 6
+		&& h[12] == 'B' && h[13] == 'C' && h[14] == 2 && h[15] == 0);
 }
 
 /**
- * @fn fna_parse_version_string
- * @brief parse version string in ("%d.%d.%d", major, minor, patch) format,
- * return 0x10000 * major + 0x100 * minor + patch
+ * @fn fna_bgzf_inflate_block
+ * @brief inflate a deflate stream of len bytes followed by the footer, checks the size and crc.
+ * returns the inflated size, negative if broken.
  */
 static _force_inline
-uint64_t fna_parse_version_string(
-	char const *str)
+int64_t fna_bgzf_inflate_block(
+	z_stream *z,
+	uint8_t const *in,
+	uint32_t len,
+	uint8_t *out)
 {
-	char buf[256];
-	uint64_t v[3] = { 0, 0, 0 };
-
-	for(int64_t i = 0; i < 3; i++) {
-		int64_t j = 0;
-		while(*str != '\0') {
-			if(*str == '.') { break; }
-			buf[j++] = *str++;
-		}
-		buf[j] = '\0';
-		v[i] = (uint64_t)strtoll(buf, NULL, 10);
-		if(*str++ == '\0') { break; }
+	uint8_t const *f = in + len;		/* footer */
+	uint32_t crc = f[0] | (f[1]<<8) | (f[2]<<16) | ((uint32_t)f[3]<<24);
+	uint32_t isize = f[4] | (f[5]<<8) | (f[6]<<16) | ((uint32_t)f[7]<<24);
+	if(isize > FNA_BGZF_BLOCK_SIZE) { return(-1); }
+
+	inflateReset(z);
+	z->next_in = (uint8_t *)in;
+	z->avail_in = len;
+	z->next_out = out;
+	z->avail_out = isize;
+	if(inflate(z, Z_FINISH) != Z_STREAM_END || z->total_out != isize
+	|| crc32(crc32(0, NULL, 0), out, isize) != crc) {
+		return(-1);
 	}
-
-	return(0x10000 * v[0] + 0x100 * v[1] + v[2]);
+	return(isize);
 }
 
 /**
- * @fn fna_read_ascii
- * @brief read ascii until delim, push '\0' terminator
+ * @fn fna_bgzf_pread_block
+ * @brief read a block at off and inflate it into out, in and out are FNA_BGZF_BLOCK_SIZE.
+ * returns the compressed size of the block (olen is the inflated size), zero at the end of the file,
+ * negative if broken.
  */
-static _force_inline
-struct fna_read_ret_s fna_read_ascii(
-	struct fna_context_s *fna,
-	lmm_kvec_uint8_t *v,
-	uint8_t const *delim_table)
+static
+int64_t fna_bgzf_pread_block(
+	z_stream *z,
+	int fd,
+	uint64_t off,
+	uint8_t *in,
+	uint8_t *out,
+	int64_t *olen)
 {
-	int64_t len = 0;
-	int c;
-
-	/* strip spaces at the head */
-	while(delim_space[(uint8_t)(c = zfgetc(fna->fp))] == 1) {
-		debug("%c, %d", c, c);
-	}
-	if(c == EOF) {
-		debug("reached eof");
-		lmm_kv_push(fna->lmm, *v, '\0');
-		return((struct fna_read_ret_s){
-			.len = len,
-			.c = (char)EOF
-		});
+	int64_t n = pread(fd, in, 18, off);
+	if(n == 0) { return(0); }
+	if(n != 18 || !fna_bgzf_is_block(in)) { return(-1); }
+
+	uint64_t xlen = in[10] | (in[11]<<8);
+	uint64_t size = (in[16] | (in[17]<<8)) + 1;
+	if(size < 12 + xlen + 8 || pread(fd, in + 18, size - 18, off + 18) != (int64_t)(size - 18)) {
+		return(-1);
 	}
+	*olen = fna_bgzf_inflate_block(z, in + 12 + xlen, size - 12 - xlen - 8, out);
+	return((*olen < 0) ? -1 : (int64_t)size);
+}
 
-	/* read line until delim */
-	debug("%c, %d", c, c);
-	lmm_kv_push(fna->lmm, *v, c); len++;
-	while(delim_table[(uint8_t)(c = zfgetc(fna->fp))] == 0) {
-		debug("%c, %d", c, c);
-		lmm_kv_push(fna->lmm, *v, c); len++;
+/**
+ * @fn fna_bgzf_locate
+ * @brief find the block containing uoffset of the decompressed stream from the headers and the
+ * footers of the blocks (nothing is inflated). returns nonzero if the file is broken.
+ */
+static
+int fna_bgzf_locate(
+	int fd,
+	uint64_t uoffset,
+	uint64_t *coffset,
+	uint64_t *boffset)
+{
+	uint64_t coff = 0, uoff = 0;
+	while(1) {
+		uint8_t h[18], f[4];
+		int64_t n = pread(fd, h, 18, coff);
+		if(n == 0) { break; }
+		if(n != 18 || !fna_bgzf_is_block(h)) { return(-1); }
+
+		uint64_t size = (h[16] | (h[17]<<8)) + 1;
+		if(pread(fd, f, 4, coff + size - 4) != 4) { return(-1); }
+		uint64_t isize = f[0] | (f[1]<<8) | (f[2]<<16) | ((uint32_t)f[3]<<24);
+		if(uoff + isize > uoffset) { break; }
+		coff += size;
+		uoff += isize;
 	}
-	char cret = (char)c;
+	*coffset = coff;
+	*boffset = uoffset - uoff;
+	return(0);
+}
 
-	/* strip spaces at the tail */
-	while(len-- > 0 && delim_space[(uint8_t)(c = lmm_kv_pop(fna->lmm, *v))] == 1) {
-		debug("%c, %d", c, c);
+/**
+ * @struct fna_bgzf_pread_s
+ * @brief sequential BGZF source from a block in the middle of the file (fna_seek)
+ */
+struct fna_bgzf_pread_s {
+	int fd;
+	uint64_t off;				/** next block */
+	z_stream z;
+	uint8_t in[FNA_BGZF_BLOCK_SIZE];
+};
+
+/**
+ * @fn fna_fill_bgzf_pread
+ * @brief inflate blocks into the window while they fit
+ */
+static
+int64_t fna_fill_bgzf_pread(
+	struct fna_context_s *fna)
+{
+	struct fna_bgzf_pread_s *b = (struct fna_bgzf_pread_s *)fna->src;
+	int64_t len = 0;
+	while(len + FNA_BGZF_BLOCK_SIZE <= FNA_BUF_SIZE) {
+		int64_t olen = 0, size = fna_bgzf_pread_block(&b->z, b->fd, b->off, b->in, fna->buf + len, &olen);
+		if(size <= 0) {
+			if(size < 0) { fna->status = FNA_ERROR_BROKEN_FORMAT; }
+			break;
+		}
+		b->off += size;
+		len += olen;
 	}
-	lmm_kv_push(fna->lmm, *v, c); len++;	/* push back last non-space char */
+	fna->p = fna->buf;
+	fna->t = fna->buf + len;
+	return(len);
+}
 
-	lmm_kv_push(fna->lmm, *v, '\0');		/* push null terminator */
-	debug("finished, len(%lld)", len);
-	return((struct fna_read_ret_s){
-		.len = len,
-		.c = cret
-	});
+/**
+ * @fn fna_bgzf_pread_close
+ */
+static
+void fna_bgzf_pread_close(
+	struct fna_context_s *fna)
+{
+	struct fna_bgzf_pread_s *b = (struct fna_bgzf_pread_s *)fna->src;
+	inflateEnd(&b->z);
+	close(b->fd);
+	free(b);
+	fna->src = NULL;
+	return;
 }
 
 /**
- * @fn fna_read_skip
+ * @fn fna_bgzf_pread_open
+ * @brief read the BGZF file from the block at coffset, returns nonzero on failure
  */
-static _force_inline
-struct fna_read_ret_s fna_read_skip(
+static
+int fna_bgzf_pread_open(
 	struct fna_context_s *fna,
-	uint8_t const *delim_table,
-	int64_t lim)
+	int fd,
+	uint64_t coffset)
 {
-	uint8_t type;
-	int c;
-	int64_t len = 0;
-	while(((type = delim_table[(uint8_t)(c = zfgetc(fna->fp))]) & DELIM_TERM) == 0) {
-		debug("%c, %d, %u, %lld, %lld", c, c, delim_table[(uint8_t)c], len, lim);
-		if(type == 0 && ++len >= lim) { break; }
-	}
-	return((struct fna_read_ret_s){
-		.len = len,
-		.c = (char)c
-	});
+	struct fna_bgzf_pread_s *b = (struct fna_bgzf_pread_s *)calloc(1, sizeof(struct fna_bgzf_pread_s));
+	if(b == NULL) { return(-1); }
+	if(inflateInit2(&b->z, -15) != Z_OK) { free(b); return(-1); }
+	b->fd = fd;
+	b->off = coffset;
+
+	fna->src = (void *)b;
+	fna->fill = fna_fill_bgzf_pread;
+	fna->src_close = fna_bgzf_pread_close;
+	return(0);
 }
+#endif /* HAVE_Z */
 
+#if defined(HAVE_Z) && defined(HAVE_PTHREAD)
 /**
- * @fn fna_read_seq_ascii
- * @brief read seq until delim, with conv table
+ * parallel BGZF decompression: workers take groups of up to FNA_BGZF_BLOCKS blocks
+ * from the file in order (under the lock), inflate them independently into their own
+ * output buffers, and the parser takes the groups in the order they were read. the
+ * window points directly to the output buffer of the current group, which is given
+ * back to the workers on the next fill.
+ */
+#define FNA_BGZF_BLOCKS				( 16 )
+
+/**
+ * @struct fna_bgzf_job_s
+ */
+struct fna_bgzf_job_s {
+	int64_t seq;				/** sequence number of the group, -1 if never used */
+	int64_t state;				/** 0: in progress, 1: done, 2: broken */
+	uint8_t *in;				/** compressed blocks as they are in the file */
+	uint8_t *out;				/** FNA_BGZF_BLOCKS * FNA_BGZF_BLOCK_SIZE + FNA_BUF_MARGIN */
+	int64_t olen;
+	int64_t cnt;
+	struct fna_bgzf_block_s {
+		uint32_t pos, len;		/** deflate stream in in[] */
+	} blk[FNA_BGZF_BLOCKS];
+};
+
+/**
+ * @struct fna_bgzf_s
+ */
+struct fna_bgzf_s {
+	FILE *fp;
+	pthread_mutex_t lock;
+	pthread_cond_t cond_free;	/** a job slot is released by the parser */
+	pthread_cond_t cond_done;	/** a job is finished by a worker */
+	int64_t issued;				/** number of groups read from the file */
+	int64_t consumed;			/** number of groups handed to the parser */
+	int64_t released;			/** number of groups given back by the parser */
+	int64_t eof, stop;
+	int64_t njobs, nth;
+	struct fna_bgzf_job_s *jobs;
+	pthread_t th[];
+};
+
+/**
+ * @fn fna_bgzf_read_job
+ * @brief read up to FNA_BGZF_BLOCKS blocks, called with the lock held. sets b->eof
+ * at the end of the file, returns nonzero if the file is broken.
  */
 static
-struct fna_read_ret_s fna_read_seq_ascii(
-	struct fna_context_s *fna,
-	lmm_kvec_uint8_t *v,
-	uint8_t const *delim_table,
-	int64_t lim)
+int fna_bgzf_read_job(
+	struct fna_bgzf_s *b,
+	struct fna_bgzf_job_s *j)
 {
-	int c = 0;
-	int64_t len = 0;
-	while(len < lim) {
-		uint8_t type = delim_table[(uint8_t)(c = zfgetc(fna->fp))];
-		if(type & DELIM_TERM) { break; }
-		if(type != 0) { continue; }
-		debug("%c, %d", c, c);
-		lmm_kv_push(fna->lmm, *v, (uint8_t)c); len++;
+	uint64_t ilen = 0;
+	for(j->cnt = 0; j->cnt < FNA_BGZF_BLOCKS; j->cnt++) {
+		uint8_t *h = j->in + ilen;
+		size_t n = fread(h, 1, 18, b->fp);
+		if(n == 0) { b->eof = 1; break; }
+		if(n != 18 || !fna_bgzf_is_block(h)) { return(-1); }
+
+		uint64_t xlen = h[10] | (h[11]<<8);
+		uint64_t size = (h[16] | (h[17]<<8)) + 1;
+		if(size < 12 + xlen + 8 || fread(h + 18, 1, size - 18, b->fp) != size - 18) {
+			return(-1);
+		}
+		j->blk[j->cnt] = (struct fna_bgzf_block_s){
+			.pos = ilen + 12 + xlen,
+			.len = size - 12 - xlen - 8
+		};
+		ilen += size;
 	}
-	lmm_kv_push(fna->lmm, *v, '\0');
-	debug("finished, len(%lld)", len);
-
-	fna->status = zfeof(fna->fp) ? FNA_EOF : FNA_SUCCESS;
-	return((struct fna_read_ret_s){
-		.len = len,
-		.c = (char)c
-	});
+	return(0);
 }
 
 /**
- * @fn fna_encode_2bit
- * @brief mapping IUPAC amb. to 2bit encoding
+ * @fn fna_bgzf_inflate_job
+ * @brief inflate blocks in a job, checks the size and crc in the footers
  */
-static _force_inline
-uint8_t fna_encode_2bit(
-	int c)
+static
+int fna_bgzf_inflate_job(
+	z_stream *z,
+	struct fna_bgzf_job_s *j)
 {
-	/* convert to upper case and subtract offset by 0x40 */
-	#define _b(x)	( (x) & 0x1f )
-
-	/* conversion tables */
-	enum bases {
-		A = 0x00, C = 0x01, G = 0x02, T = 0x03
-	};
-	static uint8_t const table[] = {
-		[_b('A')] = A,
-		[_b('C')] = C,
-		[_b('G')] = G,
-		[_b('T')] = T,
-		[_b('U')] = T,
-		[_b('N')] = A,		/* treat 'N' as 'A' */
-		[_b('_')] = 0		/* sentinel */
-	};
-	return(table[_b((uint8_t)c)]);
-
-	#undef _b
+	j->olen = 0;
+	for(int64_t i = 0; i < j->cnt; i++) {
+		int64_t isize = fna_bgzf_inflate_block(z, j->in + j->blk[i].pos, j->blk[i].len, j->out + j->olen);
+		if(isize < 0) { return(-1); }
+		j->olen += isize;
+	}
+	return(0);
 }
 
 /**
- * @fn fna_read_seq_2bit
- * @brief read seq until delim, with conv table
+ * @fn fna_bgzf_worker
  */
 static
-struct fna_read_ret_s fna_read_seq_2bit(
-	struct fna_context_s *fna,
-	lmm_kvec_uint8_t *v,
-	uint8_t const *delim_table,
-	int64_t lim)
+void *fna_bgzf_worker(
+	void *arg)
 {
-	int c = 0;
-	int64_t len = 0;
-	while(len < lim) {
-		c = zfgetc(fna->fp);
-		uint8_t type = delim_table[(uint8_t)c];
-		if(type & DELIM_TERM) { break; }
-		if(type != 0) { continue; }
-		lmm_kv_push(fna->lmm, *v, fna_encode_2bit(c)); len++;
+	struct fna_bgzf_s *b = (struct fna_bgzf_s *)arg;
+
+	z_stream z;
+	memset(&z, 0, sizeof(z_stream));
+	if(inflateInit2(&z, -15) != Z_OK) { return(NULL); }
+
+	pthread_mutex_lock(&b->lock);
+	while(1) {
+		while(b->stop == 0 && b->eof == 0 && b->issued - b->released >= b->njobs) {
+			pthread_cond_wait(&b->cond_free, &b->lock);
+		}
+		if(b->stop != 0 || b->eof != 0) { break; }
+
+		/* take the next group in the file order */
+		struct fna_bgzf_job_s *j = &b->jobs[b->issued % b->njobs];
+		j->seq = b->issued++;
+		j->state = 0;
+		int r = fna_bgzf_read_job(b, j);
+
+		pthread_mutex_unlock(&b->lock);
+		if(r == 0) { r = fna_bgzf_inflate_job(&z, j); }
+		pthread_mutex_lock(&b->lock);
+
+		j->state = (r == 0) ? 1 : 2;
+		if(r != 0) { b->eof = 1; }
+		pthread_cond_broadcast(&b->cond_done);
 	}
+	pthread_mutex_unlock(&b->lock);
 
-	fna->status = zfeof(fna->fp) ? FNA_EOF : FNA_SUCCESS;
-	return((struct fna_read_ret_s){
-		.len = len,
-		.c = (char)c
-	});
+	inflateEnd(&z);
+	return(NULL);
 }
 
 /**
- * @fn fna_read_seq_2bitpacked
- * @brief read seq until delim, with conv table
+ * @fn fna_fill_bgzf
+ * @brief give back the current group and point the window to the next one
  */
 static
-struct fna_read_ret_s fna_read_seq_2bitpacked(
-	struct fna_context_s *fna,
-	lmm_kvec_uint8_t *v,
-	uint8_t const *delim_table,
-	int64_t lim)
+int64_t fna_fill_bgzf(
+	struct fna_context_s *fna)
 {
-	int c = 0;
+	struct fna_bgzf_s *b = (struct fna_bgzf_s *)fna->src;
 	int64_t len = 0;
-	uint64_t rem = 8;
-	uint8_t arr = 0;
-	/* 4x unrolled loop */
+
+	fna->p = fna->t = fna->buf;
+	pthread_mutex_lock(&b->lock);
 	while(1) {
-		#define _fetch(_fna) ({ \
-			int _c; \
-			uint8_t _type; \
-			while((_type = delim_table[(uint8_t)(_c = zfgetc(_fna->fp))]) != 0) { \
-				if(_type & DELIM_TERM) { goto _fna_read_seq_2bitpacked_finish; } \
-			} \
-			_c; \
-		}) \
+		if(b->released < b->consumed) {
+			b->released++;
+			pthread_cond_signal(&b->cond_free);
+		}
+
+		struct fna_bgzf_job_s *j = &b->jobs[b->consumed % b->njobs];
+		while((j->seq != b->consumed || j->state == 0) && !(b->eof != 0 && b->issued == b->consumed)) {
+			pthread_cond_wait(&b->cond_done, &b->lock);
+		}
+		if(j->seq != b->consumed || j->state == 0) { break; }	/* end of file */
 
-		#define _check(l) { \
-			if((l)-- <= 0) { goto _fna_read_seq_2bitpacked_finish; } \
+		b->consumed++;
+		if(j->state != 1) {
+			fna->status = FNA_ERROR_BROKEN_FORMAT;
+			break;
 		}
+		if(j->olen == 0) { continue; }		/* empty block (EOF marker) */
 
-		rem = 8;
-		_check(lim); arr = (arr>>2) | (fna_encode_2bit(c = _fetch(fna))<<6); rem -= 2;
-		_check(lim); arr = (arr>>2) | (fna_encode_2bit(c = _fetch(fna))<<6); rem -= 2;
-		_check(lim); arr = (arr>>2) | (fna_encode_2bit(c = _fetch(fna))<<6); rem -= 2;
-		_check(lim); arr = (arr>>2) | (fna_encode_2bit(c = _fetch(fna))<<6);
-		lmm_kv_push(fna->lmm, *v, arr); len += 4;
+		fna->p = j->out;
+		fna->t = j->out + j->olen;
+		len = j->olen;
+		break;
+	}
+	pthread_mutex_unlock(&b->lock);
+	return(len);
+}
 
-		#undef _fetch
-		#undef _check
+/**
+ * @fn fna_bgzf_close
+ */
+static
+void fna_bgzf_close(
+	struct fna_context_s *fna)
+{
+	struct fna_bgzf_s *b = (struct fna_bgzf_s *)fna->src;
+
+	pthread_mutex_lock(&b->lock);
+	b->stop = 1;
+	pthread_cond_broadcast(&b->cond_free);
+	pthread_mutex_unlock(&b->lock);
+	for(int64_t i = 0; i < b->nth; i++) {
+		pthread_join(b->th[i], NULL);
 	}
-_fna_read_seq_2bitpacked_finish:;
-	lmm_kv_push(fna->lmm, *v, arr>>rem); len += (8 - rem) / 2;
 
-	fna->status = zfeof(fna->fp) ? FNA_EOF : FNA_SUCCESS;
-	return((struct fna_read_ret_s){
-		.len = len,
-		.c = (char)c
-	});
+	for(int64_t i = 0; i < b->njobs; i++) {
+		free(b->jobs[i].in);
+		free(b->jobs[i].out);
+	}
+	free(b->jobs);
+	pthread_mutex_destroy(&b->lock);
+	pthread_cond_destroy(&b->cond_free);
+	pthread_cond_destroy(&b->cond_done);
+	fclose(b->fp);
+	free(b);
+
+	fna->src = NULL;
+	return;
 }
 
 /**
- * @fn fna_encode_4bit
- * @brief mapping IUPAC amb. to 4bit encoding
+ * @fn fna_bgzf_open
+ * @brief start parallel decompression from the block at coffset if the file is BGZF, returns nonzero otherwise
  */
-static _force_inline
-uint8_t fna_encode_4bit(
-	int c)
+static
+int fna_bgzf_open(
+	struct fna_context_s *fna,
+	char const *path,
+	int64_t threads,
+	uint64_t coffset)
 {
-	/* convert to upper case and subtract offset by 0x40 */
-	#define _b(x)	( (x) & 0x1f )
+	FILE *fp = fopen(path, "rb");
+	if(fp == NULL) { return(-1); }
 
-	/* conversion tables */
-	enum bases {
-		A = 0x01, C = 0x02, G = 0x04, T = 0x08
-	};
-	static uint8_t const table[] = {
-		[_b('A')] = A,
-		[_b('C')] = C,
-		[_b('G')] = G,
-		[_b('T')] = T,
-		[_b('U')] = T,
-		[_b('R')] = A | G,
-		[_b('Y')] = C | T,
-		[_b('S')] = G | C,
-		[_b('W')] = A | T,
-		[_b('K')] = G | T,
-		[_b('M')] = A | C,
-		[_b('B')] = C | G | T,
-		[_b('D')] = A | G | T,
-		[_b('H')] = A | C | T,
-		[_b('V')] = A | C | G,
-		[_b('N')] = 0,		/* treat 'N' as a gap */
-		[_b('_')] = 0		/* sentinel */
-	};
-	return(table[_b((uint8_t)c)]);
+	uint8_t h[18];
+	if(fread(h, 1, 18, fp) != 18 || !fna_bgzf_is_block(h) || fseeko(fp, coffset, SEEK_SET) != 0) {
+		fclose(fp);
+		return(-1);
+	}
 
-	#undef _b
+	struct fna_bgzf_s *b = (struct fna_bgzf_s *)calloc(1, sizeof(struct fna_bgzf_s) + threads * sizeof(pthread_t));
+	if(b == NULL) { fclose(fp); return(-1); }
+	b->fp = fp;
+	b->njobs = 2 * threads;
+	if((b->jobs = (struct fna_bgzf_job_s *)calloc(b->njobs, sizeof(struct fna_bgzf_job_s))) == NULL) {
+		fclose(fp); free(b);
+		return(-1);
+	}
+	for(int64_t i = 0; i < b->njobs; i++) {
+		b->jobs[i].seq = -1;
+		b->jobs[i].in = (uint8_t *)malloc(FNA_BGZF_BLOCKS * FNA_BGZF_BLOCK_SIZE);
+		b->jobs[i].out = (uint8_t *)malloc(FNA_BGZF_BLOCKS * FNA_BGZF_BLOCK_SIZE + FNA_BUF_MARGIN);
+	}
+	pthread_mutex_init(&b->lock, NULL);
+	pthread_cond_init(&b->cond_free, NULL);
+	pthread_cond_init(&b->cond_done, NULL);
+
+	/* the source is installed first so that fna_bgzf_close can clean up a partial start */
+	fna->src = (void *)b;
+	fna->fill = fna_fill_bgzf;
+	fna->src_close = fna_bgzf_close;
+
+	int broken = 0;
+	for(int64_t i = 0; i < b->njobs; i++) {
+		broken |= (b->jobs[i].in == NULL || b->jobs[i].out == NULL);
+	}
+	for(b->nth = 0; broken == 0 && b->nth < threads; b->nth++) {
+		if(pthread_create(&b->th[b->nth], NULL, fna_bgzf_worker, (void *)b) != 0) { break; }
+	}
+	if(broken != 0 || b->nth == 0) {
+		fna_bgzf_close(fna);
+		fna->fill = fna_fill_zf;
+		fna->src_close = NULL;
+		return(-1);
+	}
+	return(0);
 }
+#endif /* HAVE_Z && HAVE_PTHREAD */
 
+#if defined(HAVE_PTHREAD)
 /**
- * @fn fna_read_seq_4bit
- * @brief read seq until delim, with conv table
+ * read-ahead: a producer thread keeps FNA_AHEAD_SLOTS windows filled from zf while
+ * the parser works on the previous one. the window points directly to the slot;
+ * the slot is given back to the producer on the next fill.
  */
-static
-struct fna_read_ret_s fna_read_seq_4bit(
-	struct fna_context_s *fna,
-	lmm_kvec_uint8_t *v,
-	uint8_t const *delim_table,
-	int64_t lim)
-{
-	int c = 0;
-	int64_t len = 0;
-	while(len < lim) {
-		c = zfgetc(fna->fp);
-		uint8_t type = delim_table[(uint8_t)c];
-		if(type & DELIM_TERM) { break; }
-		if(type != 0) { continue; }
-		lmm_kv_push(fna->lmm, *v, fna_encode_4bit(c)); len++;
-	}
+#define FNA_AHEAD_SLOTS				( 4 )
 
-	fna->status = zfeof(fna->fp) ? FNA_EOF : FNA_SUCCESS;
-	return((struct fna_read_ret_s){
-		.len = len,
-		.c = (char)c
-	});
-}
+/**
+ * @struct fna_ahead_s
+ */
+struct fna_ahead_s {
+	zf_t *fp;
+	pthread_t th;
+	pthread_mutex_t lock;
+	pthread_cond_t cond_free;	/** a slot is released by the parser */
+	pthread_cond_t cond_done;	/** a slot is filled by the producer */
+	int64_t filled;				/** number of slots filled */
+	int64_t consumed;			/** number of slots handed to the parser */
+	int64_t released;			/** number of slots given back by the parser */
+	int64_t stop;
+	struct fna_ahead_slot_s {
+		uint8_t *buf;			/** FNA_BUF_SIZE + FNA_BUF_MARGIN */
+		int64_t len;
+	} slot[FNA_AHEAD_SLOTS];
+};
 
 /**
- * @fn fna_read_seq_4bitpacked
- * @brief read seq until delim, with conv table
+ * @fn fna_ahead_worker
+ * @brief fill slots until the end of the stream, the last slot filled is empty
  */
 static
-struct fna_read_ret_s fna_read_seq_4bitpacked(
-	struct fna_context_s *fna,
-	lmm_kvec_uint8_t *v,
-	uint8_t const *delim_table,
-	int64_t lim)
+void *fna_ahead_worker(
+	void *arg)
 {
-	int c = 0;
-	int64_t len = 0;
-	uint64_t rem = 8;
-	uint8_t arr = 0;
-	/* 2x unrolled loop */
-	while(1) {
-		#define _fetch(_fna) ({ \
-			int _c; \
-			uint8_t _type; \
-			while((_type = delim_table[(uint8_t)(_c = zfgetc(_fna->fp))]) != 0) { \
-				if(lim-- <= 0 && _type & DELIM_TERM) { goto _fna_read_seq_4bitpacked_finish; } \
-			} \
-			_c; \
-		}) \
+	struct fna_ahead_s *a = (struct fna_ahead_s *)arg;
 
-		#define _check(l) { \
-			if((l)-- <= 0) { goto _fna_read_seq_4bitpacked_finish; } \
+	pthread_mutex_lock(&a->lock);
+	while(1) {
+		while(a->stop == 0 && a->filled - a->released >= FNA_AHEAD_SLOTS) {
+			pthread_cond_wait(&a->cond_free, &a->lock);
 		}
+		if(a->stop != 0) { break; }
 
-		rem = 8;
-		_check(lim); arr = (arr>>2) | (fna_encode_4bit(c = _fetch(fna))<<4); rem -= 4;
-		_check(lim); arr = (arr>>2) | (fna_encode_4bit(c = _fetch(fna))<<4);
-		lmm_kv_push(fna->lmm, *v, arr); len += 2;
+		struct fna_ahead_slot_s *s = &a->slot[a->filled % FNA_AHEAD_SLOTS];
+		pthread_mutex_unlock(&a->lock);
+		int64_t len = zfread(a->fp, s->buf, FNA_BUF_SIZE);
+		pthread_mutex_lock(&a->lock);
 
-		#undef _fetch
-		#undef _check
+		s->len = len;
+		a->filled++;
+		pthread_cond_signal(&a->cond_done);
+		if(len == 0) { break; }
 	}
-_fna_read_seq_4bitpacked_finish:;
-	lmm_kv_push(fna->lmm, *v, arr>>rem); len += (8 - rem) / 4;
-
-	fna->status = zfeof(fna->fp) ? FNA_EOF : FNA_SUCCESS;
-	return((struct fna_read_ret_s){
-		.len = len,
-		.c = (char)c
-	});
+	pthread_mutex_unlock(&a->lock);
+	return(NULL);
 }
 
 /**
- * @fn fna_read_head_fasta
+ * @fn fna_fill_ahead
+ * @brief give back the current slot and point the window to the next one
  */
 static
-int fna_read_head_fasta(
+int64_t fna_fill_ahead(
 	struct fna_context_s *fna)
 {
-	/* eat '>' at the head */
-	fna_read_skip(fna, delim_fasta_seq, LIM_UNLIMITED);
-	return(zfeof(fna->fp) ? FNA_EOF :  FNA_SUCCESS);
+	struct fna_ahead_s *a = (struct fna_ahead_s *)fna->src;
+
+	pthread_mutex_lock(&a->lock);
+	if(a->released < a->consumed) {
+		a->released++;
+		pthread_cond_signal(&a->cond_free);
+	}
+	while(a->filled == a->consumed) {
+		pthread_cond_wait(&a->cond_done, &a->lock);
+	}
+	struct fna_ahead_slot_s *s = &a->slot[a->consumed++ % FNA_AHEAD_SLOTS];
+	pthread_mutex_unlock(&a->lock);
+
+	fna->p = s->buf;
+	fna->t = s->buf + s->len;
+	return(s->len);
 }
 
 /**
- * @fn fna_read_fasta
- *
- * @brief (internal) fasta format parser
+ * @fn fna_ahead_close
  */
 static
-struct fna_seq_intl_s *fna_read_fasta(
+void fna_ahead_close(
 	struct fna_context_s *fna)
 {
-	lmm_kvec_uint8_t v;
-	lmm_kv_init(fna->lmm, v);
-
-	/* make margin at the head of seq */
-	fna_seq_make_margin(fna, &v, fna->head_margin);
-
-	lmm_kv_pusha(fna->lmm, struct fna_seq_intl_s, v, ((struct fna_seq_intl_s){
-		.lmm = fna->lmm,
-		.type = FNA_SEGMENT,
-		.seq_encode = fna->seq_encode,
-		.options = fna->options,
-		.head_margin = fna->head_margin,
-		.tail_margin = fna->tail_margin,
-		.seq_head_margin = fna->seq_head_margin,
-		.seq_tail_margin = fna->seq_tail_margin
-	}));
-
-	/* parse name */
-	struct fna_read_ret_s n;
-	int64_t name_len = (n = fna_read_ascii(fna, &v, delim_fasta_fastq_name)).len;
-
-	/* parse comment after name */
-	int64_t com_len = (n.c == ' ')
-		? fna_read_ascii(fna, &v, delim_line).len
-		: ({ lmm_kv_push(fna->lmm, v, '\0'); 0; });
-
-	/* parse seq */
-	fna_seq_make_margin(fna, &v, fna->seq_head_margin);
-	int64_t seq_len = (fna->read_seq(fna, &v, delim_fasta_seq, LIM_UNLIMITED)).len;
+	struct fna_ahead_s *a = (struct fna_ahead_s *)fna->src;
 
-	debug("name_len(%lld), com_len(%lld), seq_len(%lld)", name_len, com_len, seq_len);
+	pthread_mutex_lock(&a->lock);
+	a->stop = 1;
+	pthread_cond_broadcast(&a->cond_free);
+	pthread_mutex_unlock(&a->lock);
+	pthread_join(a->th, NULL);
 
-	/* check termination */
-	if(name_len == 0 && com_len == 0 && seq_len == 0) {
-		lmm_kv_destroy(fna->lmm, v);
-		return(NULL);
+	for(int64_t i = 0; i < FNA_AHEAD_SLOTS; i++) {
+		free(a->slot[i].buf);
 	}
+	pthread_mutex_destroy(&a->lock);
+	pthread_cond_destroy(&a->cond_free);
+	pthread_cond_destroy(&a->cond_done);
+	free(a);
 
-	/* make margin at the tail */
-	fna_seq_make_margin(fna, &v, fna->seq_tail_margin);
-	lmm_kv_push(fna->lmm, v, '\0');			/* qual string terminator */
-	fna_seq_make_margin(fna, &v, fna->tail_margin);
-
-	/* finished, build links */
-	struct fna_seq_intl_s *r = (struct fna_seq_intl_s *)(
-		lmm_kv_ptr(v) + fna->head_margin);
-
-	#define _next(x)		( (x).ptr + (x).len + 1 )
-	r->s.segment.name = (struct fna_str_s){
-		.ptr = (char const *)(r + 1),
-		.len = name_len
-	};
-	r->s.segment.comment = (struct fna_str_s){
-		.ptr = (char const *)_next(r->s.segment.name),
-		.len = com_len
-	};
-	r->s.segment.seq = (struct fna_sarr_s){
-		.ptr = (uint8_t const *)(_next(r->s.segment.comment) + r->seq_head_margin),
-		.len = seq_len
-	};
-	r->s.segment.qual = (struct fna_sarr_s){
-		.ptr = (uint8_t const *)(_next(r->s.segment.seq) + r->seq_tail_margin),
-		.len = 0
-	};
-	#undef _next
-	return(r);
-
-	#if 0
-	char *name = (char *)(r + 1);
-	uint8_t *seq = (uint8_t *)(name + (name_len + 1) + r->seq_head_margin);
-	uint8_t *qual = (uint8_t *)(seq + (seq_len + 1) + r->seq_tail_margin);
-	int64_t qual_len = 0;
-
-	return(_fna_pack_segment(r,
-		name, name_len,
-		seq, seq_len,
-		qual, qual_len));
-	#endif
+	fna->src = NULL;
+	return;
 }
 
 /**
- * @fn fna_read_head_fastq
+ * @fn fna_ahead_open
+ * @brief start the read-ahead thread on fna->fp, returns nonzero on failure
+ * (the caller keeps reading in its own thread then)
  */
 static
-int fna_read_head_fastq(
+int fna_ahead_open(
 	struct fna_context_s *fna)
 {
-	/* eat '@' at the head */
-	fna_read_skip(fna, delim_fastq_tail, LIM_UNLIMITED);
-	return(zfeof(fna->fp) ? FNA_EOF :  FNA_SUCCESS);
+	struct fna_ahead_s *a = (struct fna_ahead_s *)calloc(1, sizeof(struct fna_ahead_s));
+	if(a == NULL) { return(-1); }
+	a->fp = fna->fp;
+
+	int broken = 0;
+	for(int64_t i = 0; i < FNA_AHEAD_SLOTS; i++) {
+		broken |= ((a->slot[i].buf = (uint8_t *)malloc(FNA_BUF_SIZE + FNA_BUF_MARGIN)) == NULL);
+	}
+	pthread_mutex_init(&a->lock, NULL);
+	pthread_cond_init(&a->cond_free, NULL);
+	pthread_cond_init(&a->cond_done, NULL);
+
+	if(broken != 0 || pthread_create(&a->th, NULL, fna_ahead_worker, (void *)a) != 0) {
+		for(int64_t i = 0; i < FNA_AHEAD_SLOTS; i++) {
+			free(a->slot[i].buf);
+		}
+		pthread_mutex_destroy(&a->lock);
+		pthread_cond_destroy(&a->cond_free);
+		pthread_cond_destroy(&a->cond_done);
+		free(a);
+		return(-1);
+	}
+
+	fna->src = (void *)a;
+	fna->fill = fna_fill_ahead;
+	fna->src_close = fna_ahead_close;
+	return(0);
 }
+#endif /* HAVE_PTHREAD */
 
 /**
- * @fn fna_read_fastq
+ * @fn fna_init_intl
  *
- * @brief (internal) fastq format parser
+ * @brief create a sequence reader context on [begin, end) of the file, the whole stream if end == UINT64_MAX
  */
 static
-struct fna_seq_intl_s *fna_read_fastq(
-	struct fna_context_s *fna)
+fna_t *fna_init_intl(
+	char const *path,
+	fna_params_t const *params,
+	uint64_t begin,
+	uint64_t end)
 {
-	lmm_kvec_uint8_t v;
-	lmm_kv_init(fna->lmm, v);
-
-	/* make margin at the head of seq */
-	fna_seq_make_margin(fna, &v, fna->head_margin);
+	struct fna_context_s *fna = NULL;
 
-	lmm_kv_pusha(fna->lmm, struct fna_seq_intl_s, v, ((struct fna_seq_intl_s){
-		.lmm = fna->lmm,
-		.type = FNA_SEGMENT,
-		.seq_encode = fna->seq_encode,
-		.options = fna->options,
-		.head_margin = fna->head_margin,
-		.tail_margin = fna->tail_margin,
-		.seq_head_margin = fna->seq_head_margin,
-		.seq_tail_margin = fna->seq_tail_margin
-	}));
+	/* extension determination */
+	struct _ext {
+		char const *ext;
+		int32_t file_format;
+	};
+	static struct _ext const ext[] = {
+		{".fasta", FNA_FASTA},
+		{".fas",   FNA_FASTA},
+		{".seq",   FNA_FASTA},
+		{".fna",   FNA_FASTA},
+		{".ffn",   FNA_FASTA},
+		{".fa",    FNA_FASTA},
+		{".fastq", FNA_FASTQ},
+		{".fq",    FNA_FASTQ},
+		{".fast5", FNA_FAST5},
+		{".f5",    FNA_FAST5},
+		{".gfa",   FNA_GFA},
+		{NULL,     0}
+	};
+	struct _ext const *ep;
 
-	#if 0
-	/* parse name */
-	int64_t name_len = fna_read_ascii(fna, &v, delim_line).len;
-	#endif
+	/* read functions */
+	int (*read_head[])(
+		struct fna_context_s *fna) = {
+		[FNA_FASTA] = fna_read_head_fasta,
+		[FNA_FASTQ] = fna_read_head_fastq,
+		[FNA_FAST5] = fna_read_head_fast5,
+		[FNA_GFA]	= fna_read_head_gfa
+	};
+	struct fna_seq_intl_s *(*read[])(
+		struct fna_context_s *fna,
+		lmm_kvec_uint8_t *v) = {
+		[FNA_FASTA] = fna_read_fasta,
+		[FNA_FASTQ] = fna_read_fastq,
+		[FNA_FAST5] = fna_read_fast5,
+		[FNA_GFA]	= fna_read_gfa
+	};
 
-	/* parse name */
-	struct fna_read_ret_s n;
-	int64_t name_len = (n = fna_read_ascii(fna, &v, delim_fasta_fastq_name)).len;
+	/* default params */
+	struct fna_params_s default_params = {
+		.lmm = NULL,
+		.seq_encode = FNA_ASCII,
+		.file_format = FNA_UNKNOWN,
+		.options = 0,
+		.head_margin = 0,
+		.tail_margin = 0,
+		.seq_head_margin = 0,
+		.seq_tail_margin = 0,
+		.threads = 0
+	};
 
-	/* parse comment after name */
-	int64_t com_len = (n.c == ' ')
-		? fna_read_ascii(fna, &v, delim_line).len
-		: ({ lmm_kv_push(fna->lmm, v, '\0'); 0; });
+	if(path == NULL) { return NULL; }
+	if(params == NULL) { params = &default_params; }
 
-	/* parse seq */
-	fna_seq_make_margin(fna, &v, fna->seq_head_margin);
-	int64_t seq_len = (fna->read_seq(fna, &v, delim_fastq_seq, LIM_UNLIMITED)).len;
-	fna_seq_make_margin(fna, &v, fna->seq_tail_margin);
+	/* global context is malloc'd with global malloc */
+	if((fna = (struct fna_context_s *)malloc(sizeof(struct fna_context_s))) == NULL) {
+		goto _fna_init_error_handler;
+	}
+	fna->lmm = params->lmm;
+	fna->path = NULL;
+	fna->fp = NULL;
+	fna->status = FNA_SUCCESS;
+	fna->map_size = 0;
+	fna->pos = 0;
+	fna->fill = fna_fill_zf;
+	fna->src_close = NULL;
+	fna->src = NULL;
+	fna->queue = NULL;
+	fna->fai = NULL;
+	fna->len_hint = -1;
+	fna->fai_probed = 0;
+	fna->names = NULL;
+
+	/* buffer window, the whole file if mapped, initially empty otherwise */
+	if((params->options & FNA_MMAP) == 0 || fna_buf_map(fna, path) != 0) {
+		if((fna->buf = (uint8_t *)malloc(FNA_BUF_SIZE + FNA_BUF_MARGIN)) == NULL) {
+			free(fna); fna = NULL;
+			goto _fna_init_error_handler;
+		}
+		memset(fna->buf, FNA_BUF_SENTINEL, FNA_BUF_MARGIN);
+		fna->p = fna->t = fna->buf;
+		fna->eof = 0;
+	} else if(end != UINT64_MAX) {
+		/* narrow the mapped window to the range; the sentinel lands on a private copy of the page */
+		uint64_t size = fna->t - fna->buf;
+		fna->t = fna->buf + MIN2(end, size);
+		fna->p = fna->buf + MIN2(begin, (uint64_t)(fna->t - fna->buf));
+		memset(fna->t, FNA_BUF_SENTINEL, FNA_BUF_MARGIN);
+		fna->pos = fna->t - fna->buf;
+	}
 
-	/* skip name */
-	fna_read_skip(fna, delim_line, LIM_UNLIMITED);
+	/* copy params */
+	fna->seq_encode = params->seq_encode;	/** encode sequence to 2-bit if encode == FNA_2BITPACKED */
+	fna->file_format = params->file_format;	/** format (see enum FNA_FORMAT) */
+	fna->options = params->options;
+	fna->head_margin = _roundup(params->head_margin, 16);
+	fna->tail_margin = _roundup(params->tail_margin, 16);
+	fna->seq_head_margin = _roundup(params->seq_head_margin, 16);
+	fna->seq_tail_margin = _roundup(params->seq_tail_margin, 16);
+	fna->threads = params->threads;
 
-	/* parse qual */
-	int64_t qual_len = (((fna->options & FNA_SKIP_QUAL) == 0)
-		? fna->read_seq(fna, &v, delim_fastq_qual, seq_len)
-		: fna_read_skip(fna, delim_fastq_qual, seq_len)).len;
-	fna_read_skip(fna, delim_fastq_tail, LIM_UNLIMITED);	/* strip tail */
-	lmm_kv_push(fna->lmm, v, '\0');							/* push null terminator */
+	/* restore defaults */
+	if(fna->seq_encode == 0) { fna->seq_encode = FNA_ASCII; }
 
-	/* check termination */
-	debug("seq_len(%lld), qual_len(%lld), name_len(%lld)", seq_len, qual_len, name_len);
-	if(seq_len != qual_len || (name_len == 0 && seq_len == 0)) {
-		lmm_kv_destroy(fna->lmm, v);
-		return(NULL);
+	/* open file */
+	if(fna->map_size == 0 && end != UINT64_MAX) {
+		if(fna_range_open(fna, path, begin, end) != 0) {
+			fna->status = FNA_ERROR_FILE_OPEN;
+			goto _fna_init_error_handler;
+		}
+	}
+	#if defined(HAVE_Z) && defined(HAVE_PTHREAD)
+		if(fna->map_size == 0 && fna->src == NULL && params->threads > 1) {
+			fna_bgzf_open(fna, path, params->threads, 0);
+		}
+	#endif
+	if(fna->map_size == 0 && fna->src == NULL) {
+		fna->fp = zfopen(path, "r");
+		if(fna->fp == NULL) { goto _fna_init_error_handler; }
 	}
 
-	/* make margin at the tail */
-	fna_seq_make_margin(fna, &v, fna->tail_margin);
+	/**
+	 * if fna->file_format is not specified...
+	 * 1. determine file format from the path extension
+	 */
+	if(fna->file_format == 0) {
+		char const *fp_path = (fna->fp != NULL) ? fna->fp->path : path;
+		uint64_t path_len = strlen(fp_path);
+		char const *path_tail = fp_path + path_len;
+		for(ep = ext; ep->ext != NULL; ep++) {
+			/* skip if path string is shorter than extension string */
+			if(path_len < strlen(ep->ext)) { continue; }
 
-	/* finished, build links */
-	struct fna_seq_intl_s *r = (struct fna_seq_intl_s *)(
-		lmm_kv_ptr(v) + fna->head_margin);
+			/* compare ext */
+			if(strncmp(path_tail - strlen(ep->ext), ep->ext, strlen(ep->ext)) == 0) {
+				fna->file_format = ep->file_format; break;
+			}
+		}
+	}
 
-	#define _next(x)		( (x).ptr + (x).len + 1 )
-	r->s.segment.name = (struct fna_str_s){
-		.ptr = (char const *)(r + 1),
-		.len = name_len
-	};
-	r->s.segment.comment = (struct fna_str_s){
-		.ptr = (char const *)_next(r->s.segment.name),
-		.len = com_len
-	};
-	r->s.segment.seq = (struct fna_sarr_s){
-		.ptr = (uint8_t const *)(_next(r->s.segment.comment) + r->seq_head_margin),
-		.len = seq_len
-	};
-	r->s.segment.qual = (struct fna_sarr_s){
-		.ptr = (uint8_t const *)(_next(r->s.segment.seq) + r->seq_tail_margin),
-		.len = ((fna->options & FNA_SKIP_QUAL) == 0) ? qual_len : 0
-	};
-	#undef _next
-	return(r);
+	/**
+	 * 2. determine file format from the content of the file
+	 */
+	if(fna->file_format == 0) {
+		/* peek the head of the file */
+		char buf[33] = { 0 };
+		uint64_t len = 0;
+		if(fna->fp != NULL) {
+			len = zfpeek(fna->fp, buf, 32);
+		} else {
+			fna_buf_fill(fna);				/* mapped, ranged or parallel, the head is in the window */
+			len = MIN2(fna->t - fna->p, 32);
+			memcpy(buf, fna->p, len);
+		}
+		for(uint64_t i = 0; i < len; i++) {
+			switch(buf[i]) {
+				case '>': fna->file_format = FNA_FASTA; break;
+				case '@': fna->file_format = FNA_FASTQ; break;
+				case 'H':
+				if(buf[i + 1] == '\t') {
+					fna->file_format = FNA_GFA; break;
+				}
+			}
+		}
+	}
+	if(fna->file_format == 0) {
+		fna->status = FNA_ERROR_UNKNOWN_FORMAT;
+		goto _fna_init_error_handler;
+	}
+	#ifndef HAVE_HDF5
+		if(fna->file_format == FNA_FAST5) {
+			// log_error("Fast5 file format is not supported in this build.\n");
+			fna->status = FNA_ERROR_UNKNOWN_FORMAT;
+			goto _fna_init_error_handler;
+		}
+	#endif
+	fna->read_head = read_head[fna->file_format];
+	fna->read = read[fna->file_format];
 
-	#if 0
-	char *name = (char *)(r + 1);
-	uint8_t *seq = (uint8_t *)(name + (name_len + 1) + r->seq_head_margin);
-	uint8_t *qual = (uint8_t *)(seq + (seq_len + 1) + r->seq_tail_margin);
+	/* pack functions, from the kernel for the running CPU */
+	struct fna_kernel_s const *kernel = fna_kernel_select();
+	fna->read_seq = kernel->read_seq[fna->seq_encode];
+	fna->read_ascii = kernel->read_ascii;
+	fna->read_skip = kernel->read_skip;
+	fna->read_count = kernel->read_count;
+
+	/* views are available only on the mapped window, and not on seq and qual the reverse strand follows */
+	int const view = fna->map_size != 0 && (fna->options & FNA_EMIT_REVCOMP) == 0;
+	fna->view_ascii = (fna->map_size != 0) ? kernel->view_ascii : fna->read_ascii;
+	fna->view_seq = (view && fna->seq_encode == FNA_ASCII) ? kernel->view_seq : fna->read_seq;
+	fna->revcomp = kernel->revcomp;
+	fna->path = strdup(path);
 
-	return(_fna_pack_segment(r,
-		name, name_len,
-		seq, seq_len,
-		qual, qual_len));
+	/* parse chunks of an uncompressed file on a pool, or decompress in background; started
+	after zfpeek above as the threads own the input from here */
+	int pooled = 0;
+	#if defined(HAVE_PTHREAD)
+		if(fna->fp != NULL && end == UINT64_MAX && params->threads > 1
+		&& (fna->file_format == FNA_FASTA || fna->file_format == FNA_FASTQ)
+		&& fna->lmm == NULL && fna_pool_open(fna, path, params, begin) == 0) {
+			zfclose(fna->fp); fna->fp = NULL;
+			pooled = 1;
+		}
 	#endif
+
+	/* lengths of long sequences from an existing .fai, loaded on the first long record */
+	fna->fai_probed = !(pooled == 0 && end == UINT64_MAX && fna->file_format == FNA_FASTA);
+
+	/* resume at begin (fna_seek) */
+	if(pooled == 0 && end == UINT64_MAX && begin != 0 && fna_seek_open(fna, path, begin) != 0) {
+		if(fna->status == FNA_SUCCESS) { fna->status = FNA_ERROR_FILE_OPEN; }
+		goto _fna_init_error_handler;
+	}
+	#if defined(HAVE_PTHREAD)
+		if(fna->fp != NULL && params->threads > 0) {
+			fna_ahead_open(fna);
+		}
+	#endif
+
+	/* parse header, the workers parse the heads of the chunks if pooled; a resumed
+	reader skips to the head of the next record, or is at the end of the file */
+	if(pooled == 0 && (begin == 0 || fna->file_format != FNA_GFA)) {
+		int status = fna->read_head(fna);
+		if(status != FNA_SUCCESS && (begin == 0 || status != FNA_EOF)) {
+			/* something is wrong */
+			goto _fna_init_error_handler;
+		}
+	}
+
+	/* parse on a thread from here, for many readers; the name table is not shared */
+	if((params->options & FNA_SHARED) != 0) {
+		if((params->options & FNA_INTERN_NAMES) != 0) {
+			fna->status = FNA_ERROR_UNSUPPORTED_VERSION;
+			goto _fna_init_error_handler;
+		}
+		#if defined(HAVE_PTHREAD)
+			if(fna_queue_open(fna) != 0) {
+				fna->status = FNA_ERROR_OUT_OF_MEM;
+				goto _fna_init_error_handler;
+			}
+		#else
+			fna->status = FNA_ERROR_UNSUPPORTED_VERSION;
+			goto _fna_init_error_handler;
+		#endif
+	}
+	return((struct fna_s *)fna);
+
+_fna_init_error_handler:
+	if(fna != NULL) {
+		fna_fai_close(fna->fai);
+		if(fna->src_close != NULL) { fna->src_close(fna); }
+		zfclose(fna->fp); fna->fp = NULL;
+		free(fna->path); fna->path = NULL;
+		fna_buf_release(fna);
+		free(fna);
+	}
+	return(NULL);
 }
 
 /**
- * @fn fna_read_head_fast5
+ * @fn fna_init
+ *
+ * @brief create a sequence reader context
+ *
+ * @param[in] path : a path to a file to open.
+ *
+ * @return a pointer to the context
  */
-static
-int fna_read_head_fast5(
-	struct fna_context_s *fna)
+fna_t *fna_init(
+	char const *path,
+	fna_params_t const *params)
 {
-#ifdef HAVE_HDF5
-	/** not implemented yet */
-#endif /* HAVE_HDF5 */
-	return(FNA_EOF);
+	return(fna_init_intl(path, params, 0, UINT64_MAX));
 }
 
 /**
- * @fn fna_read_fast5
+ * @fn fna_init_range
  *
- * @brief (internal) fast5 format parser
+ * @brief create a sequence reader context on [begin, end) of an uncompressed file.
+ * begin must be at a record head (see fna_split).
  */
-static
-struct fna_seq_intl_s *fna_read_fast5(
-	struct fna_context_s *fna)
+fna_t *fna_init_range(
+	char const *path,
+	fna_params_t const *params,
+	uint64_t begin,
+	uint64_t end)
 {
-#ifdef HAVE_HDF5
-	/** not implemented yet */
-#endif /* HAVE_HDF5 */
-	return(NULL);
+	if(end == UINT64_MAX) { end--; }
+	return(fna_init_intl(path, params, begin, end));
 }
 
 /**
- * @fn fna_read_head_gfa
+ * @fn fna_close_input
+ * @brief stop the threads and close the file, the window and the input source
  */
 static
-int fna_read_head_gfa(
+void fna_close_input(
 	struct fna_context_s *fna)
 {
-	lmm_kvec_uint8_t buf;
-	lmm_kv_init(fna->lmm, buf);
-
-	debug("parse gfa header");
+	#if defined(HAVE_PTHREAD)
+		if(fna->queue != NULL) { fna_queue_close(fna); }
+	#endif
+	if(fna->src_close != NULL) { fna->src_close(fna); }
+	zfclose(fna->fp); fna->fp = NULL;
+	fna_buf_release(fna);
+	return;
+}
 
-	/* read until '\n' */
-	fna_read_ascii(fna, &buf, delim_line);
+/**
+ * @fn fna_close
+ *
+ * @brief clean up sequence reader context
+ */
+void fna_close(fna_t *ctx)
+{
+	struct fna_context_s *fna = (struct fna_context_s *)ctx;
 
-	/* check prefix */
-	char const *prefix = "H\tVN:Z:";
-	if(strncmp((char const *)lmm_kv_ptr(buf), prefix, strlen(prefix)) != 0) {
-		debug("broken");
-		return(fna->status = FNA_ERROR_BROKEN_FORMAT);
+	if(fna != NULL) {
+		fna_close_input(fna);
+		fna_fai_close(fna->fai); fna->fai = NULL;
+		fna_names_close(fna->names); fna->names = NULL;
+		free(fna->path); fna->path = NULL;
+		free(fna); fna = NULL;
 	}
+	return;
+}
 
-	/* check version */
-	uint64_t version = fna_parse_version_string(&((char const *)lmm_kv_ptr(buf))[strlen(prefix)]);
+/**
+ * @fn fna_set_lmm
+ */
+void *fna_set_lmm(
+	fna_t *ctx,
+	void *new)
+{
+	struct fna_context_s *fna = (struct fna_context_s *)ctx;
 
-	/* cleanup */
-	lmm_kv_destroy(fna->lmm, buf);
+	lmm_t *old = fna->lmm;
+	fna->lmm = (lmm_t *)new;
+	return((void *)old);
+}
 
-	debug("%llx", version);
-	return((version >= 0x10000) ? FNA_SUCCESS : FNA_ERROR_UNSUPPORTED_VERSION);
+/**
+ * @fn fna_split_line
+ * @brief returns the head of the next line, the length of the line (without "\r\n") in len
+ */
+static _force_inline
+uint8_t const *fna_split_line(
+	uint8_t const *p,
+	uint8_t const *t,
+	int64_t *len)
+{
+	uint8_t const *q = (uint8_t const *)memchr(p, '\n', t - p);
+	if(q == NULL) { q = t; }
+	*len = q - p - (q > p && q[-1] == '\r');
+	return(q + (q < t));
 }
 
 /**
- * @fn fna_read_gfa_seq
+ * @fn fna_split_is_head_fastq
+ * @brief the 4-line check: '@' line, sequence, '+' line, and quality of the same length,
+ * followed by another '@' line or the end of the file
  */
 static _force_inline
-struct fna_seq_intl_s *fna_read_gfa_seq(
-	struct fna_context_s *fna)
+int fna_split_is_head_fastq(
+	uint8_t const *p,
+	uint8_t const *t)
 {
-	lmm_kvec_uint8_t v;
-	lmm_kv_init(fna->lmm, v);
+	int64_t len[4];
+	uint8_t const *l[5] = { p };
+	for(int64_t i = 0; i < 4; i++) {
+		if(l[i] >= t) { return(0); }
+		l[i + 1] = fna_split_line(l[i], t, &len[i]);
+	}
+	return(l[0][0] == '@' && l[2][0] == '+' && len[1] == len[3] && (l[4] >= t || l[4][0] == '@'));
+}
 
-	/* make margin at the head of seq */
-	fna_seq_make_margin(fna, &v, fna->head_margin);
+/**
+ * @fn fna_split_is_head_fasta
+ * @brief '>' at the head of a line, the terminal fna_read_head_fasta skips to
+ */
+static _force_inline
+int fna_split_is_head_fasta(
+	uint8_t const *p,
+	uint8_t const *t)
+{
+	return(p[0] == '>');
+}
 
-	lmm_kv_pusha(fna->lmm, struct fna_seq_intl_s, v, ((struct fna_seq_intl_s){
-		.lmm = fna->lmm,
-		.type = FNA_SEGMENT,
-		.seq_encode = fna->seq_encode,
-		.options = fna->options,
-		.head_margin = fna->head_margin,
-		.tail_margin = fna->tail_margin,
-		.seq_head_margin = fna->seq_head_margin,
-		.seq_tail_margin = fna->seq_tail_margin
-	}));
+/**
+ * @fn fna_split
+ *
+ * @brief partition an uncompressed FASTA or (4-line) FASTQ file into at most n byte ranges at record heads
+ *
+ * @return the number of ranges, range i is [offs[i], offs[i + 1]); negative fna_status on error
+ */
+int64_t fna_split(
+	char const *path,
+	int64_t n,
+	uint64_t *offs)
+{
+	if(path == NULL || offs == NULL || n <= 0) { return(-FNA_ERROR_FILE_OPEN); }
 
-	/* parse name */
-	int64_t name_len = fna_read_ascii(fna, &v, delim_gfa_field).len;
+	uint64_t size = 0;
+	int fd = fna_open_plain(path, &size);
+	if(fd < 0) { return(-FNA_ERROR_FILE_OPEN); }
 
-	/* comment is always blank */
-	lmm_kv_push(fna->lmm, v, '\0');
+	offs[0] = 0;
+	if(size == 0) {
+		close(fd);
+		offs[1] = 0;
+		return(1);
+	}
 
-	/* parse seq */
-	fna_seq_make_margin(fna, &v, fna->seq_head_margin);
-	struct fna_read_ret_s ret = fna->read_seq(fna, &v, delim_gfa_field, LIM_UNLIMITED);
-	int64_t seq_len = ret.len;
+	uint8_t const *base = (uint8_t const *)mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(base == MAP_FAILED) { return(-FNA_ERROR_FILE_OPEN); }
+	int (*is_head)(uint8_t const *p, uint8_t const *t) =
+		  (base[0] == '>') ? fna_split_is_head_fasta
+		: (base[0] == '@') ? fna_split_is_head_fastq
+		: NULL;
+	if(is_head == NULL) {
+		munmap((void *)base, size);
+		return(-FNA_ERROR_UNKNOWN_FORMAT);
+	}
 
-	/* check if optional field remains */
-	if(ret.c == '\t') {
-		/* skip optional fields */
-		fna_read_skip(fna, delim_line, LIM_UNLIMITED);
+	/* walk lines forward from each even split until one passes the check */
+	uint8_t const *t = base + size;
+	int64_t cnt = 0, len;
+	for(int64_t i = 1; i < n; i++) {
+		uint8_t const *p = base + MAX2(size * i / n, offs[cnt]);
+		if(p > base && p[-1] != '\n') { p = fna_split_line(p, t, &len); }
+		while(p < t && !is_head(p, t)) {
+			p = fna_split_line(p, t, &len);
+		}
+		if(p >= t) { break; }
+		if((uint64_t)(p - base) > offs[cnt]) { offs[++cnt] = p - base; }
 	}
+	offs[++cnt] = size;
 
-	/* check termination */
-	if(name_len == 0 && seq_len == 0) {
-		lmm_kv_destroy(fna->lmm, v);
+	munmap((void *)base, size);
+	return(cnt);
+}
+
+#if defined(HAVE_PTHREAD)
+/**
+ * @struct fna_parallel_s
+ */
+struct fna_parallel_s {
+	char const *path;
+	fna_params_t const *params;
+	uint64_t begin, end;
+	int64_t i;
+	int (*worker)(fna_t *fna, int64_t i, void *arg);
+	void *arg;
+	int ret;
+	pthread_t th;
+};
+
+/**
+ * @fn fna_parallel_worker
+ */
+static
+void *fna_parallel_worker(
+	void *arg)
+{
+	struct fna_parallel_s *w = (struct fna_parallel_s *)arg;
+
+	fna_t *fna = fna_init_range(w->path, w->params, w->begin, w->end);
+	if(fna == NULL) {
+		w->ret = FNA_ERROR_FILE_OPEN;
 		return(NULL);
 	}
+	w->ret = w->worker(fna, w->i, w->arg);
+	if(w->ret == 0 && fna->status != FNA_SUCCESS && fna->status != FNA_EOF) {
+		w->ret = fna->status;
+	}
+	fna_close(fna);
+	return(NULL);
+}
 
-	/* make margin at the tail */
-	fna_seq_make_margin(fna, &v, fna->seq_tail_margin);
-	lmm_kv_push(fna->lmm, v, '\0');
-	fna_seq_make_margin(fna, &v, fna->tail_margin);
+/**
+ * @fn fna_read_parallel
+ *
+ * @brief split the file with fna_split and call worker on each range in its own thread
+ * with its own context
+ *
+ * @return zero if all the workers returned zero, the first nonzero value otherwise
+ */
+int fna_read_parallel(
+	char const *path,
+	fna_params_t const *params,
+	int64_t n,
+	int (*worker)(fna_t *fna, int64_t i, void *arg),
+	void *arg)
+{
+	if(worker == NULL || n <= 0) { return(FNA_ERROR_FILE_OPEN); }
 
-	/* finished, build links */
-	struct fna_seq_intl_s *r = (struct fna_seq_intl_s *)(
-		lmm_kv_ptr(v) + fna->head_margin);
+	uint64_t *offs = (uint64_t *)malloc(sizeof(uint64_t) * (n + 1));
+	struct fna_parallel_s *w = (struct fna_parallel_s *)malloc(sizeof(struct fna_parallel_s) * n);
+	if(offs == NULL || w == NULL) {
+		free(offs); free(w);
+		return(FNA_ERROR_OUT_OF_MEM);
+	}
 
-	#define _next(x)		( (x).ptr + (x).len + 1 )
-	r->s.segment.name = (struct fna_str_s){
-		.ptr = (char const *)(r + 1),
-		.len = name_len
-	};
-	r->s.segment.comment = (struct fna_str_s){
-		.ptr = (char const *)_next(r->s.segment.name),
-		.len = 0
-	};
-	r->s.segment.seq = (struct fna_sarr_s){
-		.ptr = (uint8_t const *)(_next(r->s.segment.comment) + r->seq_head_margin),
-		.len = seq_len
-	};
-	r->s.segment.qual = (struct fna_sarr_s){
-		.ptr = (uint8_t const *)(_next(r->s.segment.seq) + r->seq_tail_margin),
-		.len = 0
-	};
-	#undef _next
-
-	return(r);
-
-	#if 0
-	char *name = (char *)(r + 1);
-	uint8_t *seq = (uint8_t *)(name + (name_len + 1) + r->seq_head_margin);
-	uint8_t *qual = (uint8_t *)(seq + (seq_len + 1) + r->seq_tail_margin);
-	int64_t qual_len = 0;
-
-	return(_fna_pack_segment(r,
-		name, name_len,
-		seq, seq_len,
-		qual, qual_len));
-	#endif
-}
-
-/**
- * @fn fna_read_gfa_link
- */
-static _force_inline
-struct fna_seq_intl_s *fna_read_gfa_link(
-	struct fna_context_s *fna)
-{
-	lmm_kvec_uint8_t v;
-	lmm_kv_init(fna->lmm, v);
-
-	/* make margin at the head of seq */
-	fna_seq_make_margin(fna, &v, fna->head_margin);
-
-	lmm_kv_pusha(fna->lmm, struct fna_seq_intl_s, v, ((struct fna_seq_intl_s){
-		.lmm = fna->lmm,
-		.type = FNA_LINK,
-		.seq_encode = fna->seq_encode,
-		.options = fna->options,
-		.head_margin = fna->head_margin,
-		.tail_margin = fna->tail_margin,
-		.seq_head_margin = fna->seq_head_margin,
-		.seq_tail_margin = fna->seq_tail_margin
-	}));
-
-	/* parse from field */
-	struct fna_read_ret_s ret_src = fna_read_ascii(fna, &v, delim_gfa_field);
-	if(ret_src.c != '\t') {
-		fna->status = FNA_ERROR_BROKEN_FORMAT;
-		return(NULL);
-	}
-
-	/* direction */
-	int64_t src_ori = (zfgetc(fna->fp) == '+') ? 0 : 1;
-	if(zfgetc(fna->fp) != '\t') {
-		fna->status = FNA_ERROR_BROKEN_FORMAT;
-		return(NULL);
+	int64_t cnt = fna_split(path, n, offs);
+	if(cnt < 0) {
+		free(offs); free(w);
+		return(-cnt);
 	}
 
-	/* parse to field */
-	struct fna_read_ret_s ret_dst = fna_read_ascii(fna, &v, delim_gfa_field);
-	if(ret_dst.c != '\t') {
-		fna->status = FNA_ERROR_BROKEN_FORMAT;
-		return(NULL);
+	for(int64_t i = 0; i < cnt; i++) {
+		w[i] = (struct fna_parallel_s){
+			.path = path,
+			.params = params,
+			.begin = offs[i],
+			.end = offs[i + 1],
+			.i = i,
+			.worker = worker,
+			.arg = arg
+		};
 	}
-
-	/* direction */
-	int64_t dst_ori = (zfgetc(fna->fp) == '+') ? 0 : 1;
-	if(zfgetc(fna->fp) != '\t') {
-		fna->status = FNA_ERROR_BROKEN_FORMAT;
-		return(NULL);
+	for(int64_t i = 1; i < cnt; i++) {
+		if(pthread_create(&w[i].th, NULL, fna_parallel_worker, (void *)&w[i]) != 0) {
+			w[i].ret = FNA_ERROR_OUT_OF_MEM;
+			w[i].worker = NULL;
+		}
 	}
+	fna_parallel_worker((void *)&w[0]);		/* the first range in the caller */
 
-	/* parse cigar field */
-	struct fna_read_ret_s ret_cig = fna_read_ascii(fna, &v, delim_gfa_field);
-
-	/* check if optional field remains */
-	if(ret_cig.c == '\t') {
-		/* skip optional fields */
-		fna_read_skip(fna, delim_line, LIM_UNLIMITED);
+	int ret = w[0].ret;
+	for(int64_t i = 1; i < cnt; i++) {
+		if(w[i].worker != NULL) { pthread_join(w[i].th, NULL); }
+		if(ret == 0) { ret = w[i].ret; }
 	}
+	free(offs);
+	free(w);
+	return(ret);
+}
+#endif /* HAVE_PTHREAD */
 
-	/* make margin at the tail */
-	fna_seq_make_margin(fna, &v, fna->tail_margin);
-
-	/* finished, build links */
-	struct fna_seq_intl_s *r = (struct fna_seq_intl_s *)(
-		lmm_kv_ptr(v) + fna->head_margin);
-
-	#define _next(x)		( (x).ptr + (x).len + 1 )
-	r->s.link.src = (struct fna_str_s){
-		.ptr = (char const *)(r + 1),
-		.len = ret_src.len
-	};
-	r->s.link.src_ori = src_ori;
-	r->s.link.dst = (struct fna_str_s){
-		.ptr = (char const *)_next(r->s.link.src),
-		.len = ret_dst.len
-	};
-	r->s.link.dst_ori = dst_ori;
-	r->s.link.cigar = (struct fna_cigar_s){
-		.ptr = (char const *)_next(r->s.link.dst),
-		.len = ret_cig.len
-	};
-	#undef _next
-
-	/* replace "*" with "" */
-	if(r->s.link.cigar.ptr[0] == '*') {
-		((char *)r->s.link.cigar.ptr)[0] = '\0';
-		r->s.link.cigar.len = 0;
-	}
-	return(r);
+/**
+ * @struct fna_fai_rec_s
+ * @brief a line of .fai (samtools faidx): name, length, offset of the first base,
+ * bases per line and bytes per line (newline included)
+ */
+struct fna_fai_rec_s {
+	char const *name;
+	int64_t len;
+	uint64_t offset;
+	int64_t line_bases;
+	int64_t line_width;
+};
 
-	#if 0
-	char *from = (char *)(r + 1);
-	char *to = from + (ret_src.len + 1);
-	char *cig = to + (ret_to.len + 1);
+/**
+ * @struct fna_gzi_rec_s
+ * @brief a line of .gzi, offsets of the head of a BGZF block in the file and in the decompressed stream
+ */
+struct fna_gzi_rec_s {
+	uint64_t coffset;
+	uint64_t uoffset;
+};
 
-	/* replace "*" with "" */
-	if(cig[0] == '*') {
-		cig[0] = '\0';
-		ret_cig.len = 0;
-	}
+/**
+ * @struct fna_fai_s
+ * @brief index of an uncompressed or bgzipped FASTA, records sorted by name for fna_fetch.
+ * offsets in the records are on the decompressed stream.
+ */
+struct fna_fai_s {
+	int fd;						/** the indexed file, read with pread */
+	int bgzf;
+	int64_t cnt;
+	int64_t max_len;			/** the longest sequence */
+	struct fna_fai_rec_s *rec;
+	char *names;				/** storage of the names */
+	int64_t gcnt;
+	struct fna_gzi_rec_s *gzi;	/** BGZF block heads, (0, 0) of the first block included */
+};
 
-	return(_fna_pack_link(r,
-		from, ret_src.len, from_ori,
-		to, ret_to.len, to_ori,
-		cig, ret_cig.len));
-	#endif
+/**
+ * @fn fna_fai_close
+ */
+static
+void fna_fai_close(
+	struct fna_fai_s *fai)
+{
+	if(fai == NULL) { return; }
+	if(fai->fd >= 0) { close(fai->fd); }
+	free(fai->rec);
+	free(fai->names);
+	free(fai->gzi);
+	free(fai);
+	return;
 }
 
 /**
- * @fn fna_read_gfa_cont
+ * @fn fna_fai_cmp
  */
-static _force_inline
-struct fna_seq_intl_s *fna_read_gfa_cont(
-	struct fna_context_s *fna)
+static
+int fna_fai_cmp(
+	void const *a,
+	void const *b)
 {
-	/* fixme: ignoring containment information */
-	return(NULL);
+	return(strcmp(
+		((struct fna_fai_rec_s const *)a)->name,
+		((struct fna_fai_rec_s const *)b)->name));
 }
 
 /**
- * @fn fna_read_gfa_path
+ * @fn fna_fai_path
+ * @brief "<path><ext>", freed by the caller
  */
-static _force_inline
-struct fna_seq_intl_s *fna_read_gfa_path(
-	struct fna_context_s *fna)
+static
+char *fna_fai_path(
+	char const *path,
+	char const *ext)
 {
-	/* fixme: ignoring path line */
-	return(NULL);
+	char *fai_path = (char *)malloc(strlen(path) + strlen(ext) + 1);
+	if(fai_path == NULL) { return(NULL); }
+	strcpy(fai_path, path);
+	strcat(fai_path, ext);
+	return(fai_path);
 }
 
 /**
- * @fn fna_read_gfa
- *
- * @brief gfa parser driver
+ * @fn fna_fai_open_file
+ * @brief open an uncompressed or a BGZF file (bgzf is set), returns the descriptor, or -1
  */
 static
-struct fna_seq_intl_s *fna_read_gfa(
-	struct fna_context_s *fna)
+int fna_fai_open_file(
+	char const *path,
+	uint64_t *size,
+	int *bgzf)
 {
-	int c;
-	while((c = zfgetc(fna->fp)) != EOF) {
-
-		/* eat tab after type character */
-		if(zfgetc(fna->fp) != '\t') {
-			fna->status = FNA_ERROR_BROKEN_FORMAT;
-			return(NULL);
+	*bgzf = 0;
+	int fd = fna_open_plain(path, size);
+	if(fd >= 0) { return(fd); }
+
+	#if defined(HAVE_Z)
+		if((fd = open(path, O_RDONLY)) < 0) { return(-1); }
+		struct stat st;
+		uint8_t h[18];
+		if(fstat(fd, &st) == 0 && S_ISREG(st.st_mode)
+		&& pread(fd, h, 18, 0) == 18 && fna_bgzf_is_block(h)) {
+			*size = st.st_size;
+			*bgzf = 1;
+			return(fd);
 		}
+		close(fd);
+	#endif
+	return(-1);
+}
 
-		/* examine type */
-		switch(c) {
-			case 'S': return(fna_read_gfa_seq(fna));
-			case 'L': return(fna_read_gfa_link(fna));
-
-			case 'C':	/* fall throught to 'P' */
-			case 'P':
-			fna_read_skip(fna, delim_line, LIM_UNLIMITED);
-			break;
+/**
+ * @struct fna_fai_scan_s
+ * @brief state of the .fai builder, fed with the decompressed stream in chunks
+ */
+struct fna_fai_scan_s {
+	lmm_kvec_t(struct fna_fai_rec_s) rec;
+	lmm_kvec_t(char) names;
+	struct fna_fai_rec_s r;		/** the record being scanned, names are offsets until fna_fai_sort */
+	uint64_t pos;				/** offset of the next byte in the stream */
+	uint64_t name;				/** offset of the name on the current header line */
+	int64_t len;				/** bytes of the current line so far */
+	uint8_t head;				/** the first char of the current line */
+	uint8_t cr, in_name, open, closed;
+};
 
-			/*
-			case 'C': return(fna_read_gfa_cont(fna));
-			case 'P': return(fna_read_gfa_path(fna));
-			*/
-			
-			default:
-			/* broken broken broken */
-			fna->status = FNA_ERROR_BROKEN_FORMAT;
-			return(NULL);
-		}
+/**
+ * @fn fna_fai_scan_line
+ * @brief called on the tail of each line. all lines of a sequence but the last must have the
+ * same number of bases and the same width, as samtools requires; returns nonzero otherwise.
+ */
+static
+int fna_fai_scan_line(
+	struct fna_fai_scan_s *s,
+	int64_t width)
+{
+	int64_t const bases = s->len - s->cr;
+	if(s->head == '>') {
+		if(s->open != 0) { lmm_kv_push(NULL, s->rec, s->r); }
+		lmm_kv_push(NULL, s->names, '\0');
+		s->r = (struct fna_fai_rec_s){
+			.name = (char const *)(uintptr_t)s->name,
+			.offset = s->pos
+		};
+		s->open = 1;
+		s->closed = s->in_name = 0;
+		return(0);
+	}
 
+	/* sequence line; a short line (or a blank line) closes the sequence */
+	if(bases == 0) { s->closed = 1; return(0); }
+	if(s->open == 0 || s->closed != 0 || (s->r.line_bases != 0 && bases > s->r.line_bases)) {
+		return(-1);
 	}
-	fna->status = FNA_EOF;
-	return(NULL);
+	if(s->r.line_bases == 0) {
+		s->r.line_bases = bases;
+		s->r.line_width = width;
+	}
+	s->closed = bases != s->r.line_bases || width != s->r.line_width;
+	s->r.len += bases;
+	return(0);
 }
 
 /**
- * @fn fna_read
- *
- * @brief read a sequence
- *
- * @param[in] fna : a pointer to the context
- *
- * @return a pointer to a sequence object
+ * @fn fna_fai_scan
+ * @brief feed [p, t) of the stream, returns nonzero if the file can not be indexed
  */
-fna_seq_t *fna_read(fna_t *ctx)
+static
+int fna_fai_scan(
+	struct fna_fai_scan_s *s,
+	uint8_t const *p,
+	uint8_t const *t)
 {
-	struct fna_context_s *fna = (struct fna_context_s *)ctx;
-	if(fna == NULL) { return NULL; }
-	return((fna_seq_t *)fna->read(fna));
+	while(p < t) {
+		uint8_t const *q = (uint8_t const *)memchr(p, '\n', t - p);
+		uint8_t const *e = (q != NULL) ? q : t;
+
+		if(s->len == 0) {
+			s->head = *p;
+			s->cr = 0;
+			s->in_name = *p == '>';
+			s->name = lmm_kv_size(s->names);
+		}
+
+		/* name is up to the first space */
+		if(s->in_name != 0) {
+			uint8_t const *n = p + (s->len == 0), *m = n;
+			while(m < e && *m != ' ' && *m != '\t' && *m != '\r') { m++; }
+			lmm_kv_pushm(NULL, s->names, (char const *)n, m - n);
+			s->in_name = m == e;
+		}
+		if(e > p) { s->cr = e[-1] == '\r'; }
+		s->len += e - p;
+		s->pos += e - p;
+		if(q == NULL) { break; }
+
+		s->pos++;
+		if(fna_fai_scan_line(s, s->len + 1) != 0) { return(-1); }
+		s->len = 0;
+		p = q + 1;
+	}
+	return(0);
 }
 
 /**
- * @fn fna_seq_free
- *
- * @brief clean up sequence object
+ * @fn fna_fai_build
+ * @brief scan the whole file for the records, and for the block heads of BGZF
  */
-void fna_seq_free(fna_seq_t *seq)
+static
+int fna_fai_build(
+	struct fna_fai_s *fai)
 {
-	struct fna_seq_intl_s *s = (struct fna_seq_intl_s *)seq;
-	if(s != NULL) {
-
-		#define _next(x)		( (x).ptr + (x).len + 1 )
-
-		/* free if external mem is used */
-		if(s->type == FNA_SEGMENT) {
-
-			/* segment */
-			char const *name_base = (char const *)(s + 1);
-			char const *comment_base = (char const *)_next(s->s.segment.name);
-			uint8_t const *seq_base = (uint8_t const *)_next(s->s.segment.comment) + s->seq_head_margin; 
-			uint8_t const *qual_base = (uint8_t const *)_next(s->s.segment.seq) + s->seq_tail_margin; 
-
-			/* segment */
-			if(s->s.segment.name.ptr != name_base) {
-				lmm_free(s->lmm, (void *)s->s.segment.name.ptr);
-			}
-			if(s->s.segment.comment.ptr != comment_base) {
-				lmm_free(s->lmm, (void *)s->s.segment.comment.ptr);
-			}
-			if(s->s.segment.seq.ptr != seq_base) {
-				lmm_free(s->lmm, (void *)s->s.segment.seq.ptr);
-			}
-			if(s->s.segment.qual.ptr != qual_base) {
-				lmm_free(s->lmm, (void *)s->s.segment.qual.ptr);
+	struct fna_fai_scan_s s;
+	memset(&s, 0, sizeof(struct fna_fai_scan_s));
+	lmm_kv_init(NULL, s.rec);
+	lmm_kv_init(NULL, s.names);
+	lmm_kvec_t(struct fna_gzi_rec_s) gzi;
+	lmm_kv_init(NULL, gzi);
+
+	int status = FNA_SUCCESS;
+	if(fai->bgzf == 0) {
+		uint8_t *buf = (uint8_t *)malloc(FNA_BUF_SIZE);
+		int64_t len;
+		while(buf != NULL && (len = pread(fai->fd, buf, FNA_BUF_SIZE, s.pos)) > 0) {
+			if(fna_fai_scan(&s, buf, buf + len) != 0) { status = FNA_ERROR_BROKEN_FORMAT; break; }
+		}
+		if(buf == NULL) { status = FNA_ERROR_OUT_OF_MEM; }
+		free(buf);
+	} else {
+		#if defined(HAVE_Z)
+			z_stream z;
+			memset(&z, 0, sizeof(z_stream));
+			uint8_t *in = (uint8_t *)malloc(2 * FNA_BGZF_BLOCK_SIZE), *out = in + FNA_BGZF_BLOCK_SIZE;
+			if(in == NULL || inflateInit2(&z, -15) != Z_OK) {
+				free(in);
+				status = FNA_ERROR_OUT_OF_MEM;
+				in = NULL;
 			}
 
-			s->s.segment.name.ptr = NULL;
-			s->s.segment.comment.ptr = NULL;
-			s->s.segment.seq.ptr = NULL;
-			s->s.segment.qual.ptr = NULL;
-
-		} else if(s->type == FNA_LINK) {
-
-			/* link */
-			char const *src_base = (char const *)(s + 1);
-			char const *dst_base = (char const *)_next(s->s.link.src);
-			char const *cigar_base = (char const *)_next(s->s.link.dst);
-
-			if(s->s.link.src.ptr != src_base) {
-				lmm_free(s->lmm, (void *)s->s.link.src.ptr);
-			}
-			if(s->s.link.dst.ptr != dst_base) {
-				lmm_free(s->lmm, (void *)s->s.link.dst.ptr);
+			/* heads of nonempty blocks */
+			uint64_t off = 0;
+			int64_t size, olen = 0;
+			while(in != NULL && (size = fna_bgzf_pread_block(&z, fai->fd, off, in, out, &olen)) != 0) {
+				if(size < 0 || fna_fai_scan(&s, out, out + olen) != 0) { status = FNA_ERROR_BROKEN_FORMAT; break; }
+				if(olen > 0) {
+					lmm_kv_push(NULL, gzi, ((struct fna_gzi_rec_s){ .coffset = off, .uoffset = s.pos - olen }));
+				}
+				off += size;
 			}
-			if(s->s.link.cigar.ptr != cigar_base) {
-				lmm_free(s->lmm, (void *)s->s.link.cigar.ptr);
+			if(in != NULL) { inflateEnd(&z); free(in); }
+			if(lmm_kv_size(gzi) == 0) {
+				lmm_kv_push(NULL, gzi, ((struct fna_gzi_rec_s){ .coffset = 0, .uoffset = 0 }));
 			}
+		#endif
+	}
 
-			s->s.link.src.ptr = NULL;
-			s->s.link.dst.ptr = NULL;
-			s->s.link.cigar.ptr = NULL;
-		}
-
-		#undef _next
-
-		/* free context */
-		lmm_free(s->lmm, (void *)((uint8_t *)s - s->head_margin));
+	/* the last line and the last record */
+	if(status == FNA_SUCCESS && s.len > 0 && fna_fai_scan_line(&s, s.len) != 0) {
+		status = FNA_ERROR_BROKEN_FORMAT;
 	}
-	return;
+	if(status != FNA_SUCCESS) {
+		lmm_kv_destroy(NULL, s.rec);
+		lmm_kv_destroy(NULL, s.names);
+		lmm_kv_destroy(NULL, gzi);
+		return(status);
+	}
+	if(s.open != 0) { lmm_kv_push(NULL, s.rec, s.r); }
+
+	fai->cnt = lmm_kv_size(s.rec);
+	fai->rec = lmm_kv_ptr(s.rec);
+	fai->names = lmm_kv_ptr(s.names);
+	fai->gcnt = lmm_kv_size(gzi);
+	fai->gzi = lmm_kv_ptr(gzi);
+	return(FNA_SUCCESS);
 }
 
-#if 0
 /**
- * @fn fna_base_comp
- * @brief (internal) make complemented base
+ * @fn fna_fai_slurp
+ * @brief read <path><ext> if it exists and is not older than the indexed file, NULL otherwise
  */
-static _force_inline
-uint8_t fna_base_comp(uint8_t c)
+static
+char *fna_fai_slurp(
+	struct fna_fai_s const *fai,
+	char const *path,
+	char const *ext,
+	int64_t *size)
 {
-	switch(c) {
-		case 'a': return 't';
-		case 'c': return 'g';
-		case 'g': return 'c';
-		case 't': return 'a';
-		case 'A': return 'T';
-		case 'C': return 'G';
-		case 'G': return 'C';
-		case 'T': return 'A';
-		default: return 'N';
+	char *fai_path = fna_fai_path(path, ext);
+	if(fai_path == NULL) { return(NULL); }
+	int fd = open(fai_path, O_RDONLY);
+	free(fai_path);
+	if(fd < 0) { return(NULL); }
+
+	struct stat st, fst;
+	char *text = NULL;
+	if(fstat(fd, &st) != 0 || fstat(fai->fd, &fst) != 0 || st.st_mtime < fst.st_mtime
+	|| (text = (char *)malloc(st.st_size + 1)) == NULL
+	|| pread(fd, text, st.st_size, 0) != st.st_size) {
+		free(text);
+		close(fd);
+		return(NULL);
 	}
+	close(fd);
+	*size = st.st_size;
+	return(text);
 }
 
 /**
- * @fn fna_append
- *
- * @brief concatenate src sesquence after dst sequence
+ * @fn fna_fai_parse
+ * @brief load records from the text of a .fai, names are stored as offsets into names
  */
-void fna_append(
-	fna_seq_t *_dst,
-	fna_seq_t const *_src)
+static
+int fna_fai_parse(
+	struct fna_fai_s *fai,
+	char *text,
+	int64_t size)
 {
-	struct fna_seq_intl_s *dst = (struct fna_seq_intl_s *)_dst;
-	struct fna_seq_intl_s *src = (struct fna_seq_intl_s *)_src;
-
-	int64_t i;
-	int64_t size = src->len;
-
-	if(src->seq_encode != dst->seq_encode || src->seq_encode != src->seq_encode) {
-		return;
-	}
-	if(dst->seq_encode == FNA_RAW) {
-		(void)lmm_kv_pop(dst->seq);
-	}
-	dst->len += size;
-	if(src->seq_encode == FNA_RAW) {
-		lmm_kv_reserve(dst->seq, dst->len + 1);
-		for(i = 0; i < size; i++) {
-			lmm_kv_push(dst->seq, lmm_kv_at(src->seq, i));
-		}
-		lmm_kv_push(dst->seq, '\0');
-	} else if(src->seq_encode == FNA_2BIT) {
-		lmm_kv_reserve(dst->seq, dst->len);
-		for(i = 0; i < size; i++) {
-			lmm_kv_push(dst->seq, lmm_kv_at(src->seq, i));
-		}
-	} else if(src->seq_encode == FNA_2BITPACKED) {
-		kpv_reserve(dst->seq, dst->len);
-		for(i = 0; i < size; i++) {
-			kpv_push(dst->seq, kpv_at(src->seq, i));
+	lmm_kvec_t(struct fna_fai_rec_s) rec;
+	lmm_kv_init(NULL, rec);
+
+	char *p = text, *t = text + size;
+	while(p < t) {
+		char *q = (char *)memchr(p, '\n', t - p);
+		if(q == NULL) { q = t; }
+		*q = '\0';
+		if(p == q) { p = q + 1; continue; }
+
+		/* name, length, offset, line bases and line width; the sixth column of FASTQ is ignored */
+		char *c = (char *)memchr(p, '\t', q - p);
+		if(c == NULL) { goto _fna_fai_parse_error; }
+		*c++ = '\0';
+		struct fna_fai_rec_s r = { .name = (char const *)(uintptr_t)(p - text) };
+		r.len = strtoll(c, &c, 10);
+		r.offset = strtoull(c, &c, 10);
+		r.line_bases = strtoll(c, &c, 10);
+		r.line_width = strtoll(c, &c, 10);
+		if(r.len < 0 || r.line_bases < 0 || r.line_width < r.line_bases
+		|| (r.len > 0 && r.line_bases == 0)) {
+			goto _fna_fai_parse_error;
 		}
+		lmm_kv_push(NULL, rec, r);
+		p = q + 1;
 	}
-	return;
+
+	fai->cnt = lmm_kv_size(rec);
+	fai->rec = lmm_kv_ptr(rec);
+	fai->names = text;
+	return(FNA_SUCCESS);
+
+_fna_fai_parse_error:;
+	lmm_kv_destroy(NULL, rec);
+	return(FNA_ERROR_BROKEN_FORMAT);
 }
 
 /**
- * @fn fna_duplicate
- *
- * @brief duplicate sequence
+ * @fn fna_gzi_parse
+ * @brief load block heads from a .gzi: the number of entries and the pairs of offsets,
+ * all 64-bit little endian, the first block is not in the file
  */
-fna_seq_t *fna_duplicate(
-	fna_seq_t const *_seq)
+static
+int fna_gzi_parse(
+	struct fna_fai_s *fai,
+	uint8_t const *bin,
+	int64_t size)
 {
-	struct fna_seq_intl_s *seq = (struct fna_seq_intl_s *)_seq;
-
-	void *ptr = malloc(sizeof(struct fna_seq_intl_s)
-		+ seq->head_margin + seq->tail_margin);
-	struct fna_seq_intl_s *dup = (struct fna_seq_intl_s *)(ptr + seq->head_margin);
-	dup->head_margin = seq->head_margin;		/** set head margin size */
-	dup->tail_margin = seq->tail_margin;
+	#define _u64(_p)		({ uint64_t _x = 0; for(int64_t _i = 7; _i >= 0; _i--) { _x = (_x<<8) | (_p)[_i]; } _x; })
+	if(size < 8 || (uint64_t)(size - 8) / 16 != _u64(bin) || (size - 8) % 16 != 0) { return(FNA_ERROR_BROKEN_FORMAT); }
 
-	lmm_kv_init(dup->name);
-	lmm_kv_init(dup->seq);
-	dup->len = 0;
-	if(seq->s.segment.seq_encode == FNA_RAW) {
-		lmm_kv_push(dup->seq, '\0');
+	int64_t const cnt = _u64(bin) + 1;
+	if((fai->gzi = (struct fna_gzi_rec_s *)malloc(cnt * sizeof(struct fna_gzi_rec_s))) == NULL) {
+		return(FNA_ERROR_OUT_OF_MEM);
 	}
-
-	fna_append((fna_seq_t *)dup, (fna_seq_t *)seq);
-
-	dup->name = seq->s.segment.name;
-	dup->name.a = strdup(seq->s.segment.name.a);
-	dup->seq_encode = seq->s.segment.seq_encode;
-	return((fna_seq_t *)dup);
+	fai->gzi[0] = (struct fna_gzi_rec_s){ .coffset = 0, .uoffset = 0 };
+	for(int64_t i = 1; i < cnt; i++) {
+		fai->gzi[i] = (struct fna_gzi_rec_s){
+			.coffset = _u64(bin + 16 * i - 8),
+			.uoffset = _u64(bin + 16 * i)
+		};
+	}
+	fai->gcnt = cnt;
+	#undef _u64
+	return(FNA_SUCCESS);
 }
 
 /**
- * @fn fna_append_revcomp
- *
- * @brief append reverse complement of src after dst sequence
+ * @fn fna_fai_load
+ * @brief read <path>.fai (and <path>.gzi on BGZF), returns nonzero if missing or older than the file
  */
-void fna_append_revcomp(
-	fna_seq_t *_dst,
-	fna_seq_t const *_src)
+static
+int fna_fai_load(
+	struct fna_fai_s *fai,
+	char const *path)
 {
-	struct fna_seq_intl_s *dst = (struct fna_seq_intl_s *)_dst;
-	struct fna_seq_intl_s *src = (struct fna_seq_intl_s *)_src;
-
-	int64_t i;
-	int64_t size = src->len;
-
-	if(src->seq_encode != dst->seq_encode || src->seq_encode != src->seq_encode) {
-		return;
+	int64_t size = 0;
+	char *text = fna_fai_slurp(fai, path, ".fai", &size);
+	if(text == NULL) { return(-1); }
+	if(fna_fai_parse(fai, text, size) != FNA_SUCCESS) { free(text); return(-1); }
+	if(fai->bgzf == 0) { return(0); }
+
+	char *bin = fna_fai_slurp(fai, path, ".gzi", &size);
+	int status = (bin == NULL) ? FNA_ERROR_FILE_OPEN : fna_gzi_parse(fai, (uint8_t const *)bin, size);
+	free(bin);
+	if(status != FNA_SUCCESS) {
+		free(fai->rec); fai->rec = NULL;
+		free(fai->names); fai->names = NULL;
+		fai->cnt = 0;
+		return(-1);
 	}
+	return(0);
+}
 
-	if(dst->seq_encode == FNA_RAW) {
-		(void)lmm_kv_pop(dst->seq);
+/**
+ * @fn fna_fai_dump
+ * @brief write the records (before fna_fai_sort, so in file order) to <path>.fai, and the block heads to <path>.gzi
+ */
+static
+int fna_fai_dump(
+	struct fna_fai_s const *fai,
+	char const *path)
+{
+	char *fai_path = fna_fai_path(path, ".fai");
+	char *gzi_path = fna_fai_path(path, ".gzi");
+	FILE *fp = (fai_path != NULL) ? fopen(fai_path, "w") : NULL;
+	FILE *gp = (fp != NULL && gzi_path != NULL && fai->bgzf != 0) ? fopen(gzi_path, "wb") : NULL;
+	int status = (fai_path == NULL || gzi_path == NULL) ? FNA_ERROR_OUT_OF_MEM
+		: (fp == NULL || (fai->bgzf != 0 && gp == NULL)) ? FNA_ERROR_FILE_OPEN
+		: FNA_SUCCESS;
+
+	for(int64_t i = 0; status == FNA_SUCCESS && i < fai->cnt; i++) {
+		struct fna_fai_rec_s const *r = &fai->rec[i];
+		fprintf(fp, "%s\t%lld\t%llu\t%lld\t%lld\n",
+			fai->names + (uintptr_t)r->name, (long long)r->len,
+			(unsigned long long)r->offset, (long long)r->line_bases, (long long)r->line_width);
 	}
-	dst->len += size;
-	if(src->seq_encode == FNA_RAW) {
-		lmm_kv_reserve(dst->seq, dst->len + 1);
-		for(i = 0; i < size; i++) {
-			lmm_kv_push(dst->seq, fna_base_comp(lmm_kv_at(src->seq, size - i - 1)));
-		}
-		lmm_kv_push(dst->seq, '\0');
-	} else if(src->seq_encode == FNA_2BIT) {
-		lmm_kv_reserve(dst->seq, dst->len);
-		for(i = 0; i < size; i++) {
-			lmm_kv_push(dst->seq, 0x03 - lmm_kv_at(src->seq, size - i - 1));
-		}
-	} else if(src->seq_encode == FNA_2BITPACKED) {
-		lmm_kv_reserve(dst->seq, dst->len);
-		for(i = 0; i < size; i++) {
-			kpv_push(dst->seq, 0x03 - kpv_at(src->seq, size - i - 1));
+	if(gp != NULL) {
+		#define _put_u64(_x)	{ for(int64_t _i = 0; _i < 8; _i++) { fputc(((_x)>>(8 * _i)) & 0xff, gp); } }
+		_put_u64((uint64_t)(fai->gcnt - 1));
+		for(int64_t i = 1; i < fai->gcnt; i++) {
+			_put_u64(fai->gzi[i].coffset);
+			_put_u64(fai->gzi[i].uoffset);
 		}
+		#undef _put_u64
+		if(fclose(gp) != 0) { status = FNA_ERROR_FILE_OPEN; }
 	}
-	return;
+	if(fp != NULL && fclose(fp) != 0) { status = FNA_ERROR_FILE_OPEN; }
+
+	/* no partial index is left */
+	if(status != FNA_SUCCESS && fp != NULL) { unlink(fai_path); }
+	if(status != FNA_SUCCESS && gp != NULL) { unlink(gzi_path); }
+	free(fai_path);
+	free(gzi_path);
+	return(status);
 }
 
 /**
- * @fn fna_revcomp
- * @brief make reverse complemented sequence
+ * @fn fna_fai_sort
+ * @brief turn name offsets into pointers and sort the records by name
  */
-fna_seq_t *fna_revcomp(
-	fna_seq_t const *_seq)
+static
+void fna_fai_sort(
+	struct fna_fai_s *fai)
 {
-	struct fna_seq_intl_s *seq = (struct fna_seq_intl_s *)_seq;
+	for(int64_t i = 0; i < fai->cnt; i++) {
+		fai->rec[i].name = fai->names + (uintptr_t)fai->rec[i].name;
+		fai->max_len = MAX2(fai->max_len, fai->rec[i].len);
+	}
+	qsort(fai->rec, fai->cnt, sizeof(struct fna_fai_rec_s), fna_fai_cmp);
+	return;
+}
 
-	void *ptr = malloc(sizeof(struct fna_seq_intl_s)
-		+ seq->head_margin + seq->tail_margin);
-	struct fna_seq_intl_s *rev = (struct fna_seq_intl_s *)(ptr + seq->head_margin);
-	rev->head_margin = seq->head_margin;		/** set head margin size */
-	rev->tail_margin = seq->tail_margin;
+/**
+ * @fn fna_fai_find
+ * @brief binary search on the sorted records, name is len chars long (not necessarily terminated)
+ */
+static
+struct fna_fai_rec_s const *fna_fai_find(
+	struct fna_fai_s const *fai,
+	char const *name,
+	int64_t len)
+{
+	int64_t lb = 0, ub = fai->cnt;
+	while(lb < ub) {
+		int64_t const mid = (lb + ub) / 2;
+		char const *m = fai->rec[mid].name;
+		int cmp = strncmp(m, name, len);
+		if(cmp == 0) { cmp = (m[len] != '\0'); }		/* longer one comes later */
+		if(cmp == 0) { return(&fai->rec[mid]); }
+		if(cmp < 0) { lb = mid + 1; } else { ub = mid; }
+	}
+	return(NULL);
+}
 
-	lmm_kv_init(rev->name);
-	lmm_kv_init(rev->seq);
-	rev->len = 0;
-	if(seq->s.segment.seq_encode == FNA_RAW) {
-		lmm_kv_push(rev->seq, '\0');
+/**
+ * @fn fna_fai_open
+ * @brief load <path>.fai (and .gzi), or build the index if build is set (and save it next to the
+ * file if the directory is writable)
+ */
+static
+struct fna_fai_s *fna_fai_open(
+	char const *path,
+	int build)
+{
+	uint64_t size = 0;
+	struct fna_fai_s *fai = (struct fna_fai_s *)calloc(1, sizeof(struct fna_fai_s));
+	if(fai == NULL) { return(NULL); }
+	if((fai->fd = fna_fai_open_file(path, &size, &fai->bgzf)) < 0) {
+		free(fai);
+		return(NULL);
 	}
 
-	fna_append_revcomp((fna_seq_t *)rev, (fna_seq_t *)seq);
+	if(fna_fai_load(fai, path) != 0) {
+		if(build == 0 || fna_fai_build(fai) != FNA_SUCCESS) {
+			fna_fai_close(fai);
+			return(NULL);
+		}
+		fna_fai_dump(fai, path);
+	}
+	fna_fai_sort(fai);
+	return(fai);
+}
 
-	rev->name = seq->s.segment.name;
-	rev->name.a = strdup(seq->s.segment.name.a);
-	rev->seq_encode = seq->s.segment.seq_encode;
-	return((fna_seq_t *)rev);
+/**
+ * @fn fna_fai_open_hint
+ * @brief load an existing <path>.fai for length hints, NULL if missing or all the sequences are short.
+ * the file is closed until fna_fetch reads it.
+ */
+static
+struct fna_fai_s *fna_fai_open_hint(
+	char const *path)
+{
+	struct fna_fai_s *fai = fna_fai_open(path, 0);
+	if(fai != NULL && fai->max_len < FNA_HINT_MIN_LEN) {
+		fna_fai_close(fai);
+		return(NULL);
+	}
+	if(fai != NULL) { close(fai->fd); fai->fd = -1; }
+	return(fai);
 }
-#endif
 
 /**
- * unittests
+ * @fn fna_fai_pread
+ * @brief read [bs, be) of the decompressed stream; on BGZF only the blocks covering the range
+ * are inflated. returns the length read.
  */
-#include <sys/stat.h>
+static
+int64_t fna_fai_pread(
+	struct fna_fai_s const *fai,
+	uint8_t *buf,
+	uint64_t bs,
+	uint64_t be)
+{
+	int64_t len = 0;
+	if(fai->bgzf == 0) {
+		while(len < (int64_t)(be - bs)) {
+			int64_t l = pread(fai->fd, buf + len, be - bs - len, bs + len);
+			if(l <= 0) { break; }
+			len += l;
+		}
+		return(len);
+	}
 
-unittest_config(
-	.name = "fna",
-	.depends_on = {"zf"}
-);
+	#if defined(HAVE_Z)
+		/* the last block starting at or before bs */
+		int64_t lo = 0, hi = fai->gcnt;
+		while(hi - lo > 1) {
+			int64_t mid = (lo + hi) / 2;
+			if(fai->gzi[mid].uoffset <= bs) { lo = mid; } else { hi = mid; }
+		}
+
+		z_stream z;
+		memset(&z, 0, sizeof(z_stream));
+		uint8_t *in = (uint8_t *)malloc(2 * FNA_BGZF_BLOCK_SIZE), *out = in + FNA_BGZF_BLOCK_SIZE;
+		if(in == NULL || inflateInit2(&z, -15) != Z_OK) { free(in); return(0); }
+
+		uint64_t coff = fai->gzi[lo].coffset, uoff = fai->gzi[lo].uoffset;
+		while(uoff < be) {
+			int64_t olen = 0, size = fna_bgzf_pread_block(&z, fai->fd, coff, in, out, &olen);
+			if(size <= 0) { break; }
+
+			uint64_t s = MAX2(uoff, bs), e = MIN2(uoff + olen, be);
+			if(s < e) {
+				memcpy(buf + (s - bs), out + (s - uoff), e - s);
+				len = e - bs;
+			}
+			coff += size;
+			uoff += olen;
+		}
+		inflateEnd(&z);
+		free(in);
+	#endif
+	return(len);
+}
 
 /**
- * @fn fdump
- * @brief dump string to file, returns 1 if succeeded
+ * @fn fna_seek_skip
+ * @brief discard len bytes of the stream
  */
-static _force_inline
-int fdump(
-	char const *filename,
-	char const *content)
+static
+int fna_seek_skip(
+	struct fna_context_s *fna,
+	uint64_t len)
 {
-	FILE *fp = fopen(filename, "w");
-	uint64_t l = fprintf(fp, "%s", content);
-	fclose(fp);
-	return(l == strlen(content));
+	while(len > 0) {
+		if(fna->p >= fna->t && fna_buf_fill(fna) == 0) { return(-1); }
+		uint64_t n = MIN2(len, (uint64_t)(fna->t - fna->p));
+		fna->p += n;
+		len -= n;
+	}
+	return(0);
 }
 
 /**
- * @fn fcmp
- * @brief compare file, returns zero if the content is equivalent to arr
+ * @fn fna_seek_open
+ * @brief move the input to begin of the decompressed stream, before the head is parsed.
+ * uncompressed files are read from begin with pread, BGZF from the block containing begin
+ * (found with <path>.gzi if it is up to date, or by walking the block headers); other
+ * compressed streams are inflated and discarded up to begin.
  */
-static _force_inline
-int fcmp(char const *filename, uint64_t size, uint8_t const *arr)
+static
+int fna_seek_open(
+	struct fna_context_s *fna,
+	char const *path,
+	uint64_t begin)
 {
-	int64_t res;
-	struct stat st;
-	FILE *fp = NULL;
-	uint8_t *buf = NULL;
+	if(fna->map_size != 0) {
+		fna->p = fna->buf + MIN2(begin, (uint64_t)(fna->t - fna->buf));
+		return(0);
+	}
 
-	if((fp = fopen(filename, "rb")) == NULL) { return(1); }
-	fstat(fileno(fp), &st);
-	buf = malloc(sizeof(uint8_t) * st.st_size);
+	uint64_t size = 0;
+	int bgzf = 0;
+	int fd = fna_fai_open_file(path, &size, &bgzf);
+	if(fd < 0) {
+		/* not seekable, read through; stops at the end of the stream */
+		fna_seek_skip(fna, begin);
+		return(fna->status != FNA_SUCCESS);
+	}
 
-	if(fread(buf, sizeof(uint8_t), st.st_size, fp) != (size_t)st.st_size) {
-		free(buf);
-		return(0);
+	/* drop the input opened from the head */
+	if(fna->src_close != NULL) { fna->src_close(fna); }
+	zfclose(fna->fp); fna->fp = NULL;
+	fna->fill = fna_fill_zf;
+	fna->src_close = NULL;
+	fna->p = fna->t = fna->buf;
+	fna->eof = 0;
+
+	if(bgzf == 0) {
+		close(fd);
+		return(fna_range_open(fna, path, begin, UINT64_MAX));
 	}
-	res = memcmp(buf, arr, size);
-	free(buf);
-	fclose(fp);
-	return(res == 0);
+
+	#if defined(HAVE_Z)
+		struct fna_fai_s fai = { .fd = fd };
+		int64_t len = 0;
+		char *bin = fna_fai_slurp(&fai, path, ".gzi", &len);
+		uint64_t coffset = 0, boffset = 0;
+		if(bin != NULL && fna_gzi_parse(&fai, (uint8_t const *)bin, len) == FNA_SUCCESS) {
+			for(int64_t i = 0; i < fai.gcnt && fai.gzi[i].uoffset <= begin; i++) {
+				coffset = fai.gzi[i].coffset;
+				boffset = begin - fai.gzi[i].uoffset;
+			}
+		} else if(fna_bgzf_locate(fd, begin, &coffset, &boffset) != 0) {
+			free(bin);
+			close(fd);
+			fna->status = FNA_ERROR_BROKEN_FORMAT;
+			return(-1);
+		}
+		free(bin);
+		free(fai.gzi);
+
+		int r = -1;
+		#if defined(HAVE_PTHREAD)
+			if(fna->threads > 1) { r = fna_bgzf_open(fna, path, fna->threads, coffset); }
+		#endif
+		if(r == 0) {
+			close(fd);
+		} else if(fna_bgzf_pread_open(fna, fd, coffset) != 0) {
+			close(fd);
+			return(-1);
+		}
+		fna->pos = begin - boffset;
+		fna_seek_skip(fna, boffset);
+		return(0);
+	#else
+		close(fd);
+		return(-1);
+	#endif
 }
 
 /**
- * @fn unittest_random_base
+ * @fn fna_build_index
+ *
+ * @brief build <path>.fai of an uncompressed FASTA, and <path>.gzi of a bgzipped one
+ *
+ * @return FNA_SUCCESS, or fna_status on error
  */
-static _force_inline
-char unittest_random_base(void)
+int fna_build_index(
+	char const *path)
 {
-	char const table[4] = {'A', 'C', 'G', 'T'};
-	return(table[rand() % 4]);
+	if(path == NULL) { return(FNA_ERROR_FILE_OPEN); }
+
+	uint64_t size = 0;
+	struct fna_fai_s fai = { 0 };
+	if((fai.fd = fna_fai_open_file(path, &size, &fai.bgzf)) < 0) { return(FNA_ERROR_FILE_OPEN); }
+
+	int status = fna_fai_build(&fai);
+	if(status == FNA_SUCCESS) { status = fna_fai_dump(&fai, path); }
+	close(fai.fd);
+	free(fai.rec);
+	free(fai.names);
+	free(fai.gzi);
+	return(status);
 }
+#endif /* !FNA_KERNEL_ONLY */
 
 /**
- * @fn unittest_generate_random_sequence
+ * miscellaneous tables and functions
  */
-static _force_inline
-char *unittest_generate_random_sequence(
-	int64_t len)
-{
-	char *seq;		/** a pointer to sequence */
-	seq = (char *)malloc(sizeof(char) * (len + 1));
 
-	if(seq == NULL) { return NULL; }
-	for(int64_t i = 0; i < len; i++) {
-		seq[i] = unittest_random_base();
-	}
-	seq[len] = '\0';
-	return seq;
-}
+/**
+ * @macro _fna_pack_segment
+ */
+#define _fna_pack_segment(_seg, _name, _name_len, _com, _com_len, _seq, _seq_len, _qual, _qual_len) ({ \
+	(_seg)->s.segment.name = (_name); \
+	(_seg)->s.segment.name_len = (_name_len); \
+	(_seg)->s.segment.comment = (_com); \
+	(_seg)->s.segment.comment_len = (_com_len); \
+	(_seg)->s.segment.seq = (_seq); \
+	(_seg)->s.segment.seq_len = (_seq_len); \
+	(_seg)->s.segment.qual = (_qual); \
+	(_seg)->s.segment.qual_len = (_qual_len); \
+	(_seg); \
+})
+
+/**
+ * @macro _fna_pack_link
+ */
+#define _fna_pack_link(_link, _from, _from_len, _from_ori, _to, _to_len, _to_ori, _cigar, _cigar_len) ({ \
+	(_link)->s.link.from = (_from); \
+	(_link)->s.link.from_len = (_from_len); \
+	(_link)->s.link.from_ori = (_from_ori); \
+	(_link)->s.link.to = (_to); \
+	(_link)->s.link.to_len = (_to_len); \
+	(_link)->s.link.to_ori = (_to_ori); \
+	(_link)->s.link.cigar = (_cigar); \
+	(_link)->s.link.cigar_len = (_cigar_len); \
+	(_link); \
+})
+
+/**
+ * @val ascii_table, alpha_table, delim_space
+ */
+#define LIM_UNLIMITED		( INT64_MAX )
+#define DELIM_TERM			( 1 )
 
+/* non-printable, first 32 elements of the ASCII table */
+#define _non_printable(n) \
+	(n),(n),(n),(n), (n),(n),(n),(n), (n),(n),(n),(n), (n),(n),(n),(n), \
+	(n),(n),(n),(n), (n),(n),(n),(n), (n),(n),(n),(n), (n),(n),(n),(n)
 
-/* unittest for parse_version_string */
-unittest()
+static
+uint8_t const delim_space[256] = {
+	['\0'] = DELIM_TERM,
+	[' '] = DELIM_TERM,
+	['\t'] = DELIM_TERM,
+	['\v'] = DELIM_TERM,
+	[0xff] = 0xff
+};
+/**
+ * @struct fna_delim_s
+ * @brief delimiter table and its compact form for the vectorized scanners.
+ * nonzero entries in table are delimiters; DELIM_TERM terminates the field and
+ * other nonzero values are skipped. ctrl and c must cover exactly the nonzero
+ * entries: ctrl marks 0x00 - 0x1f as a whole and c lists the rest (0xff is
+ * always included as the sentinel, c is padded with 0xff). control chars are
+ * always skipped and the chars in c are always terminal when ctrl is set.
+ */
+struct fna_delim_s {
+	uint8_t table[256];
+	uint8_t ctrl;
+	uint8_t c[3];
+};
+
+#if !FNA_KERNEL_ONLY
+static
+struct fna_delim_s const delim_line = {
+	.table = {
+		['\r'] = DELIM_TERM,
+		['\n'] = DELIM_TERM,
+		[0xff] = 0xff
+	},
+	.ctrl = 0,
+	.c = { '\r', '\n', 0xff }
+};
+static
+struct fna_delim_s const delim_fasta_fastq_name = {
+	.table = {
+		[' '] = DELIM_TERM,
+		['\r'] = DELIM_TERM,
+		['\n'] = DELIM_TERM,
+		[0xff] = 0xff
+	},
+	.ctrl = 0,
+	.c = { ' ', '\r', '\n' }
+};
+static
+struct fna_delim_s const delim_fasta_seq = {
+	.table = {
+		_non_printable(2),
+		['>'] = DELIM_TERM,
+		[0xff] = 0xff
+	},
+	.ctrl = 1,
+	.c = { '>', 0xff, 0xff }
+};
+static
+struct fna_delim_s const delim_fastq_seq = {
+	.table = {
+		_non_printable(2),
+		['+'] = DELIM_TERM,
+		[0xff] = 0xff
+	},
+	.ctrl = 1,
+	.c = { '+', 0xff, 0xff }
+};
+static
+struct fna_delim_s const delim_fastq_qual = {
+	.table = {
+		_non_printable(2),
+		[0xff] = 0xff
+	},
+	.ctrl = 1,
+	.c = { 0xff, 0xff, 0xff }
+};
+static
+struct fna_delim_s const delim_fastq_tail = {
+	.table = {
+		_non_printable(2),
+		['@'] = DELIM_TERM,
+		[0xff] = 0xff
+	},
+	.ctrl = 1,
+	.c = { '@', 0xff, 0xff }
+};
+static
+struct fna_delim_s const delim_gfa_field = {
+	.table = {
+		['\t'] = DELIM_TERM,
+		['\r'] = DELIM_TERM,
+		['\n'] = DELIM_TERM,
+		[0xff] = 0xff
+	},
+	.ctrl = 0,
+	.c = { '\t', '\r', '\n' }
+};
+static
+struct fna_delim_s const delim_gfa_step = {
+	.table = {
+		['\t'] = DELIM_TERM,
+		['\n'] = DELIM_TERM,
+		[','] = DELIM_TERM,
+		[0xff] = 0xff
+	},
+	.ctrl = 0,
+	.c = { '\t', '\n', ',' }
+};
+#endif
+
+/**
+ * @fn fna_buf_fill
+ * @brief refill the window when it is exhausted, returns the number of bytes available
+ * (zero when the stream reached the end). the byte at fna->t is always the sentinel
+ * so that the scanners below need no bound checks.
+ */
+static _force_inline
+int64_t fna_buf_fill(
+	struct fna_context_s *fna)
 {
-	#define assert_parse_version_string(_str, _num) \
-		assert(fna_parse_version_string(_str) == (_num), \
-			"%u", \
-			fna_parse_version_string(_str));
+	if(fna->p < fna->t) { return(fna->t - fna->p); }
+	if(fna->eof != 0) { return(0); }
 
-	assert_parse_version_string("0.0.0", 0x000000);
-	assert_parse_version_string("0.0.1", 0x000001);
-	assert_parse_version_string("0.1.0", 0x000100);
-	assert_parse_version_string("1.2.3", 0x010203);
-	assert_parse_version_string("100.200.50", 0x64c832);
-	assert_parse_version_string("0.0.01", 0x000001);
-	assert_parse_version_string("0.0.10", 0x00000a);
-	assert_parse_version_string("0.0.15", 0x00000f);
+	int64_t len = fna->fill(fna);
+	debug("fill, len(%lld)", len);
+	fna->pos += len;
 
-	#undef assert_parse_version_string
+	memset(fna->t, FNA_BUF_SENTINEL, FNA_BUF_MARGIN);
+	if(len == 0) { fna->eof = 1; }
+	return(len);
 }
 
 /**
- * fails when failed to open file
+ * @fn fna_buf_eof
  */
-unittest()
+static _force_inline
+int fna_buf_eof(
+	struct fna_context_s *fna)
 {
-	char const *fasta_filename = "test.fa";
-
-	remove(fasta_filename);
-	fna_t *fna = fna_init(fasta_filename, NULL);
-	assert(fna == NULL);
+	return(fna->p >= fna->t && fna->eof != 0);
 }
 
 /**
- * basic FASTA parsing
+ * @fn fna_buf_getc
  */
-unittest()
+static _force_inline
+int fna_buf_getc(
+	struct fna_context_s *fna)
 {
-	/**
-	 * create file
-	 * test0: valid FASTA format
-	 * test1: a space in header
-	 * test2: two spaces in header and two \n's between header and content
-	 */
-	char const *fasta_filename = "test_fna.fa";
-	char const *fasta_content =
-		">test0\nAAAA\n"
-		"> test1\nATAT\nCGCG\n"
-		">  test2\n\nAAAA\n"
-		">\ttest3 \tcomment   \nACGT";
-	assert(fdump(fasta_filename, fasta_content));
-	assert(fcmp(fasta_filename, strlen(fasta_content), (uint8_t const *)fasta_content));
+	if(fna->p >= fna->t && fna_buf_fill(fna) == 0) {
+		return(EOF);
+	}
+	return(*fna->p++);
+}
 
-	fna_t *fna = fna_init(fasta_filename, NULL);
-	assert(fna != NULL, "fna(%p)", fna);
+/**
+ * @fn fna_buf_scan
+ * @brief returns a pointer to the first byte whose delim type is nonzero,
+ * never goes beyond fna->t thanks to the sentinel. the vectorized variants
+ * may read up to 63 bytes past the sentinel, which FNA_BUF_MARGIN covers.
+ */
+#if defined(__AVX512BW__)
 
-	/* format detection (internal) */
-	assert(fna->file_format == FNA_FASTA, "fna->file_format(%d)", fna->file_format);
+static _force_inline
+uint8_t const *fna_buf_scan(
+	struct fna_delim_s const *delim,
+	uint8_t const *p)
+{
+	__m512i const th = _mm512_set1_epi8(0x1f);
+	__m512i const c0 = _mm512_set1_epi8(delim->c[0]);
+	__m512i const c1 = _mm512_set1_epi8(delim->c[1]);
+	__m512i const c2 = _mm512_set1_epi8(delim->c[2]);
+	__m512i const ff = _mm512_set1_epi8(0xff);
+	__mmask64 const ctrl = delim->ctrl ? ~0ULL : 0ULL;
 
-	/* test0 */
-	fna_seq_t *seq = fna_read(fna);
-	assert(strcmp(seq->s.segment.name.ptr, "test0") == 0, "name(%s)", seq->s.segment.name.ptr);
-	assert(strcmp(seq->s.segment.comment.ptr, "") == 0, "comment(%s)", seq->s.segment.comment.ptr);
-	assert(strcmp((char const *)seq->s.segment.seq.ptr, "AAAA") == 0, "seq(%s)", (char const *)seq->s.segment.seq.ptr);
-	assert(seq->s.segment.seq.len == 4, "len(%lld)", seq->s.segment.seq.len);
-	fna_seq_free(seq);
+	while(1) {
+		__m512i const x = _mm512_loadu_si512((__m512i const *)p);
+		__mmask64 m = (ctrl & _mm512_cmple_epu8_mask(x, th))
+			| _mm512_cmpeq_epi8_mask(x, c0)
+			| _mm512_cmpeq_epi8_mask(x, c1)
+			| _mm512_cmpeq_epi8_mask(x, c2)
+			| _mm512_cmpeq_epi8_mask(x, ff);
+		if(m != 0) { return(p + __builtin_ctzll(m)); }
+		p += 64;
+	}
+}
 
-	/* test1 */
-	seq = fna_read(fna);
-	assert(strcmp(seq->s.segment.name.ptr, "test1") == 0, "name(%s)", seq->s.segment.name.ptr);
-	assert(strcmp(seq->s.segment.comment.ptr, "") == 0, "comment(%s)", seq->s.segment.comment.ptr);
-	assert(strcmp((char const *)seq->s.segment.seq.ptr, "ATATCGCG") == 0, "seq(%s)", (char const *)seq->s.segment.seq.ptr);
-	assert(seq->s.segment.seq.len == 8, "len(%lld)", seq->s.segment.seq.len);
-	fna_seq_free(seq);
+#elif defined(__AVX2__)
 
-	/* test2 */
+static _force_inline
+uint8_t const *fna_buf_scan(
+	struct fna_delim_s const *delim,
+	uint8_t const *p)
+{
+	__m256i const th = _mm256_set1_epi8(0x1f);
+	__m256i const c0 = _mm256_set1_epi8(delim->c[0]);
+	__m256i const c1 = _mm256_set1_epi8(delim->c[1]);
+	__m256i const c2 = _mm256_set1_epi8(delim->c[2]);
+	__m256i const ff = _mm256_set1_epi8(0xff);
+	__m256i const ctrl = _mm256_set1_epi8(delim->ctrl ? 0xff : 0x00);
+
+	while(1) {
+		__m256i const x = _mm256_loadu_si256((__m256i const *)p);
+		__m256i const m = _mm256_or_si256(
+			_mm256_or_si256(
+				_mm256_and_si256(ctrl, _mm256_cmpeq_epi8(_mm256_min_epu8(x, th), x)),
+				_mm256_cmpeq_epi8(x, c0)),
+			_mm256_or_si256(
+				_mm256_or_si256(_mm256_cmpeq_epi8(x, c1), _mm256_cmpeq_epi8(x, c2)),
+				_mm256_cmpeq_epi8(x, ff)));
+		uint32_t const mask = _mm256_movemask_epi8(m);
+		if(mask != 0) { return(p + __builtin_ctz(mask)); }
+		p += 32;
+	}
+}
+
+#elif defined(__SSE2__)
+
+static _force_inline
+uint8_t const *fna_buf_scan(
+	struct fna_delim_s const *delim,
+	uint8_t const *p)
+{
+	__m128i const th = _mm_set1_epi8(0x1f);
+	__m128i const c0 = _mm_set1_epi8(delim->c[0]);
+	__m128i const c1 = _mm_set1_epi8(delim->c[1]);
+	__m128i const c2 = _mm_set1_epi8(delim->c[2]);
+	__m128i const ff = _mm_set1_epi8(0xff);
+	__m128i const ctrl = _mm_set1_epi8(delim->ctrl ? 0xff : 0x00);
+
+	while(1) {
+		__m128i const x = _mm_loadu_si128((__m128i const *)p);
+		__m128i const m = _mm_or_si128(
+			_mm_or_si128(
+				_mm_and_si128(ctrl, _mm_cmpeq_epi8(_mm_min_epu8(x, th), x)),
+				_mm_cmpeq_epi8(x, c0)),
+			_mm_or_si128(
+				_mm_or_si128(_mm_cmpeq_epi8(x, c1), _mm_cmpeq_epi8(x, c2)),
+				_mm_cmpeq_epi8(x, ff)));
+		uint32_t const mask = _mm_movemask_epi8(m);
+		if(mask != 0) { return(p + __builtin_ctz(mask)); }
+		p += 16;
+	}
+}
+
+#else
+
+static _force_inline
+uint8_t const *fna_buf_scan(
+	struct fna_delim_s const *delim,
+	uint8_t const *p)
+{
+	while(1) {
+		if(delim->table[p[0]] != 0) { return(p); }
+		if(delim->table[p[1]] != 0) { return(p + 1); }
+		if(delim->table[p[2]] != 0) { return(p + 2); }
+		if(delim->table[p[3]] != 0) { return(p + 3); }
+		p += 4;
+	}
+}
+
+#endif
+
+/**
+ * @fn fna_buf_count
+ * @brief returns a pointer to the first terminal byte (DELIM_TERM or the sentinel) and
+ * adds the number of skipped (non-terminal delimiter) bytes before it to *skip. for
+ * delims with ctrl set only, where the skipped ones are exactly the control chars.
+ * reads past the sentinel in the same way as fna_buf_scan.
+ */
+#if defined(__AVX512BW__)
+
+static _force_inline
+uint8_t const *fna_buf_count(
+	struct fna_delim_s const *delim,
+	uint8_t const *p,
+	int64_t *skip)
+{
+	__m512i const th = _mm512_set1_epi8(0x1f);
+	__m512i const c0 = _mm512_set1_epi8(delim->c[0]);
+	__m512i const c1 = _mm512_set1_epi8(delim->c[1]);
+	__m512i const c2 = _mm512_set1_epi8(delim->c[2]);
+	__m512i const ff = _mm512_set1_epi8(0xff);
+	int64_t cnt = *skip;
+
+	while(1) {
+		__m512i const x = _mm512_loadu_si512((__m512i const *)p);
+		uint64_t const s = _mm512_cmple_epu8_mask(x, th);
+		uint64_t const m = _mm512_cmpeq_epi8_mask(x, c0)
+			| _mm512_cmpeq_epi8_mask(x, c1)
+			| _mm512_cmpeq_epi8_mask(x, c2)
+			| _mm512_cmpeq_epi8_mask(x, ff);
+		if(m != 0) {
+			*skip = cnt + __builtin_popcountll(s & ((m & -m) - 1));
+			return(p + __builtin_ctzll(m));
+		}
+		cnt += __builtin_popcountll(s);
+		p += 64;
+	}
+}
+
+#elif defined(__AVX2__)
+
+static _force_inline
+uint8_t const *fna_buf_count(
+	struct fna_delim_s const *delim,
+	uint8_t const *p,
+	int64_t *skip)
+{
+	__m256i const th = _mm256_set1_epi8(0x1f);
+	__m256i const c0 = _mm256_set1_epi8(delim->c[0]);
+	__m256i const c1 = _mm256_set1_epi8(delim->c[1]);
+	__m256i const c2 = _mm256_set1_epi8(delim->c[2]);
+	__m256i const ff = _mm256_set1_epi8(0xff);
+	int64_t cnt = *skip;
+
+	while(1) {
+		__m256i const x = _mm256_loadu_si256((__m256i const *)p);
+		uint32_t const s = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(x, th), x));
+		uint32_t const m = _mm256_movemask_epi8(_mm256_or_si256(
+			_mm256_or_si256(_mm256_cmpeq_epi8(x, c0), _mm256_cmpeq_epi8(x, c1)),
+			_mm256_or_si256(_mm256_cmpeq_epi8(x, c2), _mm256_cmpeq_epi8(x, ff))));
+		if(m != 0) {
+			*skip = cnt + __builtin_popcount(s & ((m & -m) - 1));
+			return(p + __builtin_ctz(m));
+		}
+		cnt += __builtin_popcount(s);
+		p += 32;
+	}
+}
+
+#elif defined(__SSE2__)
+
+static _force_inline
+uint8_t const *fna_buf_count(
+	struct fna_delim_s const *delim,
+	uint8_t const *p,
+	int64_t *skip)
+{
+	__m128i const th = _mm_set1_epi8(0x1f);
+	__m128i const c0 = _mm_set1_epi8(delim->c[0]);
+	__m128i const c1 = _mm_set1_epi8(delim->c[1]);
+	__m128i const c2 = _mm_set1_epi8(delim->c[2]);
+	__m128i const ff = _mm_set1_epi8(0xff);
+	int64_t cnt = *skip;
+
+	while(1) {
+		__m128i const x = _mm_loadu_si128((__m128i const *)p);
+		uint32_t const s = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(x, th), x));
+		uint32_t const m = _mm_movemask_epi8(_mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(x, c0), _mm_cmpeq_epi8(x, c1)),
+			_mm_or_si128(_mm_cmpeq_epi8(x, c2), _mm_cmpeq_epi8(x, ff))));
+		if(m != 0) {
+			*skip = cnt + __builtin_popcount(s & ((m & -m) - 1));
+			return(p + __builtin_ctz(m));
+		}
+		cnt += __builtin_popcount(s);
+		p += 16;
+	}
+}
+
+#else
+
+static _force_inline
+uint8_t const *fna_buf_count(
+	struct fna_delim_s const *delim,
+	uint8_t const *p,
+	int64_t *skip)
+{
+	int64_t cnt = *skip;
+	while((delim->table[*p] & DELIM_TERM) == 0) {
+		cnt += delim->table[*p] != 0;
+		p++;
+	}
+	*skip = cnt;
+	return(p);
+}
+
+#endif
+
+/**
+ * @fn fna_kv_expand
+ * @brief make room for len bytes at the tail of v, returns a pointer to the tail
+ */
+static _force_inline
+uint8_t *fna_kv_expand(
+	struct fna_context_s *fna,
+	lmm_kvec_uint8_t *v,
+	uint64_t len)
+{
+	if(lmm_kv_size(*v) + len > lmm_kv_max(*v)) {
+		lmm_kv_reserve(fna->lmm, *v, MAX2(2 * lmm_kv_max(*v), lmm_kv_size(*v) + len));
+	}
+	return(lmm_kv_ptr(*v) + lmm_kv_size(*v));
+}
+
+/**
+ * @fn fna_seq_make_margin
+ */
+static _force_inline
+void fna_seq_make_margin(
+	struct fna_context_s *fna,
+	lmm_kvec_uint8_t *v,
+	int64_t len)
+{
+	memset(fna_kv_expand(fna, v, len), 0, len);
+	lmm_kv_size(*v) += len;
+	return;
+}
+
+/**
+ * @fn fna_parse_version_string
+ * @brief parse version string in ("%d.%d.%d", major, minor, patch) format,
+ * return 0x10000 * major + 0x100 * minor + patch
+ */
+static _force_inline
+uint64_t fna_parse_version_string(
+	char const *str)
+{
+	char buf[256];
+	uint64_t v[3] = { 0, 0, 0 };
+
+	for(int64_t i = 0; i < 3; i++) {
+		int64_t j = 0;
+		while(*str != '\0') {
+			if(*str == '.') { break; }
+			buf[j++] = *str++;
+		}
+		buf[j] = '\0';
+		v[i] = (uint64_t)strtoll(buf, NULL, 10);
+		if(*str++ == '\0') { break; }
+	}
+
+	return(0x10000 * v[0] + 0x100 * v[1] + v[2]);
+}
+
+/**
+ * @fn fna_read_ascii
+ * @brief read ascii until delim, push '\0' terminator
+ */
+static _force_inline
+struct fna_read_ret_s fna_read_ascii(
+	struct fna_context_s *fna,
+	lmm_kvec_uint8_t *v,
+	struct fna_delim_s const *delim)
+{
+	int64_t len = 0;
+	int c;
+
+	/* strip spaces at the head */
+	while(delim_space[(uint8_t)(c = fna_buf_getc(fna))] == 1) {
+		debug("%c, %d", c, c);
+	}
+	if(c == EOF) {
+		debug("reached eof");
+		lmm_kv_push(fna->lmm, *v, '\0');
+		return((struct fna_read_ret_s){
+			.len = len,
+			.c = (char)EOF
+		});
+	}
+
+	/* read line until delim, the first char is always pushed */
+	debug("%c, %d", c, c);
+	lmm_kv_push(fna->lmm, *v, c); len++;
+	while(1) {
+		uint8_t const *p = fna->p;
+		uint8_t const *q = fna_buf_scan(delim, p);
+
+		/* copy span */
+		memcpy(fna_kv_expand(fna, v, q - p), p, q - p);
+		lmm_kv_size(*v) += q - p; len += q - p;
+		fna->p = (uint8_t *)q;
+
+		if(q < fna->t) { c = *fna->p++; break; }
+		if(fna_buf_fill(fna) == 0) { c = EOF; break; }
+	}
+	char cret = (char)c;
+
+	/* strip spaces at the tail */
+	while(len > 0 && delim_space[lmm_kv_at(*v, lmm_kv_size(*v) - 1)] == 1) {
+		lmm_kv_size(*v)--; len--;
+	}
+
+	lmm_kv_push(fna->lmm, *v, '\0');		/* push null terminator */
+	debug("finished, len(%lld)", len);
+	return((struct fna_read_ret_s){
+		.len = len,
+		.c = cret
+	});
+}
+
+/**
+ * @fn fna_read_skip
+ * @brief skip until delim or lim non-delim chars
+ */
+static _force_inline
+struct fna_read_ret_s fna_read_skip(
+	struct fna_context_s *fna,
+	struct fna_delim_s const *delim,
+	int64_t lim)
+{
+	int c = 0;
+	int64_t len = 0;
+	int64_t rem = MAX2(lim, 1);		/* at least one char is consumed */
+	while(1) {
+		uint8_t const *p = fna->p;
+		uint8_t const *q = fna_buf_scan(delim, p);
+		debug("len(%lld), rem(%lld), span(%lld)", len, rem, q - p);
+
+		if(q - p >= rem) {
+			fna->p += rem; len += rem;
+			c = p[rem - 1];
+			break;
+		}
+		len += q - p; rem -= q - p;
+		fna->p = (uint8_t *)q;
+
+		if(q < fna->t) {
+			c = *fna->p++;
+			if(delim->table[(uint8_t)c] & DELIM_TERM) { break; }
+			continue;
+		}
+		if(fna_buf_fill(fna) == 0) { c = EOF; break; }
+	}
+	return((struct fna_read_ret_s){
+		.len = len,
+		.c = (char)c
+	});
+}
+
+/**
+ * @fn fna_read_count
+ * @brief skip until a terminal delim and count non-delim chars; same as fna_read_skip
+ * without limit, but never stops at skipped delims (line breaks) on the way. delim->ctrl
+ * must be set.
+ */
+static _force_inline
+struct fna_read_ret_s fna_read_count(
+	struct fna_context_s *fna,
+	struct fna_delim_s const *delim)
+{
+	int c = 0;
+	int64_t len = 0;
+	while(1) {
+		uint8_t const *p = fna->p;
+		int64_t skip = 0;
+		uint8_t const *q = fna_buf_count(delim, p, &skip);
+		debug("len(%lld), span(%lld), skip(%lld)", len, q - p, skip);
+
+		len += (q - p) - skip;
+		fna->p = (uint8_t *)q;
+
+		if(q < fna->t) { c = *fna->p++; break; }
+		if(fna_buf_fill(fna) == 0) { c = EOF; break; }
+	}
+	return((struct fna_read_ret_s){
+		.len = len,
+		.c = (char)c
+	});
+}
+
+/**
+ * @fn fna_encode_2bit
+ * @brief mapping IUPAC amb. to 2bit encoding
+ */
+static _force_inline
+uint8_t fna_encode_2bit(
+	int c)
+{
+	/* convert to upper case and subtract offset by 0x40 */
+	#define _b(x)	( (x) & 0x1f )
+
+	/* conversion tables */
+	enum bases {
+		A = 0x00, C = 0x01, G = 0x02, T = 0x03
+	};
+	static uint8_t const table[] = {
+		[_b('A')] = A,
+		[_b('C')] = C,
+		[_b('G')] = G,
+		[_b('T')] = T,
+		[_b('U')] = T,
+		[_b('N')] = A,		/* treat 'N' as 'A' */
+		[_b('_')] = 0		/* sentinel */
+	};
+	return(table[_b((uint8_t)c)]);
+
+	#undef _b
+}
+
+/**
+ * @fn fna_encode_4bit
+ * @brief mapping IUPAC amb. to 4bit encoding
+ */
+static _force_inline
+uint8_t fna_encode_4bit(
+	int c)
+{
+	/* convert to upper case and subtract offset by 0x40 */
+	#define _b(x)	( (x) & 0x1f )
+
+	/* conversion tables */
+	enum bases {
+		A = 0x01, C = 0x02, G = 0x04, T = 0x08
+	};
+	static uint8_t const table[] = {
+		[_b('A')] = A,
+		[_b('C')] = C,
+		[_b('G')] = G,
+		[_b('T')] = T,
+		[_b('U')] = T,
+		[_b('R')] = A | G,
+		[_b('Y')] = C | T,
+		[_b('S')] = G | C,
+		[_b('W')] = A | T,
+		[_b('K')] = G | T,
+		[_b('M')] = A | C,
+		[_b('B')] = C | G | T,
+		[_b('D')] = A | G | T,
+		[_b('H')] = A | C | T,
+		[_b('V')] = A | C | G,
+		[_b('N')] = 0,		/* treat 'N' as a gap */
+		[_b('_')] = 0		/* sentinel */
+	};
+	return(table[_b((uint8_t)c)]);
+
+	#undef _b
+}
+
+/**
+ * @fn fna_encoded_size
+ * @brief number of bytes a seq of len bases occupies in a record, including the
+ * terminator (FNA_ASCII) or the flushed last byte (packed encodings)
+ */
+static _force_inline
+int64_t fna_encoded_size(
+	int encode,
+	int64_t len)
+{
+	switch(encode) {
+		case FNA_ASCII: return(len + 1);
+		case FNA_2BIT: return(len);
+		case FNA_2BITPACKED: return(len / 4 + 1);
+		case FNA_4BIT: return(len);
+		case FNA_4BITPACKED: return(len / 2 + 1);
+	}
+	return(len + 1);
+}
+
+/**
+ * @fn fna_encoded_bits
+ * @brief bits a base occupies in the encoding
+ */
+static _force_inline
+int64_t fna_encoded_bits(
+	int encode)
+{
+	return((encode == FNA_2BITPACKED) ? 2 : (encode == FNA_4BITPACKED) ? 4 : 8);
+}
+
+/**
+ * @fn fna_revcomp_room
+ * @brief bytes FNA_EMIT_REVCOMP adds after a seq of len bases: the reverse strand, and its
+ * copy built past the end when it does not start at a byte boundary (packed encodings)
+ */
+static _force_inline
+int64_t fna_revcomp_room(
+	int encode,
+	int64_t len)
+{
+	int64_t const fw = fna_encoded_size(encode, len);
+	int64_t const rc = fna_encoded_size(encode, 2 * len) - fw;
+	return((((len * fna_encoded_bits(encode)) & 7) == 0) ? rc : rc + fw);
+}
+
+/**
+ * @fn fna_seq_reserve
+ * @brief make room at once for len more bases of seq, after done bases already in v, and the rest
+ * of the record (the tail margins and the qual terminator), plus the block the compaction kernel
+ * works in. with FNA_EMIT_REVCOMP the reverse strand of all of them is included.
+ */
+static _force_inline
+void fna_seq_reserve(
+	struct fna_context_s *fna,
+	lmm_kvec_uint8_t *v,
+	int encode,
+	int64_t done,
+	int64_t len)
+{
+	int64_t const size = lmm_kv_size(*v) + fna_encoded_size(encode, len)
+		+ fna->seq_tail_margin + 1 + fna->tail_margin
+		+ FNA_COMPACT_MAX_BLOCK + FNA_BUF_MARGIN
+		+ ((fna->options & FNA_EMIT_REVCOMP) ? fna_revcomp_room(encode, done + len) : 0);
+	lmm_kv_reserve(fna->lmm, *v, size);
+	return;
+}
+
+/**
+ * @fn fna_encode_2bit_vec, fna_pack_2bit_vec
+ * @brief vectorized fna_encode_2bit; the pack variant also packs four bases into
+ * a byte (first base at the least significant bits) with pmaddubsw / pmaddwd.
+ * both process len rounded down to the vector width and return the number of
+ * bases consumed. dst may be equal to src.
+ */
+#if defined(__AVX512VBMI__)
+
+/* vpermb looks at the lower 6 bits, so the 32-entry table is repeated twice */
+#define _e2(x)		( (x) == 1 ? 0 : (x) == 3 ? 1 : (x) == 7 ? 2 : (x) == 20 || (x) == 21 ? 3 : 0 )
+#define _e2x4(x)	_e2(x), _e2(x + 1), _e2(x + 2), _e2(x + 3)
+#define _e2x32(x)	_e2x4(x), _e2x4(x + 4), _e2x4(x + 8), _e2x4(x + 12), _e2x4(x + 16), _e2x4(x + 20), _e2x4(x + 24), _e2x4(x + 28)
+static
+uint8_t const encode_2bit_table[64] __attribute__(( aligned(64) )) = {
+	_e2x32(0), _e2x32(0)
+};
+#undef _e2
+#undef _e2x4
+#undef _e2x32
+
+static _force_inline
+__m512i fna_encode_2bit_v64(
+	__m512i x)
+{
+	return(_mm512_permutexvar_epi8(x, _mm512_load_si512((__m512i const *)encode_2bit_table)));
+}
+
+static _force_inline
+int64_t fna_encode_2bit_vec(
+	uint8_t *dst,
+	uint8_t const *src,
+	int64_t len)
+{
+	int64_t i = 0;
+	for(; i + 64 <= len; i += 64) {
+		__m512i const x = _mm512_loadu_si512((__m512i const *)&src[i]);
+		_mm512_storeu_si512((__m512i *)&dst[i], fna_encode_2bit_v64(x));
+	}
+	return(i);
+}
+
+static _force_inline
+int64_t fna_pack_2bit_vec(
+	uint8_t *dst,
+	uint8_t const *src,
+	int64_t len)
+{
+	int64_t i = 0;
+	for(; i + 64 <= len; i += 64) {
+		__m512i const x = fna_encode_2bit_v64(_mm512_loadu_si512((__m512i const *)&src[i]));
+		__m512i const w = _mm512_maddubs_epi16(x, _mm512_set1_epi16(0x0401));
+		__m512i const d = _mm512_madd_epi16(w, _mm512_set1_epi32(0x00100001));
+		_mm_storeu_si128((__m128i *)&dst[i / 4], _mm512_cvtepi32_epi8(d));
+	}
+	return(i);
+}
+
+#elif defined(__SSSE3__)
+
+/* pshufb looks at the lower 4 bits; (c & 0x1f) < 16 and >= 16 are looked up separately */
+#define _encode_2bit_lo		0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0		/* A, C, G, N */
+#define _encode_2bit_hi		0, 0, 0, 0, 3, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0		/* T, U */
+
+static _force_inline
+__m128i fna_encode_2bit_v16(
+	__m128i x)
+{
+	x = _mm_and_si128(x, _mm_set1_epi8(0x1f));
+	__m128i const hi = _mm_cmpgt_epi8(x, _mm_set1_epi8(0x0f));
+	return(_mm_or_si128(
+		_mm_andnot_si128(hi, _mm_shuffle_epi8(_mm_setr_epi8(_encode_2bit_lo), x)),
+		_mm_and_si128(hi, _mm_shuffle_epi8(_mm_setr_epi8(_encode_2bit_hi), x))));
+}
+
+#if defined(__AVX2__)
+static _force_inline
+__m256i fna_encode_2bit_v32(
+	__m256i x)
+{
+	x = _mm256_and_si256(x, _mm256_set1_epi8(0x1f));
+	__m256i const hi = _mm256_cmpgt_epi8(x, _mm256_set1_epi8(0x0f));
+	return(_mm256_or_si256(
+		_mm256_andnot_si256(hi, _mm256_shuffle_epi8(_mm256_setr_epi8(_encode_2bit_lo, _encode_2bit_lo), x)),
+		_mm256_and_si256(hi, _mm256_shuffle_epi8(_mm256_setr_epi8(_encode_2bit_hi, _encode_2bit_hi), x))));
+}
+#endif
+
+static _force_inline
+int64_t fna_encode_2bit_vec(
+	uint8_t *dst,
+	uint8_t const *src,
+	int64_t len)
+{
+	int64_t i = 0;
+	#if defined(__AVX2__)
+		for(; i + 32 <= len; i += 32) {
+			__m256i const x = _mm256_loadu_si256((__m256i const *)&src[i]);
+			_mm256_storeu_si256((__m256i *)&dst[i], fna_encode_2bit_v32(x));
+		}
+	#else
+		for(; i + 16 <= len; i += 16) {
+			__m128i const x = _mm_loadu_si128((__m128i const *)&src[i]);
+			_mm_storeu_si128((__m128i *)&dst[i], fna_encode_2bit_v16(x));
+		}
+	#endif
+	return(i);
+}
+
+static _force_inline
+int64_t fna_pack_2bit_vec(
+	uint8_t *dst,
+	uint8_t const *src,
+	int64_t len)
+{
+	int64_t i = 0;
+	#if defined(__AVX2__)
+		for(; i + 32 <= len; i += 32) {
+			__m256i const x = fna_encode_2bit_v32(_mm256_loadu_si256((__m256i const *)&src[i]));
+			__m256i const w = _mm256_maddubs_epi16(x, _mm256_set1_epi16(0x0401));
+			__m256i const d = _mm256_madd_epi16(w, _mm256_set1_epi32(0x00100001));
+			__m256i const p = _mm256_shuffle_epi8(d, _mm256_setr_epi8(
+				0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+				0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1));
+			_mm_storel_epi64((__m128i *)&dst[i / 4], _mm_unpacklo_epi32(
+				_mm256_castsi256_si128(p), _mm256_extracti128_si256(p, 1)));
+		}
+	#else
+		for(; i + 16 <= len; i += 16) {
+			__m128i const x = fna_encode_2bit_v16(_mm_loadu_si128((__m128i const *)&src[i]));
+			__m128i const w = _mm_maddubs_epi16(x, _mm_set1_epi16(0x0401));
+			__m128i const d = _mm_madd_epi16(w, _mm_set1_epi32(0x00100001));
+			__m128i const p = _mm_shuffle_epi8(d, _mm_setr_epi8(
+				0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1));
+			int32_t const b = _mm_cvtsi128_si32(p);
+			memcpy(&dst[i / 4], &b, sizeof(int32_t));
+		}
+	#endif
+	return(i);
+}
+
+#undef _encode_2bit_lo
+#undef _encode_2bit_hi
+
+#else
+
+static _force_inline
+int64_t fna_encode_2bit_vec(
+	uint8_t *dst,
+	uint8_t const *src,
+	int64_t len)
+{
+	return(0);
+}
+
+static _force_inline
+int64_t fna_pack_2bit_vec(
+	uint8_t *dst,
+	uint8_t const *src,
+	int64_t len)
+{
+	return(0);
+}
+
+#endif
+
+/**
+ * @fn fna_encode_4bit_vec, fna_pack_4bit_vec
+ * @brief vectorized fna_encode_4bit; the pack variant also packs two bases into
+ * a byte (first base at the lower nibble) with pmaddubsw. both process len rounded
+ * down to the vector width and return the number of bases consumed. dst may be
+ * equal to src.
+ */
+#if defined(__AVX512VBMI__)
+
+#define _e4(x) ( \
+	  (x) == 1 ? 0x01 : (x) == 2 ? 0x0e : (x) == 3 ? 0x02 : (x) == 4 ? 0x0d \
+	: (x) == 7 ? 0x04 : (x) == 8 ? 0x0b : (x) == 11 ? 0x0c : (x) == 13 ? 0x03 \
+	: (x) == 18 ? 0x05 : (x) == 19 ? 0x06 : (x) == 20 ? 0x08 : (x) == 21 ? 0x08 \
+	: (x) == 22 ? 0x07 : (x) == 23 ? 0x09 : (x) == 25 ? 0x0a : 0 )
+#define _e4x4(x)	_e4(x), _e4(x + 1), _e4(x + 2), _e4(x + 3)
+#define _e4x32(x)	_e4x4(x), _e4x4(x + 4), _e4x4(x + 8), _e4x4(x + 12), _e4x4(x + 16), _e4x4(x + 20), _e4x4(x + 24), _e4x4(x + 28)
+static
+uint8_t const encode_4bit_table[64] __attribute__(( aligned(64) )) = {
+	_e4x32(0), _e4x32(0)
+};
+#undef _e4
+#undef _e4x4
+#undef _e4x32
+
+static _force_inline
+__m512i fna_encode_4bit_v64(
+	__m512i x)
+{
+	return(_mm512_permutexvar_epi8(x, _mm512_load_si512((__m512i const *)encode_4bit_table)));
+}
+
+static _force_inline
+int64_t fna_encode_4bit_vec(
+	uint8_t *dst,
+	uint8_t const *src,
+	int64_t len)
+{
+	int64_t i = 0;
+	for(; i + 64 <= len; i += 64) {
+		__m512i const x = _mm512_loadu_si512((__m512i const *)&src[i]);
+		_mm512_storeu_si512((__m512i *)&dst[i], fna_encode_4bit_v64(x));
+	}
+	return(i);
+}
+
+static _force_inline
+int64_t fna_pack_4bit_vec(
+	uint8_t *dst,
+	uint8_t const *src,
+	int64_t len)
+{
+	int64_t i = 0;
+	for(; i + 64 <= len; i += 64) {
+		__m512i const x = fna_encode_4bit_v64(_mm512_loadu_si512((__m512i const *)&src[i]));
+		__m512i const w = _mm512_maddubs_epi16(x, _mm512_set1_epi16(0x1001));
+		_mm256_storeu_si256((__m256i *)&dst[i / 2], _mm512_cvtepi16_epi8(w));
+	}
+	return(i);
+}
+
+#elif defined(__SSSE3__)
+
+/* (c & 0x1f) < 16 and >= 16 are looked up separately as in the 2-bit encoder */
+#define _encode_4bit_lo		0, 0x01, 0x0e, 0x02, 0x0d, 0, 0, 0x04, 0x0b, 0, 0, 0x0c, 0, 0x03, 0, 0	/* A, B, C, D, G, H, K, M, N */
+#define _encode_4bit_hi		0, 0, 0x05, 0x06, 0x08, 0x08, 0x07, 0x09, 0, 0x0a, 0, 0, 0, 0, 0, 0		/* R, S, T, U, V, W, Y */
+
+static _force_inline
+__m128i fna_encode_4bit_v16(
+	__m128i x)
+{
+	x = _mm_and_si128(x, _mm_set1_epi8(0x1f));
+	__m128i const hi = _mm_cmpgt_epi8(x, _mm_set1_epi8(0x0f));
+	return(_mm_or_si128(
+		_mm_andnot_si128(hi, _mm_shuffle_epi8(_mm_setr_epi8(_encode_4bit_lo), x)),
+		_mm_and_si128(hi, _mm_shuffle_epi8(_mm_setr_epi8(_encode_4bit_hi), x))));
+}
+
+#if defined(__AVX2__)
+static _force_inline
+__m256i fna_encode_4bit_v32(
+	__m256i x)
+{
+	x = _mm256_and_si256(x, _mm256_set1_epi8(0x1f));
+	__m256i const hi = _mm256_cmpgt_epi8(x, _mm256_set1_epi8(0x0f));
+	return(_mm256_or_si256(
+		_mm256_andnot_si256(hi, _mm256_shuffle_epi8(_mm256_setr_epi8(_encode_4bit_lo, _encode_4bit_lo), x)),
+		_mm256_and_si256(hi, _mm256_shuffle_epi8(_mm256_setr_epi8(_encode_4bit_hi, _encode_4bit_hi), x))));
+}
+#endif
+
+static _force_inline
+int64_t fna_encode_4bit_vec(
+	uint8_t *dst,
+	uint8_t const *src,
+	int64_t len)
+{
+	int64_t i = 0;
+	#if defined(__AVX2__)
+		for(; i + 32 <= len; i += 32) {
+			__m256i const x = _mm256_loadu_si256((__m256i const *)&src[i]);
+			_mm256_storeu_si256((__m256i *)&dst[i], fna_encode_4bit_v32(x));
+		}
+	#else
+		for(; i + 16 <= len; i += 16) {
+			__m128i const x = _mm_loadu_si128((__m128i const *)&src[i]);
+			_mm_storeu_si128((__m128i *)&dst[i], fna_encode_4bit_v16(x));
+		}
+	#endif
+	return(i);
+}
+
+static _force_inline
+int64_t fna_pack_4bit_vec(
+	uint8_t *dst,
+	uint8_t const *src,
+	int64_t len)
+{
+	int64_t i = 0;
+	#if defined(__AVX2__)
+		for(; i + 32 <= len; i += 32) {
+			__m256i const x = fna_encode_4bit_v32(_mm256_loadu_si256((__m256i const *)&src[i]));
+			__m256i const w = _mm256_maddubs_epi16(x, _mm256_set1_epi16(0x1001));
+			__m256i const p = _mm256_permute4x64_epi64(_mm256_packus_epi16(w, w), 0x08);
+			_mm_storeu_si128((__m128i *)&dst[i / 2], _mm256_castsi256_si128(p));
+		}
+	#else
+		for(; i + 16 <= len; i += 16) {
+			__m128i const x = fna_encode_4bit_v16(_mm_loadu_si128((__m128i const *)&src[i]));
+			__m128i const w = _mm_maddubs_epi16(x, _mm_set1_epi16(0x1001));
+			_mm_storel_epi64((__m128i *)&dst[i / 2], _mm_packus_epi16(w, w));
+		}
+	#endif
+	return(i);
+}
+
+#undef _encode_4bit_lo
+#undef _encode_4bit_hi
+
+#else
+
+static _force_inline
+int64_t fna_encode_4bit_vec(
+	uint8_t *dst,
+	uint8_t const *src,
+	int64_t len)
+{
+	return(0);
+}
+
+static _force_inline
+int64_t fna_pack_4bit_vec(
+	uint8_t *dst,
+	uint8_t const *src,
+	int64_t len)
+{
+	return(0);
+}
+
+#endif
+
+/**
+ * @struct fna_pack_s
+ * @brief bases carried over to the next span in the packed encodings
+ */
+struct fna_pack_s {
+	uint64_t arr;
+	int64_t cnt;
+};
+
+/**
+ * @fn fna_encode_span
+ * @brief encode len bases at src into dst, returns the number of bytes written.
+ * dst may be equal to src (in-place encoding); dst must not be ahead of src otherwise.
+ */
+static _force_inline
+int64_t fna_encode_span(
+	uint8_t *dst,
+	uint8_t const *src,
+	int64_t len,
+	struct fna_pack_s *pack,
+	int encode)
+{
+	switch(encode) {
+		case FNA_ASCII: {
+			if(dst != src) { memcpy(dst, src, len); }
+			return(len);
+		}
+		case FNA_2BIT: {
+			for(int64_t i = fna_encode_2bit_vec(dst, src, len); i < len; i++) {
+				dst[i] = fna_encode_2bit(src[i]);
+			}
+			return(len);
+		}
+		case FNA_4BIT: {
+			for(int64_t i = fna_encode_4bit_vec(dst, src, len); i < len; i++) {
+				dst[i] = fna_encode_4bit(src[i]);
+			}
+			return(len);
+		}
+		case FNA_2BITPACKED: {
+			/* the first base comes at the least significant bits */
+			uint8_t *q = dst;
+			uint64_t arr = pack->arr;
+			int64_t cnt = pack->cnt;
+			int64_t i = 0;
+
+			/* flush bases carried over from the previous span */
+			for(; cnt != 0 && i < len; i++) {
+				arr |= fna_encode_2bit(src[i])<<(2 * cnt);
+				if(++cnt == 4) { *q++ = arr; arr = 0; cnt = 0; }
+			}
+
+			/* byte-aligned bulk */
+			if(cnt == 0) {
+				int64_t n = fna_pack_2bit_vec(q, &src[i], len - i);
+				q += n / 4; i += n;
+			}
+
+			for(; i < len; i++) {
+				arr |= fna_encode_2bit(src[i])<<(2 * cnt);
+				if(++cnt == 4) { *q++ = arr; arr = 0; cnt = 0; }
+			}
+			pack->arr = arr; pack->cnt = cnt;
+			return(q - dst);
+		}
+		case FNA_4BITPACKED: {
+			/* the first base comes at the lower nibble */
+			uint8_t *q = dst;
+			uint64_t arr = pack->arr;
+			int64_t cnt = pack->cnt;
+			int64_t i = 0;
+
+			if(cnt != 0 && i < len) {
+				*q++ = arr | (fna_encode_4bit(src[i++])<<4);
+				arr = 0; cnt = 0;
+			}
+			if(cnt == 0) {
+				int64_t n = fna_pack_4bit_vec(q, &src[i], len - i);
+				q += n / 2; i += n;
+			}
+			for(; i < len; i++) {
+				arr |= fna_encode_4bit(src[i])<<(4 * cnt);
+				if(++cnt == 2) { *q++ = arr; arr = 0; cnt = 0; }
+			}
+			pack->arr = arr; pack->cnt = cnt;
+			return(q - dst);
+		}
+	}
+	return(0);
+}
+
+/**
+ * @val compact_table
+ * @brief pshufb indices to left-pack the bytes selected by an 8-bit mask;
+ * the j-th byte of the i-th entry is the position of the j-th set bit of i.
+ */
+#define _pc8(m)				( ((m) & 1) + (((m)>>1) & 1) + (((m)>>2) & 1) + (((m)>>3) & 1) + (((m)>>4) & 1) + (((m)>>5) & 1) + (((m)>>6) & 1) + (((m)>>7) & 1) )
+#define _lp(m, i)			( (((m)>>(i)) & 1) * ((uint64_t)(i)<<(8 * _pc8((m) & ((1<<(i)) - 1)))) )
+#define _lp8(m)				( _lp(m, 0) | _lp(m, 1) | _lp(m, 2) | _lp(m, 3) | _lp(m, 4) | _lp(m, 5) | _lp(m, 6) | _lp(m, 7) )
+#define _lp8x4(m)			_lp8(m), _lp8(m + 1), _lp8(m + 2), _lp8(m + 3)
+#define _lp8x16(m)			_lp8x4(m), _lp8x4(m + 4), _lp8x4(m + 8), _lp8x4(m + 12)
+#define _lp8x64(m)			_lp8x16(m), _lp8x16(m + 16), _lp8x16(m + 32), _lp8x16(m + 48)
+
+#if !defined(__AVX512VBMI2__) && defined(__SSSE3__)
+static
+uint64_t const compact_table[256] = {
+	_lp8x64(0), _lp8x64(64), _lp8x64(128), _lp8x64(192)
+};
+#endif
+
+#undef _pc8
+#undef _lp
+#undef _lp8
+#undef _lp8x4
+#undef _lp8x16
+#undef _lp8x64
+
+/**
+ * @fn fna_buf_compact
+ * @brief copy chars in [src, src + ilen) to dst removing the skipped (control) chars.
+ * stops before the first terminal char or after olim chars are written.
+ * delim->ctrl must be set. dst needs FNA_BUF_MARGIN bytes of room beyond the output.
+ * returns a pointer to the first unconsumed char, *olen is set to the output length.
+ */
+static _force_inline
+uint8_t const *fna_buf_compact(
+	struct fna_delim_s const *delim,
+	uint8_t *dst,
+	int64_t *olen,
+	uint8_t const *src,
+	int64_t ilen,
+	int64_t olim)
+{
+	uint8_t *d = dst;
+	uint8_t const *t = src + ilen;
+
+#if defined(__AVX512VBMI2__)
+	__m512i const th = _mm512_set1_epi8(0x1f);
+	__m512i const c0 = _mm512_set1_epi8(delim->c[0]);
+	__m512i const c1 = _mm512_set1_epi8(delim->c[1]);
+	__m512i const c2 = _mm512_set1_epi8(delim->c[2]);
+	__m512i const ff = _mm512_set1_epi8(0xff);
+
+	while(t - src >= 64 && olim - (d - dst) >= 64) {
+		__m512i const x = _mm512_loadu_si512((__m512i const *)src);
+		__mmask64 const term = _mm512_cmpeq_epi8_mask(x, c0)
+			| _mm512_cmpeq_epi8_mask(x, c1)
+			| _mm512_cmpeq_epi8_mask(x, c2)
+			| _mm512_cmpeq_epi8_mask(x, ff);
+		if(term != 0) { break; }
+
+		__mmask64 const keep = _mm512_cmpgt_epu8_mask(x, th);
+		_mm512_mask_compressstoreu_epi8(d, keep, x);
+		d += __builtin_popcountll(keep); src += 64;
+	}
+
+#elif defined(__SSSE3__)
+	__m128i const th = _mm_set1_epi8(0x1f);
+	__m128i const c0 = _mm_set1_epi8(delim->c[0]);
+	__m128i const c1 = _mm_set1_epi8(delim->c[1]);
+	__m128i const c2 = _mm_set1_epi8(delim->c[2]);
+	__m128i const ff = _mm_set1_epi8(0xff);
+
+	while(t - src >= 16 && olim - (d - dst) >= 16) {
+		__m128i const x = _mm_loadu_si128((__m128i const *)src);
+		__m128i const term = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(x, c0), _mm_cmpeq_epi8(x, c1)),
+			_mm_or_si128(_mm_cmpeq_epi8(x, c2), _mm_cmpeq_epi8(x, ff)));
+		if(_mm_movemask_epi8(term) != 0) { break; }
+
+		uint32_t const keep = ~_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(x, th), x)) & 0xffff;
+		__m128i const y = _mm_shuffle_epi8(x, _mm_set_epi64x(
+			compact_table[keep>>8] + 0x0808080808080808,
+			compact_table[keep & 0xff]));
+		_mm_storel_epi64((__m128i *)d, y);
+		_mm_storel_epi64((__m128i *)(d + __builtin_popcount(keep & 0xff)), _mm_srli_si128(y, 8));
+		d += __builtin_popcount(keep); src += 16;
+	}
+
+#endif
+
+	/* tail, or the block containing a terminal char */
+	while(src < t && d - dst < olim) {
+		uint8_t const type = delim->table[*src];
+		if(type & DELIM_TERM) { break; }
+		if(type == 0) { *d++ = *src; }
+		src++;
+	}
+	*olen = d - dst;
+	return(src);
+}
+
+/**
+ * @fn fna_read_seq_compact
+ * @brief fna_read_seq_intl for delims with skipped control chars (multi-line fields).
+ * chars are compacted into the tail of v block by block and then encoded in place.
+ */
+static _force_inline
+struct fna_read_ret_s fna_read_seq_compact(
+	struct fna_context_s *fna,
+	lmm_kvec_uint8_t *v,
+	struct fna_pack_s *pack,
+	struct fna_delim_s const *delim,
+	int64_t lim,
+	int encode)
+{
+	int c = 0;
+	int64_t len = 0;
+	int64_t blk = FNA_COMPACT_MIN_BLOCK;
+	while(len < lim) {
+		/* a long field in the mapped window: count the rest and size v for it, instead of doubling */
+		if(fna->map_size != 0 && blk == FNA_COMPACT_MAX_BLOCK / 2) {
+			int64_t skip = 0;
+			uint8_t const *e = fna_buf_count(delim, fna->p, &skip);
+			fna_seq_reserve(fna, v, encode, len, MIN2((e - fna->p) - skip, lim - len));
+		}
+		int64_t ilen = MIN2(fna->t - fna->p, blk);
+		uint8_t *q = fna_kv_expand(fna, v, ilen + FNA_BUF_MARGIN);
+
+		int64_t olen;
+		uint8_t const *p = fna_buf_compact(delim, q, &olen, fna->p, ilen, lim - len);
+		lmm_kv_size(*v) += fna_encode_span(q, q, olen, pack, encode);
+		len += olen; fna->p = (uint8_t *)p;
+
+		/* grow block size for long sequences */
+		blk = MIN2(2 * blk, FNA_COMPACT_MAX_BLOCK);
+
+		if(len >= lim) { c = p[-1]; break; }
+		if(p < fna->t) {
+			if(delim->table[*p] & DELIM_TERM) { c = *fna->p++; break; }
+			continue;		/* end of block */
+		}
+		if(fna_buf_fill(fna) == 0) { c = EOF; break; }
+	}
+	debug("finished, len(%lld)", len);
+
+	fna->status = fna_buf_eof(fna) ? FNA_EOF : FNA_SUCCESS;
+	return((struct fna_read_ret_s){
+		.len = len,
+		.c = (char)c
+	});
+}
+
+/**
+ * @fn fna_read_seq_intl
+ * @brief read seq until delim or lim bases, nonzero non-terminal chars in delim are skipped
+ */
+static _force_inline
+struct fna_read_ret_s fna_read_seq_intl(
+	struct fna_context_s *fna,
+	lmm_kvec_uint8_t *v,
+	struct fna_pack_s *pack,
+	struct fna_delim_s const *delim,
+	int64_t lim,
+	int encode)
+{
+	if(delim->ctrl != 0) {
+		return(fna_read_seq_compact(fna, v, pack, delim, lim, encode));
+	}
+
+	int c = 0;
+	int64_t len = 0;
+	while(len < lim) {
+		uint8_t const *p = fna->p;
+		uint8_t const *q = fna_buf_scan(delim, p);
+		int64_t n = MIN2(q - p, lim - len);
+
+		lmm_kv_size(*v) += fna_encode_span(fna_kv_expand(fna, v, n), p, n, pack, encode);
+		len += n; fna->p += n;
+		if(len >= lim) { c = p[n - 1]; break; }
+
+		if(q < fna->t) {
+			c = *fna->p++;
+			if(delim->table[(uint8_t)c] & DELIM_TERM) { break; }
+			continue;
+		}
+		if(fna_buf_fill(fna) == 0) { c = EOF; break; }
+	}
+	debug("finished, len(%lld)", len);
+
+	fna->status = fna_buf_eof(fna) ? FNA_EOF : FNA_SUCCESS;
+	return((struct fna_read_ret_s){
+		.len = len,
+		.c = (char)c
+	});
+}
+
+/**
+ * @fn fna_read_seq_ascii
+ * @brief read seq until delim, with conv table
+ */
+static
+struct fna_read_ret_s fna_read_seq_ascii(
+	struct fna_context_s *fna,
+	lmm_kvec_uint8_t *v,
+	struct fna_delim_s const *delim,
+	int64_t lim)
+{
+	struct fna_read_ret_s r = fna_read_seq_intl(fna, v, NULL, delim, lim, FNA_ASCII);
+	lmm_kv_push(fna->lmm, *v, '\0');
+	return(r);
+}
+
+/**
+ * @fn fna_read_seq_2bit
+ * @brief read seq until delim, with conv table
+ */
+static
+struct fna_read_ret_s fna_read_seq_2bit(
+	struct fna_context_s *fna,
+	lmm_kvec_uint8_t *v,
+	struct fna_delim_s const *delim,
+	int64_t lim)
+{
+	return(fna_read_seq_intl(fna, v, NULL, delim, lim, FNA_2BIT));
+}
+
+/**
+ * @fn fna_read_seq_2bitpacked
+ * @brief read seq until delim, with conv table
+ */
+static
+struct fna_read_ret_s fna_read_seq_2bitpacked(
+	struct fna_context_s *fna,
+	lmm_kvec_uint8_t *v,
+	struct fna_delim_s const *delim,
+	int64_t lim)
+{
+	struct fna_pack_s pack = { .arr = 0, .cnt = 0 };
+	struct fna_read_ret_s r = fna_read_seq_intl(fna, v, &pack, delim, lim, FNA_2BITPACKED);
+
+	/* flush the last (possibly empty) byte */
+	lmm_kv_push(fna->lmm, *v, pack.arr);
+	return(r);
+}
+
+/**
+ * @fn fna_read_seq_4bit
+ * @brief read seq until delim, with conv table
+ */
+static
+struct fna_read_ret_s fna_read_seq_4bit(
+	struct fna_context_s *fna,
+	lmm_kvec_uint8_t *v,
+	struct fna_delim_s const *delim,
+	int64_t lim)
+{
+	return(fna_read_seq_intl(fna, v, NULL, delim, lim, FNA_4BIT));
+}
+
+/**
+ * @fn fna_read_seq_4bitpacked
+ * @brief read seq until delim, with conv table
+ */
+static
+struct fna_read_ret_s fna_read_seq_4bitpacked(
+	struct fna_context_s *fna,
+	lmm_kvec_uint8_t *v,
+	struct fna_delim_s const *delim,
+	int64_t lim)
+{
+	struct fna_pack_s pack = { .arr = 0, .cnt = 0 };
+	struct fna_read_ret_s r = fna_read_seq_intl(fna, v, &pack, delim, lim, FNA_4BITPACKED);
+
+	/* flush the last (possibly empty) byte */
+	lmm_kv_push(fna->lmm, *v, pack.arr);
+	return(r);
+}
+
+/**
+ * @fn fna_view_ascii
+ * @brief fna_read_ascii on a mapped window; returns the field as a view and pushes
+ * an empty string to v instead. the whole file is in the window, so no refill.
+ */
+static
+struct fna_read_ret_s fna_view_ascii(
+	struct fna_context_s *fna,
+	lmm_kvec_uint8_t *v,
+	struct fna_delim_s const *delim)
+{
+	uint8_t const *p = fna->p, *t = fna->t;
+	lmm_kv_push(fna->lmm, *v, '\0');
+
+	/* strip spaces at the head, stops at the sentinel */
+	while(delim_space[*p] == 1) { p++; }
+	if(p >= t) {
+		fna->p = (uint8_t *)t;
+		return((struct fna_read_ret_s){
+			.len = 0,
+			.c = (char)EOF,
+			.ptr = p
+		});
+	}
+
+	/* the first char is always taken */
+	uint8_t const *q = fna_buf_scan(delim, p + 1);
+	int c = (q < t) ? *q : EOF;
+	fna->p = (uint8_t *)((q < t) ? q + 1 : q);
+
+	/* strip spaces at the tail */
+	while(q > p && delim_space[q[-1]] == 1) { q--; }
+
+	debug("finished, len(%lld)", q - p);
+	return((struct fna_read_ret_s){
+		.len = q - p,
+		.c = (char)c,
+		.ptr = p
+	});
+}
+
+/**
+ * @fn fna_view_seq_ascii
+ * @brief fna_read_seq_ascii on a mapped window; the seq is returned as a view when
+ * it is a single span (only skipped chars between the span and the terminator).
+ * otherwise it is copied to v as usual.
+ */
+static
+struct fna_read_ret_s fna_view_seq_ascii(
+	struct fna_context_s *fna,
+	lmm_kvec_uint8_t *v,
+	struct fna_delim_s const *delim,
+	int64_t lim)
+{
+	uint8_t const *p = fna->p, *t = fna->t;
+	while(p < t && delim->table[*p] != 0 && (delim->table[*p] & DELIM_TERM) == 0) { p++; }	/* leading line breaks */
+	uint8_t const *q = fna_buf_scan(delim, p);
+
+	int c = 0;
+	if(q - p >= lim) {
+		/* lim bases in a row */
+		q = p + lim;
+		c = (lim > 0) ? q[-1] : 0;
+		fna->p = (uint8_t *)q;
+	} else {
+		/* skip line breaks, the next char must be a terminator */
+		uint8_t const *r = q;
+		while(r < t && (delim->table[*r] & DELIM_TERM) == 0) {
+			if(delim->table[*r] == 0) {
+				return(fna_read_seq_ascii(fna, v, delim, lim));		/* multi-line */
+			}
+			r++;
+		}
+		c = (r < t) ? *r : EOF;
+		fna->p = (uint8_t *)((r < t) ? r + 1 : r);
+	}
+	lmm_kv_push(fna->lmm, *v, '\0');
+	fna->status = fna_buf_eof(fna) ? FNA_EOF : FNA_SUCCESS;
+
+	debug("finished, len(%lld)", q - p);
+	return((struct fna_read_ret_s){
+		.len = q - p,
+		.c = (char)c,
+		.ptr = p
+	});
+}
+
+/**
+ * @val _comp_ascii_lo, _comp_ascii_hi
+ * @brief complements of letters indexed by (c & 0x1f), in upper case; IUPAC codes
+ * are mapped to their complements and the others to N.
+ */
+#define _comp_ascii_lo		'N', 'T', 'V', 'G', 'H', 'N', 'N', 'C', 'D', 'N', 'N', 'M', 'N', 'K', 'N', 'N'
+#define _comp_ascii_hi		'N', 'N', 'Y', 'S', 'A', 'A', 'B', 'W', 'N', 'R', 'N', 'N', 'N', 'N', 'N', 'N'
+#define _comp_4bit			0x00, 0x08, 0x04, 0x0c, 0x02, 0x0a, 0x06, 0x0e, 0x01, 0x09, 0x05, 0x0d, 0x03, 0x0b, 0x07, 0x0f
+
+/**
+ * @fn fna_comp_base
+ * @brief complement of a base in an unpacked encoding; case is kept for ASCII,
+ * and non-letters are mapped to N.
+ */
+static _force_inline
+uint8_t fna_comp_base(
+	uint8_t c,
+	int encode)
+{
+	static uint8_t const comp_ascii[32] = { _comp_ascii_lo, _comp_ascii_hi };
+	static uint8_t const comp_4bit[16] = { _comp_4bit };
+
+	switch(encode) {
+		case FNA_ASCII: return(((c & 0xc0) == 0x40) ? (comp_ascii[c & 0x1f] | (c & 0x20)) : 'N');
+		case FNA_2BIT: return(c ^ 0x03);
+		case FNA_4BIT: return(comp_4bit[c & 0x0f]);
+	}
+	return(c);
+}
+
+/**
+ * @fn fna_revcomp_vec
+ * @brief vectorized reverse complement of unpacked seqs; loads vectors backward from
+ * the tail of src, reverses bytes with pshufb and complements them with a table lookup
+ * (ASCII, 4-bit) or xor (2-bit). processes len rounded down to the vector width and
+ * returns the number of bases written to the head of dst.
+ */
+#if defined(__AVX512BW__)
+
+static _force_inline
+__m512i fna_comp_v64(
+	__m512i x,
+	int encode)
+{
+	if(encode == FNA_2BIT) {
+		return(_mm512_xor_si512(x, _mm512_set1_epi8(0x03)));
+	}
+	if(encode == FNA_4BIT) {
+		return(_mm512_shuffle_epi8(_mm512_broadcast_i32x4(_mm_setr_epi8(_comp_4bit)), x));
+	}
+
+	__m512i const idx = _mm512_and_si512(x, _mm512_set1_epi8(0x1f));
+	__mmask64 const hi = _mm512_cmpgt_epi8_mask(idx, _mm512_set1_epi8(0x0f));
+	__mmask64 const letter = _mm512_cmpeq_epi8_mask(_mm512_and_si512(x, _mm512_set1_epi8(0xc0)), _mm512_set1_epi8(0x40));
+	__m512i const c = _mm512_mask_blend_epi8(hi,
+		_mm512_shuffle_epi8(_mm512_broadcast_i32x4(_mm_setr_epi8(_comp_ascii_lo)), idx),
+		_mm512_shuffle_epi8(_mm512_broadcast_i32x4(_mm_setr_epi8(_comp_ascii_hi)), idx));
+	return(_mm512_mask_blend_epi8(letter, _mm512_set1_epi8('N'),
+		_mm512_or_si512(c, _mm512_and_si512(x, _mm512_set1_epi8(0x20)))));
+}
+
+static _force_inline
+int64_t fna_revcomp_vec(
+	uint8_t *dst,
+	uint8_t const *src,
+	int64_t len,
+	int encode)
+{
+	__m512i const rv = _mm512_broadcast_i32x4(_mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0));
+
+	#define _loop(_e) { \
+		for(; i + 64 <= len; i += 64) { \
+			__m512i const x = _mm512_shuffle_epi8(_mm512_loadu_si512((__m512i const *)&src[len - i - 64]), rv); \
+			_mm512_storeu_si512((__m512i *)&dst[i], fna_comp_v64(_mm512_shuffle_i64x2(x, x, 0x1b), (_e))); \
+		} \
+	}
+
+	int64_t i = 0;
+	switch(encode) {
+		case FNA_ASCII: _loop(FNA_ASCII); break;
+		case FNA_2BIT: _loop(FNA_2BIT); break;
+		case FNA_4BIT: _loop(FNA_4BIT); break;
+	}
+
+	#undef _loop
+	return(i);
+}
+
+#elif defined(__SSSE3__)
+
+static _force_inline
+__m128i fna_comp_v16(
+	__m128i x,
+	int encode)
+{
+	if(encode == FNA_2BIT) {
+		return(_mm_xor_si128(x, _mm_set1_epi8(0x03)));
+	}
+	if(encode == FNA_4BIT) {
+		return(_mm_shuffle_epi8(_mm_setr_epi8(_comp_4bit), x));
+	}
+
+	__m128i const idx = _mm_and_si128(x, _mm_set1_epi8(0x1f));
+	__m128i const hi = _mm_cmpgt_epi8(idx, _mm_set1_epi8(0x0f));
+	__m128i const letter = _mm_cmpeq_epi8(_mm_and_si128(x, _mm_set1_epi8(0xc0)), _mm_set1_epi8(0x40));
+	__m128i const c = _mm_or_si128(
+		_mm_andnot_si128(hi, _mm_shuffle_epi8(_mm_setr_epi8(_comp_ascii_lo), idx)),
+		_mm_and_si128(hi, _mm_shuffle_epi8(_mm_setr_epi8(_comp_ascii_hi), idx)));
+	return(_mm_or_si128(
+		_mm_and_si128(letter, _mm_or_si128(c, _mm_and_si128(x, _mm_set1_epi8(0x20)))),
+		_mm_andnot_si128(letter, _mm_set1_epi8('N'))));
+}
+
+#if defined(__AVX2__)
+static _force_inline
+__m256i fna_comp_v32(
+	__m256i x,
+	int encode)
+{
+	if(encode == FNA_2BIT) {
+		return(_mm256_xor_si256(x, _mm256_set1_epi8(0x03)));
+	}
+	if(encode == FNA_4BIT) {
+		return(_mm256_shuffle_epi8(_mm256_setr_epi8(_comp_4bit, _comp_4bit), x));
+	}
+
+	__m256i const idx = _mm256_and_si256(x, _mm256_set1_epi8(0x1f));
+	__m256i const hi = _mm256_cmpgt_epi8(idx, _mm256_set1_epi8(0x0f));
+	__m256i const letter = _mm256_cmpeq_epi8(_mm256_and_si256(x, _mm256_set1_epi8(0xc0)), _mm256_set1_epi8(0x40));
+	__m256i const c = _mm256_blendv_epi8(
+		_mm256_shuffle_epi8(_mm256_setr_epi8(_comp_ascii_lo, _comp_ascii_lo), idx),
+		_mm256_shuffle_epi8(_mm256_setr_epi8(_comp_ascii_hi, _comp_ascii_hi), idx), hi);
+	return(_mm256_blendv_epi8(_mm256_set1_epi8('N'),
+		_mm256_or_si256(c, _mm256_and_si256(x, _mm256_set1_epi8(0x20))), letter));
+}
+#endif
+
+static _force_inline
+int64_t fna_revcomp_vec(
+	uint8_t *dst,
+	uint8_t const *src,
+	int64_t len,
+	int encode)
+{
+	#if defined(__AVX2__)
+		__m256i const rv = _mm256_setr_epi8(
+			15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+			15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+		#define _loop(_e) { \
+			for(; i + 32 <= len; i += 32) { \
+				__m256i const x = _mm256_shuffle_epi8(_mm256_loadu_si256((__m256i const *)&src[len - i - 32]), rv); \
+				_mm256_storeu_si256((__m256i *)&dst[i], fna_comp_v32(_mm256_permute4x64_epi64(x, 0x4e), (_e))); \
+			} \
+		}
+	#else
+		__m128i const rv = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+		#define _loop(_e) { \
+			for(; i + 16 <= len; i += 16) { \
+				__m128i const x = _mm_loadu_si128((__m128i const *)&src[len - i - 16]); \
+				_mm_storeu_si128((__m128i *)&dst[i], fna_comp_v16(_mm_shuffle_epi8(x, rv), (_e))); \
+			} \
+		}
+	#endif
+
+	int64_t i = 0;
+	switch(encode) {
+		case FNA_ASCII: _loop(FNA_ASCII); break;
+		case FNA_2BIT: _loop(FNA_2BIT); break;
+		case FNA_4BIT: _loop(FNA_4BIT); break;
+	}
+
+	#undef _loop
+	return(i);
+}
+
+#else
+
+static _force_inline
+int64_t fna_revcomp_vec(
+	uint8_t *dst,
+	uint8_t const *src,
+	int64_t len,
+	int encode)
+{
+	return(0);
+}
+
+#endif
+
+#undef _comp_ascii_lo
+#undef _comp_ascii_hi
+
+/**
+ * @fn fna_revcomp_word
+ * @brief reverse complement of 64 bits of packed bases (first base at the least
+ * significant bits). a bit reversal reverses the order of the bases and complements
+ * 4-bit codes at once; 2-bit codes are moved as pairs and negated instead.
+ */
+static _force_inline
+uint64_t fna_revcomp_word(
+	uint64_t w,
+	int bits)
+{
+	w = __builtin_bswap64(w);
+	w = ((w>>4) & 0x0f0f0f0f0f0f0f0f) | ((w & 0x0f0f0f0f0f0f0f0f)<<4);
+	w = ((w>>2) & 0x3333333333333333) | ((w & 0x3333333333333333)<<2);
+	if(bits == 2) { return(~w); }
+	return(((w>>1) & 0x5555555555555555) | ((w & 0x5555555555555555)<<1));
+}
+
+/**
+ * @fn fna_revcomp_packed
+ * @brief reverse complement of packed seqs, a word at a time; words of src are loaded
+ * at the bit offset of the corresponding bases, so len needs not be a multiple of the
+ * bases per byte. the padding bits of dst are cleared.
+ */
+static _force_inline
+void fna_revcomp_packed(
+	uint8_t *dst,
+	uint8_t const *src,
+	int64_t len,
+	int bits)
+{
+	static uint8_t const comp_4bit[16] = { _comp_4bit };
+	int64_t const n = 64 / bits;
+
+	int64_t i = 0;
+	for(; i + n <= len; i += n) {
+		uint64_t const ofs = (len - i - n) * bits;
+		uint64_t w;
+		memcpy(&w, &src[ofs / 8], sizeof(uint64_t));
+		if((ofs & 7) != 0) {
+			w = (w>>(ofs & 7)) | ((uint64_t)src[ofs / 8 + 8]<<(64 - (ofs & 7)));
+		}
+		w = fna_revcomp_word(w, bits);
+		memcpy(&dst[i * bits / 8], &w, sizeof(uint64_t));
+	}
+
+	/* tail, a base at a time */
+	memset(&dst[i * bits / 8], 0, (len - i) * bits / 8 + 1);
+	for(; i < len; i++) {
+		int64_t const j = (len - i - 1) * bits;
+		uint8_t const c = (src[j / 8]>>(j & 7)) & ((1<<bits) - 1);
+		dst[i * bits / 8] |= ((bits == 2) ? c ^ 0x03 : comp_4bit[c])<<((i * bits) & 7);
+	}
+	return;
+}
+
+#undef _comp_4bit
+
+/**
+ * @fn fna_revcomp_span
+ * @brief reverse complement of len bases of src into dst, in encode. writes
+ * fna_encoded_size(encode, len) bytes, the terminator (ASCII) and the padding
+ * (packed ones) included. dst and src must not overlap.
+ */
+static
+void fna_revcomp_span(
+	uint8_t *dst,
+	uint8_t const *src,
+	int64_t len,
+	int encode)
+{
+	if(encode == FNA_2BITPACKED || encode == FNA_4BITPACKED) {
+		fna_revcomp_packed(dst, src, len, (encode == FNA_2BITPACKED) ? 2 : 4);
+		return;
+	}
+
+	int64_t i = fna_revcomp_vec(dst, src, len, encode);
+	for(; i < len; i++) {
+		dst[i] = fna_comp_base(src[len - i - 1], encode);
+	}
+	if(encode == FNA_ASCII) { dst[len] = '\0'; }
+	return;
+}
+
+/**
+ * @val fna_kernel_<FNA_KERNEL>
+ * @brief readers of this object; isa is derived from the target macros so that
+ * the table is never selected on a CPU that lacks what the compiler used.
+ */
+struct fna_kernel_s const _fna_kernel(FNA_KERNEL) = {
+	.name = _fna_kernel_str(FNA_KERNEL),
+	.isa = 0
+	#if defined(__SSE4_1__)
+		| FNA_ISA_SSE41
+	#endif
+	#if defined(__AVX2__)
+		| FNA_ISA_AVX2
+	#endif
+	#if defined(__AVX512BW__)
+		| FNA_ISA_AVX512BW
+	#endif
+	#if defined(__AVX512VBMI__) || defined(__AVX512VBMI2__)
+		| FNA_ISA_AVX512VBMI
+	#endif
+	,
+	.read_ascii = fna_read_ascii,
+	.read_skip = fna_read_skip,
+	.read_count = fna_read_count,
+	.read_seq = {
+		[FNA_ASCII] = fna_read_seq_ascii,
+		[FNA_2BIT] = fna_read_seq_2bit,
+		[FNA_2BITPACKED] = fna_read_seq_2bitpacked,
+		[FNA_4BIT] = fna_read_seq_4bit,
+		[FNA_4BITPACKED] = fna_read_seq_4bitpacked
+	},
+	.view_ascii = fna_view_ascii,
+	.view_seq = fna_view_seq_ascii,
+	.revcomp = fna_revcomp_span,
+	.scan = fna_buf_scan,
+	.count = fna_buf_count,
+	.compact = fna_buf_compact,
+	.encode_span = fna_encode_span
+};
+
+#if !FNA_KERNEL_ONLY
+/**
+ * @val fna_kernels
+ * @brief kernel objects linked in, in the order of preference
+ */
+#if defined(FNA_DISPATCH)
+extern struct fna_kernel_s const fna_kernel_sse41, fna_kernel_avx2, fna_kernel_avx512bw, fna_kernel_avx512vbmi;
+#endif
+static
+struct fna_kernel_s const *const fna_kernels[] = {
+	#if defined(FNA_DISPATCH)
+		&fna_kernel_avx512vbmi,
+		&fna_kernel_avx512bw,
+		&fna_kernel_avx2,
+		&fna_kernel_sse41,
+	#endif
+	&fna_kernel_generic,
+	NULL
+};
+
+/**
+ * @fn fna_cpu_isa
+ * @brief fna_isa flags of the running CPU
+ */
+static
+uint32_t fna_cpu_isa(void)
+{
+	uint32_t isa = 0;
+	#if defined(__x86_64__) || defined(__i386__)
+		__builtin_cpu_init();
+		if(__builtin_cpu_supports("sse4.1")) { isa |= FNA_ISA_SSE41; }
+		if(__builtin_cpu_supports("avx2")) { isa |= FNA_ISA_AVX2; }
+		if(__builtin_cpu_supports("avx512bw")) { isa |= FNA_ISA_AVX512BW; }
+		if(__builtin_cpu_supports("avx512vbmi") && __builtin_cpu_supports("avx512vbmi2")) { isa |= FNA_ISA_AVX512VBMI; }
+	#endif
+	return(isa);
+}
+
+/**
+ * @fn fna_kernel_select
+ * @brief the first kernel in fna_kernels whose requirements are met, the generic
+ * one is always taken as the last resort.
+ */
+static
+struct fna_kernel_s const *fna_kernel_select(void)
+{
+	uint32_t const isa = fna_cpu_isa();
+	struct fna_kernel_s const *const *k = fna_kernels;
+	while(k[1] != NULL && ((*k)->isa & ~isa) != 0) { k++; }
+
+	debug("kernel(%s)", (*k)->name);
+	return(*k);
+}
+
+/**
+ * @fn fna_segment_base
+ * @brief pointers to the storage of name, comment, seq and qual in the record body.
+ * lengths and flags must be set; a view field (enum fna_seq_flags) takes an empty one.
+ */
+static _force_inline
+void fna_segment_base(
+	struct fna_seq_intl_s const *r,
+	uint8_t const **base)
+{
+	#define _len(_x, _flag)		( (r->flags & (_flag)) ? 0 : (_x).len )
+	base[0] = (uint8_t const *)(r + 1);
+	base[1] = base[0] + _len(r->s.segment.name, FNA_VIEW_NAME) + 1;
+	base[2] = base[1] + _len(r->s.segment.comment, FNA_VIEW_COMMENT) + 1 + r->seq_head_margin;
+	base[3] = base[2] + fna_encoded_size(r->seq_encode, _len(r->s.segment.seq, FNA_VIEW_SEQ | FNA_NO_SEQ)) + r->seq_tail_margin;
+	#undef _len
+	return;
+}
+
+/**
+ * @fn fna_segment_link
+ * @brief build links of a segment record from the results of the field readers
+ */
+static _force_inline
+void fna_segment_link(
+	struct fna_seq_intl_s *r,
+	struct fna_read_ret_s name,
+	struct fna_read_ret_s comment,
+	struct fna_read_ret_s seq,
+	struct fna_read_ret_s qual)
+{
+	r->flags = (r->flags & FNA_NO_SEQ)
+		| ((name.ptr != NULL) ? FNA_VIEW_NAME : 0)
+		| ((comment.ptr != NULL) ? FNA_VIEW_COMMENT : 0)
+		| ((seq.ptr != NULL) ? FNA_VIEW_SEQ : 0)
+		| ((qual.ptr != NULL) ? FNA_VIEW_QUAL : 0);
+	r->s.segment.name.len = name.len;
+	r->s.segment.name.id = -1;
+	r->s.segment.comment.len = comment.len;
+	r->s.segment.seq.len = seq.len;
+	r->s.segment.qual.len = qual.len;
+
+	uint8_t const *base[4];
+	fna_segment_base(r, base);
+	r->s.segment.name.ptr = (char const *)((name.ptr != NULL) ? name.ptr : base[0]);
+	r->s.segment.comment.ptr = (char const *)((comment.ptr != NULL) ? comment.ptr : base[1]);
+	r->s.segment.seq.ptr = (seq.ptr != NULL) ? seq.ptr : base[2];
+	r->s.segment.qual.ptr = (qual.ptr != NULL) ? qual.ptr : base[3];
+	return;
+}
+
+/**
+ * @fn fna_skip_seq
+ * @brief (internal) FNA_SKIP_SEQ, count bases up to the terminal delim and leave an empty
+ * seq body; multi-line sequences are counted in one pass without stopping at line breaks.
+ */
+static _force_inline
+struct fna_read_ret_s fna_skip_seq(
+	struct fna_context_s *fna,
+	lmm_kvec_uint8_t *v,
+	struct fna_delim_s const *delim)
+{
+	struct fna_read_ret_s seq = fna->read_count(fna, delim);
+	fna_seq_make_margin(fna, v, fna_encoded_size(fna->seq_encode, 0));
+	fna->status = fna_buf_eof(fna) ? FNA_EOF : FNA_SUCCESS;
+	return(seq);
+}
+
+/**
+ * @fn fna_pack_put
+ * @brief (internal) put nbits of packed bases of b at the bit offset ofs of p, which is size
+ * bytes long; bits of p from ofs on are overwritten and the padding after the bases is cleared.
+ */
+static _force_inline
+void fna_pack_put(
+	uint8_t *p,
+	int64_t ofs,
+	uint8_t const *b,
+	int64_t nbits,
+	int64_t size)
+{
+	int64_t const sh = ofs & 7;
+	if(ofs / 8 >= size) { return; }		/* empty b in 2BIT / 4BIT */
+	p[ofs / 8] &= (1<<sh) - 1;
+	memset(&p[ofs / 8 + 1], 0, size - ofs / 8 - 1);
+	for(int64_t i = 0, d = ofs / 8; i < (nbits + 7) / 8; i++, d++) {
+		p[d] |= b[i]<<sh;
+		if(sh != 0 && d + 1 < size) { p[d + 1] |= b[i]>>(8 - sh); }
+	}
+	if((ofs + nbits) / 8 < size) {
+		p[(ofs + nbits) / 8] &= (1<<((ofs + nbits) & 7)) - 1;
+	}
+	return;
+}
+
+/**
+ * @fn fna_reverse_span
+ * @brief (internal) reverse len bases (or quals, which share the encoding of seq) of src into dst
+ * without complementing them; writes fna_encoded_size(encode, len) bytes as fna_revcomp_span does.
+ */
+static
+void fna_reverse_span(
+	uint8_t *dst,
+	uint8_t const *src,
+	int64_t len,
+	int encode)
+{
+	int64_t const bits = fna_encoded_bits(encode);
+	if(bits == 8) {
+		for(int64_t i = 0; i < len; i++) { dst[i] = src[len - i - 1]; }
+		if(encode == FNA_ASCII) { dst[len] = '\0'; }
+		return;
+	}
+
+	/* packed ones a base at a time */
+	memset(dst, 0, fna_encoded_size(encode, len));
+	for(int64_t i = 0; i < len; i++) {
+		int64_t const j = (len - i - 1) * bits;
+		dst[i * bits / 8] |= ((src[j / 8]>>(j & 7)) & ((1<<bits) - 1))<<((i * bits) & 7);
+	}
+	return;
+}
+
+/**
+ * @fn fna_emit_strand
+ * @brief (internal) FNA_EMIT_REVCOMP, put the other strand of the field at ofs of v (the last one
+ * in v) right after it in place of the terminator, while the bases are still in cache; rev is the
+ * reverse complement for seq and fna_reverse_span for qual. a packed strand starting in the middle
+ * of a byte is built past the end and shifted in.
+ */
+static _force_inline
+struct fna_read_ret_s fna_emit_strand(
+	struct fna_context_s *fna,
+	lmm_kvec_uint8_t *v,
+	int64_t ofs,
+	struct fna_read_ret_s ret,
+	int encode,
+	void (*rev)(uint8_t *dst, uint8_t const *src, int64_t len, int encode))
+{
+	int64_t const len = ret.len, bits = fna_encoded_bits(encode);
+	int64_t const size = fna_encoded_size(encode, 2 * len);
+	lmm_kv_reserve(fna->lmm, *v, ofs + fna_encoded_size(encode, len) + fna_revcomp_room(encode, len));
+
+	uint8_t *p = lmm_kv_ptr(*v) + ofs;
+	if(((len * bits) & 7) == 0) {
+		rev(&p[len * bits / 8], p, len, encode);
+	} else {
+		rev(&p[size], p, len, encode);
+		fna_pack_put(p, len * bits, &p[size], len * bits, size);
+	}
+	lmm_kv_size(*v) = ofs + size;
+	ret.len = 2 * len;
+	return(ret);
+}
+
+/**
+ * @fn fna_len_hint
+ * @brief (internal) length of the seq of a record named name in <path>.fai, negative if unknown.
+ * the index is loaded on the first call, which comes only with a long record.
+ */
+static
+int64_t fna_len_hint(
+	struct fna_context_s *fna,
+	char const *name,
+	int64_t len)
+{
+	if(fna->fai == NULL && fna->fai_probed == 0) {
+		fna->fai = fna_fai_open_hint(fna->path);
+		fna->fai_probed = 1;
+	}
+	if(fna->fai == NULL || fna->fai->max_len < FNA_HINT_MIN_LEN) { return(-1); }
+	struct fna_fai_rec_s const *e = fna_fai_find(fna->fai, name, len);
+	return((e != NULL) ? e->len : -1);
+}
+
+/**
+ * @fn fna_read_seq_grow
+ * @brief (internal) read the rest of a long seq of unknown length, after the first seq.len bases
+ * (FNA_GROW_MIN_LEN) read into v. v is grown in place by steps as long as the bases so far (up to
+ * FNA_GROW_MAX_STEP) and trimmed to the record at the end. blocks this large are moved by remapping their pages on realloc (mremap on
+ * glibc), so the bases are not copied and the unwritten tail of a step is never committed; other
+ * allocators may copy them once per step.
+ */
+static
+struct fna_read_ret_s fna_read_seq_grow(
+	struct fna_context_s *fna,
+	lmm_kvec_uint8_t *v,
+	struct fna_delim_s const *delim,
+	struct fna_read_ret_s seq)
+{
+	int64_t const term = fna_encoded_size(fna->seq_encode, 0);	/* terminator (or flushed byte) at the tail of each read */
+
+	/* by steps, appended in place of the terminator of the previous one */
+	while(1) {
+		int64_t const lim = MIN2(seq.len, FNA_GROW_MAX_STEP);
+		lmm_kv_size(*v) -= term;
+		lmm_kv_reserve(fna->lmm, *v, lmm_kv_size(*v) + fna_encoded_size(fna->seq_encode, lim) + FNA_COMPACT_MAX_BLOCK + FNA_BUF_MARGIN);
+		struct fna_read_ret_s r = fna->read_seq(fna, v, delim, lim);
+		seq.len += r.len; seq.c = r.c;
+		if(r.len < lim) { break; }
+	}
+
+	/* trim the slack of the last step, leaving the room for the tail of the record */
+	int64_t const room = (fna->options & FNA_EMIT_REVCOMP) ? fna_revcomp_room(fna->seq_encode, seq.len) : 0;
+	lmm_kv_resize(fna->lmm, *v, lmm_kv_size(*v) + room + fna->seq_tail_margin + 1 + fna->tail_margin);
+	return(seq);
+}
+
+/**
+ * @fn fna_read_seq_long
+ * @brief (internal) read a FASTA seq into a buffer of the final size if the length is known from
+ * fna_set_len_hint or, past the first FNA_GROW_MIN_LEN bases, from .fai; grown in place by steps
+ * otherwise. the name is at name_ofs in v. seqs in the mapped window are counted by the compaction kernel.
+ */
+static _force_inline
+struct fna_read_ret_s fna_read_seq_long(
+	struct fna_context_s *fna,
+	lmm_kvec_uint8_t *v,
+	struct fna_delim_s const *delim,
+	int64_t name_ofs,
+	int64_t name_len)
+{
+	if(fna->len_hint >= 0) {
+		fna_seq_reserve(fna, v, fna->seq_encode, 0, fna->len_hint);
+		return(fna->read_seq(fna, v, delim, LIM_UNLIMITED));
+	}
+
+	/* short ones are read as usual, not worth a lookup per record */
+	struct fna_read_ret_s seq = fna->read_seq(fna, v, delim, FNA_GROW_MIN_LEN);
+	if(seq.len < FNA_GROW_MIN_LEN) { return(seq); }
+
+	int64_t const hint = fna_len_hint(fna, (char const *)(lmm_kv_ptr(*v) + name_ofs), name_len);
+	if(hint < 0) { return(fna_read_seq_grow(fna, v, delim, seq)); }
+
+	/* the rest at once, in place of the terminator */
+	lmm_kv_size(*v) -= fna_encoded_size(fna->seq_encode, 0);
+	fna_seq_reserve(fna, v, fna->seq_encode, seq.len, MAX2(hint - seq.len, 0));
+	struct fna_read_ret_s r = fna->read_seq(fna, v, delim, LIM_UNLIMITED);
+	seq.len += r.len; seq.c = r.c;
+	return(seq);
+}
+
+/**
+ * @fn fna_read_head_fasta
+ */
+static
+int fna_read_head_fasta(
+	struct fna_context_s *fna)
+{
+	/* eat '>' at the head */
+	fna->read_skip(fna, &delim_fasta_seq, LIM_UNLIMITED);
+	return(fna_buf_eof(fna) ? FNA_EOF :  FNA_SUCCESS);
+}
+
+/**
+ * @fn fna_read_fasta
+ *
+ * @brief (internal) fasta format parser
+ */
+static
+struct fna_seq_intl_s *fna_read_fasta(
+	struct fna_context_s *fna,
+	lmm_kvec_uint8_t *v)
+{
+	int64_t const base = lmm_kv_size(*v);
+
+	/* make margin at the head of seq */
+	fna_seq_make_margin(fna, v, fna->head_margin);
+
+	lmm_kv_pusha(fna->lmm, struct fna_seq_intl_s, *v, ((struct fna_seq_intl_s){
+		.lmm = fna->lmm,
+		.type = FNA_SEGMENT,
+		.flags = (fna->options & FNA_SKIP_SEQ) ? FNA_NO_SEQ : 0,
+		.seq_encode = fna->seq_encode,
+		.options = fna->options,
+		.head_margin = fna->head_margin,
+		.tail_margin = fna->tail_margin,
+		.seq_head_margin = fna->seq_head_margin,
+		.seq_tail_margin = fna->seq_tail_margin
+	}));
+
+	/* parse name */
+	struct fna_read_ret_s name = fna->view_ascii(fna, v, &delim_fasta_fastq_name);
+	int64_t name_len = name.len;
+
+	/* parse comment after name */
+	struct fna_read_ret_s com = (name.c == ' ')
+		? fna->view_ascii(fna, v, &delim_line)
+		: ({ lmm_kv_push(fna->lmm, *v, '\0'); (struct fna_read_ret_s){ .len = 0 }; });
+	int64_t com_len = com.len;
+
+	/* parse seq; the name is in v unless mapped */
+	fna_seq_make_margin(fna, v, fna->seq_head_margin);
+	int64_t const seq_ofs = lmm_kv_size(*v);
+	struct fna_read_ret_s seq = ((fna->options & FNA_SKIP_SEQ) != 0) ? fna_skip_seq(fna, v, &delim_fasta_seq)
+		: (fna->map_size != 0) ? fna->view_seq(fna, v, &delim_fasta_seq, LIM_UNLIMITED)
+		: fna_read_seq_long(fna, v, &delim_fasta_seq, base + fna->head_margin + sizeof(struct fna_seq_intl_s), name_len);
+	int64_t seq_len = seq.len;
+	if((fna->options & (FNA_EMIT_REVCOMP | FNA_SKIP_SEQ)) == FNA_EMIT_REVCOMP) {
+		seq = fna_emit_strand(fna, v, seq_ofs, seq, fna->seq_encode, fna->revcomp);
+	}
+
+	debug("name_len(%lld), com_len(%lld), seq_len(%lld)", name_len, com_len, seq_len);
+
+	/* check termination */
+	if(name_len == 0 && com_len == 0 && seq_len == 0) {
+		lmm_kv_size(*v) = base;
+		return(NULL);
+	}
+
+	/* make margin at the tail */
+	fna_seq_make_margin(fna, v, fna->seq_tail_margin);
+	lmm_kv_push(fna->lmm, *v, '\0');			/* qual string terminator */
+	fna_seq_make_margin(fna, v, fna->tail_margin);
+
+	/* finished, build links */
+	struct fna_seq_intl_s *r = (struct fna_seq_intl_s *)(
+		lmm_kv_ptr(*v) + base + fna->head_margin);
+	fna_segment_link(r, name, com, seq, (struct fna_read_ret_s){ .len = 0 });
+	return(r);
+
+	#if 0
+	char *name = (char *)(r + 1);
+	uint8_t *seq = (uint8_t *)(name + (name_len + 1) + r->seq_head_margin);
+	uint8_t *qual = (uint8_t *)(seq + (seq_len + 1) + r->seq_tail_margin);
+	int64_t qual_len = 0;
+
+	return(_fna_pack_segment(r,
+		name, name_len,
+		seq, seq_len,
+		qual, qual_len));
+	#endif
+}
+
+/**
+ * @fn fna_read_head_fastq
+ */
+static
+int fna_read_head_fastq(
+	struct fna_context_s *fna)
+{
+	/* eat '@' at the head */
+	fna->read_skip(fna, &delim_fastq_tail, LIM_UNLIMITED);
+	return(fna_buf_eof(fna) ? FNA_EOF :  FNA_SUCCESS);
+}
+
+/**
+ * @fn fna_read_fastq
+ *
+ * @brief (internal) fastq format parser
+ */
+static
+struct fna_seq_intl_s *fna_read_fastq(
+	struct fna_context_s *fna,
+	lmm_kvec_uint8_t *v)
+{
+	int64_t const base = lmm_kv_size(*v);
+
+	/* make margin at the head of seq */
+	fna_seq_make_margin(fna, v, fna->head_margin);
+
+	lmm_kv_pusha(fna->lmm, struct fna_seq_intl_s, *v, ((struct fna_seq_intl_s){
+		.lmm = fna->lmm,
+		.type = FNA_SEGMENT,
+		.flags = (fna->options & FNA_SKIP_SEQ) ? FNA_NO_SEQ : 0,
+		.seq_encode = fna->seq_encode,
+		.options = fna->options,
+		.head_margin = fna->head_margin,
+		.tail_margin = fna->tail_margin,
+		.seq_head_margin = fna->seq_head_margin,
+		.seq_tail_margin = fna->seq_tail_margin
+	}));
+
+	#if 0
+	/* parse name */
+	int64_t name_len = fna->read_ascii(fna, v, &delim_line).len;
+	#endif
+
+	/* parse name */
+	struct fna_read_ret_s name = fna->view_ascii(fna, v, &delim_fasta_fastq_name);
+	int64_t name_len = name.len;
+
+	/* parse comment after name */
+	struct fna_read_ret_s com = (name.c == ' ')
+		? fna->view_ascii(fna, v, &delim_line)
+		: ({ lmm_kv_push(fna->lmm, *v, '\0'); (struct fna_read_ret_s){ .len = 0 }; });
+
+	/* parse seq, the reverse strand follows while the bases are in cache */
+	int const emit = (fna->options & (FNA_EMIT_REVCOMP | FNA_SKIP_SEQ)) == FNA_EMIT_REVCOMP;
+	fna_seq_make_margin(fna, v, fna->seq_head_margin);
+	int64_t const seq_ofs = lmm_kv_size(*v);
+	struct fna_read_ret_s seq = ((fna->options & FNA_SKIP_SEQ) == 0)
+		? fna->view_seq(fna, v, &delim_fastq_seq, LIM_UNLIMITED)
+		: fna_skip_seq(fna, v, &delim_fastq_seq);
+	int64_t seq_len = seq.len;
+	if(emit) { seq = fna_emit_strand(fna, v, seq_ofs, seq, fna->seq_encode, fna->revcomp); }
+	fna_seq_make_margin(fna, v, fna->seq_tail_margin);
+
+	/* skip name */
+	fna->read_skip(fna, &delim_line, LIM_UNLIMITED);
+
+	/* parse qual, dropped along with seq (read_skip consumes at least one char, not called on empty ones) */
+	int const skip_qual = (fna->options & (FNA_SKIP_QUAL | FNA_SKIP_SEQ)) != 0;
+	int64_t const qual_ofs = lmm_kv_size(*v);
+	struct fna_read_ret_s qual = (skip_qual == 0)
+		? fna->view_seq(fna, v, &delim_fastq_qual, seq_len)
+		: ((seq_len == 0) ? (struct fna_read_ret_s){ .len = 0 } : fna->read_skip(fna, &delim_fastq_qual, seq_len));
+	int64_t qual_len = qual.len;
+	if(emit && skip_qual == 0) { qual = fna_emit_strand(fna, v, qual_ofs, qual, fna->seq_encode, fna_reverse_span); }
+	fna->read_skip(fna, &delim_fastq_tail, LIM_UNLIMITED);	/* strip tail */
+	lmm_kv_push(fna->lmm, *v, '\0');							/* push null terminator */
+
+	/* check termination */
+	debug("seq_len(%lld), qual_len(%lld), name_len(%lld)", seq_len, qual_len, name_len);
+	if(seq_len != qual_len || (name_len == 0 && seq_len == 0)) {
+		lmm_kv_size(*v) = base;
+		return(NULL);
+	}
+
+	/* make margin at the tail */
+	fna_seq_make_margin(fna, v, fna->tail_margin);
+
+	/* finished, build links */
+	struct fna_seq_intl_s *r = (struct fna_seq_intl_s *)(
+		lmm_kv_ptr(*v) + base + fna->head_margin);
+	fna_segment_link(r, name, com, seq,
+		(skip_qual == 0) ? qual : (struct fna_read_ret_s){ .len = 0 });
+	return(r);
+
+	#if 0
+	char *name = (char *)(r + 1);
+	uint8_t *seq = (uint8_t *)(name + (name_len + 1) + r->seq_head_margin);
+	uint8_t *qual = (uint8_t *)(seq + (seq_len + 1) + r->seq_tail_margin);
+
+	return(_fna_pack_segment(r,
+		name, name_len,
+		seq, seq_len,
+		qual, qual_len));
+	#endif
+}
+
+/**
+ * @fn fna_read_head_fast5
+ */
+static
+int fna_read_head_fast5(
+	struct fna_context_s *fna)
+{
+#ifdef HAVE_HDF5
+	/** not implemented yet */
+#endif /* HAVE_HDF5 */
+	return(FNA_EOF);
+}
+
+/**
+ * @fn fna_read_fast5
+ *
+ * @brief (internal) fast5 format parser
+ */
+static
+struct fna_seq_intl_s *fna_read_fast5(
+	struct fna_context_s *fna,
+	lmm_kvec_uint8_t *v)
+{
+#ifdef HAVE_HDF5
+	/** not implemented yet */
+#endif /* HAVE_HDF5 */
+	return(NULL);
+}
+
+/**
+ * @struct fna_names_s
+ * @brief segment names and their ids (FNA_INTERN_NAMES). the table is open-addressed with
+ * linear probing and kept at most half full; a slot holds the 32-bit hash of the name in
+ * the upper half and id + 1 in the lower half (zero for empty ones), so probes compare the
+ * names only on a hash match and the table is grown without hashing the names again.
+ */
+struct fna_names_s {
+	lmm_t *lmm;
+	uint64_t *table;
+	uint64_t mask;				/** size of the table - 1 */
+	lmm_kvec_t(int64_t) ofs;	/** head of the name of each id in buf */
+	lmm_kvec_t(char) buf;		/** names, null-terminated and back to back */
+};
+#define FNA_NAMES_INIT_SIZE		( 1024 )
+
+/**
+ * @fn fna_names_hash
+ */
+static _force_inline
+uint32_t fna_names_hash(
+	char const *p,
+	int64_t len)
+{
+	uint64_t h = 0x9e3779b97f4a7c15ULL ^ (uint64_t)len, x;
+	for(; len >= 8; p += 8, len -= 8) {
+		memcpy(&x, p, 8);
+		h = (h ^ x) * 0xff51afd7ed558ccdULL; h ^= h >> 32;
+	}
+	x = 0; memcpy(&x, p, len);
+	h = (h ^ x) * 0xc4ceb9fe1a85ec53ULL; h ^= h >> 29;
+	return((uint32_t)(h >> 32));
+}
+
+/**
+ * @fn fna_names_slot
+ * @brief the slot of the name, or the empty slot where it goes
+ */
+static _force_inline
+uint64_t *fna_names_slot(
+	struct fna_names_s const *n,
+	char const *p,
+	int64_t len,
+	uint32_t h)
+{
+	for(uint64_t i = h & n->mask;; i = (i + 1) & n->mask) {
+		uint64_t const e = n->table[i];
+		if(e == 0) { return(&n->table[i]); }
+		if((uint32_t)(e>>32) != h) { continue; }
+
+		char const *q = lmm_kv_ptr(n->buf) + lmm_kv_at(n->ofs, (e & 0xffffffff) - 1);
+		if(strncmp(q, p, len) == 0 && q[len] == '\0') { return(&n->table[i]); }	/* stops at the end of a shorter q */
+	}
+}
+
+/**
+ * @fn fna_names_close
+ */
+static
+void fna_names_close(
+	struct fna_names_s *n)
+{
+	if(n == NULL) { return; }
+	lmm_kv_destroy(n->lmm, n->ofs);
+	lmm_kv_destroy(n->lmm, n->buf);
+	lmm_free(n->lmm, n->table);
+	lmm_free(n->lmm, n);
+	return;
+}
+
+/**
+ * @fn fna_names_init
+ */
+static
+struct fna_names_s *fna_names_init(
+	lmm_t *lmm)
+{
+	struct fna_names_s *n = (struct fna_names_s *)lmm_malloc(lmm, sizeof(struct fna_names_s));
+	if(n == NULL) { return(NULL); }
+	n->lmm = lmm;
+	n->mask = FNA_NAMES_INIT_SIZE - 1;
+	lmm_kv_init(lmm, n->ofs);
+	lmm_kv_init(lmm, n->buf);
+	if((n->table = (uint64_t *)lmm_malloc(lmm, FNA_NAMES_INIT_SIZE * sizeof(uint64_t))) == NULL) {
+		fna_names_close(n);
+		return(NULL);
+	}
+	memset(n->table, 0, FNA_NAMES_INIT_SIZE * sizeof(uint64_t));
+	return(n);
+}
+
+/**
+ * @fn fna_names_grow
+ * @brief double the table, slots are moved with the hashes they hold
+ */
+static
+int fna_names_grow(
+	struct fna_names_s *n)
+{
+	uint64_t const size = 2 * (n->mask + 1);
+	uint64_t *table = (uint64_t *)lmm_malloc(n->lmm, size * sizeof(uint64_t));
+	if(table == NULL) { return(-1); }
+	memset(table, 0, size * sizeof(uint64_t));
+
+	for(uint64_t i = 0; i <= n->mask; i++) {
+		uint64_t const e = n->table[i];
+		if(e == 0) { continue; }
+
+		uint64_t j = (e>>32) & (size - 1);
+		while(table[j] != 0) { j = (j + 1) & (size - 1); }
+		table[j] = e;
+	}
+	lmm_free(n->lmm, n->table);
+	n->table = table;
+	n->mask = size - 1;
+	return(0);
+}
+
+/**
+ * @fn fna_names_find
+ * @brief id of the name, -1 if not found
+ */
+static _force_inline
+int64_t fna_names_find(
+	struct fna_names_s const *n,
+	char const *p,
+	int64_t len)
+{
+	if(n == NULL) { return(-1); }
+	uint64_t const e = *fna_names_slot(n, p, len, fna_names_hash(p, len));
+	return((int64_t)(e & 0xffffffff) - 1);
+}
+
+/**
+ * @fn fna_intern
+ * @brief id of a segment name, given to a new name; -1 without FNA_INTERN_NAMES (or out of memory)
+ */
+static _force_inline
+int32_t fna_intern(
+	struct fna_context_s *fna,
+	char const *p,
+	int64_t len)
+{
+	if((fna->options & FNA_INTERN_NAMES) == 0) { return(-1); }
+	if(fna->names == NULL && (fna->names = fna_names_init(fna->lmm)) == NULL) { return(-1); }
+
+	struct fna_names_s *n = fna->names;
+	uint32_t const h = fna_names_hash(p, len);
+	uint64_t *e = fna_names_slot(n, p, len, h);
+	if(*e != 0) { return((int32_t)(*e & 0xffffffff) - 1); }
+
+	/* new name; grow before the table gets half full */
+	int64_t const id = lmm_kv_size(n->ofs);
+	if(2 * (uint64_t)(id + 1) > n->mask + 1) {
+		if(fna_names_grow(n) != 0) { return(-1); }
+		e = fna_names_slot(n, p, len, h);
+	}
+	lmm_kv_push(n->lmm, n->ofs, lmm_kv_size(n->buf));
+	lmm_kv_pushm(n->lmm, n->buf, p, len);
+	lmm_kv_push(n->lmm, n->buf, '\0');
+	*e = ((uint64_t)h<<32) | (uint64_t)(id + 1);
+	return((int32_t)id);
+}
+
+/**
+ * @fn fna_read_head_gfa
+ */
+static
+int fna_read_head_gfa(
+	struct fna_context_s *fna)
+{
+	lmm_kvec_uint8_t buf;
+	lmm_kv_init(fna->lmm, buf);
+
+	debug("parse gfa header");
+
+	/* read until '\n' */
+	fna->read_ascii(fna, &buf, &delim_line);
+
+	/* check prefix */
+	char const *prefix = "H\tVN:Z:";
+	if(strncmp((char const *)lmm_kv_ptr(buf), prefix, strlen(prefix)) != 0) {
+		debug("broken");
+		lmm_kv_destroy(fna->lmm, buf);
+		return(fna->status = FNA_ERROR_BROKEN_FORMAT);
+	}
+
+	/* check version */
+	uint64_t version = fna_parse_version_string(&((char const *)lmm_kv_ptr(buf))[strlen(prefix)]);
+
+	/* cleanup */
+	lmm_kv_destroy(fna->lmm, buf);
+
+	debug("%llx", version);
+	return((version >= 0x10000) ? FNA_SUCCESS : FNA_ERROR_UNSUPPORTED_VERSION);
+}
+
+/**
+ * @fn fna_read_gfa_seq
+ */
+static _force_inline
+struct fna_seq_intl_s *fna_read_gfa_seq(
+	struct fna_context_s *fna,
+	lmm_kvec_uint8_t *v)
+{
+	int64_t const base = lmm_kv_size(*v);
+
+	/* make margin at the head of seq */
+	fna_seq_make_margin(fna, v, fna->head_margin);
+
+	lmm_kv_pusha(fna->lmm, struct fna_seq_intl_s, *v, ((struct fna_seq_intl_s){
+		.lmm = fna->lmm,
+		.type = FNA_SEGMENT,
+		.seq_encode = fna->seq_encode,
+		.options = fna->options,
+		.head_margin = fna->head_margin,
+		.tail_margin = fna->tail_margin,
+		.seq_head_margin = fna->seq_head_margin,
+		.seq_tail_margin = fna->seq_tail_margin
+	}));
+
+	/* parse name */
+	int64_t name_len = fna->read_ascii(fna, v, &delim_gfa_field).len;
+
+	/* comment is always blank */
+	lmm_kv_push(fna->lmm, *v, '\0');
+
+	/* parse seq */
+	fna_seq_make_margin(fna, v, fna->seq_head_margin);
+	struct fna_read_ret_s ret = fna->read_seq(fna, v, &delim_gfa_field, LIM_UNLIMITED);
+	int64_t seq_len = ret.len;
+
+	/* check if optional field remains */
+	if(ret.c == '\t') {
+		/* skip optional fields */
+		fna->read_skip(fna, &delim_line, LIM_UNLIMITED);
+	}
+
+	/* check termination */
+	if(name_len == 0 && seq_len == 0) {
+		lmm_kv_size(*v) = base;
+		return(NULL);
+	}
+
+	/* make margin at the tail */
+	fna_seq_make_margin(fna, v, fna->seq_tail_margin);
+	lmm_kv_push(fna->lmm, *v, '\0');
+	fna_seq_make_margin(fna, v, fna->tail_margin);
+
+	/* finished, build links */
+	struct fna_seq_intl_s *r = (struct fna_seq_intl_s *)(
+		lmm_kv_ptr(*v) + base + fna->head_margin);
+
+	#define _next(x)		( (x).ptr + (x).len + 1 )
+	r->s.segment.name = (struct fna_str_s){
+		.ptr = (char const *)(r + 1),
+		.len = name_len,
+		.id = fna_intern(fna, (char const *)(r + 1), name_len)
+	};
+	r->s.segment.comment = (struct fna_str_s){
+		.ptr = (char const *)_next(r->s.segment.name),
+		.len = 0
+	};
+	r->s.segment.seq = (struct fna_sarr_s){
+		.ptr = (uint8_t const *)(_next(r->s.segment.comment) + r->seq_head_margin),
+		.len = seq_len
+	};
+	r->s.segment.qual = (struct fna_sarr_s){
+		.ptr = (uint8_t const *)(r->s.segment.seq.ptr
+			+ fna_encoded_size(r->seq_encode, r->s.segment.seq.len) + r->seq_tail_margin),
+		.len = 0
+	};
+	#undef _next
+
+	return(r);
+
+	#if 0
+	char *name = (char *)(r + 1);
+	uint8_t *seq = (uint8_t *)(name + (name_len + 1) + r->seq_head_margin);
+	uint8_t *qual = (uint8_t *)(seq + (seq_len + 1) + r->seq_tail_margin);
+	int64_t qual_len = 0;
+
+	return(_fna_pack_segment(r,
+		name, name_len,
+		seq, seq_len,
+		qual, qual_len));
+	#endif
+}
+
+/**
+ * @fn fna_read_gfa_edge
+ * @brief parse 'L' and 'C' lines; they share the layout of the body, src\0 dst\0 cigar\0,
+ * and the containment has the position before the cigar
+ */
+static _force_inline
+struct fna_seq_intl_s *fna_read_gfa_edge(
+	struct fna_context_s *fna,
+	lmm_kvec_uint8_t *v,
+	uint8_t type)
+{
+	int64_t const base = lmm_kv_size(*v);
+
+	/* make margin at the head of seq */
+	fna_seq_make_margin(fna, v, fna->head_margin);
+
+	lmm_kv_pusha(fna->lmm, struct fna_seq_intl_s, *v, ((struct fna_seq_intl_s){
+		.lmm = fna->lmm,
+		.type = type,
+		.seq_encode = fna->seq_encode,
+		.options = fna->options,
+		.head_margin = fna->head_margin,
+		.tail_margin = fna->tail_margin,
+		.seq_head_margin = fna->seq_head_margin,
+		.seq_tail_margin = fna->seq_tail_margin
+	}));
+
+	/* parse from field */
+	struct fna_read_ret_s ret_src = fna->read_ascii(fna, v, &delim_gfa_field);
+	if(ret_src.c != '\t') {
+		fna->status = FNA_ERROR_BROKEN_FORMAT;
+		return(NULL);
+	}
+
+	/* direction */
+	int64_t src_ori = (fna_buf_getc(fna) == '+') ? 0 : 1;
+	if(fna_buf_getc(fna) != '\t') {
+		fna->status = FNA_ERROR_BROKEN_FORMAT;
+		return(NULL);
+	}
+
+	/* parse to field */
+	struct fna_read_ret_s ret_dst = fna->read_ascii(fna, v, &delim_gfa_field);
+	if(ret_dst.c != '\t') {
+		fna->status = FNA_ERROR_BROKEN_FORMAT;
+		return(NULL);
+	}
+
+	/* direction */
+	int64_t dst_ori = (fna_buf_getc(fna) == '+') ? 0 : 1;
+	if(fna_buf_getc(fna) != '\t') {
+		fna->status = FNA_ERROR_BROKEN_FORMAT;
+		return(NULL);
+	}
+
+	/* position of the contained segment */
+	int64_t pos = 0;
+	if(type == FNA_CONTAINMENT) {
+		int c, cnt = 0;
+		while((uint8_t)((c = fna_buf_getc(fna)) - '0') < 10) {
+			pos = pos * 10 + (c - '0'); cnt++;
+		}
+		if(cnt == 0 || c != '\t') {
+			fna->status = FNA_ERROR_BROKEN_FORMAT;
+			return(NULL);
+		}
+	}
+
+	/* parse cigar field */
+	struct fna_read_ret_s ret_cig = fna->read_ascii(fna, v, &delim_gfa_field);
+
+	/* check if optional field remains */
+	if(ret_cig.c == '\t') {
+		/* skip optional fields */
+		fna->read_skip(fna, &delim_line, LIM_UNLIMITED);
+	}
+
+	/* make margin at the tail */
+	fna_seq_make_margin(fna, v, fna->tail_margin);
+
+	/* finished, build links */
+	struct fna_seq_intl_s *r = (struct fna_seq_intl_s *)(
+		lmm_kv_ptr(*v) + base + fna->head_margin);
+
+	#define _next(x)		( (x).ptr + (x).len + 1 )
+	r->s.link.src = (struct fna_str_s){
+		.ptr = (char const *)(r + 1),
+		.len = ret_src.len
+	};
+	r->s.link.src.id = fna_intern(fna, r->s.link.src.ptr, r->s.link.src.len);
+	r->s.link.src_ori = src_ori;
+	r->s.link.dst = (struct fna_str_s){
+		.ptr = (char const *)_next(r->s.link.src),
+		.len = ret_dst.len
+	};
+	r->s.link.dst.id = fna_intern(fna, r->s.link.dst.ptr, r->s.link.dst.len);
+	r->s.link.dst_ori = dst_ori;
+	r->s.link.cigar = (struct fna_cigar_s){
+		.ptr = (char const *)_next(r->s.link.dst),
+		.len = ret_cig.len
+	};
+	#undef _next
+
+	/* replace "*" with "" */
+	if(r->s.link.cigar.ptr[0] == '*') {
+		((char *)r->s.link.cigar.ptr)[0] = '\0';
+		r->s.link.cigar.len = 0;
+	}
+	if(type == FNA_CONTAINMENT) {
+		r->s.containment.pos = pos;
+	}
+	return(r);
+}
+
+/**
+ * @fn fna_read_gfa_link
+ */
+static _force_inline
+struct fna_seq_intl_s *fna_read_gfa_link(
+	struct fna_context_s *fna,
+	lmm_kvec_uint8_t *v)
+{
+	return(fna_read_gfa_edge(fna, v, FNA_LINK));
+}
+
+/**
+ * @fn fna_read_gfa_cont
+ */
+static _force_inline
+struct fna_seq_intl_s *fna_read_gfa_cont(
+	struct fna_context_s *fna,
+	lmm_kvec_uint8_t *v)
+{
+	return(fna_read_gfa_edge(fna, v, FNA_CONTAINMENT));
+}
+
+/**
+ * @fn fna_read_gfa_path
+ * @brief the body is name\0 step names\0... overlap\0, followed by the offsets of the
+ * step names (aligned to 8 bytes from the record), the ids, and the orientations. each step
+ * is cut out by the field scanner and its trailing '+' / '-' is stripped in place, so the
+ * names are copied once; the arrays are gathered aside until the count is known.
+ */
+static _force_inline
+struct fna_seq_intl_s *fna_read_gfa_path(
+	struct fna_context_s *fna,
+	lmm_kvec_uint8_t *v)
+{
+	int64_t const base = lmm_kv_size(*v);
+
+	/* make margin at the head of seq */
+	fna_seq_make_margin(fna, v, fna->head_margin);
+
+	lmm_kv_pusha(fna->lmm, struct fna_seq_intl_s, *v, ((struct fna_seq_intl_s){
+		.lmm = fna->lmm,
+		.type = FNA_PATH,
+		.seq_encode = fna->seq_encode,
+		.options = fna->options,
+		.head_margin = fna->head_margin,
+		.tail_margin = fna->tail_margin,
+		.seq_head_margin = fna->seq_head_margin,
+		.seq_tail_margin = fna->seq_tail_margin
+	}));
+	int64_t const head = base + fna->head_margin;
+	int64_t const body = head + sizeof(struct fna_seq_intl_s);
+
+	/* path name */
+	struct fna_read_ret_s ret_name = fna->read_ascii(fna, v, &delim_gfa_field);
+	if(ret_name.c != '\t') {
+		fna->status = FNA_ERROR_BROKEN_FORMAT;
+		return(NULL);
+	}
+
+	/* steps, "name+,name-,..." */
+	int const intern = (fna->options & FNA_INTERN_NAMES) != 0;
+	lmm_kvec_t(int64_t) ofs;
+	lmm_kvec_t(int32_t) id;
+	lmm_kvec_t(uint8_t) ori;
+	lmm_kv_init(fna->lmm, ofs);
+	lmm_kv_init(fna->lmm, id);
+	lmm_kv_init(fna->lmm, ori);
+
+	#define _destroy() { \
+		lmm_kv_destroy(fna->lmm, ofs); \
+		lmm_kv_destroy(fna->lmm, id); \
+		lmm_kv_destroy(fna->lmm, ori); \
+	}
+	struct fna_read_ret_s ret = { .c = ',' };
+	while(ret.c == ',') {
+		int64_t const p = lmm_kv_size(*v);
+		ret = fna->read_ascii(fna, v, &delim_gfa_step);
+
+		/* orientation at the tail of the name */
+		uint8_t const c = (ret.len > 1) ? lmm_kv_at(*v, p + ret.len - 1) : 0;
+		if(c != '+' && c != '-') {
+			_destroy();
+			fna->status = FNA_ERROR_BROKEN_FORMAT;
+			return(NULL);
+		}
+		lmm_kv_at(*v, p + ret.len - 1) = '\0';
+		lmm_kv_size(*v)--;
+		lmm_kv_push(fna->lmm, ofs, p - body);
+		lmm_kv_push(fna->lmm, ori, c == '-');
+		if(intern) {
+			lmm_kv_push(fna->lmm, id, fna_intern(fna, (char const *)lmm_kv_ptr(*v) + p, ret.len - 1));
+		}
+	}
+
+	/* overlaps, "*" is replaced with "" */
+	int64_t const ovl = lmm_kv_size(*v);
+	struct fna_read_ret_s ret_ovl = { .len = 0, .c = ret.c };
+	if(ret.c == '\t') {
+		ret_ovl = fna->read_ascii(fna, v, &delim_gfa_field);
+		if(ret_ovl.len == 1 && lmm_kv_at(*v, ovl) == '*') {
+			lmm_kv_at(*v, ovl) = '\0';
+			lmm_kv_size(*v)--;
+			ret_ovl.len = 0;
+		}
+	} else {
+		lmm_kv_push(fna->lmm, *v, '\0');
+	}
+
+	/* check if optional field remains */
+	if(ret_ovl.c == '\t') {
+		/* skip optional fields */
+		fna->read_skip(fna, &delim_line, LIM_UNLIMITED);
+	}
+
+	/* offsets, ids, and orientations */
+	int64_t const cnt = lmm_kv_size(ofs);
+	fna_seq_make_margin(fna, v, _roundup(lmm_kv_size(*v) - head, 8) - (lmm_kv_size(*v) - head));
+	int64_t const arr = lmm_kv_size(*v);
+	#define _append(_kv) { \
+		uint64_t const _size = lmm_kv_size(_kv) * sizeof(*lmm_kv_ptr(_kv)); \
+		memcpy(fna_kv_expand(fna, v, _size), lmm_kv_ptr(_kv), _size); \
+		lmm_kv_size(*v) += _size; \
+	}
+	_append(ofs);
+	_append(id);
+	_append(ori);
+	#undef _append
+	_destroy();
+	#undef _destroy
+
+	/* make margin at the tail */
+	fna_seq_make_margin(fna, v, fna->tail_margin);
+
+	/* finished, build links */
+	uint8_t *h = lmm_kv_ptr(*v);
+	struct fna_seq_intl_s *r = (struct fna_seq_intl_s *)(h + head);
+	r->s.path = (struct fna_path_s){
+		.name = { .ptr = (char const *)(r + 1), .len = ret_name.len, .id = -1 },
+		.len = cnt,
+		.seg_ofs = (int64_t const *)(h + arr),
+		.ori = h + arr + cnt * (sizeof(int64_t) + (intern ? sizeof(int32_t) : 0)),
+		.seg_id = intern ? (int32_t const *)(h + arr + cnt * sizeof(int64_t)) : NULL,
+		.overlap = { .ptr = (char const *)(h + ovl), .len = ret_ovl.len }
+	};
+	return(r);
+}
+
+/**
+ * @fn fna_read_gfa
+ *
+ * @brief gfa parser driver
+ */
+static
+struct fna_seq_intl_s *fna_read_gfa(
+	struct fna_context_s *fna,
+	lmm_kvec_uint8_t *v)
+{
+	int c;
+	while((c = fna_buf_getc(fna)) != EOF) {
+
+		/* eat tab after type character */
+		if(fna_buf_getc(fna) != '\t') {
+			fna->status = FNA_ERROR_BROKEN_FORMAT;
+			return(NULL);
+		}
+
+		/* examine type */
+		switch(c) {
+			case 'S': return(fna_read_gfa_seq(fna, v));
+			case 'L': return(fna_read_gfa_link(fna, v));
+			case 'C': return(fna_read_gfa_cont(fna, v));
+			case 'P': return(fna_read_gfa_path(fna, v));
+
+			default:
+			/* broken broken broken */
+			fna->status = FNA_ERROR_BROKEN_FORMAT;
+			return(NULL);
+		}
+
+	}
+	fna->status = FNA_EOF;
+	return(NULL);
+}
+
+/**
+ * @fn fna_seq_free_fields
+ * @brief (internal) free fields placed out of the record body
+ */
+static _force_inline
+void fna_seq_free_fields(
+	struct fna_seq_intl_s *s)
+{
+	#define _next(x)		( (x).ptr + (x).len + 1 )
+
+	/* free if external mem is used */
+	if(s->type == FNA_SEGMENT) {
+
+		/* segment, views into the mapped file are not freed */
+		uint8_t const *base[4];
+		fna_segment_base(s, base);
+
+		if((s->flags & FNA_VIEW_NAME) == 0 && (uint8_t const *)s->s.segment.name.ptr != base[0]) {
+			lmm_free(s->lmm, (void *)s->s.segment.name.ptr);
+		}
+		if((s->flags & FNA_VIEW_COMMENT) == 0 && (uint8_t const *)s->s.segment.comment.ptr != base[1]) {
+			lmm_free(s->lmm, (void *)s->s.segment.comment.ptr);
+		}
+		if(s->flags & FNA_OUT_SEQ) {
+			/* base[2] and base[3] no longer match the lengths */
+			lmm_free(s->lmm, (void *)(s->s.segment.seq.ptr - s->seq_head_margin));
+			lmm_free(s->lmm, (void *)s->s.segment.qual.ptr);
+		} else {
+			if((s->flags & FNA_VIEW_SEQ) == 0 && s->s.segment.seq.ptr != base[2]) {
+				lmm_free(s->lmm, (void *)s->s.segment.seq.ptr);
+			}
+			if((s->flags & FNA_VIEW_QUAL) == 0 && s->s.segment.qual.ptr != base[3]) {
+				lmm_free(s->lmm, (void *)s->s.segment.qual.ptr);
+			}
+		}
+
+		s->s.segment.name.ptr = NULL;
+		s->s.segment.comment.ptr = NULL;
+		s->s.segment.seq.ptr = NULL;
+		s->s.segment.qual.ptr = NULL;
+
+	} else if(s->type == FNA_LINK || s->type == FNA_CONTAINMENT) {
+
+		/* link and containment, fields shared at the same offsets */
+		char const *src_base = (char const *)(s + 1);
+		char const *dst_base = (char const *)_next(s->s.link.src);
+		char const *cigar_base = (char const *)_next(s->s.link.dst);
+
+		if(s->s.link.src.ptr != src_base) {
+			lmm_free(s->lmm, (void *)s->s.link.src.ptr);
+		}
+		if(s->s.link.dst.ptr != dst_base) {
+			lmm_free(s->lmm, (void *)s->s.link.dst.ptr);
+		}
+		if(s->s.link.cigar.ptr != cigar_base) {
+			lmm_free(s->lmm, (void *)s->s.link.cigar.ptr);
+		}
+
+		s->s.link.src.ptr = NULL;
+		s->s.link.dst.ptr = NULL;
+		s->s.link.cigar.ptr = NULL;
+	}
+
+	#undef _next
+	return;
+}
+
+/**
+ * @fn fna_read
+ *
+ * @brief read a sequence
+ *
+ * @param[in] fna : a pointer to the context
+ *
+ * @return a pointer to a sequence object
+ */
+fna_seq_t *fna_read(fna_t *ctx)
+{
+	struct fna_context_s *fna = (struct fna_context_s *)ctx;
+	if(fna == NULL) { return NULL; }
+
+	#if defined(HAVE_PTHREAD)
+		/* the records are already allocated by the parser thread */
+		if(fna->queue != NULL) { return((fna_seq_t *)fna_queue_read(fna, 1)); }
+	#endif
+
+	lmm_kvec_uint8_t v;
+	lmm_kv_init(fna->lmm, v);
+	struct fna_seq_intl_s *r = fna->read(fna, &v);
+	fna->len_hint = -1;			/* for this record only, whether the parser took it or not */
+	if(r == NULL) {
+		lmm_kv_destroy(fna->lmm, v);
+		return(NULL);
+	}
+	r->size = lmm_kv_max(v);
+	return((fna_seq_t *)r);
+}
+
+/**
+ * @fn fna_try_read
+ *
+ * @brief read a sequence if one is ready, never blocks on a shared context (FNA_SHARED)
+ *
+ * @return a pointer to a sequence object, NULL if none is ready yet or the file pointer
+ * reached the end (fna->status is FNA_EOF then)
+ */
+fna_seq_t *fna_try_read(fna_t *ctx)
+{
+	#if defined(HAVE_PTHREAD)
+		struct fna_context_s *fna = (struct fna_context_s *)ctx;
+		if(fna != NULL && fna->queue != NULL) { return((fna_seq_t *)fna_queue_read(fna, 0)); }
+	#endif
+	return(fna_read(ctx));
+}
+
+/**
+ * @fn fna_read_into
+ *
+ * @brief read a sequence into the buffer of seq, which is grown only if the record does not fit
+ *
+ * @param[in] fna : a pointer to the context
+ * @param[in] seq : a record returned by fna_read or fna_read_into, consumed (may be NULL)
+ *
+ * @return a pointer to a sequence object, NULL if the file pointer reached the end (seq is freed).
+ */
+fna_seq_t *fna_read_into(fna_t *ctx, fna_seq_t *seq)
+{
+	struct fna_context_s *fna = (struct fna_context_s *)ctx;
+	struct fna_seq_intl_s *s = (struct fna_seq_intl_s *)seq;
+	if(fna == NULL) { return NULL; }
+
+	/* records from a batch or another memory manager are not recycled */
+	if(s == NULL || (s->flags & FNA_IN_BATCH) != 0 || s->lmm != fna->lmm || s->size == 0) {
+		fna_seq_free(seq);
+		return(fna_read(ctx));
+	}
+
+	/* reuse the whole buffer, head margin included */
+	fna_seq_free_fields(s);
+	lmm_kvec_uint8_t v = {
+		.n = 0,
+		.m = s->size,
+		.a = (uint8_t *)s - s->head_margin
+	};
+	struct fna_seq_intl_s *r = fna->read(fna, &v);
+	fna->len_hint = -1;
+	if(r == NULL) {
+		lmm_kv_destroy(fna->lmm, v);
+		return(NULL);
+	}
+	r->size = lmm_kv_max(v);
+	return((fna_seq_t *)r);
+}
+
+/**
+ * @fn fna_set_len_hint
+ *
+ * @brief tell the length of the sequence of the next record, which is then read into a buffer of the
+ * final size (FASTA). the hint is dropped after the record, and the record is read as usual if it is wrong.
+ *
+ * @return FNA_SUCCESS, FNA_ERROR_UNSUPPORTED_VERSION on contexts parsing ahead on threads (pooled or FNA_SHARED)
+ */
+int fna_set_len_hint(
+	fna_t *ctx,
+	int64_t len)
+{
+	struct fna_context_s *fna = (struct fna_context_s *)ctx;
+	if(fna == NULL) { return(FNA_ERROR_FILE_OPEN); }
+	#if defined(HAVE_PTHREAD)
+		if(fna->queue != NULL || fna->read == fna_read_pool) { return(FNA_ERROR_UNSUPPORTED_VERSION); }
+	#endif
+	fna->len_hint = len;
+	return(FNA_SUCCESS);
+}
+
+/**
+ * @fn fna_fetch
+ *
+ * @brief read bases [start, end) (0-based, clipped to the sequence) of a sequence in an uncompressed
+ * or bgzipped FASTA, through <path>.fai and <path>.gzi (loaded, or built, on the first call)
+ *
+ * @return a record named name (no comment) in the encoding of the context, NULL if the index is not
+ * available or name is not found
+ */
+fna_seq_t *fna_fetch(
+	fna_t *ctx,
+	char const *name,
+	int64_t start,
+	int64_t end)
+{
+	struct fna_context_s *fna = (struct fna_context_s *)ctx;
+	if(fna == NULL || name == NULL) { return(NULL); }
+	if(fna->fai == NULL && (fna->fai = fna_fai_open(fna->path, 1)) == NULL) { return(NULL); }
+	if(fna->fai->fd < 0) {
+		uint64_t size = 0;
+		if((fna->fai->fd = fna_fai_open_file(fna->path, &size, &fna->fai->bgzf)) < 0) { return(NULL); }
+	}
+
+	struct fna_fai_rec_s const *e = fna_fai_find(fna->fai, name, strlen(name));
+	if(e == NULL) { return(NULL); }
+
+	/* bytes spanning the bases */
+	#define _pos(_i)		( e->offset + (_i) / e->line_bases * e->line_width + (_i) % e->line_bases )
+	start = MIN2(MAX2(start, 0), e->len);
+	end = MIN2(MAX2(end, start), e->len);
+	uint64_t const bs = (start < end) ? _pos(start) : 0;
+	uint64_t const be = (start < end) ? _pos(end - 1) + 1 : 0;
+	#undef _pos
+
+	uint8_t *buf = (uint8_t *)malloc(be - bs + FNA_BUF_MARGIN);
+	if(buf == NULL) { return(NULL); }
+	int64_t len = fna_fai_pread(fna->fai, buf, bs, be);
+
+	/* decode the bytes with the field readers of the context, in a window of its own */
+	struct fna_context_s w = *fna;
+	w.buf = w.p = buf;
+	w.t = buf + len;
+	w.eof = 1;
+	memset(w.t, FNA_BUF_SENTINEL, FNA_BUF_MARGIN);
+
+	lmm_kvec_uint8_t v;
+	lmm_kv_init(fna->lmm, v);
+	fna_seq_make_margin(fna, &v, fna->head_margin);
+	lmm_kv_pusha(fna->lmm, struct fna_seq_intl_s, v, ((struct fna_seq_intl_s){
+		.lmm = fna->lmm,
+		.type = FNA_SEGMENT,
+		.seq_encode = fna->seq_encode,
+		.options = fna->options,
+		.head_margin = fna->head_margin,
+		.tail_margin = fna->tail_margin,
+		.seq_head_margin = fna->seq_head_margin,
+		.seq_tail_margin = fna->seq_tail_margin
+	}));
+	int64_t const name_len = strlen(e->name);
+	lmm_kv_pushm(fna->lmm, v, (uint8_t const *)e->name, name_len + 1);
+	lmm_kv_push(fna->lmm, v, '\0');				/* comment */
+	fna_seq_make_margin(fna, &v, fna->seq_head_margin);
+	int64_t const seq_ofs = lmm_kv_size(v);
+	struct fna_read_ret_s seq = fna->read_seq(&w, &v, &delim_fasta_seq, end - start);
+	if(fna->options & FNA_EMIT_REVCOMP) {
+		seq = fna_emit_strand(fna, &v, seq_ofs, seq, fna->seq_encode, fna->revcomp);
+	}
+	fna_seq_make_margin(fna, &v, fna->seq_tail_margin);
+	lmm_kv_push(fna->lmm, v, '\0');				/* qual */
+	fna_seq_make_margin(fna, &v, fna->tail_margin);
+	free(buf);
+
+	struct fna_seq_intl_s *r = (struct fna_seq_intl_s *)(lmm_kv_ptr(v) + fna->head_margin);
+	fna_segment_link(r,
+		(struct fna_read_ret_s){ .len = name_len },
+		(struct fna_read_ret_s){ .len = 0 },
+		seq,
+		(struct fna_read_ret_s){ .len = 0 });
+	r->size = lmm_kv_max(v);
+	return((fna_seq_t *)r);
+}
+
+/**
+ * @fn fna_seq_relink
+ * @brief rebuild pointers to the fields in the record body after the record was moved
+ */
+static _force_inline
+void fna_seq_relink(
+	struct fna_seq_intl_s *r)
+{
+	#define _next(x)		( (x).ptr + (x).len + 1 )
+	if(r->type == FNA_SEGMENT) {
+		uint8_t const *base[4];
+		fna_segment_base(r, base);
+		if((r->flags & FNA_VIEW_NAME) == 0) { r->s.segment.name.ptr = (char const *)base[0]; }
+		if((r->flags & FNA_VIEW_COMMENT) == 0) { r->s.segment.comment.ptr = (char const *)base[1]; }
+		if((r->flags & FNA_VIEW_SEQ) == 0) { r->s.segment.seq.ptr = base[2]; }
+		if((r->flags & FNA_VIEW_QUAL) == 0) { r->s.segment.qual.ptr = base[3]; }
+	} else if(r->type == FNA_LINK || r->type == FNA_CONTAINMENT) {
+		r->s.link.src.ptr = (char const *)(r + 1);
+		r->s.link.dst.ptr = (char const *)_next(r->s.link.src);
+		r->s.link.cigar.ptr = (char const *)_next(r->s.link.dst);
+	} else if(r->type == FNA_PATH) {
+		/* the whole body moved together, shift the fields by the displacement of the name */
+		uintptr_t const d = (uintptr_t)(r + 1) - (uintptr_t)r->s.path.name.ptr;
+		r->s.path.name.ptr = (char const *)(r + 1);
+		r->s.path.seg_ofs = (int64_t const *)((uintptr_t)r->s.path.seg_ofs + d);
+		r->s.path.ori = (uint8_t const *)((uintptr_t)r->s.path.ori + d);
+		if(r->s.path.seg_id != NULL) { r->s.path.seg_id = (int32_t const *)((uintptr_t)r->s.path.seg_id + d); }
+		r->s.path.overlap.ptr = (char const *)((uintptr_t)r->s.path.overlap.ptr + d);
+	}
+	#undef _next
+	return;
+}
+
+/**
+ * @fn fna_pair_name_match
+ * @brief compare names of mates, up to the "/1" and "/2" suffixes
+ */
+static _force_inline
+int fna_pair_name_match(
+	struct fna_str_s a,
+	struct fna_str_s b)
+{
+	#define _strip(_s)	{ if((_s).len >= 2 && (_s).ptr[(_s).len - 2] == '/' && (uint8_t)((_s).ptr[(_s).len - 1] - '0') < 10) { (_s).len -= 2; } }
+	_strip(a);
+	_strip(b);
+	#undef _strip
+	return(a.len == b.len && memcmp(a.ptr, b.ptr, a.len) == 0);
+}
+
+/**
+ * @fn fna_read_batch_intl
+ * @brief read units of one record (unit == 1), or a pair of records from fna[0] and fna[1]
+ * (unit == 2, both may point to the same interleaved reader), into a single arena. *status
+ * is set to FNA_ERROR_BROKEN_FORMAT if a mate is missing or the names of mates differ.
+ */
+static
+fna_batch_t *fna_read_batch_intl(
+	struct fna_context_s *const *fna,
+	int64_t unit,
+	int64_t max_units,
+	int64_t max_bytes,
+	int32_t *status)
+{
+	if(max_units <= 0) { return NULL; }
+	if(max_bytes <= 0) { max_bytes = INT64_MAX; }
+
+	/* arena, records are appended after the header and linked when the arena is no longer moved */
+	lmm_t *lmm = fna[0]->lmm;
+	lmm_kvec_uint8_t v;
+	lmm_kv_init(lmm, v);
+	lmm_kv_reserve(lmm, v, MIN2(max_bytes, FNA_BATCH_INIT_SIZE));
+	lmm_kv_pusha(lmm, struct fna_batch_intl_s, v, ((struct fna_batch_intl_s){
+		.lmm = lmm
+	}));
+
+	lmm_kvec_t(int64_t) offs;
+	lmm_kv_init(lmm, offs);
+	while((int64_t)lmm_kv_size(offs) < unit * max_units && (int64_t)lmm_kv_size(v) < max_bytes) {
+		int64_t const head = lmm_kv_size(v);
+		int64_t k;
+		for(k = 0; k < unit; k++) {
+			fna_seq_make_margin(fna[k], &v, _roundup(lmm_kv_size(v), 16) - lmm_kv_size(v));
+
+			struct fna_seq_intl_s *r = fna[k]->read(fna[k], &v);
+			fna[k]->len_hint = -1;
+			if(r == NULL) { break; }
+			r->flags |= FNA_IN_BATCH;
+			lmm_kv_push(lmm, offs, (uint8_t *)r - lmm_kv_ptr(v));
+		}
+		if(k < unit) {
+			/* a mate is missing, either R1 or R2 is longer than the other */
+			if(k != 0 || (unit == 2 && fna[1] != fna[0] && fna[1]->read(fna[1], &v) != NULL)) {
+				*status = FNA_ERROR_BROKEN_FORMAT;
+			}
+			lmm_kv_size(offs) -= k;
+			lmm_kv_size(v) = head;
+			break;
+		}
+		if(unit == 2) {
+			struct fna_seq_intl_s *r1 = (struct fna_seq_intl_s *)(lmm_kv_ptr(v) + lmm_kv_at(offs, lmm_kv_size(offs) - 2));
+			struct fna_seq_intl_s *r2 = (struct fna_seq_intl_s *)(lmm_kv_ptr(v) + lmm_kv_at(offs, lmm_kv_size(offs) - 1));
+			fna_seq_relink(r1);
+			fna_seq_relink(r2);
+			if(!fna_pair_name_match(r1->s.segment.name, r2->s.segment.name)) {
+				*status = FNA_ERROR_BROKEN_FORMAT;
+				lmm_kv_size(offs) -= 2;
+				lmm_kv_size(v) = head;
+				break;
+			}
+		}
+	}
+
+	int64_t const cnt = lmm_kv_size(offs);
+	if(cnt == 0) {
+		lmm_kv_destroy(lmm, offs);
+		lmm_kv_destroy(lmm, v);
+		return(NULL);
+	}
+
+	/* pointer array at the tail */
+	fna_seq_make_margin(fna[0], &v, _roundup(lmm_kv_size(v), 16) - lmm_kv_size(v));
+	int64_t const arr = lmm_kv_size(v);
+	lmm_kv_reserve(lmm, v, arr + cnt * sizeof(struct fna_seq_intl_s *));
+	lmm_kv_size(v) += cnt * sizeof(struct fna_seq_intl_s *);
+
+	struct fna_batch_intl_s *b = (struct fna_batch_intl_s *)lmm_kv_ptr(v);
+	b->seq = (struct fna_seq_intl_s **)(lmm_kv_ptr(v) + arr);
+	b->cnt = cnt;
+	b->size = lmm_kv_size(v);
+	for(int64_t i = 0; i < cnt; i++) {
+		struct fna_seq_intl_s *r = (struct fna_seq_intl_s *)(lmm_kv_ptr(v) + lmm_kv_at(offs, i));
+		fna_seq_relink(r);
+		b->seq[i] = r;
+	}
+	lmm_kv_destroy(lmm, offs);
+	return((fna_batch_t *)b);
+}
+
+/**
+ * @fn fna_read_batch
+ *
+ * @brief read up to max_records records (or until the records exceed max_bytes) into a single arena
+ *
+ * @return a batch, NULL if no record remains
+ */
+fna_batch_t *fna_read_batch(
+	fna_t *ctx,
+	int64_t max_records,
+	int64_t max_bytes)
+{
+	struct fna_context_s *fna = (struct fna_context_s *)ctx;
+	if(fna == NULL) { return NULL; }
+	return(fna_read_batch_intl((struct fna_context_s *const [2]){ fna, fna }, 1, max_records, max_bytes, &fna->status));
+}
+
+/**
+ * @fn fna_batch_free
+ *
+ * @brief release a batch and all the records in it
+ */
+void fna_batch_free(
+	fna_batch_t *batch)
+{
+	struct fna_batch_intl_s *b = (struct fna_batch_intl_s *)batch;
+	if(b != NULL) {
+		lmm_free(b->lmm, (void *)b);
+	}
+	return;
+}
+
+/**
+ * @fn fna_init_pair
+ *
+ * @brief open R1 and R2 of paired-end reads, or interleaved pairs in path1 if path2 is NULL
+ */
+fna_pair_t *fna_init_pair(
+	char const *path1,
+	char const *path2,
+	fna_params_t const *params)
+{
+	fna_pair_t *pair = (fna_pair_t *)calloc(1, sizeof(fna_pair_t));
+	if(pair == NULL) { return(NULL); }
+
+	pair->fna[0] = fna_init(path1, params);
+	pair->fna[1] = (path2 != NULL) ? fna_init(path2, params) : pair->fna[0];
+	if(pair->fna[0] == NULL || pair->fna[1] == NULL) {
+		fna_close_pair(pair);
+		return(NULL);
+	}
+	pair->status = FNA_SUCCESS;
+	return(pair);
+}
+
+/**
+ * @fn fna_close_pair
+ */
+void fna_close_pair(
+	fna_pair_t *pair)
+{
+	if(pair != NULL) {
+		if(pair->fna[1] != pair->fna[0]) { fna_close(pair->fna[1]); }
+		fna_close(pair->fna[0]);
+		free(pair);
+	}
+	return;
+}
+
+/**
+ * @fn fna_read_pair
+ *
+ * @brief read up to max_pairs pairs into a single arena, mates are seq[2 * i] and seq[2 * i + 1]
+ *
+ * @return a batch, NULL if no pair remains or the files are out of sync (status is FNA_ERROR_BROKEN_FORMAT then)
+ */
+fna_batch_t *fna_read_pair(
+	fna_pair_t *pair,
+	int64_t max_pairs,
+	int64_t max_bytes)
+{
+	if(pair == NULL || pair->status != FNA_SUCCESS) { return(NULL); }
+
+	struct fna_context_s *const fna[2] = {
+		(struct fna_context_s *)pair->fna[0],
+		(struct fna_context_s *)pair->fna[1]
+	};
+	fna_batch_t *b = fna_read_batch_intl(fna, 2, max_pairs, max_bytes, &pair->status);
+	if(b == NULL && pair->status == FNA_SUCCESS) {
+		pair->status = (fna[0]->status != FNA_SUCCESS && fna[0]->status != FNA_EOF) ? fna[0]->status
+			: (fna[1]->status != FNA_SUCCESS && fna[1]->status != FNA_EOF) ? fna[1]->status
+			: FNA_EOF;
+	}
+	return(b);
+}
+
+/**
+ * @fn fna_tell_intl
+ * @brief offset of the head of the next record. the FASTA / FASTQ parsers stop after the
+ * '>' or '@' of the next record, GFA parsers at the head of the next line.
+ */
+static _force_inline
+uint64_t fna_tell_intl(
+	struct fna_context_s *fna)
+{
+	uint64_t pos = fna->pos - (fna->t - fna->p);
+	if((fna->file_format == FNA_FASTA || fna->file_format == FNA_FASTQ) && !fna_buf_eof(fna)) {
+		pos--;
+	}
+	return(pos);
+}
+
+#if defined(HAVE_PTHREAD)
+/**
+ * chunk pool: an uncompressed FASTA / FASTQ is cut into chunks of about
+ * FNA_POOL_CHUNK_SIZE at record heads (fna_split), and the workers parse the
+ * chunks into their own arenas on private range contexts. the reader takes the
+ * chunks in file order (or in the order they are finished with FNA_UNORDERED)
+ * and copies the records out one by one.
+ */
+#define FNA_POOL_CHUNK_SIZE			( 8 * 1024 * 1024 )
+
+/**
+ * @struct fna_pool_job_s
+ */
+struct fna_pool_job_s {
+	int64_t chunk;				/** chunk index, -1 if the slot is free */
+	int64_t state;				/** 0: in progress, 1: done */
+	int32_t status;				/** FNA_SUCCESS or an error from the worker context */
+	lmm_kvec_uint8_t arena;		/** records, head margin included */
+	lmm_kvec_t(int64_t) offs;	/** record i spans [offs[i], offs[i + 1]) in the arena */
+	lmm_kvec_t(uint64_t) ends;	/** fna_tell after record i */
+	int64_t pos;				/** next record to hand out */
+};
+
+/**
+ * @struct fna_pool_s
+ */
+struct fna_pool_s {
+	char *path;
+	fna_params_t params;		/** for the range contexts */
+	uint64_t *offs;
+	int64_t cnt;				/** number of chunks */
+	int64_t issued, consumed;	/** chunks given to the workers and taken by the reader */
+	int64_t busy;				/** occupied slots */
+	int64_t stop, ordered;
+	struct fna_pool_job_s *cur;	/** chunk the reader is on */
+	uint64_t pos;				/** fna_tell after the last record handed out */
+
+	pthread_mutex_t lock;
+	pthread_cond_t cond_free;	/** a slot was released */
+	pthread_cond_t cond_done;	/** a chunk was parsed */
+
+	int64_t threads, slots;
+	struct fna_pool_job_s *job;
+	pthread_t th[];
+};
+
+/**
+ * @fn fna_pool_parse
+ * @brief parse a chunk into the arena of the job
+ */
+static
+void fna_pool_parse(
+	struct fna_pool_s *q,
+	struct fna_pool_job_s *j)
+{
+	lmm_kv_clear(NULL, j->arena);
+	lmm_kv_clear(NULL, j->offs);
+	lmm_kv_clear(NULL, j->ends);
+	j->pos = 0;
+
+	struct fna_context_s *c = (struct fna_context_s *)fna_init_range(q->path, &q->params,
+		q->offs[j->chunk], q->offs[j->chunk + 1]);
+	if(c == NULL) {
+		j->status = FNA_ERROR_FILE_OPEN;
+		return;
+	}
+
+	lmm_kv_push(NULL, j->offs, 0);
+	while(1) {
+		fna_seq_make_margin(c, &j->arena, _roundup(lmm_kv_size(j->arena), 16) - lmm_kv_size(j->arena));
+		int64_t const base = lmm_kv_size(j->arena);
+		if(c->read(c, &j->arena) == NULL) {
+			lmm_kv_size(j->arena) = base;
+			break;
+		}
+		lmm_kv_at(j->offs, lmm_kv_size(j->offs) - 1) = base;
+		lmm_kv_push(NULL, j->offs, lmm_kv_size(j->arena));
+		lmm_kv_push(NULL, j->ends, fna_tell_intl(c));
+	}
+	j->status = (c->status == FNA_EOF) ? FNA_SUCCESS : c->status;
+	fna_close((fna_t *)c);
+	return;
+}
+
+/**
+ * @fn fna_pool_worker
+ */
+static
+void *fna_pool_worker(
+	void *arg)
+{
+	struct fna_pool_s *q = (struct fna_pool_s *)arg;
+
+	pthread_mutex_lock(&q->lock);
+	while(q->stop == 0 && q->issued < q->cnt) {
+		if(q->busy == q->slots) {
+			pthread_cond_wait(&q->cond_free, &q->lock);
+			continue;
+		}
+
+		/* take the next chunk and a free slot */
+		struct fna_pool_job_s *j = q->job;
+		while(j->chunk >= 0) { j++; }
+		j->chunk = q->issued++;
+		j->state = 0;
+		q->busy++;
+		pthread_mutex_unlock(&q->lock);
+
+		fna_pool_parse(q, j);
+
+		pthread_mutex_lock(&q->lock);
+		j->state = 1;
+		pthread_cond_broadcast(&q->cond_done);
+	}
+	pthread_mutex_unlock(&q->lock);
+	return(NULL);
+}
+
+/**
+ * @fn fna_read_pool
+ * @brief copy the next record out of the chunks, the parser of the pooled context
+ */
+static
+struct fna_seq_intl_s *fna_read_pool(
+	struct fna_context_s *fna,
+	lmm_kvec_uint8_t *v)
+{
+	struct fna_pool_s *q = (struct fna_pool_s *)fna->src;
+	struct fna_pool_job_s *j = q->cur;
+
+	while(j == NULL || j->pos + 1 >= (int64_t)lmm_kv_size(j->offs)) {
+		pthread_mutex_lock(&q->lock);
+		if(j != NULL) {
+			/* give the slot back */
+			j->chunk = -1;
+			q->cur = j = NULL;
+			q->busy--;
+			q->consumed++;
+			pthread_cond_broadcast(&q->cond_free);
+		}
+		while(q->consumed < q->cnt) {
+			for(int64_t i = 0; i < q->slots; i++) {
+				struct fna_pool_job_s *k = &q->job[i];
+				if(k->chunk >= 0 && k->state == 1 && (q->ordered == 0 || k->chunk == q->consumed)) {
+					j = k; break;
+				}
+			}
+			if(j != NULL) { break; }
+			pthread_cond_wait(&q->cond_done, &q->lock);
+		}
+		q->cur = j;
+		pthread_mutex_unlock(&q->lock);
+
+		if(j == NULL) {
+			fna->status = FNA_EOF;
+			return(NULL);
+		}
+		if(j->status != FNA_SUCCESS) {
+			fna->status = j->status;
+			return(NULL);
+		}
+	}
+
+	/* copy the record, then link it at its new place */
+	int64_t const base = lmm_kv_size(*v);
+	int64_t const len = lmm_kv_at(j->offs, j->pos + 1) - lmm_kv_at(j->offs, j->pos);
+	lmm_kv_reserve(fna->lmm, *v, base + len);
+	memcpy(lmm_kv_ptr(*v) + base, lmm_kv_ptr(j->arena) + lmm_kv_at(j->offs, j->pos), len);
+	lmm_kv_size(*v) += len;
+	q->pos = lmm_kv_at(j->ends, j->pos);
+	j->pos++;
+
+	struct fna_seq_intl_s *r = (struct fna_seq_intl_s *)(lmm_kv_ptr(*v) + base + fna->head_margin);
+	fna_seq_relink(r);
+	return(r);
+}
+
+/**
+ * @fn fna_pool_close
+ */
+static
+void fna_pool_close(
+	struct fna_context_s *fna)
+{
+	struct fna_pool_s *q = (struct fna_pool_s *)fna->src;
+
+	pthread_mutex_lock(&q->lock);
+	q->stop = 1;
+	pthread_cond_broadcast(&q->cond_free);
+	pthread_mutex_unlock(&q->lock);
+	for(int64_t i = 0; i < q->threads; i++) {
+		pthread_join(q->th[i], NULL);
+	}
+
+	for(int64_t i = 0; i < q->slots; i++) {
+		lmm_kv_destroy(NULL, q->job[i].arena);
+		lmm_kv_destroy(NULL, q->job[i].offs);
+		lmm_kv_destroy(NULL, q->job[i].ends);
+	}
+	pthread_mutex_destroy(&q->lock);
+	pthread_cond_destroy(&q->cond_free);
+	pthread_cond_destroy(&q->cond_done);
+	free(q->job);
+	free(q->offs);
+	free(q->path);
+	free(q);
+
+	fna->src = NULL;
+	return;
+}
+
+/**
+ * @fn fna_pool_open
+ * @brief start parsing an uncompressed file from begin (a record head) on params->threads workers,
+ * returns nonzero if the file is not worth splitting (or not splittable); the caller reads it sequentially then
+ */
+static
+int fna_pool_open(
+	struct fna_context_s *fna,
+	char const *path,
+	fna_params_t const *params,
+	uint64_t begin)
+{
+	uint64_t size = 0;
+	int fd = fna_open_plain(path, &size);
+	if(fd < 0) { return(-1); }
+	close(fd);
+
+	int64_t n = (size + FNA_POOL_CHUNK_SIZE - 1) / FNA_POOL_CHUNK_SIZE;
+	if(n < 2) { return(-1); }
+
+	int64_t const threads = params->threads;
+	struct fna_pool_s *q = (struct fna_pool_s *)calloc(1, sizeof(struct fna_pool_s) + sizeof(pthread_t) * threads);
+	if(q == NULL) { return(-1); }
+	q->offs = (uint64_t *)malloc(sizeof(uint64_t) * (n + 1));
+	q->path = strdup(path);
+	if(q->offs == NULL || q->path == NULL || (q->cnt = fna_split(path, n, q->offs)) < 2) {
+		free(q->offs); free(q->path); free(q);
+		return(-1);
+	}
+
+	/* drop the chunks before begin */
+	int64_t k = 0;
+	while(k < q->cnt && q->offs[k + 1] <= begin) { k++; }
+	if(k == q->cnt) {
+		free(q->offs); free(q->path); free(q);
+		return(-1);
+	}
+	memmove(q->offs, q->offs + k, sizeof(uint64_t) * (q->cnt - k + 1));
+	q->cnt -= k;
+	q->offs[0] = MAX2(q->offs[0], begin);
+	q->pos = q->offs[0];
+
+	/* range contexts parse the chunks in the callers' thread, through pread */
+	q->params = *params;
+	q->params.file_format = fna->file_format;
+	q->params.options &= ~FNA_MMAP;
+	q->params.threads = 0;
+	q->ordered = (params->options & FNA_UNORDERED) == 0;
+
+	q->slots = 2 * threads;
+	q->job = (struct fna_pool_job_s *)calloc(q->slots, sizeof(struct fna_pool_job_s));
+	if(q->job == NULL) {
+		free(q->offs); free(q->path); free(q);
+		return(-1);
+	}
+	for(int64_t i = 0; i < q->slots; i++) {
+		q->job[i].chunk = -1;
+		lmm_kv_init(NULL, q->job[i].arena);
+		lmm_kv_init(NULL, q->job[i].offs);
+		lmm_kv_init(NULL, q->job[i].ends);
+	}
+	pthread_mutex_init(&q->lock, NULL);
+	pthread_cond_init(&q->cond_free, NULL);
+	pthread_cond_init(&q->cond_done, NULL);
+
+	fna->src = (void *)q;
+	fna->src_close = fna_pool_close;
+	for(q->threads = 0; q->threads < threads; q->threads++) {
+		if(pthread_create(&q->th[q->threads], NULL, fna_pool_worker, (void *)q) != 0) { break; }
+	}
+	if(q->threads == 0) {
+		fna_pool_close(fna);
+		fna->src_close = NULL;
+		return(-1);
+	}
+	fna->read = fna_read_pool;
+	return(0);
+}
+#endif /* HAVE_PTHREAD */
+
+#if defined(HAVE_PTHREAD)
+/**
+ * shared reader (FNA_SHARED): a parser thread pushes the records into a bounded
+ * lock-free queue (Vyukov's MPMC ring, a sequence number per cell) and any number
+ * of threads pop them. both sides spin for a while on an empty or a full ring,
+ * then park on a condition; the other side takes the lock to wake them only when
+ * someone is parked, so the fast path has no lock.
+ */
+#define FNA_QUEUE_SIZE				( 1024 )	/* power of two */
+#define FNA_QUEUE_SPIN				( 256 )
+
+/**
+ * @struct fna_queue_cell_s
+ */
+struct fna_queue_cell_s {
+	uint64_t seq;
+	struct fna_seq_intl_s *r;
+};
+
+/**
+ * @struct fna_queue_s
+ */
+struct fna_queue_s {
+	uint64_t head;				/** next cell to push */
+	uint8_t _pad1[56];
+	uint64_t tail;				/** next cell to pop */
+	uint8_t _pad2[56];
+
+	int64_t done;				/** the parser thread pushed its last record */
+	int64_t stop;
+	int64_t waiters;			/** threads parked on cond */
+	int32_t status;				/** status of the parser at the end */
+
+	/* the parser thread works on a copy of the context, so that readers never see its state */
+	struct fna_context_s ctx;
+
+	pthread_t th;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	struct fna_queue_cell_s cell[FNA_QUEUE_SIZE];
+};
+
+/**
+ * @fn fna_queue_push
+ * @brief returns zero if the ring is full
+ */
+static _force_inline
+int fna_queue_push(
+	struct fna_queue_s *q,
+	struct fna_seq_intl_s *r)
+{
+	uint64_t pos = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+	while(1) {
+		struct fna_queue_cell_s *c = &q->cell[pos & (FNA_QUEUE_SIZE - 1)];
+		int64_t dif = (int64_t)(__atomic_load_n(&c->seq, __ATOMIC_ACQUIRE) - pos);
+		if(dif == 0) {
+			if(__atomic_compare_exchange_n(&q->head, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+				c->r = r;
+				__atomic_store_n(&c->seq, pos + 1, __ATOMIC_RELEASE);
+				return(1);
+			}
+		} else if(dif < 0) {
+			return(0);
+		} else {
+			pos = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+		}
+	}
+}
+
+/**
+ * @fn fna_queue_pop
+ * @brief returns NULL if the ring is empty
+ */
+static _force_inline
+struct fna_seq_intl_s *fna_queue_pop(
+	struct fna_queue_s *q)
+{
+	uint64_t pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+	while(1) {
+		struct fna_queue_cell_s *c = &q->cell[pos & (FNA_QUEUE_SIZE - 1)];
+		int64_t dif = (int64_t)(__atomic_load_n(&c->seq, __ATOMIC_ACQUIRE) - (pos + 1));
+		if(dif == 0) {
+			if(__atomic_compare_exchange_n(&q->tail, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+				struct fna_seq_intl_s *r = c->r;
+				__atomic_store_n(&c->seq, pos + FNA_QUEUE_SIZE, __ATOMIC_RELEASE);
+				return(r);
+			}
+		} else if(dif < 0) {
+			return(NULL);
+		} else {
+			pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+		}
+	}
+}
+
+/**
+ * @fn fna_queue_wake
+ * @brief wake the parked threads after a push or a pop, if any
+ */
+static _force_inline
+void fna_queue_wake(
+	struct fna_queue_s *q)
+{
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if(__atomic_load_n(&q->waiters, __ATOMIC_RELAXED) != 0) {
+		pthread_mutex_lock(&q->lock);
+		pthread_cond_broadcast(&q->cond);
+		pthread_mutex_unlock(&q->lock);
+	}
+	return;
+}
+
+/**
+ * @macro _fna_queue_park
+ * @brief park until cond is true; cond is evaluated after waiters is raised so that a wake is never lost
+ */
+#define _fna_queue_park(_q, _cond) { \
+	pthread_mutex_lock(&(_q)->lock); \
+	__atomic_add_fetch(&(_q)->waiters, 1, __ATOMIC_SEQ_CST); \
+	__atomic_thread_fence(__ATOMIC_SEQ_CST); \
+	while(!(_cond)) { pthread_cond_wait(&(_q)->cond, &(_q)->lock); } \
+	__atomic_sub_fetch(&(_q)->waiters, 1, __ATOMIC_SEQ_CST); \
+	pthread_mutex_unlock(&(_q)->lock); \
+}
+
+/**
+ * @fn fna_queue_worker
+ * @brief the parser thread
+ */
+static
+void *fna_queue_worker(
+	void *arg)
+{
+	struct fna_queue_s *q = (struct fna_queue_s *)arg;
+	struct fna_context_s *fna = &q->ctx;
+
+	while(__atomic_load_n(&q->stop, __ATOMIC_ACQUIRE) == 0) {
+		lmm_kvec_uint8_t v;
+		lmm_kv_init(fna->lmm, v);
+		struct fna_seq_intl_s *r = fna->read(fna, &v);
+		if(r == NULL) {
+			lmm_kv_destroy(fna->lmm, v);
+			break;
+		}
+		r->size = lmm_kv_size(v);		/* bytes in use, copied by fna_read_queue */
+
+		for(int64_t i = 0; fna_queue_push(q, r) == 0; i++) {
+			if(i < FNA_QUEUE_SPIN) { continue; }
+			uint64_t const head = __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+			_fna_queue_park(q, __atomic_load_n(&q->stop, __ATOMIC_ACQUIRE) != 0
+				|| __atomic_load_n(&q->cell[head & (FNA_QUEUE_SIZE - 1)].seq, __ATOMIC_ACQUIRE) == head);
+			if(__atomic_load_n(&q->stop, __ATOMIC_ACQUIRE) != 0) {
+				fna_seq_free((fna_seq_t *)r);
+				r = NULL;
+				break;
+			}
+		}
+		if(r == NULL) { break; }
+		fna_queue_wake(q);
+	}
+	q->status = (fna->status == FNA_SUCCESS) ? FNA_EOF : fna->status;
+	__atomic_store_n(&q->done, 1, __ATOMIC_RELEASE);
+	pthread_mutex_lock(&q->lock);
+	pthread_cond_broadcast(&q->cond);
+	pthread_mutex_unlock(&q->lock);
+	return(NULL);
+}
+
+/**
+ * @fn fna_queue_read
+ * @brief pop a record, wait for one if block is nonzero
+ */
+static
+struct fna_seq_intl_s *fna_queue_read(
+	struct fna_context_s *fna,
+	int block)
+{
+	struct fna_queue_s *q = fna->queue;
+	struct fna_seq_intl_s *r = NULL;
+
+	for(int64_t i = 0; ; i++) {
+		if((r = fna_queue_pop(q)) != NULL) {
+			fna_queue_wake(q);
+			return(r);
+		}
+		if(__atomic_load_n(&q->done, __ATOMIC_ACQUIRE) != 0) {
+			/* records pushed before done was raised are visible now */
+			if((r = fna_queue_pop(q)) != NULL) { return(r); }
+			__atomic_store_n(&fna->status, q->status, __ATOMIC_RELAXED);
+			return(NULL);
+		}
+		if(block == 0) { return(NULL); }
+		if(i < FNA_QUEUE_SPIN) { continue; }
+
+		_fna_queue_park(q, __atomic_load_n(&q->done, __ATOMIC_ACQUIRE) != 0
+			|| (r = fna_queue_pop(q)) != NULL);
+		if(r != NULL) {
+			fna_queue_wake(q);
+			return(r);
+		}
+	}
+}
+
+/**
+ * @fn fna_read_queue
+ * @brief the parser of a shared context for fna_read_into and fna_read_batch: copies a record out of the queue
+ */
+static
+struct fna_seq_intl_s *fna_read_queue(
+	struct fna_context_s *fna,
+	lmm_kvec_uint8_t *v)
+{
+	struct fna_seq_intl_s *s = fna_queue_read(fna, 1);
+	if(s == NULL) { return(NULL); }
+
+	int64_t const base = lmm_kv_size(*v);
+	lmm_kv_reserve(fna->lmm, *v, base + s->size);
+	memcpy(lmm_kv_ptr(*v) + base, (uint8_t *)s - s->head_margin, s->size);
+	lmm_kv_size(*v) += s->size;
+
+	struct fna_seq_intl_s *r = (struct fna_seq_intl_s *)(lmm_kv_ptr(*v) + base + s->head_margin);
+	fna_seq_relink(r);
+	fna_seq_free((fna_seq_t *)s);
+	return(r);
+}
+
+/**
+ * @fn fna_queue_close
+ */
+static
+void fna_queue_close(
+	struct fna_context_s *fna)
+{
+	struct fna_queue_s *q = fna->queue;
+
+	__atomic_store_n(&q->stop, 1, __ATOMIC_RELEASE);
+	pthread_mutex_lock(&q->lock);
+	pthread_cond_broadcast(&q->cond);
+	pthread_mutex_unlock(&q->lock);
+	pthread_join(q->th, NULL);
+
+	/* records nobody took */
+	struct fna_seq_intl_s *r;
+	while((r = fna_queue_pop(q)) != NULL) {
+		fna_seq_free((fna_seq_t *)r);
+	}
+
+	/* take the input back for cleanup */
+	q->ctx.lmm = fna->lmm;
+	q->ctx.status = fna->status;
+	if(q->ctx.fai != fna->fai) { fna_fai_close(q->ctx.fai); }	/* loaded by the parser for hints */
+	q->ctx.fai = fna->fai;
+	*fna = q->ctx;
+	pthread_mutex_destroy(&q->lock);
+	pthread_cond_destroy(&q->cond);
+	free(q);
+
+	fna->queue = NULL;
+	return;
+}
+
+/**
+ * @fn fna_queue_open
+ * @brief start the parser thread, returns nonzero on failure
+ */
+static
+int fna_queue_open(
+	struct fna_context_s *fna)
+{
+	struct fna_queue_s *q = (struct fna_queue_s *)calloc(1, sizeof(struct fna_queue_s));
+	if(q == NULL) { return(-1); }
+	for(int64_t i = 0; i < FNA_QUEUE_SIZE; i++) {
+		q->cell[i].seq = i;
+	}
+	q->ctx = *fna;
+	pthread_mutex_init(&q->lock, NULL);
+	pthread_cond_init(&q->cond, NULL);
+
+	fna->queue = q;
+	fna->read = fna_read_queue;
+	if(pthread_create(&q->th, NULL, fna_queue_worker, (void *)q) != 0) {
+		fna->read = q->ctx.read;
+		fna->queue = NULL;
+		pthread_mutex_destroy(&q->lock);
+		pthread_cond_destroy(&q->cond);
+		free(q);
+		return(-1);
+	}
+	return(0);
+}
+#endif /* HAVE_PTHREAD */
+
+/**
+ * @fn fna_tell
+ *
+ * @brief save the position of the next record
+ *
+ * @return FNA_SUCCESS, FNA_ERROR_UNSUPPORTED_VERSION on shared (FNA_SHARED) and unordered
+ * (FNA_UNORDERED on the pool) contexts, which have no single position
+ */
+int fna_tell(
+	fna_t *ctx,
+	fna_pos_t *pos)
+{
+	struct fna_context_s *fna = (struct fna_context_s *)ctx;
+	if(fna == NULL || pos == NULL) { return(FNA_ERROR_FILE_OPEN); }
+
+	*pos = (fna_pos_t){ .offset = fna_tell_intl(fna) };
+	#if defined(HAVE_PTHREAD)
+		if(fna->queue != NULL) { return(FNA_ERROR_UNSUPPORTED_VERSION); }
+		if(fna->read == fna_read_pool) {
+			struct fna_pool_s *q = (struct fna_pool_s *)fna->src;
+			if(q->ordered == 0) { return(FNA_ERROR_UNSUPPORTED_VERSION); }
+			pos->offset = q->pos;
+		}
+	#endif
+	return(FNA_SUCCESS);
+}
+
+/**
+ * @fn fna_seek
+ *
+ * @brief resume reading at a position saved by fna_tell, on a context (or a process) opened
+ * on the same file with the same params. the input is reopened at the position (see
+ * fna_seek_open); records returned before are not affected.
+ *
+ * @return FNA_SUCCESS, or fna_status if the file could not be reopened (the context is left as it was)
+ */
+int fna_seek(
+	fna_t *ctx,
+	fna_pos_t const *pos)
+{
+	struct fna_context_s *fna = (struct fna_context_s *)ctx;
+	if(fna == NULL || pos == NULL) { return(FNA_ERROR_FILE_OPEN); }
+
+	/* move in the mapped window, which keeps the views of the records read before valid */
+	if(fna->map_size != 0) {
+		#if defined(HAVE_PTHREAD)
+			int const shared = fna->queue != NULL;
+			if(shared != 0) { fna_queue_close(fna); }
+		#endif
+		fna->p = fna->buf + MIN2(pos->offset, (uint64_t)(fna->t - fna->buf));
+		fna->status = FNA_SUCCESS;
+		if(pos->offset == 0 || fna->file_format != FNA_GFA) { fna->read_head(fna); }
+		#if defined(HAVE_PTHREAD)
+			if(shared != 0 && fna_queue_open(fna) != 0) { return(FNA_ERROR_OUT_OF_MEM); }
+		#endif
+		return(FNA_SUCCESS);
+	}
+
+	fna_params_t const params = {
+		.file_format = fna->file_format,
+		.seq_encode = fna->seq_encode,
+		.options = fna->options,
+		.head_margin = fna->head_margin,
+		.tail_margin = fna->tail_margin,
+		.seq_head_margin = fna->seq_head_margin,
+		.seq_tail_margin = fna->seq_tail_margin,
+		.threads = fna->threads,
+		.lmm = fna->lmm
+	};
+	struct fna_context_s *n = (struct fna_context_s *)fna_init_intl(fna->path, &params, pos->offset, UINT64_MAX);
+	if(n == NULL) { return(FNA_ERROR_FILE_OPEN); }
+
+	/* take the new input, the index and the segment ids are kept; the table is taken
+	after the input is closed, which brings back the context of the parser thread */
+	struct fna_fai_s *fai = fna->fai;
+	if(fai != NULL) { fna_fai_close(n->fai); } else { fai = n->fai; }
+	fna_close_input(fna);
+	struct fna_names_s *names = fna->names;
+	free(fna->path);
+	*fna = *n;
+	fna->fai = fai;
+	fna->names = names;
+	free(n);
+	return(FNA_SUCCESS);
+}
+
+/**
+ * @fn fna_segment_id
+ */
+int64_t fna_segment_id(
+	fna_t const *ctx,
+	char const *name)
+{
+	struct fna_context_s const *fna = (struct fna_context_s const *)ctx;
+	return(fna_names_find(fna->names, name, strlen(name)));
+}
+
+/**
+ * @fn fna_segment_name
+ */
+char const *fna_segment_name(
+	fna_t const *ctx,
+	int64_t id)
+{
+	struct fna_context_s const *fna = (struct fna_context_s const *)ctx;
+	if(fna->names == NULL || id < 0 || id >= (int64_t)lmm_kv_size(fna->names->ofs)) { return(NULL); }
+	return(lmm_kv_ptr(fna->names->buf) + lmm_kv_at(fna->names->ofs, id));
+}
+
+/**
+ * @fn fna_segment_count
+ */
+int64_t fna_segment_count(
+	fna_t const *ctx)
+{
+	struct fna_context_s const *fna = (struct fna_context_s const *)ctx;
+	return((fna->names == NULL) ? 0 : (int64_t)lmm_kv_size(fna->names->ofs));
+}
+
+/**
+ * @struct fna_graph_link_s
+ * @brief a link gathered by fna_load_graph, the tail and head vertices of the forward arc and
+ * the overlap lengths on their segments (the latter is that of the complement arc)
+ */
+struct fna_graph_link_s {
+	uint32_t u, v;
+	uint32_t ou, ov;
+};
+
+/**
+ * @fn fna_graph_overlap
+ * @brief bases of the two segments covered by an overlap cigar, the first one as the reference
+ */
+static _force_inline
+void fna_graph_overlap(
+	struct fna_cigar_s cigar,
+	uint32_t *ref,
+	uint32_t *query)
+{
+	uint64_t n = 0, r = 0, q = 0;
+	for(int64_t i = 0; i < cigar.len; i++) {
+		int const c = cigar.ptr[i];
+		if((uint8_t)(c - '0') < 10) { n = n * 10 + (c - '0'); continue; }
+		switch(c) {
+			case 'M': case '=': case 'X': r += n; q += n; break;
+			case 'D': case 'N': r += n; break;
+			case 'I': case 'S': q += n; break;
+			default: break;
+		}
+		n = 0;
+	}
+	*ref = (uint32_t)MIN2(r, UINT32_MAX);
+	*query = (uint32_t)MIN2(q, UINT32_MAX);
+	return;
+}
+
+/**
+ * @fn fna_graph_arc_cmp
+ */
+static
+int fna_graph_arc_cmp(
+	void const *a,
+	void const *b)
+{
+	struct fna_graph_arc_s const *x = (struct fna_graph_arc_s const *)a, *y = (struct fna_graph_arc_s const *)b;
+	if(x->v != y->v) { return((x->v < y->v) ? -1 : 1); }
+	return((x->overlap < y->overlap) ? -1 : (x->overlap > y->overlap));
+}
+
+/**
+ * @struct fna_graph_sort_s
+ * @brief a share of the counting sort of the arcs; links [lb, le) are counted and scattered,
+ * and the rows of vertices [vb, ve) are sorted
+ */
+struct fna_graph_sort_s {
+	struct fna_graph_link_s const *link;
+	int64_t *ofs;
+	struct fna_graph_arc_s *adj;
+	int64_t lb, le, vb, ve;
+	int phase;
+	#if defined(HAVE_PTHREAD)
+		pthread_t th;
+	#endif
+};
+
+/**
+ * @fn fna_graph_sort_worker
+ * @brief phase 0 counts the arcs leaving each vertex, phase 1 puts the arcs at the heads of
+ * the rows (ofs[u] is the cursor of the row, and the end of it after all), phase 2 sorts the rows
+ */
+static
+void *fna_graph_sort_worker(
+	void *arg)
+{
+	struct fna_graph_sort_s *w = (struct fna_graph_sort_s *)arg;
+	int64_t *ofs = w->ofs;
+
+	#define _put(_u, _v, _o) { \
+		int64_t const _k = __atomic_fetch_add(&ofs[_u], 1, __ATOMIC_RELAXED); \
+		w->adj[_k] = (struct fna_graph_arc_s){ .v = (_v), .overlap = (_o) }; \
+	}
+	if(w->phase == 0) {
+		for(int64_t i = w->lb; i < w->le; i++) {
+			__atomic_fetch_add(&ofs[w->link[i].u + 1], 1, __ATOMIC_RELAXED);
+			__atomic_fetch_add(&ofs[(w->link[i].v ^ 0x01) + 1], 1, __ATOMIC_RELAXED);
+		}
+	} else if(w->phase == 1) {
+		for(int64_t i = w->lb; i < w->le; i++) {
+			struct fna_graph_link_s const l = w->link[i];
+			_put(l.u, l.v, l.ou);
+			_put(l.v ^ 0x01, l.u ^ 0x01, l.ov);
+		}
+	} else {
+		for(int64_t u = w->vb; u < w->ve; u++) {
+			int64_t const b = (u == 0) ? 0 : ofs[u - 1], e = ofs[u];
+			if(e - b > 1) { qsort(&w->adj[b], e - b, sizeof(struct fna_graph_arc_s), fna_graph_arc_cmp); }
+		}
+	}
+	#undef _put
+	return(NULL);
+}
+
+/**
+ * @fn fna_graph_sort
+ * @brief counting sort of the arcs into the rows of adj on threads (vertex u is in
+ * [ofs[u], ofs[u + 1]) on return); ofs has vcnt + 1 elements
+ */
+static
+int fna_graph_sort(
+	struct fna_graph_link_s const *link,
+	int64_t lcnt,
+	int64_t *ofs,
+	int64_t vcnt,
+	struct fna_graph_arc_s *adj,
+	int64_t threads)
+{
+	threads = MAX2(1, MIN2(threads, (lcnt + 4095) / 4096));
+	struct fna_graph_sort_s *w = (struct fna_graph_sort_s *)malloc(sizeof(struct fna_graph_sort_s) * threads);
+	if(w == NULL) { return(FNA_ERROR_OUT_OF_MEM); }
+	for(int64_t i = 0; i < threads; i++) {
+		w[i] = (struct fna_graph_sort_s){
+			.link = link,
+			.ofs = ofs,
+			.adj = adj,
+			.lb = lcnt * i / threads,
+			.le = lcnt * (i + 1) / threads,
+			.vb = vcnt * i / threads,
+			.ve = vcnt * (i + 1) / threads
+		};
+	}
+
+	memset(ofs, 0, sizeof(int64_t) * (vcnt + 1));
+	for(int phase = 0; phase < 3; phase++) {
+		int64_t n = 1;
+		for(int64_t i = 0; i < threads; i++) { w[i].phase = phase; }
+		#if defined(HAVE_PTHREAD)
+			for(; n < threads; n++) {
+				if(pthread_create(&w[n].th, NULL, fna_graph_sort_worker, (void *)&w[n]) != 0) { break; }
+			}
+		#endif
+		fna_graph_sort_worker((void *)&w[0]);
+		for(int64_t i = n; i < threads; i++) { fna_graph_sort_worker((void *)&w[i]); }	/* not started */
+		#if defined(HAVE_PTHREAD)
+			for(int64_t i = 1; i < n; i++) { pthread_join(w[i].th, NULL); }
+		#endif
+
+		/* counts to the heads of the rows */
+		if(phase == 0) {
+			for(int64_t u = 0; u < vcnt; u++) { ofs[u + 1] += ofs[u]; }
+		}
+	}
+
+	/* the cursors ended at the tails of the rows */
+	memmove(&ofs[1], &ofs[0], sizeof(int64_t) * vcnt);
+	ofs[0] = 0;
+	free(w);
+	return(FNA_SUCCESS);
+}
+
+/**
+ * @fn fna_load_graph
+ */
+fna_graph_t *fna_load_graph(
+	char const *path,
+	fna_params_t const *params)
+{
+	static fna_params_t const default_params = { 0 };
+	if(params == NULL) { params = &default_params; }
+
+	/* records and the name table in the global malloc, so that the arrays are taken over as they are */
+	fna_params_t p = *params;
+	p.options = (params->options & FNA_MMAP) | FNA_INTERN_NAMES;
+	p.threads = MIN2(params->threads, 1);
+	p.head_margin = p.tail_margin = p.seq_head_margin = p.seq_tail_margin = 0;
+	p.lmm = NULL;
+
+	struct fna_context_s *fna = (struct fna_context_s *)fna_init(path, &p);
+	if(fna == NULL) { return(NULL); }
+	if(fna->file_format != FNA_GFA) {
+		fna_close((fna_t *)fna);
+		return(NULL);
+	}
+
+	lmm_kvec_t(uint8_t) seq;
+	lmm_kvec_t(int64_t) seq_ofs, seq_len;
+	lmm_kvec_t(struct fna_graph_link_s) link;
+	lmm_kv_init(NULL, seq);
+	lmm_kv_init(NULL, seq_ofs);
+	lmm_kv_init(NULL, seq_len);
+	lmm_kv_init(NULL, link);
+
+	/* an empty sequence at the head for the segments without 'S' line */
+	int const encode = fna->seq_encode;
+	for(int64_t i = 0; i < fna_encoded_size(encode, 0); i++) { lmm_kv_push(NULL, seq, 0); }
+
+	fna_seq_t *r = NULL;
+	int status = FNA_SUCCESS;
+	while((r = fna_read_into((fna_t *)fna, r)) != NULL) {
+		if(r->type == FNA_SEGMENT) {
+			int64_t const id = r->s.segment.name.id;
+			if(id < 0) { status = FNA_ERROR_OUT_OF_MEM; break; }
+			while((int64_t)lmm_kv_size(seq_ofs) <= id) {
+				lmm_kv_push(NULL, seq_ofs, 0);
+				lmm_kv_push(NULL, seq_len, 0);
+			}
+			int64_t const size = fna_encoded_size(encode, r->s.segment.seq.len);
+			lmm_kv_at(seq_ofs, id) = lmm_kv_size(seq);
+			lmm_kv_at(seq_len, id) = r->s.segment.seq.len;
+			if(lmm_kv_size(seq) + size > lmm_kv_max(seq)) {
+				lmm_kv_reserve(NULL, seq, MAX2(2 * lmm_kv_max(seq), lmm_kv_size(seq) + size));
+			}
+			memcpy(lmm_kv_ptr(seq) + lmm_kv_size(seq), r->s.segment.seq.ptr, size);
+			lmm_kv_size(seq) += size;
+		} else if(r->type == FNA_LINK) {
+			struct fna_link_s const *l = &r->s.link;
+			if(l->src.id < 0 || l->dst.id < 0) { status = FNA_ERROR_OUT_OF_MEM; break; }
+
+			struct fna_graph_link_s e = {
+				.u = ((uint32_t)l->src.id<<1) | (l->src_ori != 0),
+				.v = ((uint32_t)l->dst.id<<1) | (l->dst_ori != 0)
+			};
+			fna_graph_overlap(l->cigar, &e.ou, &e.ov);
+			lmm_kv_push(NULL, link, e);
+		}
+	}
+	if(status == FNA_SUCCESS && fna->status != FNA_EOF) { status = fna->status; }
+	fna_seq_free(r);
+
+	/* take over the names */
+	int64_t const seg_cnt = fna_segment_count((fna_t *)fna);
+	if(status == FNA_SUCCESS && seg_cnt >= ((int64_t)1<<31)) { status = FNA_ERROR_OUT_OF_MEM; }
+
+	lmm_kvec_t(char) name;
+	lmm_kvec_t(int64_t) name_ofs;
+	lmm_kv_init(NULL, name);
+	lmm_kv_init(NULL, name_ofs);
+	if(fna->names != NULL) {
+		lmm_kv_destroy(NULL, name);
+		lmm_kv_destroy(NULL, name_ofs);
+		name.a = lmm_kv_ptr(fna->names->buf); fna->names->buf.a = NULL;
+		name_ofs.a = lmm_kv_ptr(fna->names->ofs); fna->names->ofs.a = NULL;
+	}
+	fna_close((fna_t *)fna);
+
+	/* names referenced by the last links only */
+	while((int64_t)lmm_kv_size(seq_ofs) < seg_cnt) {
+		lmm_kv_push(NULL, seq_ofs, 0);
+		lmm_kv_push(NULL, seq_len, 0);
+	}
+
+	/* adjacency */
+	struct fna_graph_s *g = (struct fna_graph_s *)malloc(sizeof(struct fna_graph_s));
+	int64_t *adj_ofs = (int64_t *)malloc(sizeof(int64_t) * (2 * seg_cnt + 1));
+	struct fna_graph_arc_s *adj = (struct fna_graph_arc_s *)malloc(sizeof(struct fna_graph_arc_s) * (2 * lmm_kv_size(link) + 1));
+	if(status == FNA_SUCCESS && (g == NULL || adj_ofs == NULL || adj == NULL)) { status = FNA_ERROR_OUT_OF_MEM; }
+	if(status == FNA_SUCCESS) {
+		status = fna_graph_sort(lmm_kv_ptr(link), lmm_kv_size(link), adj_ofs, 2 * seg_cnt, adj, params->threads);
+	}
+	int64_t const lcnt = lmm_kv_size(link);
+	lmm_kv_destroy(NULL, link);
+
+	if(status != FNA_SUCCESS) {
+		lmm_kv_destroy(NULL, seq);
+		lmm_kv_destroy(NULL, seq_ofs);
+		lmm_kv_destroy(NULL, seq_len);
+		lmm_kv_destroy(NULL, name);
+		lmm_kv_destroy(NULL, name_ofs);
+		free(adj_ofs); free(adj); free(g);
+		return(NULL);
+	}
+
+	*g = (struct fna_graph_s){
+		.seg_cnt = seg_cnt,
+		.arc_cnt = 2 * lcnt,
+		.seq_encode = encode,
+		.name = lmm_kv_ptr(name),
+		.name_ofs = lmm_kv_ptr(name_ofs),
+		.seq = lmm_kv_ptr(seq),
+		.seq_ofs = lmm_kv_ptr(seq_ofs),
+		.seq_len = lmm_kv_ptr(seq_len),
+		.adj_ofs = adj_ofs,
+		.adj = adj
+	};
+	return((fna_graph_t *)g);
+}
+
+/**
+ * @fn fna_graph_free
+ */
+void fna_graph_free(
+	fna_graph_t *g)
+{
+	if(g == NULL) { return; }
+	free((void *)g->name);
+	free((void *)g->name_ofs);
+	free((void *)g->seq);
+	free((void *)g->seq_ofs);
+	free((void *)g->seq_len);
+	free((void *)g->adj_ofs);
+	free((void *)g->adj);
+	free(g);
+	return;
+}
+
+/**
+ * @fn fna_seq_free
+ *
+ * @brief clean up sequence object
+ */
+void fna_seq_free(fna_seq_t *seq)
+{
+	struct fna_seq_intl_s *s = (struct fna_seq_intl_s *)seq;
+	if(s != NULL && (s->flags & FNA_IN_BATCH) == 0) {
+		fna_seq_free_fields(s);
+
+		/* free context */
+		lmm_free(s->lmm, (void *)((uint8_t *)s - s->head_margin));
+	}
+	return;
+}
+
+/**
+ * @fn fna_seq_alloc
+ * @brief (internal) allocate a self-contained segment record with the margins and
+ * the encoding of s, for seq_len bases and qual_len quality chars (in the encoding of
+ * seq, as the parsers leave them). name and comment are copied from s; seq and qual are
+ * left to the caller except for the terminators.
+ */
+static
+struct fna_seq_intl_s *fna_seq_alloc(
+	struct fna_seq_intl_s const *s,
+	int64_t seq_len,
+	int64_t qual_len)
+{
+	uint32_t const no_seq = s->flags & FNA_NO_SEQ;
+	int64_t const name_len = s->s.segment.name.len;
+	int64_t const com_len = s->s.segment.comment.len;
+	int64_t const seq_size = fna_encoded_size(s->seq_encode, no_seq ? 0 : seq_len);
+	uint64_t const size = s->head_margin + sizeof(struct fna_seq_intl_s)
+		+ name_len + 1 + com_len + 1
+		+ s->seq_head_margin + seq_size + s->seq_tail_margin
+		+ qual_len + 1 + s->tail_margin;
+
+	uint8_t *a = (uint8_t *)lmm_malloc(s->lmm, size);
+	if(a == NULL) { return(NULL); }
+
+	struct fna_seq_intl_s *r = (struct fna_seq_intl_s *)(a + s->head_margin);
+	*r = (struct fna_seq_intl_s){
+		.lmm = s->lmm,
+		.type = FNA_SEGMENT,
+		.flags = no_seq,
+		.seq_encode = s->seq_encode,
+		.options = s->options,
+		.head_margin = s->head_margin,
+		.tail_margin = s->tail_margin,
+		.seq_head_margin = s->seq_head_margin,
+		.seq_tail_margin = s->seq_tail_margin,
+		.size = size
+	};
+	fna_segment_link(r,
+		(struct fna_read_ret_s){ .len = name_len },
+		(struct fna_read_ret_s){ .len = com_len },
+		(struct fna_read_ret_s){ .len = seq_len },
+		(struct fna_read_ret_s){ .len = qual_len });
+	r->s.segment.name.id = s->s.segment.name.id;
+
+	/* views are not terminated, copy the bodies */
+	char *name = (char *)r->s.segment.name.ptr, *com = (char *)r->s.segment.comment.ptr;
+	memcpy(name, s->s.segment.name.ptr, name_len); name[name_len] = '\0';
+	memcpy(com, s->s.segment.comment.ptr, com_len); com[com_len] = '\0';
+
+	/* margins are cleared as the parsers do; an empty seq body is cleared as well */
+	uint8_t *seq = (uint8_t *)r->s.segment.seq.ptr, *qual = (uint8_t *)r->s.segment.qual.ptr;
+	memset(a, 0, s->head_margin);
+	memset(seq - s->seq_head_margin, 0, s->seq_head_margin);
+	memset(seq + seq_size, 0, s->seq_tail_margin);
+	if(no_seq) {
+		memset(seq, 0, seq_size);
+	} else if(s->seq_encode == FNA_ASCII) {
+		seq[seq_len] = '\0';
+	}
+	memset(qual + qual_len, 0, 1 + s->tail_margin);
+	return(r);
+}
+
+/**
+ * @fn fna_duplicate
+ *
+ * @brief duplicate sequence, into a self-contained record with the same margins.
+ * fields viewing the mapped file are copied. returns NULL for non-segments.
+ */
+fna_seq_t *fna_duplicate(
+	fna_seq_t const *seq)
+{
+	struct fna_seq_intl_s const *s = (struct fna_seq_intl_s const *)seq;
+	if(s == NULL || s->type != FNA_SEGMENT) { return(NULL); }
+
+	struct fna_seq_intl_s *r = fna_seq_alloc(s, s->s.segment.seq.len, s->s.segment.qual.len);
+	if(r == NULL) { return(NULL); }
+
+	/* the ASCII terminators are set by fna_seq_alloc */
+	#define _size(_x)		( fna_encoded_size(s->seq_encode, (_x).len) - (s->seq_encode == FNA_ASCII) )
+	if((s->flags & FNA_NO_SEQ) == 0) {
+		memcpy((uint8_t *)r->s.segment.seq.ptr, s->s.segment.seq.ptr, _size(s->s.segment.seq));
+	}
+	memcpy((uint8_t *)r->s.segment.qual.ptr, s->s.segment.qual.ptr, _size(s->s.segment.qual));
+	#undef _size
+	return((fna_seq_t *)r);
+}
+
+/**
+ * @fn fna_revcomp
+ * @brief make reverse complemented sequence, into a self-contained record with the
+ * same margins; qual is reversed. returns NULL for non-segments.
+ */
+fna_seq_t *fna_revcomp(
+	fna_seq_t const *seq)
+{
+	struct fna_seq_intl_s const *s = (struct fna_seq_intl_s const *)seq;
+	if(s == NULL || s->type != FNA_SEGMENT) { return(NULL); }
+
+	struct fna_seq_intl_s *r = fna_seq_alloc(s, s->s.segment.seq.len, s->s.segment.qual.len);
+	if(r == NULL) { return(NULL); }
+
+	if((s->flags & FNA_NO_SEQ) == 0) {
+		fna_kernel_select()->revcomp((uint8_t *)r->s.segment.seq.ptr, s->s.segment.seq.ptr,
+			s->s.segment.seq.len, s->seq_encode);
+	}
+
+	fna_reverse_span((uint8_t *)r->s.segment.qual.ptr, s->s.segment.qual.ptr,
+		s->s.segment.qual.len, s->seq_encode);
+	return((fna_seq_t *)r);
+}
+
+/**
+ * @fn fna_concat_span
+ * @brief (internal) a followed by b, or by rev(b), in a buffer of its own with margins around.
+ * rev writes b in place when it starts at a byte boundary, b is shifted into place otherwise.
+ * returns a pointer to the head of the concatenation, NULL if out of memory.
+ */
+static
+uint8_t *fna_concat_span(
+	lmm_t *lmm,
+	struct fna_sarr_s a,
+	struct fna_sarr_s b,
+	int encode,
+	void (*rev)(uint8_t *dst, uint8_t const *src, int64_t len, int encode),
+	int64_t head_margin,
+	int64_t tail_margin)
+{
+	int64_t const bits = fna_encoded_bits(encode), ofs = a.len * bits;
+	int64_t const size = fna_encoded_size(encode, a.len + b.len);
+
+	uint8_t *m = (uint8_t *)lmm_malloc(lmm, head_margin + size + tail_margin);
+	if(m == NULL) { return(NULL); }
+	uint8_t *p = m + head_margin;
+	memset(m, 0, head_margin);
+	memset(p + size, 0, tail_margin);
+	memcpy(p, a.ptr, (ofs + 7) / 8);
+
+	if(rev != NULL && (ofs & 7) == 0) {
+		rev(&p[ofs / 8], b.ptr, b.len, encode);
+	} else if(rev != NULL) {
+		uint8_t *t = (uint8_t *)lmm_malloc(lmm, fna_encoded_size(encode, b.len));
+		if(t == NULL) {
+			lmm_free(lmm, m);
+			return(NULL);
+		}
+		rev(t, b.ptr, b.len, encode);
+		fna_pack_put(p, ofs, t, b.len * bits, size);
+		lmm_free(lmm, t);
+	} else {
+		fna_pack_put(p, ofs, b.ptr, b.len * bits, size);
+	}
+	return(p);
+}
+
+/**
+ * @fn fna_append_intl
+ * @brief (internal) fna_append and fna_append_revcomp. seq and qual of dst are rebuilt
+ * in buffers out of the record body (FNA_OUT_SEQ) so that dst stays where it is.
+ */
+static
+void fna_append_intl(
+	struct fna_seq_intl_s *dst,
+	struct fna_seq_intl_s const *src,
+	int rev)
+{
+	if(dst == NULL || src == NULL || dst->type != FNA_SEGMENT || src->type != FNA_SEGMENT) { return; }
+	if(dst->seq_encode != src->seq_encode) { return; }
+	if((dst->flags & (FNA_IN_BATCH | FNA_NO_SEQ)) != 0 || (src->flags & FNA_NO_SEQ) != 0) { return; }
+
+	/* quals share the encoding of seq */
+	struct fna_sarr_s const ds = dst->s.segment.seq, dq = dst->s.segment.qual;
+	uint8_t *p = fna_concat_span(dst->lmm, ds, src->s.segment.seq, dst->seq_encode,
+		rev ? fna_kernel_select()->revcomp : NULL, dst->seq_head_margin, dst->seq_tail_margin);
+	uint8_t *q = fna_concat_span(dst->lmm, dq, src->s.segment.qual, dst->seq_encode,
+		rev ? fna_reverse_span : NULL, 0, 0);
+	if(p == NULL || q == NULL) {
+		if(p != NULL) { lmm_free(dst->lmm, p - dst->seq_head_margin); }
+		lmm_free(dst->lmm, q);
+		return;
+	}
+
+	/* src may be dst itself, the old buffers are released at the end */
+	if(dst->flags & FNA_OUT_SEQ) {
+		lmm_free(dst->lmm, (void *)(ds.ptr - dst->seq_head_margin));
+		lmm_free(dst->lmm, (void *)dq.ptr);
+	}
+	dst->flags = (dst->flags & ~(FNA_VIEW_SEQ | FNA_VIEW_QUAL)) | FNA_OUT_SEQ;
+	dst->s.segment.seq = (struct fna_sarr_s){ .ptr = p, .len = ds.len + src->s.segment.seq.len };
+	dst->s.segment.qual = (struct fna_sarr_s){ .ptr = q, .len = dq.len + src->s.segment.qual.len };
+	return;
+}
+
+/**
+ * @fn fna_append
+ *
+ * @brief concatenate src sequence (and qual) after dst sequence. nothing is done
+ * when the encodings differ, either was read with FNA_SKIP_SEQ, or dst is in a batch.
+ */
+void fna_append(
+	fna_seq_t *dst,
+	fna_seq_t const *src)
+{
+	fna_append_intl((struct fna_seq_intl_s *)dst, (struct fna_seq_intl_s const *)src, 0);
+	return;
+}
+
+/**
+ * @fn fna_append_revcomp
+ *
+ * @brief append reverse complement of src after dst sequence, qual is reversed.
+ * the same restrictions as fna_append apply.
+ */
+void fna_append_revcomp(
+	fna_seq_t *dst,
+	fna_seq_t const *src)
+{
+	fna_append_intl((struct fna_seq_intl_s *)dst, (struct fna_seq_intl_s const *)src, 1);
+	return;
+}
+
+/**
+ * unittests
+ */
+#include <sys/stat.h>
+
+unittest_config(
+	.name = "fna",
+	.depends_on = {"zf"}
+);
+
+/**
+ * @fn fdump
+ * @brief dump string to file, returns 1 if succeeded
+ */
+static _force_inline
+int fdump(
+	char const *filename,
+	char const *content)
+{
+	FILE *fp = fopen(filename, "w");
+	uint64_t l = fprintf(fp, "%s", content);
+	fclose(fp);
+	return(l == strlen(content));
+}
+
+/**
+ * @fn fcmp
+ * @brief compare file, returns zero if the content is equivalent to arr
+ */
+static _force_inline
+int fcmp(char const *filename, uint64_t size, uint8_t const *arr)
+{
+	int64_t res;
+	struct stat st;
+	FILE *fp = NULL;
+	uint8_t *buf = NULL;
+
+	if((fp = fopen(filename, "rb")) == NULL) { return(1); }
+	fstat(fileno(fp), &st);
+	buf = malloc(sizeof(uint8_t) * st.st_size);
+
+	if(fread(buf, sizeof(uint8_t), st.st_size, fp) != (size_t)st.st_size) {
+		free(buf);
+		return(0);
+	}
+	res = memcmp(buf, arr, size);
+	free(buf);
+	fclose(fp);
+	return(res == 0);
+}
+
+/**
+ * @fn unittest_random_base
+ */
+static _force_inline
+char unittest_random_base(void)
+{
+	char const table[4] = {'A', 'C', 'G', 'T'};
+	return(table[rand() % 4]);
+}
+
+/**
+ * @fn unittest_generate_random_sequence
+ */
+static _force_inline
+char *unittest_generate_random_sequence(
+	int64_t len)
+{
+	char *seq;		/** a pointer to sequence */
+	seq = (char *)malloc(sizeof(char) * (len + 1));
+
+	if(seq == NULL) { return NULL; }
+	for(int64_t i = 0; i < len; i++) {
+		seq[i] = unittest_random_base();
+	}
+	seq[len] = '\0';
+	return seq;
+}
+
+
+/* unittest for parse_version_string */
+unittest()
+{
+	#define assert_parse_version_string(_str, _num) \
+		assert(fna_parse_version_string(_str) == (_num), \
+			"%u", \
+			fna_parse_version_string(_str));
+
+	assert_parse_version_string("0.0.0", 0x000000);
+	assert_parse_version_string("0.0.1", 0x000001);
+	assert_parse_version_string("0.1.0", 0x000100);
+	assert_parse_version_string("1.2.3", 0x010203);
+	assert_parse_version_string("100.200.50", 0x64c832);
+	assert_parse_version_string("0.0.01", 0x000001);
+	assert_parse_version_string("0.0.10", 0x00000a);
+	assert_parse_version_string("0.0.15", 0x00000f);
+
+	#undef assert_parse_version_string
+}
+
+/**
+ * fails when failed to open file
+ */
+unittest()
+{
+	char const *fasta_filename = "test.fa";
+
+	remove(fasta_filename);
+	fna_t *fna = fna_init(fasta_filename, NULL);
+	assert(fna == NULL);
+}
+
+/**
+ * basic FASTA parsing
+ */
+unittest()
+{
+	/**
+	 * create file
+	 * test0: valid FASTA format
+	 * test1: a space in header
+	 * test2: two spaces in header and two \n's between header and content
+	 */
+	char const *fasta_filename = "test_fna.fa";
+	char const *fasta_content =
+		">test0\nAAAA\n"
+		"> test1\nATAT\nCGCG\n"
+		">  test2\n\nAAAA\n"
+		">\ttest3 \tcomment   \nACGT";
+	assert(fdump(fasta_filename, fasta_content));
+	assert(fcmp(fasta_filename, strlen(fasta_content), (uint8_t const *)fasta_content));
+
+	fna_t *fna = fna_init(fasta_filename, NULL);
+	assert(fna != NULL, "fna(%p)", fna);
+
+	/* format detection (internal) */
+	assert(fna->file_format == FNA_FASTA, "fna->file_format(%d)", fna->file_format);
+
+	/* test0 */
+	fna_seq_t *seq = fna_read(fna);
+	assert(strcmp(seq->s.segment.name.ptr, "test0") == 0, "name(%s)", seq->s.segment.name.ptr);
+	assert(strcmp(seq->s.segment.comment.ptr, "") == 0, "comment(%s)", seq->s.segment.comment.ptr);
+	assert(strcmp((char const *)seq->s.segment.seq.ptr, "AAAA") == 0, "seq(%s)", (char const *)seq->s.segment.seq.ptr);
+	assert(seq->s.segment.seq.len == 4, "len(%lld)", seq->s.segment.seq.len);
+	fna_seq_free(seq);
+
+	/* test1 */
+	seq = fna_read(fna);
+	assert(strcmp(seq->s.segment.name.ptr, "test1") == 0, "name(%s)", seq->s.segment.name.ptr);
+	assert(strcmp(seq->s.segment.comment.ptr, "") == 0, "comment(%s)", seq->s.segment.comment.ptr);
+	assert(strcmp((char const *)seq->s.segment.seq.ptr, "ATATCGCG") == 0, "seq(%s)", (char const *)seq->s.segment.seq.ptr);
+	assert(seq->s.segment.seq.len == 8, "len(%lld)", seq->s.segment.seq.len);
+	fna_seq_free(seq);
+
+	/* test2 */
+	seq = fna_read(fna);
+	assert(strcmp(seq->s.segment.name.ptr, "test2") == 0, "name(%s)", seq->s.segment.name.ptr);
+	assert(strcmp(seq->s.segment.comment.ptr, "") == 0, "comment(%s)", seq->s.segment.comment.ptr);
+	assert(strcmp((char const *)seq->s.segment.seq.ptr, "AAAA") == 0, "seq(%s)", (char const *)seq->s.segment.seq.ptr);
+	assert(seq->s.segment.seq.len == 4, "len(%lld)", seq->s.segment.seq.len);
+	fna_seq_free(seq);
+
+	/* test3 */
+	seq = fna_read(fna);
+	assert(strcmp(seq->s.segment.name.ptr, "test3") == 0, "name(%s)", seq->s.segment.name.ptr);
+	assert(strcmp(seq->s.segment.comment.ptr, "comment") == 0, "comment(%s)", seq->s.segment.comment.ptr);
+	assert(strcmp((char const *)seq->s.segment.seq.ptr, "ACGT") == 0, "seq(%s)", (char const *)seq->s.segment.seq.ptr);
+	assert(seq->s.segment.seq.len == 4, "len(%lld)", seq->s.segment.seq.len);
+	fna_seq_free(seq);
+
+	/* test eof */
+	seq = fna_read(fna);
+	assert(seq == NULL, "seq(%p)", seq);
+	assert(fna->status == FNA_EOF, "status(%d)", fna->status);
+	fna_seq_free(seq);
+
+	fna_close(fna);
+
+	/** cleanup files */
+	remove(fasta_filename);
+}
+
+/**
+ * basic FASTQ parsing
+ */
+unittest()
+{
+	/**
+	 * create file
+	 * test0: valid FASTQ format
+	 * test1: a space in header
+	 * test2: two spaces in header and two \n's between header and content
+	 */
+	char const *fastq_filename = "test_fna.fq";
+	char const *fastq_content =
+		"@test0\nAAAA\n+test0\nNNNN\n"
+		"@ test1\nATAT\nCGCG\n+ test1\nNNNN\nNNNN\n"
+		"@  test2\n\nAAAA\n+  test2\n\nNNNN\n"
+		"@\ttest3\t  comment   \nACGT\n\n+\ttest3\nNNNN";
+	assert(fdump(fastq_filename, fastq_content));
+	assert(fcmp(fastq_filename, strlen(fastq_content), (uint8_t const *)fastq_content));
+
+	fna_t *fna = fna_init(fastq_filename, NULL);
+	assert(fna != NULL, "fna(%p)", fna);
+
+	/* format detection (internal) */
+	assert(fna->file_format == FNA_FASTQ, "fna->file_format(%d)", fna->file_format);
+
+	/* test0 */
+	fna_seq_t *seq = fna_read(fna);
+	assert(strcmp(seq->s.segment.name.ptr, "test0") == 0, "name(%s)", seq->s.segment.name.ptr);
+	assert(strcmp(seq->s.segment.comment.ptr, "") == 0, "comment(%s)", seq->s.segment.comment.ptr);
+	assert(strcmp((char const *)seq->s.segment.seq.ptr, "AAAA") == 0, "seq(%s)", (char const *)seq->s.segment.seq.ptr);
+	assert(seq->s.segment.seq.len == 4, "len(%lld)", seq->s.segment.seq.len);
+	assert(strcmp((char const *)seq->s.segment.qual.ptr, "NNNN") == 0, "seq(%s)", (char const *)seq->s.segment.qual.ptr);
+	assert(seq->s.segment.qual.len == 4, "len(%lld)", seq->s.segment.qual.len);
+	fna_seq_free(seq);
+
+	/* test1 */
+	seq = fna_read(fna);
+	assert(strcmp(seq->s.segment.name.ptr, "test1") == 0, "name(%s)", seq->s.segment.name.ptr);
+	assert(strcmp(seq->s.segment.comment.ptr, "") == 0, "comment(%s)", seq->s.segment.comment.ptr);
+	assert(strcmp((char const *)seq->s.segment.seq.ptr, "ATATCGCG") == 0, "seq(%s)", (char const *)seq->s.segment.seq.ptr);
+	assert(seq->s.segment.seq.len == 8, "len(%lld)", seq->s.segment.seq.len);
+	assert(strcmp((char const *)seq->s.segment.qual.ptr, "NNNNNNNN") == 0, "seq(%s)", (char const *)seq->s.segment.qual.ptr);
+	assert(seq->s.segment.qual.len == 8, "len(%lld)", seq->s.segment.qual.len);
+	fna_seq_free(seq);
+
+	/* test2 */
+	seq = fna_read(fna);
+	assert(strcmp(seq->s.segment.name.ptr, "test2") == 0, "name(%s)", seq->s.segment.name.ptr);
+	assert(strcmp(seq->s.segment.comment.ptr, "") == 0, "comment(%s)", seq->s.segment.comment.ptr);
+	assert(strcmp((char const *)seq->s.segment.seq.ptr, "AAAA") == 0, "seq(%s)", (char const *)seq->s.segment.seq.ptr);
+	assert(seq->s.segment.seq.len == 4, "len(%lld)", seq->s.segment.seq.len);
+	assert(strcmp((char const *)seq->s.segment.qual.ptr, "NNNN") == 0, "seq(%s)", (char const *)seq->s.segment.qual.ptr);
+	assert(seq->s.segment.qual.len == 4, "len(%lld)", seq->s.segment.qual.len);
+	fna_seq_free(seq);
+
+	/* test3 */
+	seq = fna_read(fna);
+	assert(strcmp(seq->s.segment.name.ptr, "test3") == 0, "name(%s)", seq->s.segment.name.ptr);
+	assert(strcmp(seq->s.segment.comment.ptr, "comment") == 0, "comment(%s)", seq->s.segment.comment.ptr);
+	assert(strcmp((char const *)seq->s.segment.seq.ptr, "ACGT") == 0, "seq(%s)", (char const *)seq->s.segment.seq.ptr);
+	assert(seq->s.segment.seq.len == 4, "len(%lld)", seq->s.segment.seq.len);
+	assert(strcmp((char const *)seq->s.segment.qual.ptr, "NNNN") == 0, "seq(%s)", (char const *)seq->s.segment.qual.ptr);
+	assert(seq->s.segment.qual.len == 4, "len(%lld)", seq->s.segment.qual.len);
+	fna_seq_free(seq);
+
+	/* test eof */
+	seq = fna_read(fna);
+	assert(seq == NULL, "seq(%p)", seq);
+	assert(fna->status == FNA_EOF, "status(%d)", fna->status);
+	fna_seq_free(seq);
+
+	fna_close(fna);
+
+	/** cleanup files */
+	remove(fastq_filename);
+	return;
+}
+
+/* fastq with qual skipping */
+unittest()
+{
+	/**
+	 * create file
+	 * test0: valid FASTQ format
+	 * test1: a space in header
+	 * test2: two spaces in header and two \n's between header and content
+	 */
+	char const *fastq_filename = "test_fna.fq";
+	char const *fastq_content =
+		"@test0\nAAAA\n+test0\nNNNN\n"
+		"@ test1\nATAT\nCGCG\n+ test1\nII@#\n+III\n"
+		"@  test2\n\nAAAA\n+  test2\n\nNNNN\n"
+		"@\ttest3\nACGT\n\n+\ttest3\nNNNN";
+	assert(fdump(fastq_filename, fastq_content));
+	assert(fcmp(fastq_filename, strlen(fastq_content), (uint8_t const *)fastq_content));
+
+	fna_t *fna = fna_init(fastq_filename, FNA_PARAMS(.options = FNA_SKIP_QUAL));
+	assert(fna != NULL, "fna(%p)", fna);
+
+	/* format detection (internal) */
+	assert(fna->file_format == FNA_FASTQ, "fna->file_format(%d)", fna->file_format);
+
+	/* test0 */
+	fna_seq_t *seq = fna_read(fna);
+	assert(strcmp(seq->s.segment.name.ptr, "test0") == 0, "name(%s)", seq->s.segment.name.ptr);
+	assert(strcmp((char const *)seq->s.segment.seq.ptr, "AAAA") == 0, "seq(%s)", (char const *)seq->s.segment.seq.ptr);
+	assert(seq->s.segment.seq.len == 4, "len(%lld)", seq->s.segment.seq.len);
+	assert(strcmp((char const *)seq->s.segment.qual.ptr, "") == 0, "seq(%s)", (char const *)seq->s.segment.qual.ptr);
+	assert(seq->s.segment.qual.len == 0, "len(%lld)", seq->s.segment.qual.len);
+	fna_seq_free(seq);
+
+	/* test1 */
+	seq = fna_read(fna);
+	assert(strcmp(seq->s.segment.name.ptr, "test1") == 0, "name(%s)", seq->s.segment.name.ptr);
+	assert(strcmp((char const *)seq->s.segment.seq.ptr, "ATATCGCG") == 0, "seq(%s)", (char const *)seq->s.segment.seq.ptr);
+	assert(seq->s.segment.seq.len == 8, "len(%lld)", seq->s.segment.seq.len);
+	assert(strcmp((char const *)seq->s.segment.qual.ptr, "") == 0, "seq(%s)", (char const *)seq->s.segment.qual.ptr);
+	assert(seq->s.segment.qual.len == 0, "len(%lld)", seq->s.segment.qual.len);
+	fna_seq_free(seq);
+
+	/* test2 */
 	seq = fna_read(fna);
 	assert(strcmp(seq->s.segment.name.ptr, "test2") == 0, "name(%s)", seq->s.segment.name.ptr);
-	assert(strcmp(seq->s.segment.comment.ptr, "") == 0, "comment(%s)", seq->s.segment.comment.ptr);
 	assert(strcmp((char const *)seq->s.segment.seq.ptr, "AAAA") == 0, "seq(%s)", (char const *)seq->s.segment.seq.ptr);
 	assert(seq->s.segment.seq.len == 4, "len(%lld)", seq->s.segment.seq.len);
+	assert(strcmp((char const *)seq->s.segment.qual.ptr, "") == 0, "seq(%s)", (char const *)seq->s.segment.qual.ptr);
+	assert(seq->s.segment.qual.len == 0, "len(%lld)", seq->s.segment.qual.len);
+	fna_seq_free(seq);
+
+	/* test3 */
+	seq = fna_read(fna);
+	assert(strcmp(seq->s.segment.name.ptr, "test3") == 0, "name(%s)", seq->s.segment.name.ptr);
+	assert(strcmp((char const *)seq->s.segment.seq.ptr, "ACGT") == 0, "seq(%s)", (char const *)seq->s.segment.seq.ptr);
+	assert(seq->s.segment.seq.len == 4, "len(%lld)", seq->s.segment.seq.len);
+	assert(strcmp((char const *)seq->s.segment.qual.ptr, "") == 0, "seq(%s)", (char const *)seq->s.segment.qual.ptr);
+	assert(seq->s.segment.qual.len == 0, "len(%lld)", seq->s.segment.qual.len);
+	fna_seq_free(seq);
+
+	/* test eof */
+	seq = fna_read(fna);
+	assert(seq == NULL, "seq(%p)", seq);
+	assert(fna->status == FNA_EOF, "status(%d)", fna->status);
+	fna_seq_free(seq);
+
+	fna_close(fna);
+
+	/** cleanup files */
+	remove(fastq_filename);
+	return;
+}
+
+/**
+ * gfa parsing
+ */
+unittest()
+{
+	char const *gfa_filename = "test_gfa.gfa";
+	char const *gfa_content =
+		"H	VN:Z:1.0\n"
+		"S	11	ACCTT\n"
+		"S	12	TCAAGG\n"
+		"S	13	CTTGATT\n"
+		"L	11	+	12	-	4M\n"
+		"L	12	-	13	+	5M\n"
+		"L	11	+	13	+	3M\n"
+		"P	14	11+,12-,13+	4M,5M\n"
+		"C	13	-	15	+	2	*	ID:Z:c1\n"
+		"S	15	CTTGATT\n";
+
+	assert(fdump(gfa_filename, gfa_content));
+	assert(fcmp(gfa_filename, strlen(gfa_content), (uint8_t const *)gfa_content));
+
+	debug("start gfa");
+	fna_t *fna = fna_init(gfa_filename, NULL);
+	assert(fna != NULL, "fna(%p)", fna);
+
+	/* format detection (internal) */
+	assert(fna->file_format == FNA_GFA, "fna->file_format(%d)", fna->file_format);
+
+	/* segment 11 */
+	fna_seq_t *seq = fna_read(fna);
+	assert(seq->type == FNA_SEGMENT, "type(%d)", seq->type);
+	assert(strcmp(seq->s.segment.name.ptr, "11") == 0, "name(%s)", seq->s.segment.name.ptr);
+	assert(strcmp((char const *)seq->s.segment.seq.ptr, "ACCTT") == 0, "seq(%s)", (char const *)seq->s.segment.seq.ptr);
+	assert(seq->s.segment.seq.len == 5, "len(%lld)", seq->s.segment.seq.len);
+	fna_seq_free(seq);
+
+	/* segment 12 */
+	seq = fna_read(fna);
+	assert(seq->type == FNA_SEGMENT, "type(%d)", seq->type);
+	assert(strcmp(seq->s.segment.name.ptr, "12") == 0, "name(%s)", seq->s.segment.name.ptr);
+	assert(strcmp((char const *)seq->s.segment.seq.ptr, "TCAAGG") == 0, "seq(%s)", (char const *)seq->s.segment.seq.ptr);
+	assert(seq->s.segment.seq.len == 6, "len(%lld)", seq->s.segment.seq.len);
+	fna_seq_free(seq);
+
+	/* segment 13 */
+	seq = fna_read(fna);
+	assert(seq->type == FNA_SEGMENT, "type(%d)", seq->type);
+	assert(strcmp(seq->s.segment.name.ptr, "13") == 0, "name(%s)", seq->s.segment.name.ptr);
+	assert(strcmp((char const *)seq->s.segment.seq.ptr, "CTTGATT") == 0, "seq(%s)", (char const *)seq->s.segment.seq.ptr);
+	assert(seq->s.segment.seq.len == 7, "len(%lld)", seq->s.segment.seq.len);
+	fna_seq_free(seq);
+
+	/* link 11 to 12 */
+	seq = fna_read(fna);
+	assert(seq->type == FNA_LINK, "type(%d)", seq->type);
+	assert(strcmp(seq->s.link.src.ptr, "11") == 0, "from(%s)", seq->s.link.src.ptr);
+	assert(seq->s.link.src_ori == 0, "src_ori(%d)", seq->s.link.src_ori);
+	assert(strcmp(seq->s.link.dst.ptr, "12") == 0, "to(%s)", seq->s.link.dst.ptr);
+	assert(seq->s.link.dst_ori == 1, "dst_ori(%d)", seq->s.link.dst_ori);
+	assert(strcmp((char const *)seq->s.link.cigar.ptr, "4M") == 0, "cigar(%s)", (char const *)seq->s.link.cigar.ptr);
+	fna_seq_free(seq);
+
+	/* link 12 to 13 */
+	seq = fna_read(fna);
+	assert(seq->type == FNA_LINK, "type(%d)", seq->type);
+	assert(strcmp(seq->s.link.src.ptr, "12") == 0, "from(%s)", seq->s.link.src.ptr);
+	assert(seq->s.link.src_ori == 1, "src_ori(%d)", seq->s.link.src_ori);
+	assert(strcmp(seq->s.link.dst.ptr, "13") == 0, "to(%s)", seq->s.link.dst.ptr);
+	assert(seq->s.link.dst_ori == 0, "dst_ori(%d)", seq->s.link.dst_ori);
+	assert(strcmp((char const *)seq->s.link.cigar.ptr, "5M") == 0, "cigar(%s)", (char const *)seq->s.link.cigar.ptr);
+	fna_seq_free(seq);
+
+	/* link 11 to 13 */
+	seq = fna_read(fna);
+	assert(seq->type == FNA_LINK, "type(%d)", seq->type);
+	assert(strcmp(seq->s.link.src.ptr, "11") == 0, "from(%s)", seq->s.link.src.ptr);
+	assert(seq->s.link.src_ori == 0, "src_ori(%d)", seq->s.link.src_ori);
+	assert(strcmp(seq->s.link.dst.ptr, "13") == 0, "to(%s)", seq->s.link.dst.ptr);
+	assert(seq->s.link.dst_ori == 0, "dst_ori(%d)", seq->s.link.dst_ori);
+	assert(strcmp((char const *)seq->s.link.cigar.ptr, "3M") == 0, "cigar(%s)", (char const *)seq->s.link.cigar.ptr);
+	fna_seq_free(seq);
+
+	/* path 14 */
+	seq = fna_read(fna);
+	assert(seq->type == FNA_PATH, "type(%d)", seq->type);
+	assert(strcmp(seq->s.path.name.ptr, "14") == 0, "name(%s)", seq->s.path.name.ptr);
+	assert(seq->s.path.len == 3, "len(%lld)", seq->s.path.len);
+	assert(strcmp(seq->s.path.name.ptr + seq->s.path.seg_ofs[0], "11") == 0, "seg(%s)", seq->s.path.name.ptr + seq->s.path.seg_ofs[0]);
+	assert(strcmp(seq->s.path.name.ptr + seq->s.path.seg_ofs[1], "12") == 0, "seg(%s)", seq->s.path.name.ptr + seq->s.path.seg_ofs[1]);
+	assert(strcmp(seq->s.path.name.ptr + seq->s.path.seg_ofs[2], "13") == 0, "seg(%s)", seq->s.path.name.ptr + seq->s.path.seg_ofs[2]);
+	assert(seq->s.path.ori[0] == 0 && seq->s.path.ori[1] == 1 && seq->s.path.ori[2] == 0, "ori(%u, %u, %u)", seq->s.path.ori[0], seq->s.path.ori[1], seq->s.path.ori[2]);
+	assert(((uintptr_t)seq->s.path.seg_ofs & 0x07) == 0, "seg_ofs(%p)", seq->s.path.seg_ofs);
+	assert(strcmp(seq->s.path.overlap.ptr, "4M,5M") == 0, "overlap(%s)", seq->s.path.overlap.ptr);
+	assert(seq->s.path.overlap.len == 5, "len(%lld)", seq->s.path.overlap.len);
+	fna_seq_free(seq);
+
+	/* 15 in 13 */
+	seq = fna_read(fna);
+	assert(seq->type == FNA_CONTAINMENT, "type(%d)", seq->type);
+	assert(strcmp(seq->s.containment.src.ptr, "13") == 0, "src(%s)", seq->s.containment.src.ptr);
+	assert(seq->s.containment.src_ori == 1, "src_ori(%d)", seq->s.containment.src_ori);
+	assert(strcmp(seq->s.containment.dst.ptr, "15") == 0, "dst(%s)", seq->s.containment.dst.ptr);
+	assert(seq->s.containment.dst_ori == 0, "dst_ori(%d)", seq->s.containment.dst_ori);
+	assert(seq->s.containment.pos == 2, "pos(%lld)", seq->s.containment.pos);
+	assert(seq->s.containment.cigar.len == 0, "cigar(%s)", seq->s.containment.cigar.ptr);
+	fna_seq_free(seq);
+
+	/* segment 15 */
+	seq = fna_read(fna);
+	assert(seq->type == FNA_SEGMENT, "type(%d)", seq->type);
+	assert(strcmp(seq->s.segment.name.ptr, "15") == 0, "name(%s)", seq->s.segment.name.ptr);
+	assert(strcmp((char const *)seq->s.segment.seq.ptr, "CTTGATT") == 0, "seq(%s)", (char const *)seq->s.segment.seq.ptr);
+	assert(seq->s.segment.seq.len == 7, "len(%lld)", seq->s.segment.seq.len);
+	fna_seq_free(seq);
+
+	/* term */
+	seq = fna_read(fna);
+	assert(seq == NULL, "%p", seq);
 	fna_seq_free(seq);
 
-	/* test3 */
-	seq = fna_read(fna);
-	assert(strcmp(seq->s.segment.name.ptr, "test3") == 0, "name(%s)", seq->s.segment.name.ptr);
-	assert(strcmp(seq->s.segment.comment.ptr, "comment") == 0, "comment(%s)", seq->s.segment.comment.ptr);
-	assert(strcmp((char const *)seq->s.segment.seq.ptr, "ACGT") == 0, "seq(%s)", (char const *)seq->s.segment.seq.ptr);
-	assert(seq->s.segment.seq.len == 4, "len(%lld)", seq->s.segment.seq.len);
-	fna_seq_free(seq);
+	fna_close(fna);
+
+	/** cleanup files */
+	remove(gfa_filename);
+	return;
+}
+
+/**
+ * format detection (fail)
+ */
+unittest()
+{
+	char const *fail_filename = "test_fail.txt";
+	char const *fail_content = "A quick brown fox jumps over the lazy dog.\n";
+	assert(fdump(fail_filename, fail_content));
+	assert(fcmp(fail_filename, strlen(fail_content), (uint8_t const *)fail_content));
+
+	/* returns NULL when failed to detect format */
+	fna_t *fna = fna_init(fail_filename, NULL);
+	assert(fna == NULL, "fna(%p)", fna);
+
+	/** cleanup file */
+	remove(fail_filename);
+	return;
+}
+
+/**
+ * format detection from the content of the file (FASTA)
+ */
+unittest()
+{
+	char const *fasta_filename = "test_fna.txt";
+	char const *fasta_content =
+		">test0\nAAAA\n"
+		"> test1\nATAT\nCGCG\n"
+		">  test2\n\nAAAA\n";
+	assert(fdump(fasta_filename, fasta_content));
+	assert(fcmp(fasta_filename, strlen(fasta_content), (uint8_t const *)fasta_content));
+	fna_t *fna = fna_init(fasta_filename, NULL);
+	assert(fna != NULL, "fna(%p)", fna);
+
+	/* format detection (internal) */
+	assert(fna->file_format == FNA_FASTA, "fna->file_format(%d)", fna->file_format);
+
+	fna_close(fna);
+
+	/** cleanup file */
+	remove(fasta_filename);
+	return;
+}
+
+/**
+ * format detection (FASTQ)
+ */
+unittest()
+{
+	char const *fastq_filename = "test_fna.txt";
+	char const *fastq_content =
+		"@test0\nAAAA\n+test0\nNNNN\n"
+		"@ test1\nATAT\nCGCG\n+ test1\nNNNN\nNNNN\n"
+		"@  test2\n\nAAAA\n+  test2\n\nNNNN\n";
+	assert(fdump(fastq_filename, fastq_content));
+	assert(fcmp(fastq_filename, strlen(fastq_content), (uint8_t const *)fastq_content));
+
+	fna_t *fna = fna_init(fastq_filename, NULL);
+	assert(fna != NULL, "fna(%p)", fna);
+
+	/* format detection (internal) */
+	assert(fna->file_format == FNA_FASTQ, "fna->file_format(%d)", fna->file_format);
+
+	fna_close(fna);
+
+	/** cleanup file */
+	remove(fastq_filename);
+	return;
+}
+
+/* format detection */
+unittest()
+{
+	char const *gfa_filename = "test_gfa.txt";
+	char const *gfa_content =
+		"H	VN:Z:1.0\n"
+		"S	11	ACCTT\n"
+		"S	12	TCAAGG\n"
+		"S	13	CTTGATT\n"
+		"L	11	+	12	-	4M\n"
+		"L	12	-	13	+	5M\n"
+		"L	11	+	13	+	3M\n"
+		"P	14	11+,12-,13+	4M,5M\n"
+		"S	15	CTTGATT\n";
+
+	assert(fdump(gfa_filename, gfa_content));
+	assert(fcmp(gfa_filename, strlen(gfa_content), (uint8_t const *)gfa_content));
+
+	fna_t *fna = fna_init(gfa_filename, NULL);
+	assert(fna != NULL, "fna(%p)", fna);
+
+	/* format detection (internal) */
+	assert(fna->file_format == FNA_GFA, "fna->file_format(%d)", fna->file_format);
+
+	fna_close(fna);
+
+	/** cleanup file */
+	remove(gfa_filename);
+	return;
+}
+
+/* fna_load_graph, small graph */
+unittest()
+{
+	char const *gfa_filename = "test_gfa_graph.gfa";
+	assert(fdump(gfa_filename,
+		"H\tVN:Z:1.0\n"
+		"S\ta\tACGTACGT\n"
+		"L\ta\t+\tb\t-\t4M\n"
+		"S\tb\tCCGGA\n"
+		"P\tp\ta+,b-\t4M\n"
+		"L\tb\t+\tc\t+\t2M1I3M2D\tRC:i:3\n"
+		"C\ta\t+\tb\t+\t1\t*\n"
+		"L\ta\t-\ta\t+\t*\n"));
+
+	fna_graph_t *g = fna_load_graph(gfa_filename, FNA_PARAMS( .seq_encode = FNA_ASCII ));
+	assert(g != NULL, "g(%p)", g);
+	assert(g->seg_cnt == 3, "seg_cnt(%lld)", g->seg_cnt);
+	assert(g->arc_cnt == 6, "arc_cnt(%lld)", g->arc_cnt);
+
+	char const *names[] = { "a", "b", "c" }, *seqs[] = { "ACGTACGT", "CCGGA", "" };
+	for(int64_t i = 0; i < 3; i++) {
+		assert(strcmp(g->name + g->name_ofs[i], names[i]) == 0, "i(%lld), name(%s)", i, g->name + g->name_ofs[i]);
+		assert(g->seq_len[i] == (int64_t)strlen(seqs[i]), "i(%lld), len(%lld)", i, g->seq_len[i]);
+		assert(strcmp((char const *)g->seq + g->seq_ofs[i], seqs[i]) == 0, "i(%lld), seq(%s)", i, g->seq + g->seq_ofs[i]);
+	}
 
-	/* test eof */
+	/* vertices a+, a-, b+, b-, c+, c- */
+	int64_t const adj_ofs[] = { 0, 1, 3, 5, 5, 5, 6 };
+	struct fna_graph_arc_s const adj[] = {
+		{ 3, 4 },			/* a+ -> b- */
+		{ 0, 0 }, { 0, 0 },	/* a- -> a+, and its complement */
+		{ 1, 4 }, { 4, 7 },	/* b+ -> a- (complement of a+ -> b-), b+ -> c+ with 7 bases of b */
+		{ 3, 6 }			/* c- -> b-, 6 bases of c */
+	};
+	for(int64_t u = 0; u < 7; u++) {
+		assert(g->adj_ofs[u] == adj_ofs[u], "u(%lld), ofs(%lld, %lld)", u, g->adj_ofs[u], adj_ofs[u]);
+	}
+	for(int64_t i = 0; i < 6; i++) {
+		assert(g->adj[i].v == adj[i].v && g->adj[i].overlap == adj[i].overlap, "i(%lld), arc(%u, %u), ans(%u, %u)",
+			i, g->adj[i].v, g->adj[i].overlap, adj[i].v, adj[i].overlap);
+	}
+	fna_graph_free(g);
+
+	/* not a GFA */
+	assert(fdump(gfa_filename, ">s0\nACGT\n"));
+	assert(fna_load_graph(gfa_filename, NULL) == NULL);
+	remove(gfa_filename);
+}
+
+/* fna_load_graph on threads, compared against the links and segments read one by one */
+unittest()
+{
+	char const *gfa_filename = "test_gfa_graph_rand.gfa";
+	int64_t const scnt = 3000, lcnt = 20000;
+
+	FILE *fp = fopen(gfa_filename, "w");
+	fprintf(fp, "H\tVN:Z:1.0\n");
+	for(int64_t i = 0; i < scnt + lcnt; i++) {
+		if(i % 7 == 0 && i / 7 < scnt) {
+			fprintf(fp, "S\ts%lld\t", (long long)(i / 7));
+			for(int64_t j = 0, len = 1 + (i * 13) % 97; j < len; j++) { fputc(unittest_random_base(), fp); }
+			fputc('\n', fp);
+		} else {
+			fprintf(fp, "L\ts%lld\t%c\ts%lld\t%c\t%dM\n",
+				(long long)(rand() % (scnt + 10)), "+-"[rand() & 1], (long long)(rand() % (scnt + 10)), "+-"[rand() & 1], rand() % 10);
+		}
+	}
+	fclose(fp);
+
+	fna_graph_t *g[3] = {
+		fna_load_graph(gfa_filename, FNA_PARAMS( .seq_encode = FNA_2BITPACKED )),
+		fna_load_graph(gfa_filename, FNA_PARAMS( .seq_encode = FNA_2BITPACKED, .threads = 4 )),
+		fna_load_graph(gfa_filename, FNA_PARAMS( .seq_encode = FNA_2BITPACKED, .threads = 1, .options = FNA_MMAP ))
+	};
+	for(int64_t k = 0; k < 3; k++) {
+		assert(g[k] != NULL, "k(%lld)", k);
+		assert(g[k]->seg_cnt == g[0]->seg_cnt && g[k]->arc_cnt == g[0]->arc_cnt, "k(%lld)", k);
+		assert(memcmp(g[k]->adj_ofs, g[0]->adj_ofs, sizeof(int64_t) * (2 * g[0]->seg_cnt + 1)) == 0, "k(%lld)", k);
+		assert(memcmp(g[k]->adj, g[0]->adj, sizeof(struct fna_graph_arc_s) * g[0]->arc_cnt) == 0, "k(%lld)", k);
+	}
+	assert(g[0]->adj_ofs[2 * g[0]->seg_cnt] == g[0]->arc_cnt, "ofs(%lld)", g[0]->adj_ofs[2 * g[0]->seg_cnt]);
+
+	/* every link is found in the rows of its both ends, rows are sorted */
+	fna_t *fna = fna_init(gfa_filename, FNA_PARAMS( .seq_encode = FNA_2BITPACKED, .options = FNA_INTERN_NAMES ));
+	fna_seq_t *seq;
+	int64_t links = 0;
+	while((seq = fna_read(fna)) != NULL) {
+		if(seq->type == FNA_SEGMENT) {
+			int64_t const id = seq->s.segment.name.id;
+			assert(g[0]->seq_len[id] == seq->s.segment.seq.len, "id(%lld)", id);
+			assert(memcmp(g[0]->seq + g[0]->seq_ofs[id], seq->s.segment.seq.ptr, seq->s.segment.seq.len / 4 + 1) == 0, "id(%lld)", id);
+		} else {
+			uint32_t const u = (seq->s.link.src.id<<1) | seq->s.link.src_ori, v = (seq->s.link.dst.id<<1) | seq->s.link.dst_ori;
+			uint32_t const o = atoi(seq->s.link.cigar.ptr);
+			int64_t f = 0, r = 0;
+			for(int64_t i = g[0]->adj_ofs[u]; i < g[0]->adj_ofs[u + 1]; i++) { f += g[0]->adj[i].v == v && g[0]->adj[i].overlap == o; }
+			for(int64_t i = g[0]->adj_ofs[v ^ 1]; i < g[0]->adj_ofs[(v ^ 1) + 1]; i++) { r += g[0]->adj[i].v == (u ^ 1) && g[0]->adj[i].overlap == o; }
+			assert(f > 0 && r > 0, "u(%u), v(%u), f(%lld), r(%lld)", u, v, f, r);
+			links++;
+		}
+		fna_seq_free(seq);
+	}
+	assert(links == lcnt, "links(%lld)", links);
+	for(int64_t i = 0; i < fna_segment_count(fna); i++) {
+		assert(strcmp(g[0]->name + g[0]->name_ofs[i], fna_segment_name(fna, i)) == 0, "i(%lld)", i);
+	}
+	for(int64_t u = 0; u < 2 * g[0]->seg_cnt; u++) {
+		for(int64_t i = g[0]->adj_ofs[u] + 1; i < g[0]->adj_ofs[u + 1]; i++) {
+			assert(g[0]->adj[i - 1].v <= g[0]->adj[i].v, "u(%lld), i(%lld)", u, i);
+		}
+	}
+	fna_close(fna);
+
+	for(int64_t k = 0; k < 3; k++) { fna_graph_free(g[k]); }
+	remove(gfa_filename);
+}
+
+/* FNA_INTERN_NAMES, ids of segment names in the order of appearance */
+unittest()
+{
+	char const *gfa_filename = "test_gfa_intern.gfa";
+	assert(fdump(gfa_filename,
+		"H\tVN:Z:1.0\n"
+		"L\ta\t+\tbb\t-\t4M\n"
+		"S\tbb\tACGT\n"
+		"S\tccc\tACGT\n"
+		"C\tccc\t+\ta\t-\t1\t*\n"
+		"P\tp\ta+,ccc-,dddd+\t*\n"
+		"S\ta\tAC\n"));
+
+	for(int64_t k = 0; k < 2; k++) {
+		fna_t *fna = fna_init(gfa_filename, FNA_PARAMS( .options = (k == 0) ? 0 : FNA_INTERN_NAMES ));
+		int32_t const n = -1;
+		#define _id(_i)		( (k == 0) ? n : (_i) )
+
+		fna_seq_t *seq = fna_read(fna);
+		assert(seq->type == FNA_LINK, "k(%lld), type(%d)", k, seq->type);
+		assert(seq->s.link.src.id == _id(0) && seq->s.link.dst.id == _id(1), "k(%lld), id(%d, %d)", k, seq->s.link.src.id, seq->s.link.dst.id);
+		fna_seq_free(seq);
+
+		seq = fna_read(fna);
+		assert(seq->s.segment.name.id == _id(1), "k(%lld), id(%d)", k, seq->s.segment.name.id);
+		fna_seq_t *dup = fna_duplicate(seq);
+		assert(dup->s.segment.name.id == _id(1), "k(%lld), id(%d)", k, dup->s.segment.name.id);
+		fna_seq_free(dup);
+		fna_seq_free(seq);
+
+		seq = fna_read(fna);
+		assert(seq->s.segment.name.id == _id(2), "k(%lld), id(%d)", k, seq->s.segment.name.id);
+		fna_seq_free(seq);
+
+		seq = fna_read(fna);
+		assert(seq->type == FNA_CONTAINMENT, "k(%lld), type(%d)", k, seq->type);
+		assert(seq->s.containment.src.id == _id(2) && seq->s.containment.dst.id == _id(0), "k(%lld), id(%d, %d)", k, seq->s.containment.src.id, seq->s.containment.dst.id);
+		fna_seq_free(seq);
+
+		seq = fna_read(fna);
+		assert(seq->type == FNA_PATH && seq->s.path.len == 3, "k(%lld), type(%d)", k, seq->type);
+		assert(seq->s.path.name.id == -1, "k(%lld), id(%d)", k, seq->s.path.name.id);
+		if(k == 0) {
+			assert(seq->s.path.seg_id == NULL, "k(%lld)", k);
+		} else {
+			assert(seq->s.path.seg_id[0] == 0 && seq->s.path.seg_id[1] == 2 && seq->s.path.seg_id[2] == 3,
+				"k(%lld), id(%d, %d, %d)", k, seq->s.path.seg_id[0], seq->s.path.seg_id[1], seq->s.path.seg_id[2]);
+		}
+		fna_seq_free(seq);
+
+		seq = fna_read(fna);
+		assert(seq->s.segment.name.id == _id(0), "k(%lld), id(%d)", k, seq->s.segment.name.id);
+		fna_seq_free(seq);
+		assert(fna_read(fna) == NULL, "k(%lld)", k);
+		#undef _id
+
+		/* lookup */
+		char const *names[] = { "a", "bb", "ccc", "dddd" };
+		assert(fna_segment_count(fna) == ((k == 0) ? 0 : 4), "k(%lld), cnt(%lld)", k, fna_segment_count(fna));
+		for(int64_t i = 0; i < 4; i++) {
+			assert(fna_segment_id(fna, names[i]) == ((k == 0) ? -1 : i), "k(%lld), i(%lld)", k, i);
+			assert((k == 0) == (fna_segment_name(fna, i) == NULL), "k(%lld), i(%lld)", k, i);
+			assert(k == 0 || strcmp(fna_segment_name(fna, i), names[i]) == 0, "k(%lld), i(%lld)", k, i);
+		}
+		assert(fna_segment_id(fna, "b") == -1 && fna_segment_id(fna, "") == -1, "k(%lld)", k);
+		assert(fna_segment_name(fna, 4) == NULL && fna_segment_name(fna, -1) == NULL, "k(%lld)", k);
+		fna_close(fna);
+	}
+
+	/* many names, ids survive the growth of the table and fna_seek */
+	FILE *fp = fopen(gfa_filename, "w");
+	fprintf(fp, "H\tVN:Z:1.0\n");
+	for(int64_t i = 0; i < 50000; i++) {
+		fprintf(fp, "S\tseg_%lld_%s\tACGT\n", (long long)(i * 7) % 50000, (i & 1) ? "long_name_over_eight_bytes" : "x");
+	}
+	fclose(fp);
+
+	fna_t *fna = fna_init(gfa_filename, FNA_PARAMS( .options = FNA_INTERN_NAMES ));
+	fna_pos_t pos;
+	fna_seq_t *seq;
+	for(int64_t i = 0; (seq = fna_read(fna)) != NULL; i++) {
+		assert(seq->s.segment.name.id == i, "i(%lld), id(%d)", i, seq->s.segment.name.id);
+		assert(strcmp(fna_segment_name(fna, i), seq->s.segment.name.ptr) == 0, "i(%lld)", i);
+		if(i == 100) { fna_tell(fna, &pos); }
+		fna_seq_free(seq);
+	}
+	assert(fna_segment_count(fna) == 50000, "cnt(%lld)", fna_segment_count(fna));
+	assert(fna_seek(fna, &pos) == FNA_SUCCESS);
 	seq = fna_read(fna);
-	assert(seq == NULL, "seq(%p)", seq);
-	assert(fna->status == FNA_EOF, "status(%d)", fna->status);
+	assert(seq->s.segment.name.id == 101, "id(%d)", seq->s.segment.name.id);
 	fna_seq_free(seq);
+	assert(fna_segment_count(fna) == 50000, "cnt(%lld)", fna_segment_count(fna));
+	fna_close(fna);
 
+	/* names of different lengths on the same hash, the shorter one compared at the tail of the storage */
+	assert(fna_names_hash("ap3r", 4) == fna_names_hash("a0ab5", 5));
+	fp = fopen(gfa_filename, "w");
+	fprintf(fp, "H\tVN:Z:1.0\nS\tap3r\tACGT\nS\ta0ab5\tACGT\n");
+	fclose(fp);
+	fna = fna_init(gfa_filename, FNA_PARAMS( .options = FNA_INTERN_NAMES ));
+	while((seq = fna_read(fna)) != NULL) { fna_seq_free(seq); }
+	assert(fna_segment_id(fna, "ap3r") == 0 && fna_segment_id(fna, "a0ab5") == 1);
+	assert(fna_segment_id(fna, "ap3") == -1 && fna_segment_count(fna) == 2);
 	fna_close(fna);
 
-	/** cleanup files */
-	remove(fasta_filename);
+	/* the parser thread of FNA_SHARED does not share the table */
+	assert(fna_init(gfa_filename, FNA_PARAMS( .options = FNA_INTERN_NAMES | FNA_SHARED )) == NULL);
+
+	remove(gfa_filename);
+}
+
+/* long path, steps over many windows, read one by one and in a batch with the names interned */
+unittest()
+{
+	char const *gfa_filename = "test_gfa_path.gfa";
+	int64_t const cnt = 300000;
+
+	FILE *fp = fopen(gfa_filename, "w");
+	fprintf(fp, "H\tVN:Z:1.0\nS\t0\tACGT\nP\tp0\t");
+	for(int64_t i = 0; i < cnt; i++) {
+		fprintf(fp, "%s%d%c", (i == 0) ? "" : ",", (int)((i * 7919) % 100000), (i % 3 == 0) ? '-' : '+');
+	}
+	fprintf(fp, "\t*\tSR:i:0\nP\tp1\t0+\t*\nS\t1\tAC\nP\tp2\t0-,x\t*\n");
+	fclose(fp);
+
+	for(int64_t b = 0; b < 2; b++) {
+		fna_t *fna = fna_init(gfa_filename, FNA_PARAMS( .head_margin = 16, .options = (b == 0) ? 0 : FNA_INTERN_NAMES ));
+		fna_batch_t *batch = (b == 0) ? NULL : fna_read_batch(fna, 10, 0);
+		assert(b == 0 || (batch != NULL && batch->cnt == 4), "b(%lld), batch(%p)", b, batch);
+		#define _get(_i)		( (b == 0) ? fna_read(fna) : batch->seq[_i] )
+
+		fna_seq_t *seq = _get(0);
+		assert(seq->type == FNA_SEGMENT, "b(%lld), type(%d)", b, seq->type);
+		fna_seq_free(seq);
+
+		seq = _get(1);
+		assert(seq->type == FNA_PATH, "b(%lld), type(%d)", b, seq->type);
+		assert(strcmp(seq->s.path.name.ptr, "p0") == 0, "b(%lld), name(%s)", b, seq->s.path.name.ptr);
+		assert(seq->s.path.len == cnt, "b(%lld), len(%lld)", b, seq->s.path.len);
+		for(int64_t i = 0; i < cnt; i++) {
+			char name[16];
+			sprintf(name, "%d", (int)((i * 7919) % 100000));
+			assert(strcmp(seq->s.path.name.ptr + seq->s.path.seg_ofs[i], name) == 0, "b(%lld), i(%lld), seg(%s)", b, i, seq->s.path.name.ptr + seq->s.path.seg_ofs[i]);
+			assert(seq->s.path.ori[i] == (i % 3 == 0), "b(%lld), i(%lld)", b, i);
+			if(b != 0) {
+				char const *p = fna_segment_name(fna, seq->s.path.seg_id[i]);
+				assert(p != NULL && strcmp(p, name) == 0, "b(%lld), i(%lld), id(%d)", b, i, seq->s.path.seg_id[i]);
+			}
+		}
+		assert((b == 0) == (seq->s.path.seg_id == NULL), "b(%lld), seg_id(%p)", b, seq->s.path.seg_id);
+		assert(fna_segment_count(fna) == ((b == 0) ? 0 : 100000), "b(%lld), cnt(%lld)", b, fna_segment_count(fna));
+		assert(seq->s.path.overlap.len == 0, "b(%lld), overlap(%s)", b, seq->s.path.overlap.ptr);
+		fna_seq_free(seq);
+
+		seq = _get(2);
+		assert(seq->type == FNA_PATH && seq->s.path.len == 1, "b(%lld), type(%d)", b, seq->type);
+		assert(strcmp(seq->s.path.name.ptr + seq->s.path.seg_ofs[0], "0") == 0 && seq->s.path.ori[0] == 0, "b(%lld), seg(%s)", b, seq->s.path.name.ptr + seq->s.path.seg_ofs[0]);
+		fna_seq_free(seq);
+
+		seq = _get(3);
+		assert(seq->type == FNA_SEGMENT, "b(%lld), type(%d)", b, seq->type);
+		fna_seq_free(seq);
+		#undef _get
+
+		/* a step without orientation */
+		if(b == 0) {
+			assert(fna_read(fna) == NULL, "b(%lld)", b);
+			assert(fna->status == FNA_ERROR_BROKEN_FORMAT, "b(%lld), status(%d)", b, fna->status);
+		} else {
+			fna_batch_free(batch);
+		}
+		fna_close(fna);
+	}
+	remove(gfa_filename);
+}
+
+/* large sequence */
+unittest()
+{
+	char const *filename = "test.fa";
+
+	/* dump */
+	zf_t *fp = zfopen(filename, "w");
+	for(int64_t i = 0; i < 100; i++) {
+		char *seq = unittest_generate_random_sequence(100000);
+		char *base = seq;
+
+		zfprintf(fp, "> seq%lld\n", i);
+		while(*seq != '\0') {
+			for(int64_t j = 0; j < 80; j++) {
+				zfputc(fp, *seq++);
+				if(*seq == '\0') { break; }
+			}
+			zfputc(fp, '\n');
+		}
+
+		free(base);
+	}
+	zfclose(fp);
+
+	/* read */
+	fna_t *fna = fna_init(filename, NULL);
+	fna_seq_t *seq = NULL;
+
+	int64_t i = 0;
+	while((seq = fna_read(fna)) != NULL) {
+		char buf[1024];
+		sprintf(buf, "seq%" PRId64 "", i++);
+
+		assert(strcmp(seq->s.segment.name.ptr, buf) == 0, "name(%s, %s)", seq->s.segment.name.ptr, buf);
+		assert(seq->s.segment.seq.len == 100000, "len(%lld)", seq->s.segment.seq.len);
+
+		fna_seq_free(seq);
+	}
+
+	fna_close(fna);
+	remove(filename);
+}
+
+/* kernel selection */
+unittest()
+{
+	uint32_t const isa = fna_cpu_isa();
+	struct fna_kernel_s const *kernel = fna_kernel_select();
+	assert(kernel != NULL, "kernel(%p)", kernel);
+	assert((kernel->isa & ~isa) == 0, "%s, isa(%x), cpu(%x)", kernel->name, kernel->isa, isa);
+
+	/* no better kernel is available */
+	for(struct fna_kernel_s const *const *k = fna_kernels; *k != kernel; k++) {
+		assert(((*k)->isa & ~isa) != 0, "%s, isa(%x), cpu(%x)", (*k)->name, (*k)->isa, isa);
+	}
+}
+
+/* FNA_MMAP, compared against the buffered reader */
+unittest()
+{
+	struct {
+		char const *filename, *content;
+		int encode;
+		uint32_t views[5];
+	} const files[] = {
+		{
+			"test_fna_mmap.fa",
+			">s0 comment  \nACGTACGT\n>s1\nACGT\nACGT\n>s2\r\nAC\r\n\n>s3\n",
+			FNA_ASCII,
+			{ 0x07, 0x01, 0x05, 0x05 }		/* s1 is copied */
+		},
+		{
+			"test_fna_mmap.fq",
+			"@r0 c\nACGT\n+\nIIII\n@r1\nAC\nGT\n+r1\nII\nII\n@r2\nAC\n+\n!!\n",
+			FNA_ASCII,
+			{ 0x0f, 0x01, 0x0d }
+		},
+		{
+			"test_fna_mmap_2bit.fq",
+			"@r0 c\nACGT\n+\nIIII\n",
+			FNA_2BIT,
+			{ 0x03 }						/* names only */
+		}
+	};
+
+	for(int64_t f = 0; f < (int64_t)(sizeof(files) / sizeof(files[0])); f++) {
+		assert(fdump(files[f].filename, files[f].content));
+		fna_t *fb = fna_init(files[f].filename, FNA_PARAMS(.seq_encode = files[f].encode));
+		fna_t *fm = fna_init(files[f].filename, FNA_PARAMS(.seq_encode = files[f].encode, .options = FNA_MMAP));
+		assert(fb != NULL && fm != NULL, "fb(%p), fm(%p)", fb, fm);
+		assert(((struct fna_context_s *)fm)->map_size != 0, "%s", files[f].filename);
+
+		#define _eq(_a, _b, _size)	( (_a).len == (_b).len && memcmp((_a).ptr, (_b).ptr, (_size)) == 0 )
+		fna_seq_t *b, *m;
+		int64_t i = 0;
+		while((b = fna_read(fb)) != NULL) {
+			m = fna_read(fm);
+			assert(m != NULL, "%s, i(%lld)", files[f].filename, i);
+			struct fna_segment_s const *x = &b->s.segment, *y = &m->s.segment;
+			assert(_eq(x->name, y->name, x->name.len), "%s, i(%lld)", files[f].filename, i);
+			assert(_eq(x->comment, y->comment, x->comment.len), "%s, i(%lld)", files[f].filename, i);
+			assert(_eq(x->seq, y->seq, fna_encoded_size(files[f].encode, x->seq.len) - (files[f].encode == FNA_ASCII)), "%s, i(%lld)", files[f].filename, i);
+			assert(_eq(x->qual, y->qual, x->qual.len), "%s, i(%lld)", files[f].filename, i);
+			assert(((struct fna_seq_intl_s *)m)->flags == files[f].views[i], "%s, i(%lld), flags(%x)",
+				files[f].filename, i, ((struct fna_seq_intl_s *)m)->flags);
+			fna_seq_free(b);
+			fna_seq_free(m);
+			i++;
+		}
+		assert(fna_read(fm) == NULL, "%s", files[f].filename);
+		assert(fb->status == fm->status, "%s, status(%d, %d)", files[f].filename, fb->status, fm->status);
+		#undef _eq
+
+		fna_close(fb);
+		fna_close(fm);
+		remove(files[f].filename);
+	}
+}
+
+#if defined(HAVE_PTHREAD)
+/* read-ahead thread, over more windows than slots in the ring */
+unittest()
+{
+	char const *filename = "test_fna_ahead.fa";
+	int64_t const cnt = 4, len = 3 * FNA_BUF_SIZE;
+
+	FILE *fp = fopen(filename, "w");
+	for(int64_t i = 0; i < cnt; i++) {
+		fprintf(fp, ">s%d\n", (int)i);
+		for(int64_t j = 0; j < len; j++) {
+			fputc(unittest_random_base(), fp);
+			if(j % 60 == 59) { fputc('\n', fp); }
+		}
+		fputc('\n', fp);
+	}
+	fclose(fp);
+
+	fna_t *fs = fna_init(filename, NULL);
+	fna_t *fa = fna_init(filename, FNA_PARAMS(.threads = 1));
+	assert(fs != NULL && fa != NULL, "fs(%p), fa(%p)", fs, fa);
+	assert(((struct fna_context_s *)fa)->src != NULL, "");
+
+	fna_seq_t *a, *b;
+	int64_t i = 0;
+	while((a = fna_read(fs)) != NULL) {
+		b = fna_read(fa);
+		assert(b != NULL, "i(%lld)", i);
+		assert(strcmp(a->s.segment.name.ptr, b->s.segment.name.ptr) == 0, "i(%lld)", i);
+		assert(a->s.segment.seq.len == len && b->s.segment.seq.len == len, "i(%lld)", i);
+		assert(memcmp(a->s.segment.seq.ptr, b->s.segment.seq.ptr, len) == 0, "i(%lld)", i);
+		fna_seq_free(a);
+		fna_seq_free(b);
+		i++;
+	}
+	assert(i == cnt, "i(%lld)", i);
+	assert(fna_read(fa) == NULL, "");
+	assert(fa->status == FNA_EOF, "status(%d)", fa->status);
+	fna_close(fs);
+	fna_close(fa);
+
+	/* closed before the end */
+	fa = fna_init(filename, FNA_PARAMS(.threads = 1));
+	fna_seq_free(fna_read(fa));
+	fna_close(fa);
+	remove(filename);
 }
+#endif
 
+#if defined(HAVE_Z) && defined(HAVE_PTHREAD)
 /**
- * basic FASTQ parsing
+ * @fn unittest_dump_bgzf_block
+ * @brief append a BGZF block, an empty one makes the EOF marker
  */
+static
+int unittest_dump_bgzf_block(
+	FILE *fp,
+	char const *p,
+	uint64_t len)
+{
+	uint8_t buf[FNA_BGZF_BLOCK_SIZE];
+	z_stream z;
+	memset(&z, 0, sizeof(z_stream));
+	deflateInit2(&z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+	z.next_in = (uint8_t *)p;
+	z.avail_in = len;
+	z.next_out = buf + 18;
+	z.avail_out = FNA_BGZF_BLOCK_SIZE - 26;
+	int r = deflate(&z, Z_FINISH);
+	uint64_t size = 18 + z.total_out + 8;
+	deflateEnd(&z);
+	if(r != Z_STREAM_END) { return(0); }
+
+	uint8_t const head[16] = { 0x1f, 0x8b, 0x08, 0x04, 0, 0, 0, 0, 0, 0xff, 6, 0, 'B', 'C', 2, 0 };
+	uint32_t crc = crc32(crc32(0, NULL, 0), (uint8_t const *)p, len);
+	memcpy(buf, head, 16);
+	buf[16] = (size - 1) & 0xff; buf[17] = (size - 1)>>8;
+	for(int64_t i = 0; i < 4; i++) {
+		buf[size - 8 + i] = crc>>(8 * i);
+		buf[size - 4 + i] = len>>(8 * i);
+	}
+	return(fwrite(buf, 1, size, fp) == size);
+}
+
+/* parallel BGZF decompression, compared against zf */
 unittest()
 {
-	/**
-	 * create file
-	 * test0: valid FASTQ format
-	 * test1: a space in header
-	 * test2: two spaces in header and two \n's between header and content
-	 */
-	char const *fastq_filename = "test_fna.fq";
-	char const *fastq_content =
-		"@test0\nAAAA\n+test0\nNNNN\n"
-		"@ test1\nATAT\nCGCG\n+ test1\nNNNN\nNNNN\n"
-		"@  test2\n\nAAAA\n+  test2\n\nNNNN\n"
-		"@\ttest3\t  comment   \nACGT\n\n+\ttest3\nNNNN";
-	assert(fdump(fastq_filename, fastq_content));
-	assert(fcmp(fastq_filename, strlen(fastq_content), (uint8_t const *)fastq_content));
+	char const *filename = "test_fna_bgzf.fq.gz";
+	int64_t const cnt = 3000, block = 1000;		/* small blocks to make many groups */
+
+	lmm_kvec_t(char) v;
+	lmm_kv_init(NULL, v);
+	char line[512];
+	for(int64_t i = 0; i < cnt; i++) {
+		int64_t len = 1 + rand() % 200;
+		char *seq = unittest_generate_random_sequence(len);
+		int64_t n = sprintf(line, "@r%lld c\n%s\n+\n%s\n", (long long)i, seq, seq);
+		for(int64_t j = 0; j < n; j++) { lmm_kv_push(NULL, v, line[j]); }
+		free(seq);
+	}
 
-	fna_t *fna = fna_init(fastq_filename, NULL);
-	assert(fna != NULL, "fna(%p)", fna);
+	FILE *fp = fopen(filename, "wb");
+	for(uint64_t p = 0; p < lmm_kv_size(v); p += block) {
+		assert(unittest_dump_bgzf_block(fp, lmm_kv_ptr(v) + p, MIN2(block, lmm_kv_size(v) - p)));
+	}
+	assert(unittest_dump_bgzf_block(fp, NULL, 0));
+	fclose(fp);
+	lmm_kv_destroy(NULL, v);
 
-	/* format detection (internal) */
-	assert(fna->file_format == FNA_FASTQ, "fna->file_format(%d)", fna->file_format);
+	fna_t *fs = fna_init(filename, FNA_PARAMS(.file_format = FNA_FASTQ));
+	fna_t *fp4 = fna_init(filename, FNA_PARAMS(.file_format = FNA_FASTQ, .threads = 4));
+	assert(fs != NULL && fp4 != NULL, "fs(%p), fp4(%p)", fs, fp4);
+	assert(((struct fna_context_s *)fp4)->src != NULL, "");
 
-	/* test0 */
-	fna_seq_t *seq = fna_read(fna);
-	assert(strcmp(seq->s.segment.name.ptr, "test0") == 0, "name(%s)", seq->s.segment.name.ptr);
-	assert(strcmp(seq->s.segment.comment.ptr, "") == 0, "comment(%s)", seq->s.segment.comment.ptr);
-	assert(strcmp((char const *)seq->s.segment.seq.ptr, "AAAA") == 0, "seq(%s)", (char const *)seq->s.segment.seq.ptr);
-	assert(seq->s.segment.seq.len == 4, "len(%lld)", seq->s.segment.seq.len);
-	assert(strcmp((char const *)seq->s.segment.qual.ptr, "NNNN") == 0, "seq(%s)", (char const *)seq->s.segment.qual.ptr);
-	assert(seq->s.segment.qual.len == 4, "len(%lld)", seq->s.segment.qual.len);
-	fna_seq_free(seq);
+	fna_seq_t *a, *b;
+	int64_t i = 0;
+	while((a = fna_read(fs)) != NULL) {
+		b = fna_read(fp4);
+		assert(b != NULL, "i(%lld)", i);
+		assert(strcmp(a->s.segment.name.ptr, b->s.segment.name.ptr) == 0, "i(%lld)", i);
+		assert(strcmp((char const *)a->s.segment.seq.ptr, (char const *)b->s.segment.seq.ptr) == 0, "i(%lld)", i);
+		assert(strcmp((char const *)a->s.segment.qual.ptr, (char const *)b->s.segment.qual.ptr) == 0, "i(%lld)", i);
+		fna_seq_free(a);
+		fna_seq_free(b);
+		i++;
+	}
+	assert(i == cnt, "i(%lld)", i);
+	assert(fna_read(fp4) == NULL, "");
+	assert(fp4->status == FNA_EOF, "status(%d)", fp4->status);
 
-	/* test1 */
-	seq = fna_read(fna);
-	assert(strcmp(seq->s.segment.name.ptr, "test1") == 0, "name(%s)", seq->s.segment.name.ptr);
-	assert(strcmp(seq->s.segment.comment.ptr, "") == 0, "comment(%s)", seq->s.segment.comment.ptr);
-	assert(strcmp((char const *)seq->s.segment.seq.ptr, "ATATCGCG") == 0, "seq(%s)", (char const *)seq->s.segment.seq.ptr);
-	assert(seq->s.segment.seq.len == 8, "len(%lld)", seq->s.segment.seq.len);
-	assert(strcmp((char const *)seq->s.segment.qual.ptr, "NNNNNNNN") == 0, "seq(%s)", (char const *)seq->s.segment.qual.ptr);
-	assert(seq->s.segment.qual.len == 8, "len(%lld)", seq->s.segment.qual.len);
-	fna_seq_free(seq);
+	fna_close(fs);
+	fna_close(fp4);
+	remove(filename);
+}
+#endif
 
-	/* test2 */
-	seq = fna_read(fna);
-	assert(strcmp(seq->s.segment.name.ptr, "test2") == 0, "name(%s)", seq->s.segment.name.ptr);
-	assert(strcmp(seq->s.segment.comment.ptr, "") == 0, "comment(%s)", seq->s.segment.comment.ptr);
-	assert(strcmp((char const *)seq->s.segment.seq.ptr, "AAAA") == 0, "seq(%s)", (char const *)seq->s.segment.seq.ptr);
-	assert(seq->s.segment.seq.len == 4, "len(%lld)", seq->s.segment.seq.len);
-	assert(strcmp((char const *)seq->s.segment.qual.ptr, "NNNN") == 0, "seq(%s)", (char const *)seq->s.segment.qual.ptr);
-	assert(seq->s.segment.qual.len == 4, "len(%lld)", seq->s.segment.qual.len);
-	fna_seq_free(seq);
+/* delimiter scanner, compared against the table */
+unittest()
+{
+	struct fna_delim_s const *delim[] = {
+		&delim_line, &delim_fasta_fastq_name, &delim_fasta_seq, &delim_fastq_seq,
+		&delim_fastq_qual, &delim_fastq_tail, &delim_gfa_field
+	};
+	char const chars[] = "ACGTN>+@ \t\r\n\v\x01\x7f\x80";
+	uint8_t buf[1024 + FNA_BUF_MARGIN];
+	uint32_t const isa = fna_cpu_isa();
+
+	for(int64_t d = 0; d < (int64_t)(sizeof(delim) / sizeof(delim[0])); d++) {
+		for(int64_t i = 0; i < 1000; i++) {
+			int64_t len = rand() % 1024;
+			for(int64_t j = 0; j < len; j++) {
+				/* mostly bases, so that the vectorized loop runs several iterations */
+				buf[j] = (rand() % 64 == 0)
+					? chars[rand() % (sizeof(chars) - 1)]
+					: "ACGT"[rand() % 4];
+			}
+			memset(&buf[len], FNA_BUF_SENTINEL, FNA_BUF_MARGIN);
+
+			int64_t start = (len == 0) ? 0 : rand() % len;
+			uint8_t const *p = &buf[start];
+			while(delim[d]->table[*p] == 0) { p++; }
+
+			for(struct fna_kernel_s const *const *k = fna_kernels; *k != NULL; k++) {
+				if(((*k)->isa & ~isa) != 0) { continue; }
+				uint8_t const *q = (*k)->scan(delim[d], &buf[start]);
+				assert(q == p, "%s, d(%lld), len(%lld), start(%lld), q(%lld), p(%lld)",
+					(*k)->name, d, len, start, q - buf, p - buf);
+			}
+		}
+	}
+}
+
+/* counting scanner, compared against the table */
+unittest()
+{
+	struct fna_delim_s const *delim[] = {
+		&delim_fasta_seq, &delim_fastq_seq, &delim_fastq_qual, &delim_fastq_tail
+	};
+	char const chars[] = "ACGTN>+@\r\n\n\n\t\x01\x7f";
+	uint8_t buf[1024 + FNA_BUF_MARGIN];
+	uint32_t const isa = fna_cpu_isa();
+
+	for(int64_t d = 0; d < (int64_t)(sizeof(delim) / sizeof(delim[0])); d++) {
+		for(int64_t i = 0; i < 1000; i++) {
+			int64_t len = rand() % 1024;
+			int64_t freq = (rand() % 2) ? 16 : 256;		/* dense and sparse delimiters */
+			for(int64_t j = 0; j < len; j++) {
+				buf[j] = (rand() % freq == 0)
+					? chars[rand() % (sizeof(chars) - 1)]
+					: "ACGT"[rand() % 4];
+			}
+			memset(&buf[len], FNA_BUF_SENTINEL, FNA_BUF_MARGIN);
+
+			/* reference */
+			int64_t k = 0, rskip = 0;
+			while((delim[d]->table[buf[k]] & DELIM_TERM) == 0) {
+				rskip += delim[d]->table[buf[k]] != 0;
+				k++;
+			}
+
+			for(struct fna_kernel_s const *const *kr = fna_kernels; *kr != NULL; kr++) {
+				if(((*kr)->isa & ~isa) != 0) { continue; }
+				int64_t skip = 3;
+				uint8_t const *p = (*kr)->count(delim[d], buf, &skip);
+				assert(p == &buf[k], "%s, d(%lld), len(%lld), p(%lld), k(%lld)", (*kr)->name, d, len, p - buf, k);
+				assert(skip == rskip + 3, "%s, d(%lld), len(%lld), skip(%lld), rskip(%lld)", (*kr)->name, d, len, skip, rskip);
+			}
+		}
+	}
+}
+
+/* compaction kernel, compared against the table */
+unittest()
+{
+	struct fna_delim_s const *delim[] = {
+		&delim_fasta_seq, &delim_fastq_seq, &delim_fastq_qual, &delim_fastq_tail
+	};
+	char const chars[] = "ACGTN>+@\r\n\n\n\t\x01";
+	uint8_t src[1024 + FNA_BUF_MARGIN], dst[1024 + FNA_BUF_MARGIN], ref[1024];
+	uint32_t const isa = fna_cpu_isa();
+
+	for(int64_t d = 0; d < (int64_t)(sizeof(delim) / sizeof(delim[0])); d++) {
+		for(int64_t i = 0; i < 1000; i++) {
+			int64_t len = rand() % 1024;
+			int64_t freq = (rand() % 2) ? 16 : 256;		/* dense and sparse delimiters */
+			for(int64_t j = 0; j < len; j++) {
+				src[j] = (rand() % freq == 0)
+					? chars[rand() % (sizeof(chars) - 1)]
+					: "ACGT"[rand() % 4];
+			}
+			memset(&src[len], FNA_BUF_SENTINEL, FNA_BUF_MARGIN);
+			int64_t olim = (rand() % 2) ? LIM_UNLIMITED : rand() % 1024;
+
+			/* reference */
+			int64_t rlen = 0, k = 0;
+			while(k < len && rlen < olim) {
+				uint8_t type = delim[d]->table[src[k]];
+				if(type & DELIM_TERM) { break; }
+				if(type == 0) { ref[rlen++] = src[k]; }
+				k++;
+			}
+
+			for(struct fna_kernel_s const *const *kr = fna_kernels; *kr != NULL; kr++) {
+				if(((*kr)->isa & ~isa) != 0) { continue; }
+				int64_t olen;
+				uint8_t const *p = (*kr)->compact(delim[d], dst, &olen, src, len, olim);
+				assert(p == &src[k], "%s, d(%lld), len(%lld), p(%lld), k(%lld)", (*kr)->name, d, len, p - src, k);
+				assert(olen == rlen, "%s, d(%lld), len(%lld), olen(%lld), rlen(%lld)", (*kr)->name, d, len, olen, rlen);
+				assert(memcmp(dst, ref, rlen) == 0, "%s, d(%lld), len(%lld)", (*kr)->name, d, len);
+			}
+		}
+	}
+}
 
-	/* test3 */
-	seq = fna_read(fna);
-	assert(strcmp(seq->s.segment.name.ptr, "test3") == 0, "name(%s)", seq->s.segment.name.ptr);
-	assert(strcmp(seq->s.segment.comment.ptr, "comment") == 0, "comment(%s)", seq->s.segment.comment.ptr);
-	assert(strcmp((char const *)seq->s.segment.seq.ptr, "ACGT") == 0, "seq(%s)", (char const *)seq->s.segment.seq.ptr);
-	assert(seq->s.segment.seq.len == 4, "len(%lld)", seq->s.segment.seq.len);
-	assert(strcmp((char const *)seq->s.segment.qual.ptr, "NNNN") == 0, "seq(%s)", (char const *)seq->s.segment.qual.ptr);
-	assert(seq->s.segment.qual.len == 4, "len(%lld)", seq->s.segment.qual.len);
-	fna_seq_free(seq);
+/* 2-bit encoder kernels, compared against fna_encode_2bit */
+unittest()
+{
+	uint8_t src[1024], dst[1024], ref[1024];
+	uint32_t const isa = fna_cpu_isa();
 
-	/* test eof */
-	seq = fna_read(fna);
-	assert(seq == NULL, "seq(%p)", seq);
-	assert(fna->status == FNA_EOF, "status(%d)", fna->status);
-	fna_seq_free(seq);
+	#define _unpack(_p, _j)		( ((_p)[(_j) / 4]>>(2 * ((_j) % 4))) & 0x03 )
 
-	fna_close(fna);
+	for(int64_t i = 0; i < 1000; i++) {
+		int64_t len = rand() % 1024;
+		for(int64_t j = 0; j < len; j++) {
+			src[j] = (i < 256) ? (j + i) : "ACGTNacgtnUuRYKM"[rand() % 16];	/* all chars first */
+			ref[j] = fna_encode_2bit(src[j]);
+		}
 
-	/** cleanup files */
-	remove(fastq_filename);
-	return;
+		/* unpacked */
+		int64_t n = fna_encode_2bit_vec(dst, src, len);
+		assert(n <= len, "len(%lld), n(%lld)", len, n);
+		assert(memcmp(dst, ref, n) == 0, "len(%lld)", len);
+
+		/* packed */
+		n = fna_pack_2bit_vec(dst, src, len);
+		assert(n % 4 == 0 && n <= len, "len(%lld), n(%lld)", len, n);
+		int64_t j = 0;
+		while(j < n && _unpack(dst, j) == ref[j]) { j++; }
+		assert(j == n, "len(%lld), j(%lld)", len, j);
+
+		/* in place, with bases carried over from the previous span, on every kernel */
+		int64_t split = (len == 0) ? 0 : rand() % len;
+		for(struct fna_kernel_s const *const *k = fna_kernels; *k != NULL; k++) {
+			if(((*k)->isa & ~isa) != 0) { continue; }
+			struct fna_pack_s pack = { .arr = 0, .cnt = 0 };
+			memcpy(dst, src, len);
+			int64_t b = (*k)->encode_span(dst, dst, split, &pack, FNA_2BITPACKED);
+			b += (*k)->encode_span(dst + b, dst + split, len - split, &pack, FNA_2BITPACKED);
+			dst[b] = pack.arr;
+			assert(b == len / 4, "%s, len(%lld), b(%lld)", (*k)->name, len, b);
+			j = 0;
+			while(j < len && _unpack(dst, j) == ref[j]) { j++; }
+			assert(j == len, "%s, len(%lld), j(%lld)", (*k)->name, len, j);
+
+			/* unpacked */
+			b = (*k)->encode_span(dst, src, len, NULL, FNA_2BIT);
+			assert(b == len && memcmp(dst, ref, len) == 0, "%s, len(%lld)", (*k)->name, len);
+		}
+	}
+
+	#undef _unpack
 }
 
-/* fastq with qual skipping */
+/* 4-bit encoder kernels, compared against fna_encode_4bit */
 unittest()
 {
-	/**
-	 * create file
-	 * test0: valid FASTQ format
-	 * test1: a space in header
-	 * test2: two spaces in header and two \n's between header and content
-	 */
-	char const *fastq_filename = "test_fna.fq";
-	char const *fastq_content =
-		"@test0\nAAAA\n+test0\nNNNN\n"
-		"@ test1\nATAT\nCGCG\n+ test1\nII@#\n+III\n"
-		"@  test2\n\nAAAA\n+  test2\n\nNNNN\n"
-		"@\ttest3\nACGT\n\n+\ttest3\nNNNN";
-	assert(fdump(fastq_filename, fastq_content));
-	assert(fcmp(fastq_filename, strlen(fastq_content), (uint8_t const *)fastq_content));
+	char const iupac[] = "ACGTUNRYSWKMBDHVacgtunryswkmbdhv";
+	uint8_t src[1024], dst[1024], ref[1024];
+	uint32_t const isa = fna_cpu_isa();
 
-	fna_t *fna = fna_init(fastq_filename, FNA_PARAMS(.options = FNA_SKIP_QUAL));
-	assert(fna != NULL, "fna(%p)", fna);
+	#define _unpack(_p, _j)		( ((_p)[(_j) / 2]>>(4 * ((_j) % 2))) & 0x0f )
 
-	/* format detection (internal) */
-	assert(fna->file_format == FNA_FASTQ, "fna->file_format(%d)", fna->file_format);
+	for(int64_t i = 0; i < 1000; i++) {
+		int64_t len = rand() % 1024;
+		for(int64_t j = 0; j < len; j++) {
+			src[j] = (i < 256) ? (j + i) : iupac[rand() % (sizeof(iupac) - 1)];	/* all chars first */
+			ref[j] = fna_encode_4bit(src[j]);
+		}
 
-	/* test0 */
-	fna_seq_t *seq = fna_read(fna);
-	assert(strcmp(seq->s.segment.name.ptr, "test0") == 0, "name(%s)", seq->s.segment.name.ptr);
-	assert(strcmp((char const *)seq->s.segment.seq.ptr, "AAAA") == 0, "seq(%s)", (char const *)seq->s.segment.seq.ptr);
-	assert(seq->s.segment.seq.len == 4, "len(%lld)", seq->s.segment.seq.len);
-	assert(strcmp((char const *)seq->s.segment.qual.ptr, "") == 0, "seq(%s)", (char const *)seq->s.segment.qual.ptr);
-	assert(seq->s.segment.qual.len == 0, "len(%lld)", seq->s.segment.qual.len);
-	fna_seq_free(seq);
+		/* unpacked */
+		int64_t n = fna_encode_4bit_vec(dst, src, len);
+		assert(n <= len, "len(%lld), n(%lld)", len, n);
+		assert(memcmp(dst, ref, n) == 0, "len(%lld)", len);
 
-	/* test1 */
-	seq = fna_read(fna);
-	assert(strcmp(seq->s.segment.name.ptr, "test1") == 0, "name(%s)", seq->s.segment.name.ptr);
-	assert(strcmp((char const *)seq->s.segment.seq.ptr, "ATATCGCG") == 0, "seq(%s)", (char const *)seq->s.segment.seq.ptr);
-	assert(seq->s.segment.seq.len == 8, "len(%lld)", seq->s.segment.seq.len);
-	assert(strcmp((char const *)seq->s.segment.qual.ptr, "") == 0, "seq(%s)", (char const *)seq->s.segment.qual.ptr);
-	assert(seq->s.segment.qual.len == 0, "len(%lld)", seq->s.segment.qual.len);
-	fna_seq_free(seq);
+		/* packed */
+		n = fna_pack_4bit_vec(dst, src, len);
+		assert(n % 2 == 0 && n <= len, "len(%lld), n(%lld)", len, n);
+		int64_t j = 0;
+		while(j < n && _unpack(dst, j) == ref[j]) { j++; }
+		assert(j == n, "len(%lld), j(%lld)", len, j);
+
+		/* in place, with a base carried over from the previous span, on every kernel */
+		int64_t split = (len == 0) ? 0 : rand() % len;
+		for(struct fna_kernel_s const *const *k = fna_kernels; *k != NULL; k++) {
+			if(((*k)->isa & ~isa) != 0) { continue; }
+			struct fna_pack_s pack = { .arr = 0, .cnt = 0 };
+			memcpy(dst, src, len);
+			int64_t b = (*k)->encode_span(dst, dst, split, &pack, FNA_4BITPACKED);
+			b += (*k)->encode_span(dst + b, dst + split, len - split, &pack, FNA_4BITPACKED);
+			dst[b] = pack.arr;
+			assert(b == len / 2, "%s, len(%lld), b(%lld)", (*k)->name, len, b);
+			j = 0;
+			while(j < len && _unpack(dst, j) == ref[j]) { j++; }
+			assert(j == len, "%s, len(%lld), j(%lld)", (*k)->name, len, j);
+
+			/* unpacked */
+			b = (*k)->encode_span(dst, src, len, NULL, FNA_4BIT);
+			assert(b == len && memcmp(dst, ref, len) == 0, "%s, len(%lld)", (*k)->name, len);
+		}
+	}
 
-	/* test2 */
-	seq = fna_read(fna);
-	assert(strcmp(seq->s.segment.name.ptr, "test2") == 0, "name(%s)", seq->s.segment.name.ptr);
-	assert(strcmp((char const *)seq->s.segment.seq.ptr, "AAAA") == 0, "seq(%s)", (char const *)seq->s.segment.seq.ptr);
-	assert(seq->s.segment.seq.len == 4, "len(%lld)", seq->s.segment.seq.len);
-	assert(strcmp((char const *)seq->s.segment.qual.ptr, "") == 0, "seq(%s)", (char const *)seq->s.segment.qual.ptr);
-	assert(seq->s.segment.qual.len == 0, "len(%lld)", seq->s.segment.qual.len);
-	fna_seq_free(seq);
+	#undef _unpack
+}
 
-	/* test3 */
-	seq = fna_read(fna);
-	assert(strcmp(seq->s.segment.name.ptr, "test3") == 0, "name(%s)", seq->s.segment.name.ptr);
-	assert(strcmp((char const *)seq->s.segment.seq.ptr, "ACGT") == 0, "seq(%s)", (char const *)seq->s.segment.seq.ptr);
-	assert(seq->s.segment.seq.len == 4, "len(%lld)", seq->s.segment.seq.len);
-	assert(strcmp((char const *)seq->s.segment.qual.ptr, "") == 0, "seq(%s)", (char const *)seq->s.segment.qual.ptr);
-	assert(seq->s.segment.qual.len == 0, "len(%lld)", seq->s.segment.qual.len);
-	fna_seq_free(seq);
+/* all IUPAC codes through the 4-bit packed reader, odd and even lengths */
+unittest()
+{
+	char const *filename = "test_fna_4bitpacked.fa";
+	char const iupac[] = "ACGTUNRYSWKMBDHVacgtunryswkmbdhv";
+	int64_t const cnt = 160;
 
-	/* test eof */
-	seq = fna_read(fna);
-	assert(seq == NULL, "seq(%p)", seq);
+	FILE *fp = fopen(filename, "w");
+	for(int64_t i = 0; i < cnt; i++) {
+		fprintf(fp, ">test%d\n", (int)i);
+		for(int64_t j = 0; j < i; j++) {
+			fputc(iupac[(i + j) % (sizeof(iupac) - 1)], fp);
+			if(j % 60 == 59) { fputc('\n', fp); }
+		}
+		fputc('\n', fp);
+	}
+	fclose(fp);
+
+	fna_t *fna = fna_init(filename, FNA_PARAMS(.seq_encode = FNA_4BITPACKED));
+	assert(fna != NULL, "fna(%p)", fna);
+
+	for(int64_t i = 0; i < cnt; i++) {
+		fna_seq_t *seq = fna_read(fna);
+		assert(seq != NULL, "i(%lld)", i);
+		assert(seq->s.segment.seq.len == i, "i(%lld), len(%lld)", i, seq->s.segment.seq.len);
+
+		uint8_t ref[128] = { 0 };
+		for(int64_t j = 0; j < i; j++) {
+			ref[j / 2] |= fna_encode_4bit(iupac[(i + j) % (sizeof(iupac) - 1)])<<(4 * (j % 2));
+		}
+		assert(fna_encoded_size(FNA_4BITPACKED, i) == i / 2 + 1, "i(%lld)", i);
+		assert(memcmp(seq->s.segment.seq.ptr, ref, i / 2 + 1) == 0, "i(%lld)", i);
+		fna_seq_free(seq);
+	}
+	assert(fna_read(fna) == NULL, "");
 	assert(fna->status == FNA_EOF, "status(%d)", fna->status);
-	fna_seq_free(seq);
 
 	fna_close(fna);
+	remove(filename);
+}
 
-	/** cleanup files */
+/* non-ascii encodings keep seq and qual apart */
+unittest()
+{
+	char const *fastq_filename = "test_fna.fq";
+	char const *fastq_content =
+		"@test0\nACGTTGCA\n+\nACGTTGCA\n"
+		"@test1\nACG\nTT\n+\nAC\nGTT\n";
+	assert(fdump(fastq_filename, fastq_content));
+
+	uint8_t const expected[][2][8] = {
+		[FNA_2BIT] = { { 0, 1, 2, 3, 3, 2, 1, 0 }, { 0, 1, 2, 3, 3 } },
+		[FNA_2BITPACKED] = { { 0xe4, 0x1b, 0x00 }, { 0xe4, 0x03 } },
+		[FNA_4BIT] = { { 1, 2, 4, 8, 8, 4, 2, 1 }, { 1, 2, 4, 8, 8 } },
+		[FNA_4BITPACKED] = { { 0x21, 0x84, 0x48, 0x12, 0x00 }, { 0x21, 0x84, 0x08 } }
+	};
+	int64_t const len[2] = { 8, 5 };
+	int const encode[] = { FNA_2BIT, FNA_2BITPACKED, FNA_4BIT, FNA_4BITPACKED };
+
+	for(int64_t e = 0; e < 4; e++) {
+		fna_t *fna = fna_init(fastq_filename, FNA_PARAMS(.seq_encode = encode[e], .seq_tail_margin = 16));
+		assert(fna != NULL, "fna(%p)", fna);
+
+		for(int64_t i = 0; i < 2; i++) {
+			fna_seq_t *seq = fna_read(fna);
+			int64_t size = fna_encoded_size(encode[e], len[i]);
+			assert(seq->s.segment.seq.len == len[i], "len(%lld)", seq->s.segment.seq.len);
+			assert(seq->s.segment.qual.len == len[i], "len(%lld)", seq->s.segment.qual.len);
+			assert(memcmp(seq->s.segment.seq.ptr, expected[encode[e]][i], size) == 0, "e(%d), i(%lld)", encode[e], i);
+			assert(memcmp(seq->s.segment.qual.ptr, expected[encode[e]][i], size) == 0, "e(%d), i(%lld)", encode[e], i);
+			fna_seq_free(seq);
+		}
+		fna_close(fna);
+	}
 	remove(fastq_filename);
-	return;
 }
 
-/**
- * gfa parsing
- */
+/* fna_read_into, compared against fna_read */
 unittest()
 {
-	char const *gfa_filename = "test_gfa.gfa";
-	char const *gfa_content =
-		"H	VN:Z:1.0\n"
-		"S	11	ACCTT\n"
-		"S	12	TCAAGG\n"
-		"S	13	CTTGATT\n"
-		"L	11	+	12	-	4M\n"
-		"L	12	-	13	+	5M\n"
-		"L	11	+	13	+	3M\n"
-		"P	14	11+,12-,13+	4M,5M\n"
-		"S	15	CTTGATT\n";
+	char const *fasta_filename = "test_fna_into.fa";
+
+	FILE *fp = fopen(fasta_filename, "w");
+	for(int64_t i = 0; i < 200; i++) {
+		int64_t const len = (i < 100) ? 150 : 150 + 37 * i;		/* same-sized, then growing */
+		fprintf(fp, ">s%d%s\n", (int)i, (i % 4 == 0) ? " comment" : "");
+		for(int64_t j = 0; j < len; j++) {
+			fputc(unittest_random_base(), fp);
+			if(j % 60 == 59) { fputc('\n', fp); }
+		}
+		fputc('\n', fp);
+	}
+	fclose(fp);
 
-	assert(fdump(gfa_filename, gfa_content));
-	assert(fcmp(gfa_filename, strlen(gfa_content), (uint8_t const *)gfa_content));
+	uint16_t const options[] = { 0, FNA_MMAP };
+	int const encode[] = { FNA_ASCII, FNA_2BITPACKED };
+	for(int64_t k = 0; k < 2; k++) {
+		fna_params_t const params = { .seq_encode = encode[k], .options = options[k], .head_margin = 16, .seq_tail_margin = 5 };
+		fna_t *fs = fna_init(fasta_filename, &params);
+		fna_t *fi = fna_init(fasta_filename, &params);
+		assert(fs != NULL && fi != NULL, "fs(%p), fi(%p)", fs, fi);
+
+		fna_seq_t *a, *b = NULL;
+		int64_t i = 0, reused = 0;
+		while((a = fna_read(fs)) != NULL) {
+			fna_seq_t const *prev = b;
+			uint64_t const prev_size = (b != NULL) ? ((struct fna_seq_intl_s *)b)->size : 0;
+			b = fna_read_into(fi, b);
+			assert(b != NULL, "k(%lld), i(%lld)", k, i);
+
+			/* the buffer moves only when it grows */
+			if(prev != NULL && ((struct fna_seq_intl_s *)b)->size == prev_size) {
+				assert(b == prev, "k(%lld), i(%lld)", k, i);
+				reused++;
+			}
 
-	debug("start gfa");
-	fna_t *fna = fna_init(gfa_filename, NULL);
-	assert(fna != NULL, "fna(%p)", fna);
+			int64_t const size = fna_encoded_size(encode[k], a->s.segment.seq.len) - (encode[k] == FNA_ASCII);
+			assert(strncmp(a->s.segment.name.ptr, b->s.segment.name.ptr, a->s.segment.name.len) == 0, "k(%lld), i(%lld)", k, i);
+			assert(a->s.segment.comment.len == b->s.segment.comment.len, "k(%lld), i(%lld)", k, i);
+			assert(a->s.segment.seq.len == b->s.segment.seq.len, "k(%lld), i(%lld)", k, i);
+			assert(memcmp(a->s.segment.seq.ptr, b->s.segment.seq.ptr, size) == 0, "k(%lld), i(%lld)", k, i);
+			fna_seq_free(a);
+			i++;
+		}
+		assert(i == 200, "k(%lld), i(%lld)", k, i);
+		assert(reused >= 99, "k(%lld), reused(%lld)", k, reused);
+		assert(fna_read_into(fi, b) == NULL, "k(%lld)", k);		/* frees b */
+		assert(fi->status == fs->status, "k(%lld), status(%d, %d)", k, fi->status, fs->status);
+		fna_close(fs);
+		fna_close(fi);
+	}
+	remove(fasta_filename);
+}
 
-	/* format detection (internal) */
-	assert(fna->file_format == FNA_GFA, "fna->file_format(%d)", fna->file_format);
+/* fna_split and fna_init_range on a FASTQ with quality lines starting with '@' */
+#if defined(HAVE_PTHREAD)
+static
+int unittest_count_records(
+	fna_t *fna,
+	int64_t i,
+	void *arg)
+{
+	int64_t *cnt = (int64_t *)arg;
+	fna_seq_t *seq = NULL;
+	while((seq = fna_read_into(fna, seq)) != NULL) {
+		__sync_fetch_and_add(cnt, 1);
+	}
+	return(0);
+}
+#endif
 
-	/* segment 11 */
-	fna_seq_t *seq = fna_read(fna);
-	assert(seq->type == FNA_SEGMENT, "type(%d)", seq->type);
-	assert(strcmp(seq->s.segment.name.ptr, "11") == 0, "name(%s)", seq->s.segment.name.ptr);
-	assert(strcmp((char const *)seq->s.segment.seq.ptr, "ACCTT") == 0, "seq(%s)", (char const *)seq->s.segment.seq.ptr);
-	assert(seq->s.segment.seq.len == 5, "len(%lld)", seq->s.segment.seq.len);
-	fna_seq_free(seq);
+unittest()
+{
+	char const *filename = "test_fna_split.fq";
+	int64_t const cnt = 3000;
+	uint64_t *heads = (uint64_t *)malloc(sizeof(uint64_t) * (cnt + 1));
 
-	/* segment 12 */
-	seq = fna_read(fna);
-	assert(seq->type == FNA_SEGMENT, "type(%d)", seq->type);
-	assert(strcmp(seq->s.segment.name.ptr, "12") == 0, "name(%s)", seq->s.segment.name.ptr);
-	assert(strcmp((char const *)seq->s.segment.seq.ptr, "TCAAGG") == 0, "seq(%s)", (char const *)seq->s.segment.seq.ptr);
-	assert(seq->s.segment.seq.len == 6, "len(%lld)", seq->s.segment.seq.len);
-	fna_seq_free(seq);
+	FILE *fp = fopen(filename, "w");
+	for(int64_t i = 0; i < cnt; i++) {
+		int64_t len = 1 + rand() % 200;
+		heads[i] = ftell(fp);
+		fprintf(fp, "@r%d\n", (int)i);
+		for(int64_t j = 0; j < len; j++) { fputc(unittest_random_base(), fp); }
+		fprintf(fp, (i % 5 == 0) ? "\n+r%d\n" : "\n+\n", (int)i);
+		for(int64_t j = 0; j < len; j++) { fputc((j == 0 || rand() % 4 == 0) ? '@' : 'I', fp); }
+		fputc('\n', fp);
+	}
+	heads[cnt] = ftell(fp);
+	fclose(fp);
 
-	/* segment 13 */
-	seq = fna_read(fna);
-	assert(seq->type == FNA_SEGMENT, "type(%d)", seq->type);
-	assert(strcmp(seq->s.segment.name.ptr, "13") == 0, "name(%s)", seq->s.segment.name.ptr);
-	assert(strcmp((char const *)seq->s.segment.seq.ptr, "CTTGATT") == 0, "seq(%s)", (char const *)seq->s.segment.seq.ptr);
-	assert(seq->s.segment.seq.len == 7, "len(%lld)", seq->s.segment.seq.len);
-	fna_seq_free(seq);
+	int64_t const n[] = { 1, 2, 3, 7, 16, 64 };
+	for(int64_t k = 0; k < (int64_t)(sizeof(n) / sizeof(n[0])); k++) {
+		uint64_t offs[65];
+		int64_t r = fna_split(filename, n[k], offs);
+		assert(r >= 1 && r <= n[k], "n(%lld), r(%lld)", n[k], r);
+		assert(offs[0] == 0 && offs[r] == heads[cnt], "n(%lld), r(%lld)", n[k], r);
+
+		/* every split is a record head */
+		int64_t h = 0;
+		for(int64_t i = 1; i < r; i++) {
+			assert(offs[i] > offs[i - 1], "n(%lld), i(%lld)", n[k], i);
+			while(heads[h] < offs[i]) { h++; }
+			assert(heads[h] == offs[i], "n(%lld), i(%lld), offs(%llu)", n[k], i, offs[i]);
+		}
 
-	/* link 11 to 12 */
-	seq = fna_read(fna);
-	assert(seq->type == FNA_LINK, "type(%d)", seq->type);
-	assert(strcmp(seq->s.link.src.ptr, "11") == 0, "from(%s)", seq->s.link.src.ptr);
-	assert(seq->s.link.src_ori == 0, "src_ori(%d)", seq->s.link.src_ori);
-	assert(strcmp(seq->s.link.dst.ptr, "12") == 0, "to(%s)", seq->s.link.dst.ptr);
-	assert(seq->s.link.dst_ori == 1, "dst_ori(%d)", seq->s.link.dst_ori);
-	assert(strcmp((char const *)seq->s.link.cigar.ptr, "4M") == 0, "cigar(%s)", (char const *)seq->s.link.cigar.ptr);
-	fna_seq_free(seq);
+		/* ranges concatenate to the whole file */
+		uint16_t const options[] = { 0, FNA_MMAP };
+		for(int64_t m = 0; m < 2; m++) {
+			fna_t *fs = fna_init(filename, FNA_PARAMS(.options = options[m]));
+			int64_t i = 0;
+			for(int64_t j = 0; j < r; j++) {
+				fna_t *fr = fna_init_range(filename, FNA_PARAMS(.options = options[m]), offs[j], offs[j + 1]);
+				assert(fr != NULL, "n(%lld), j(%lld)", n[k], j);
+				fna_seq_t *a, *b;
+				while((b = fna_read(fr)) != NULL) {
+					a = fna_read(fs);
+					assert(a != NULL, "n(%lld), i(%lld)", n[k], i);
+					assert(a->s.segment.name.len == b->s.segment.name.len
+						&& memcmp(a->s.segment.name.ptr, b->s.segment.name.ptr, a->s.segment.name.len) == 0, "n(%lld), i(%lld)", n[k], i);
+					assert(a->s.segment.seq.len == b->s.segment.seq.len
+						&& memcmp(a->s.segment.seq.ptr, b->s.segment.seq.ptr, a->s.segment.seq.len) == 0, "n(%lld), i(%lld)", n[k], i);
+					assert(a->s.segment.qual.len == b->s.segment.qual.len
+						&& memcmp(a->s.segment.qual.ptr, b->s.segment.qual.ptr, a->s.segment.qual.len) == 0, "n(%lld), i(%lld)", n[k], i);
+					fna_seq_free(a);
+					fna_seq_free(b);
+					i++;
+				}
+				assert(fr->status == FNA_EOF, "n(%lld), j(%lld), status(%d)", n[k], j, fr->status);
+				fna_close(fr);
+			}
+			assert(i == cnt, "n(%lld), i(%lld)", n[k], i);
+			assert(fna_read(fs) == NULL, "n(%lld)", n[k]);
+			fna_close(fs);
+		}
 
-	/* link 12 to 13 */
-	seq = fna_read(fna);
-	assert(seq->type == FNA_LINK, "type(%d)", seq->type);
-	assert(strcmp(seq->s.link.src.ptr, "12") == 0, "from(%s)", seq->s.link.src.ptr);
-	assert(seq->s.link.src_ori == 1, "src_ori(%d)", seq->s.link.src_ori);
-	assert(strcmp(seq->s.link.dst.ptr, "13") == 0, "to(%s)", seq->s.link.dst.ptr);
-	assert(seq->s.link.dst_ori == 0, "dst_ori(%d)", seq->s.link.dst_ori);
-	assert(strcmp((char const *)seq->s.link.cigar.ptr, "5M") == 0, "cigar(%s)", (char const *)seq->s.link.cigar.ptr);
-	fna_seq_free(seq);
+		#if defined(HAVE_PTHREAD)
+		int64_t total = 0;
+		assert(fna_read_parallel(filename, NULL, n[k], unittest_count_records, (void *)&total) == 0, "n(%lld)", n[k]);
+		assert(total == cnt, "n(%lld), total(%lld)", n[k], total);
+		#endif
+	}
+	free(heads);
+
+	/* shorter than n, the splits land on the head of the file */
+	char const *short_filename = "test_fna_split_short.fa";
+	uint64_t offs[65];
+	assert(fdump(short_filename, ">a\nA\n"));
+	assert(fna_split(short_filename, 64, offs) == 1 && offs[0] == 0 && offs[1] == 5, "offs(%llu, %llu)", offs[0], offs[1]);
+	#if defined(HAVE_PTHREAD)
+	int64_t total = 0;
+	assert(fna_read_parallel(short_filename, NULL, 64, unittest_count_records, (void *)&total) == 0 && total == 1, "total(%lld)", total);
+	#endif
+	remove(short_filename);
 
-	/* link 11 to 13 */
-	seq = fna_read(fna);
-	assert(seq->type == FNA_LINK, "type(%d)", seq->type);
-	assert(strcmp(seq->s.link.src.ptr, "11") == 0, "from(%s)", seq->s.link.src.ptr);
-	assert(seq->s.link.src_ori == 0, "src_ori(%d)", seq->s.link.src_ori);
-	assert(strcmp(seq->s.link.dst.ptr, "13") == 0, "to(%s)", seq->s.link.dst.ptr);
-	assert(seq->s.link.dst_ori == 0, "dst_ori(%d)", seq->s.link.dst_ori);
-	assert(strcmp((char const *)seq->s.link.cigar.ptr, "3M") == 0, "cigar(%s)", (char const *)seq->s.link.cigar.ptr);
-	fna_seq_free(seq);
+	/* neither FASTA nor FASTQ */
+	assert(fdump(filename, "H\tVN:Z:1.0\n"));
+	assert(fna_split(filename, 2, offs) == -FNA_ERROR_UNKNOWN_FORMAT, "");
+	remove(filename);
+}
 
-	/* skip path line, not implemented yet */
+/* chunks parsed on threads, compared against the sequential reader */
+#if defined(HAVE_PTHREAD)
+unittest()
+{
+	char const *filename[2] = { "test_fna_pool.fa", "test_fna_pool.fq" };
+
+	/* a little over four chunks each */
+	for(int64_t f = 0; f < 2; f++) {
+		FILE *fp = fopen(filename[f], "w");
+		for(int64_t i = 0; ftell(fp) < 4 * FNA_POOL_CHUNK_SIZE + 1000; i++) {
+			int64_t len = 1 + rand() % ((i % 100 == 0) ? 200000 : 2000);
+			fprintf(fp, (f == 0) ? ">c%d%s\n" : "@c%d%s\n", (int)i, (i % 3 == 0) ? " a>b" : "");
+			for(int64_t j = 0; j < len; j++) {
+				fputc(unittest_random_base(), fp);
+				if(f == 0 && j % 80 == 79) { fputc('\n', fp); }
+			}
+			if(f == 1) {
+				fprintf(fp, "\n+\n");
+				for(int64_t j = 0; j < len; j++) { fputc((j == 0) ? '@' : 'I', fp); }
+			}
+			fputc('\n', fp);
+		}
+		fclose(fp);
+	}
 
-	/* segment 15 */
-	seq = fna_read(fna);
-	assert(seq->type == FNA_SEGMENT, "type(%d)", seq->type);
-	assert(strcmp(seq->s.segment.name.ptr, "15") == 0, "name(%s)", seq->s.segment.name.ptr);
-	assert(strcmp((char const *)seq->s.segment.seq.ptr, "CTTGATT") == 0, "seq(%s)", (char const *)seq->s.segment.seq.ptr);
-	assert(seq->s.segment.seq.len == 7, "len(%lld)", seq->s.segment.seq.len);
-	fna_seq_free(seq);
+	#define _eq(_a, _b)	( (_a).len == (_b).len && memcmp((_a).ptr, (_b).ptr, (_a).len) == 0 )
+	for(int64_t f = 0; f < 2; f++) {
+		for(int64_t unordered = 0; unordered < 2; unordered++) {
+			fna_t *fs = fna_init(filename[f], NULL);
+			fna_t *fp = fna_init(filename[f], FNA_PARAMS(.threads = 3, .options = unordered ? FNA_UNORDERED : 0));
+			assert(fs != NULL && fp != NULL, "fs(%p), fp(%p)", fs, fp);
+			assert(((struct fna_context_s *)fp)->read == fna_read_pool, "f(%lld)", f);
+
+			/* in order, or the same set of records */
+			fna_seq_t *a, *b;
+			int64_t i = 0, moved = 0;
+			int64_t sum[2] = { 0, 0 };
+			while((a = fna_read(fs)) != NULL) {
+				b = fna_read(fp);
+				assert(b != NULL, "f(%lld), i(%lld)", f, i);
+				if(unordered == 0) {
+					assert(_eq(a->s.segment.name, b->s.segment.name), "f(%lld), i(%lld)", f, i);
+					assert(_eq(a->s.segment.comment, b->s.segment.comment), "f(%lld), i(%lld)", f, i);
+					assert(_eq(a->s.segment.seq, b->s.segment.seq), "f(%lld), i(%lld)", f, i);
+					assert(_eq(a->s.segment.qual, b->s.segment.qual), "f(%lld), i(%lld)", f, i);
+				}
+				moved += !_eq(a->s.segment.name, b->s.segment.name);
+				sum[0] += atoi(a->s.segment.name.ptr + 1) + a->s.segment.seq.len;
+				sum[1] += atoi(b->s.segment.name.ptr + 1) + b->s.segment.seq.len;
+				fna_seq_free(a);
+				fna_seq_free(b);
+				i++;
+			}
+			assert(fna_read(fp) == NULL, "f(%lld)", f);
+			assert(fp->status == FNA_EOF, "f(%lld), status(%d)", f, fp->status);
+			assert(sum[0] == sum[1], "f(%lld), sum(%lld, %lld)", f, sum[0], sum[1]);
+			if(unordered == 0) { assert(moved == 0, "f(%lld), moved(%lld)", f, moved); }
+			fna_close(fs);
+			fna_close(fp);
+		}
 
-	/* term */
-	seq = fna_read(fna);
-	assert(seq == NULL, "%p", seq);
-	fna_seq_free(seq);
+		/* batches and recycled records on the pool, and closing midway */
+		fna_t *fp = fna_init(filename[f], FNA_PARAMS(.threads = 2, .head_margin = 8));
+		fna_batch_t *batch = fna_read_batch(fp, 1000, 0);
+		assert(batch != NULL && batch->cnt == 1000, "f(%lld)", f);
+		assert(atoi(batch->seq[999]->s.segment.name.ptr + 1) == 999, "f(%lld)", f);
+		fna_batch_free(batch);
+		fna_seq_t *seq = NULL;
+		for(int64_t i = 0; i < 1000; i++) { seq = fna_read_into(fp, seq); }
+		assert(atoi(seq->s.segment.name.ptr + 1) == 1999, "f(%lld)", f);
+		fna_seq_free(seq);
+		fna_close(fp);
+		remove(filename[f]);
+	}
+	#undef _eq
+}
+#endif
+
+#if defined(HAVE_PTHREAD)
+/**
+ * @struct unittest_shared_s
+ */
+struct unittest_shared_s {
+	fna_t *fna;
+	int64_t mode;				/* 0: fna_read, 1: fna_try_read, 2: fna_read_into, 3: fna_read_batch */
+	int64_t cnt, sum;
+};
+
+/**
+ * @fn unittest_shared_reader
+ */
+static
+void *unittest_shared_reader(
+	void *arg)
+{
+	struct unittest_shared_s *u = (struct unittest_shared_s *)arg;
+	#define _count(_s) { u->cnt++; u->sum += atoi((_s)->s.segment.name.ptr + 1) + (_s)->s.segment.seq.len; }
+	if(u->mode == 0 || u->mode == 1) {
+		while(1) {
+			fna_seq_t *s = (u->mode == 0) ? fna_read(u->fna) : fna_try_read(u->fna);
+			if(s == NULL) {
+				if(u->mode == 1 && __atomic_load_n(&u->fna->status, __ATOMIC_RELAXED) != FNA_EOF) { continue; }
+				break;
+			}
+			_count(s);
+			fna_seq_free(s);
+		}
+	} else if(u->mode == 2) {
+		fna_seq_t *s = NULL;
+		while((s = fna_read_into(u->fna, s)) != NULL) { _count(s); }
+	} else {
+		fna_batch_t *b;
+		while((b = fna_read_batch(u->fna, 100, 0)) != NULL) {
+			for(int64_t i = 0; i < b->cnt; i++) { _count(b->seq[i]); }
+			fna_batch_free(b);
+		}
+	}
+	#undef _count
+	return(NULL);
+}
+
+/* shared context, records taken on many threads */
+unittest()
+{
+	char const *filename = "test_fna_shared.fq";
+	int64_t const cnt = 2 * FNA_POOL_CHUNK_SIZE / 256;		/* spans a few chunks */
+	int64_t sum = 0;
+
+	FILE *fp = fopen(filename, "w");
+	for(int64_t i = 0; i < cnt; i++) {
+		int64_t len = 100 + rand() % 100;
+		fprintf(fp, "@r%d\n", (int)i);
+		for(int64_t j = 0; j < len; j++) { fputc(unittest_random_base(), fp); }
+		fprintf(fp, "\n+\n");
+		for(int64_t j = 0; j < len; j++) { fputc('I', fp); }
+		fputc('\n', fp);
+		sum += i + len;
+	}
+	fclose(fp);
+
+	/* serial parser and chunk pool under the queue, readers of each kind */
+	for(int64_t threads = 0; threads <= 2; threads += 2) {
+		for(int64_t mode = 0; mode < 4; mode++) {
+			fna_t *fna = fna_init(filename, FNA_PARAMS(.options = FNA_SHARED, .threads = threads));
+			assert(fna != NULL, "threads(%lld)", threads);
+
+			struct unittest_shared_s u[4];
+			pthread_t th[4];
+			for(int64_t i = 0; i < 4; i++) {
+				u[i] = (struct unittest_shared_s){ .fna = fna, .mode = (i == 3) ? 1 : mode };
+				pthread_create(&th[i], NULL, unittest_shared_reader, (void *)&u[i]);
+			}
+			int64_t c = 0, s = 0;
+			for(int64_t i = 0; i < 4; i++) {
+				pthread_join(th[i], NULL);
+				c += u[i].cnt;
+				s += u[i].sum;
+			}
+			assert(c == cnt, "threads(%lld), mode(%lld), cnt(%lld)", threads, mode, c);
+			assert(s == sum, "threads(%lld), mode(%lld), sum(%lld, %lld)", threads, mode, s, sum);
+			assert(fna->status == FNA_EOF, "status(%d)", fna->status);
+			fna_close(fna);
+		}
+	}
 
+	/* closed while the parser waits on a full queue */
+	fna_t *fna = fna_init(filename, FNA_PARAMS(.options = FNA_SHARED));
+	fna_seq_free(fna_read(fna));
+	usleep(10000);
 	fna_close(fna);
+	remove(filename);
+}
+#endif
 
-	/** cleanup files */
-	remove(gfa_filename);
-	return;
+/* paired-end reader on two files and on interleaved input */
+unittest()
+{
+	char const *r1 = "test_fna_pair_1.fq", *r2 = "test_fna_pair_2.fq", *il = "test_fna_pair_il.fq";
+	int64_t const cnt = 2500;
+
+	FILE *fp[3] = { fopen(r1, "w"), fopen(r2, "w"), fopen(il, "w") };
+	for(int64_t i = 0; i < cnt; i++) {
+		for(int64_t m = 0; m < 2; m++) {
+			int64_t len = 50 + (i + m) % 100;
+			char seq[256], qual[256];
+			for(int64_t j = 0; j < len; j++) { seq[j] = unittest_random_base(); qual[j] = 'I'; }
+			seq[len] = qual[len] = '\0';
+			/* "/1" suffix on odd reads, casava-style comment on even */
+			if(i % 2) {
+				fprintf(fp[m], "@p%d/%d\n%s\n+\n%s\n", (int)i, (int)m + 1, seq, qual);
+				fprintf(fp[2], "@p%d/%d\n%s\n+\n%s\n", (int)i, (int)m + 1, seq, qual);
+			} else {
+				fprintf(fp[m], "@p%d %d:N:0\n%s\n+\n%s\n", (int)i, (int)m + 1, seq, qual);
+				fprintf(fp[2], "@p%d %d:N:0\n%s\n+\n%s\n", (int)i, (int)m + 1, seq, qual);
+			}
+		}
+	}
+	fclose(fp[0]); fclose(fp[1]); fclose(fp[2]);
+
+	for(int64_t k = 0; k < 3; k++) {
+		fna_pair_t *pair = (k == 2)
+			? fna_init_pair(il, NULL, NULL)
+			: fna_init_pair(r1, r2, FNA_PARAMS(.threads = k));
+		fna_t *ref[2] = { fna_init(r1, NULL), fna_init(r2, NULL) };
+		assert(pair != NULL, "k(%lld)", k);
+
+		fna_batch_t *b;
+		int64_t i = 0;
+		while((b = fna_read_pair(pair, 333, 0)) != NULL) {
+			assert(b->cnt % 2 == 0 && b->cnt <= 666, "k(%lld), cnt(%lld)", k, b->cnt);
+			for(int64_t j = 0; j < b->cnt; j++) {
+				fna_seq_t *a = fna_read(ref[j & 1]);
+				assert(a->s.segment.name.len == b->seq[j]->s.segment.name.len
+					&& memcmp(a->s.segment.name.ptr, b->seq[j]->s.segment.name.ptr, a->s.segment.name.len) == 0, "k(%lld), i(%lld)", k, i);
+				assert(a->s.segment.seq.len == b->seq[j]->s.segment.seq.len
+					&& memcmp(a->s.segment.seq.ptr, b->seq[j]->s.segment.seq.ptr, a->s.segment.seq.len) == 0, "k(%lld), i(%lld)", k, i);
+				fna_seq_free(a);
+			}
+			i += b->cnt / 2;
+			fna_batch_free(b);
+		}
+		assert(i == cnt, "k(%lld), i(%lld)", k, i);
+		assert(pair->status == FNA_EOF, "k(%lld), status(%d)", k, pair->status);
+		fna_close(ref[0]);
+		fna_close(ref[1]);
+		fna_close_pair(pair);
+	}
+
+	/* out of sync: a missing mate, and swapped names */
+	char const *broken[][2] = {
+		{ "@a/1\nAC\n+\nII\n@b/1\nAC\n+\nII\n", "@a/2\nAC\n+\nII\n" },
+		{ "@a/1\nAC\n+\nII\n", "@a/2\nAC\n+\nII\n@b/2\nAC\n+\nII\n" },
+		{ "@a/1\nAC\n+\nII\n@b/1\nAC\n+\nII\n", "@a/2\nAC\n+\nII\n@c/2\nAC\n+\nII\n" }
+	};
+	for(int64_t k = 0; k < 3; k++) {
+		assert(fdump(r1, broken[k][0]));
+		assert(fdump(r2, broken[k][1]));
+		fna_pair_t *pair = fna_init_pair(r1, r2, NULL);
+		fna_batch_t *b = fna_read_pair(pair, 10, 0);
+		assert(b != NULL && b->cnt == 2, "k(%lld)", k);
+		assert(pair->status == FNA_ERROR_BROKEN_FORMAT, "k(%lld), status(%d)", k, pair->status);
+		assert(fna_read_pair(pair, 10, 0) == NULL, "k(%lld)", k);
+		fna_batch_free(b);
+		fna_close_pair(pair);
+	}
+	remove(r1);
+	remove(r2);
+	remove(il);
 }
 
-/**
- * format detection (fail)
- */
+/* .fai and fna_fetch, compared against slices of the records read sequentially */
 unittest()
 {
-	char const *fail_filename = "test_fail.txt";
-	char const *fail_content = "A quick brown fox jumps over the lazy dog.\n";
-	assert(fdump(fail_filename, fail_content));
-	assert(fcmp(fail_filename, strlen(fail_content), (uint8_t const *)fail_content));
+	char const *filename = "test_fna_fetch.fa";
+	char const *fai_filename = "test_fna_fetch.fa.fai";
+
+	/* samtools-compatible columns */
+	assert(fdump(filename, ">a x\nACGT\nAC\n>b\r\nAC\r\nA\r\n>c\n>d\nACG"));
+	remove(fai_filename);
+	assert(fna_build_index(filename) == FNA_SUCCESS);
+	char fai[256] = { 0 };
+	FILE *fp = fopen(fai_filename, "r");
+	assert(fp != NULL && fread(fai, 1, 255, fp) > 0);
+	fclose(fp);
+	assert(strcmp(fai, "a\t6\t5\t4\t5\nb\t3\t17\t2\t4\nc\t0\t27\t0\t0\nd\t3\t30\t3\t3\n") == 0, "%s", fai);
 
-	/* returns NULL when failed to detect format */
-	fna_t *fna = fna_init(fail_filename, NULL);
-	assert(fna == NULL, "fna(%p)", fna);
+	/* lines of different widths */
+	char const *broken[] = { ">a\nACG\nACGT\n", ">a\nACG\nA\nACG\n", ">a\nACG\n\nACG\n" };
+	for(int64_t k = 0; k < 3; k++) {
+		assert(fdump(filename, broken[k]));
+		assert(fna_build_index(filename) == FNA_ERROR_BROKEN_FORMAT, "k(%lld)", k);
+	}
+	remove(fai_filename);
+
+	/* multi-line sequences, CRLF, single-line and empty */
+	int64_t const cnt = 6;
+	int64_t const len[] = { 10000, 7001, 4200, 1, 0, 12345 };
+	int64_t const width[] = { 60, 70, 80, 60, 60, 100000 };
+	fp = fopen(filename, "w");
+	for(int64_t i = 0; i < cnt; i++) {
+		fprintf(fp, ">s%d comment %d%s\n", (int)i, (int)i, (i == 1) ? "\r" : "");
+		for(int64_t j = 0; j < len[i]; j++) {
+			fputc(unittest_random_base(), fp);
+			if((j + 1) % width[i] == 0 || j + 1 == len[i]) { fputs((i == 1) ? "\r\n" : "\n", fp); }
+		}
+	}
+	fclose(fp);
 
-	/** cleanup file */
-	remove(fail_filename);
-	return;
+	for(int64_t e = 0; e < 5; e++) {
+		/* reference records, and contexts reading the file in different ways */
+		fna_t *fs = fna_init(filename, FNA_PARAMS(.seq_encode = e));
+		fna_seq_t *ref[6];
+		for(int64_t i = 0; i < cnt; i++) { ref[i] = fna_read(fs); assert(ref[i] != NULL, "e(%lld), i(%lld)", e, i); }
+		fna_t *ctx[3] = {
+			fs,
+			fna_init(filename, FNA_PARAMS(.seq_encode = e, .options = FNA_MMAP, .head_margin = 16, .seq_head_margin = 8)),
+			fna_init(filename, FNA_PARAMS(.seq_encode = e, .threads = 2))
+		};
+
+		for(int64_t c = 0; c < 3; c++) {
+			for(int64_t i = 0; i < cnt; i++) {
+				char name[16];
+				sprintf(name, "s%d", (int)i);
+
+				/* whole sequence, clipped */
+				fna_seq_t *s = fna_fetch(ctx[c], name, -10, len[i] + 10);
+				assert(s != NULL, "e(%lld), c(%lld), i(%lld)", e, c, i);
+				assert(strcmp(s->s.segment.name.ptr, name) == 0 && s->s.segment.comment.len == 0, "e(%lld), c(%lld), i(%lld)", e, c, i);
+				assert(s->s.segment.seq.len == len[i], "e(%lld), c(%lld), i(%lld), len(%lld)", e, c, i, s->s.segment.seq.len);
+				assert(memcmp(s->s.segment.seq.ptr, ref[i]->s.segment.seq.ptr, fna_encoded_size(e, len[i])) == 0, "e(%lld), c(%lld), i(%lld)", e, c, i);
+				fna_seq_free(s);
+
+				/* random ranges, compared base by base on the unpacked encodings */
+				for(int64_t k = 0; k < 20 && e != FNA_2BITPACKED && e != FNA_4BITPACKED; k++) {
+					int64_t b = rand() % (len[i] + 1), t = b + rand() % (len[i] - b + 1);
+					s = fna_fetch(ctx[c], name, b, t);
+					assert(s != NULL && s->s.segment.seq.len == t - b, "e(%lld), c(%lld), i(%lld), b(%lld), t(%lld)", e, c, i, b, t);
+					assert(memcmp(s->s.segment.seq.ptr, ref[i]->s.segment.seq.ptr + b, t - b) == 0, "e(%lld), c(%lld), i(%lld), b(%lld), t(%lld)", e, c, i, b, t);
+					fna_seq_free(s);
+				}
+			}
+			assert(fna_fetch(ctx[c], "s", 0, 10) == NULL, "e(%lld), c(%lld)", e, c);
+			assert(fna_fetch(ctx[c], "s10", 0, 10) == NULL, "e(%lld), c(%lld)", e, c);
+		}
+
+		/* the sequential reader is left where it was */
+		fna_seq_t *s = fna_read(ctx[2]);
+		assert(s != NULL && strcmp(s->s.segment.name.ptr, "s0") == 0, "e(%lld)", e);
+		fna_seq_free(s);
+		assert(fna_read(fs) == NULL && fs->status == FNA_EOF, "e(%lld)", e);
+
+		for(int64_t i = 0; i < cnt; i++) { fna_seq_free(ref[i]); }
+		for(int64_t c = 0; c < 3; c++) { fna_close(ctx[c]); }
+	}
+
+	/* the index saved on the first fetch is loaded by the others */
+	fp = fopen(fai_filename, "r");
+	assert(fp != NULL);
+	if(fp != NULL) { fclose(fp); }
+	remove(filename);
+	remove(fai_filename);
 }
 
-/**
- * format detection from the content of the file (FASTA)
- */
+#if defined(HAVE_Z) && defined(HAVE_PTHREAD)
+/* fna_fetch on BGZF through .gzi, compared against the uncompressed file */
 unittest()
 {
-	char const *fasta_filename = "test_fna.txt";
-	char const *fasta_content =
-		">test0\nAAAA\n"
-		"> test1\nATAT\nCGCG\n"
-		">  test2\n\nAAAA\n";
-	assert(fdump(fasta_filename, fasta_content));
-	assert(fcmp(fasta_filename, strlen(fasta_content), (uint8_t const *)fasta_content));
-	fna_t *fna = fna_init(fasta_filename, NULL);
-	assert(fna != NULL, "fna(%p)", fna);
+	char const *filename = "test_fna_fetch_bgzf.fa";
+	char const *gz_filename = "test_fna_fetch_bgzf.fa.gz";
+	char const *idx[] = { "test_fna_fetch_bgzf.fa.fai", "test_fna_fetch_bgzf.fa.gz.fai", "test_fna_fetch_bgzf.fa.gz.gzi" };
+
+	int64_t const cnt = 5;
+	int64_t const len[] = { 100000, 7001, 0, 250000, 33 };
+	int64_t const width[] = { 60, 70, 60, 1000000, 80 };
+	lmm_kvec_t(char) v;
+	lmm_kv_init(NULL, v);
+	for(int64_t i = 0; i < cnt; i++) {
+		char name[32];
+		int64_t l = sprintf(name, ">c%d\n", (int)i);
+		lmm_kv_pushm(NULL, v, name, l);
+		for(int64_t j = 0; j < len[i]; j++) {
+			lmm_kv_push(NULL, v, unittest_random_base());
+			if((j + 1) % width[i] == 0 || j + 1 == len[i]) { lmm_kv_push(NULL, v, '\n'); }
+		}
+	}
 
-	/* format detection (internal) */
-	assert(fna->file_format == FNA_FASTA, "fna->file_format(%d)", fna->file_format);
+	/* blocks of different sizes, an empty one in the middle, and the EOF marker */
+	FILE *fp = fopen(filename, "w");
+	assert(fwrite(lmm_kv_ptr(v), 1, lmm_kv_size(v), fp) == lmm_kv_size(v));
+	fclose(fp);
+	fp = fopen(gz_filename, "wb");
+	int64_t blocks = 0;
+	for(uint64_t p = 0, block = 1000; p < lmm_kv_size(v); p += block, block = 1000 + (block * 7) % 60000) {
+		assert(unittest_dump_bgzf_block(fp, lmm_kv_ptr(v) + p, MIN2(block, lmm_kv_size(v) - p)));
+		if(blocks++ == 3) { assert(unittest_dump_bgzf_block(fp, NULL, 0)); }
+	}
+	assert(unittest_dump_bgzf_block(fp, NULL, 0));
+	fclose(fp);
+	for(int64_t k = 0; k < 3; k++) { remove(idx[k]); }
 
-	fna_close(fna);
+	/* samtools-compatible .gzi: the number of entries and the offsets of the nonempty blocks but the first */
+	assert(fna_build_index(gz_filename) == FNA_SUCCESS);
+	struct stat st;
+	assert(stat(idx[2], &st) == 0 && st.st_size == 8 + 16 * (blocks - 1), "size(%lld), blocks(%lld)", (long long)st.st_size, blocks);
+	remove(idx[1]);
+	remove(idx[2]);
+
+	/* built on the first fetch, then loaded */
+	for(int64_t k = 0; k < 2; k++) {
+		fna_t *fa = fna_init(filename, NULL);
+		fna_t *fz = fna_init(gz_filename, FNA_PARAMS(.file_format = FNA_FASTA, .seq_encode = (k == 0) ? FNA_ASCII : FNA_4BIT));
+		fna_t *fr = fna_init(filename, FNA_PARAMS(.seq_encode = (k == 0) ? FNA_ASCII : FNA_4BIT));
+		assert(fa != NULL && fz != NULL && fr != NULL, "k(%lld)", k);
+		for(int64_t i = 0; i < cnt; i++) {
+			char name[16];
+			sprintf(name, "c%d", (int)i);
+			for(int64_t j = 0; j < 30; j++) {
+				int64_t b = (j == 0) ? 0 : rand() % (len[i] + 1);
+				int64_t t = (j == 0) ? len[i] : b + rand() % (MIN2(len[i] - b, 20000) + 1);
+				fna_seq_t *a = fna_fetch(fa, name, b, t);
+				fna_seq_t *z = fna_fetch(fz, name, b, t);
+				fna_seq_t *r = fna_fetch(fr, name, b, t);
+				assert(a != NULL && z != NULL && r != NULL, "k(%lld), i(%lld), b(%lld), t(%lld)", k, i, b, t);
+				assert(a->s.segment.seq.len == t - b && z->s.segment.seq.len == t - b, "k(%lld), i(%lld), b(%lld), t(%lld)", k, i, b, t);
+				assert(memcmp(z->s.segment.seq.ptr, r->s.segment.seq.ptr, t - b) == 0, "k(%lld), i(%lld), b(%lld), t(%lld)", k, i, b, t);
+				fna_seq_free(a);
+				fna_seq_free(z);
+				fna_seq_free(r);
+			}
+		}
+		assert(fna_fetch(fz, "c5", 0, 1) == NULL, "k(%lld)", k);
+
+		/* the sequential reader on the same context */
+		fna_seq_t *s = fna_read(fz);
+		assert(s != NULL && strcmp(s->s.segment.name.ptr, "c0") == 0 && s->s.segment.seq.len == len[0], "k(%lld)", k);
+		fna_seq_free(s);
+		fna_close(fa);
+		fna_close(fz);
+		fna_close(fr);
+		assert(stat(idx[1], &st) == 0 && stat(idx[2], &st) == 0, "k(%lld)", k);
+	}
 
-	/** cleanup file */
-	remove(fasta_filename);
-	return;
+	lmm_kv_destroy(NULL, v);
+	remove(filename);
+	remove(gz_filename);
+	for(int64_t k = 0; k < 3; k++) { remove(idx[k]); }
 }
+#endif
 
-/**
- * format detection (FASTQ)
- */
+#if defined(HAVE_Z) && defined(HAVE_PTHREAD)
+/* fna_tell and fna_seek, resumed reads compared against a straight read */
 unittest()
 {
-	char const *fastq_filename = "test_fna.txt";
-	char const *fastq_content =
-		"@test0\nAAAA\n+test0\nNNNN\n"
-		"@ test1\nATAT\nCGCG\n+ test1\nNNNN\nNNNN\n"
-		"@  test2\n\nAAAA\n+  test2\n\nNNNN\n";
-	assert(fdump(fastq_filename, fastq_content));
-	assert(fcmp(fastq_filename, strlen(fastq_content), (uint8_t const *)fastq_content));
+	char const *filename[] = {
+		"test_fna_seek.fa", "test_fna_seek.fa.gz", "test_fna_seek.bgzf.fa.gz",
+		"test_fna_seek.fq", "test_fna_seek.gfa"
+	};
+	char const *gzi_filename = "test_fna_seek.bgzf.fa.gz.gzi";
+
+	/* multi-line FASTA over a few chunks of the pool, its gzip and BGZF, a FASTQ and a GFA */
+	int64_t const cnt = 3000;
+	lmm_kvec_t(char) v;
+	lmm_kv_init(NULL, v);
+	for(int64_t i = 0; i < cnt; i++) {
+		char name[32];
+		lmm_kv_pushm(NULL, v, name, sprintf(name, ">r%d c\n", (int)i));
+		for(int64_t j = 0, len = 1000 + (i * 37) % 10000; j < len; j++) {
+			lmm_kv_push(NULL, v, unittest_random_base());
+			if((j + 1) % 60 == 0 || j + 1 == len) { lmm_kv_push(NULL, v, '\n'); }
+		}
+	}
+	FILE *fp = fopen(filename[0], "w");
+	assert(fwrite(lmm_kv_ptr(v), 1, lmm_kv_size(v), fp) == lmm_kv_size(v));
+	fclose(fp);
+	gzFile gp = gzopen(filename[1], "wb");
+	assert(gzwrite(gp, lmm_kv_ptr(v), lmm_kv_size(v)) == (int)lmm_kv_size(v));
+	gzclose(gp);
+	fp = fopen(filename[2], "wb");
+	for(uint64_t p = 0; p < lmm_kv_size(v); p += 60000) {
+		assert(unittest_dump_bgzf_block(fp, lmm_kv_ptr(v) + p, MIN2(60000, lmm_kv_size(v) - p)));
+	}
+	assert(unittest_dump_bgzf_block(fp, NULL, 0));
+	fclose(fp);
+	lmm_kv_destroy(NULL, v);
 
-	fna_t *fna = fna_init(fastq_filename, NULL);
-	assert(fna != NULL, "fna(%p)", fna);
+	fp = fopen(filename[3], "w");
+	for(int64_t i = 0; i < cnt; i++) { fprintf(fp, "@q%d\nACGTAC\n+\n@@@@@@\n", (int)i); }
+	fclose(fp);
+	fp = fopen(filename[4], "w");
+	fprintf(fp, "H\tVN:Z:1.0\n");
+	for(int64_t i = 0; i < cnt; i++) { fprintf(fp, "S\ts%d\tACGT\n", (int)i); }
+	fclose(fp);
 
-	/* format detection (internal) */
-	assert(fna->file_format == FNA_FASTQ, "fna->file_format(%d)", fna->file_format);
+	struct conf_s {
+		char const *filename;
+		fna_params_t params;
+	} const conf[] = {
+		{ filename[0], { 0 } },
+		{ filename[0], { .options = FNA_MMAP } },
+		{ filename[0], { .threads = 1 } },
+		{ filename[0], { .threads = 2 } },
+		{ filename[1], { 0 } },
+		{ filename[2], { 0 } },
+		{ filename[2], { .threads = 2, .seq_encode = FNA_2BIT } },
+		{ filename[3], { 0 } },
+		{ filename[4], { 0 } }
+	};
+	#define _eq(_a, _b)		( (_a).len == (_b).len && memcmp((_a).ptr, (_b).ptr, (_a).len) == 0 )
+	for(int64_t c = 0; c < (int64_t)(sizeof(conf) / sizeof(struct conf_s)); c++) {
+		if(c == 6) { assert(fna_build_index(filename[2]) == FNA_SUCCESS); }
+
+		/* positions before each record */
+		fna_t *fs = fna_init(conf[c].filename, &conf[c].params);
+		assert(fs != NULL, "c(%lld)", c);
+		fna_seq_t **ref = (fna_seq_t **)calloc(cnt + 1, sizeof(fna_seq_t *));
+		fna_pos_t *pos = (fna_pos_t *)calloc(cnt + 1, sizeof(fna_pos_t));
+		int64_t n = 0;
+		do {
+			assert(fna_tell(fs, &pos[n]) == FNA_SUCCESS, "c(%lld), n(%lld)", c, n);
+		} while((ref[n] = fna_read(fs)) != NULL && ++n <= cnt);
+		assert(n == cnt, "c(%lld), n(%lld)", c, n);
+
+		/* resume on a new context, and move back on the same one */
+		fna_t *fr = fna_init(conf[c].filename, &conf[c].params);
+		int64_t const at[] = { cnt / 2, 1, cnt - 1, cnt, 0, 7 * cnt / 10 };
+		for(int64_t k = 0; k < 6; k++) {
+			assert(fna_seek((k == 0) ? fs : fr, &pos[at[k]]) == FNA_SUCCESS, "c(%lld), k(%lld)", c, k);
+			fna_t *f = (k == 0) ? fs : fr;
+			for(int64_t i = at[k]; i < MIN2(at[k] + 600, cnt); i++) {
+				fna_seq_t *s = fna_read(f);
+				assert(s != NULL, "c(%lld), k(%lld), i(%lld)", c, k, i);
+				if(s == NULL) { break; }
+				if(ref[i]->type == FNA_SEGMENT) {
+					assert(_eq(s->s.segment.name, ref[i]->s.segment.name) && _eq(s->s.segment.seq, ref[i]->s.segment.seq),
+						"c(%lld), k(%lld), i(%lld)", c, k, i);
+				}
+				fna_seq_free(s);
+			}
+			if(at[k] >= cnt - 600) { assert(fna_read(f) == NULL && f->status == FNA_EOF, "c(%lld), k(%lld)", c, k); }
+		}
 
-	fna_close(fna);
+		/* checkpoints on the resumed context */
+		fna_pos_t p = { 0 };
+		assert(fna_seek(fr, &pos[cnt / 3]) == FNA_SUCCESS && fna_tell(fr, &p) == FNA_SUCCESS, "c(%lld)", c);
+		assert(p.offset == pos[cnt / 3].offset, "c(%lld), offset(%llu, %llu)", c, (unsigned long long)p.offset, (unsigned long long)pos[cnt / 3].offset);
+		fna_seq_free(fna_read(fr));
+		assert(fna_tell(fr, &p) == FNA_SUCCESS && p.offset == pos[cnt / 3 + 1].offset, "c(%lld)", c);
+
+		for(int64_t i = 0; i < cnt; i++) { fna_seq_free(ref[i]); }
+		free(ref);
+		free(pos);
+		fna_close(fs);
+		fna_close(fr);
+	}
+	#undef _eq
 
-	/** cleanup file */
-	remove(fastq_filename);
-	return;
+	/* no single position on shared contexts */
+	fna_t *fs = fna_init(filename[0], FNA_PARAMS(.options = FNA_SHARED));
+	fna_pos_t p = { 0 };
+	assert(fna_tell(fs, &p) == FNA_ERROR_UNSUPPORTED_VERSION);
+	fna_close(fs);
+
+	for(int64_t i = 0; i < 5; i++) { remove(filename[i]); }
+	remove(gzi_filename);
 }
+#endif
 
-/* format detection */
+/* FNA_SKIP_SEQ, names and lengths compared against the full reader */
 unittest()
 {
-	char const *gfa_filename = "test_gfa.txt";
-	char const *gfa_content =
-		"H	VN:Z:1.0\n"
-		"S	11	ACCTT\n"
-		"S	12	TCAAGG\n"
-		"S	13	CTTGATT\n"
-		"L	11	+	12	-	4M\n"
-		"L	12	-	13	+	5M\n"
-		"L	11	+	13	+	3M\n"
-		"P	14	11+,12-,13+	4M,5M\n"
-		"S	15	CTTGATT\n";
+	char const *filename[2] = { "test_fna_skip_seq.fa", "test_fna_skip_seq.fq" };
+
+	/* multi-line FASTA with CRLF and empty records, and a multi-line FASTQ, over a few windows */
+	for(int64_t f = 0; f < 2; f++) {
+		FILE *fp = fopen(filename[f], "w");
+		for(int64_t i = 0; i < 2000; i++) {
+			int64_t len = (i % 50 == 0) ? 0 : 1 + rand() % 3000;
+			char const *nl = (i % 7 == 0) ? "\r\n" : "\n";
+			fprintf(fp, (f == 0) ? ">s%d%s%s" : "@s%d%s%s", (int)i, (i % 3 == 0) ? " c" : "", nl);
+			for(int64_t j = 0; j < len; j++) {
+				fputc(unittest_random_base(), fp);
+				if(j % 60 == 59 && j + 1 < len) { fputs(nl, fp); }
+			}
+			if(f == 1) {
+				fprintf(fp, "%s+%s", nl, nl);
+				for(int64_t j = 0; j < len; j++) { fputc((j == 0) ? '@' : 'I', fp); }
+			}
+			fputs(nl, fp);
+		}
+		fclose(fp);
+	}
 
-	assert(fdump(gfa_filename, gfa_content));
-	assert(fcmp(gfa_filename, strlen(gfa_content), (uint8_t const *)gfa_content));
+	struct { uint32_t options; uint16_t threads; int encode; } const modes[] = {
+		{ 0, 0, FNA_ASCII },
+		{ FNA_MMAP, 0, FNA_ASCII },
+		{ FNA_SKIP_QUAL, 0, FNA_2BIT },
+		{ 0, 2, FNA_4BITPACKED },
+		{ FNA_SHARED, 0, FNA_ASCII }
+	};
 
-	fna_t *fna = fna_init(gfa_filename, NULL);
-	assert(fna != NULL, "fna(%p)", fna);
+	#define _eq(_a, _b)	( (_a).len == (_b).len && memcmp((_a).ptr, (_b).ptr, (_a).len) == 0 )
+	for(int64_t f = 0; f < 2; f++) {
+		for(int64_t m = 0; m < (int64_t)(sizeof(modes) / sizeof(modes[0])); m++) {
+			fna_t *fa = fna_init(filename[f], NULL);
+			fna_t *fs = fna_init(filename[f], FNA_PARAMS(
+				.seq_encode = modes[m].encode,
+				.options = modes[m].options | FNA_SKIP_SEQ,
+				.threads = modes[m].threads
+			));
+			assert(fa != NULL && fs != NULL, "fa(%p), fs(%p)", fa, fs);
+
+			/* every other record through fna_read_into, which relinks the recycled buffer */
+			fna_seq_t *a, *b, *r = NULL;
+			int64_t i = 0;
+			while((a = fna_read(fa)) != NULL) {
+				b = (i % 2 == 0) ? fna_read(fs) : (r = fna_read_into(fs, r));
+				assert(b != NULL, "f(%lld), m(%lld), i(%lld)", f, m, i);
+				assert(_eq(a->s.segment.name, b->s.segment.name), "f(%lld), m(%lld), i(%lld)", f, m, i);
+				assert(_eq(a->s.segment.comment, b->s.segment.comment), "f(%lld), m(%lld), i(%lld)", f, m, i);
+				assert(a->s.segment.seq.len == b->s.segment.seq.len, "f(%lld), m(%lld), i(%lld), len(%lld, %lld)",
+					f, m, i, a->s.segment.seq.len, b->s.segment.seq.len);
+				assert(b->s.segment.qual.len == 0, "f(%lld), m(%lld), i(%lld)", f, m, i);
+				assert(((struct fna_seq_intl_s *)b)->flags & FNA_NO_SEQ, "f(%lld), m(%lld), i(%lld)", f, m, i);
+				if(modes[m].encode == FNA_ASCII) {
+					assert(b->s.segment.seq.ptr[0] == '\0', "f(%lld), m(%lld), i(%lld)", f, m, i);
+				}
+				fna_seq_free(a);
+				if(i % 2 == 0) { fna_seq_free(b); }
+				i++;
+			}
+			assert(i == 2000, "f(%lld), m(%lld), i(%lld)", f, m, i);
+			assert(fna_read(fs) == NULL, "f(%lld), m(%lld)", f, m);
+			assert(fs->status == FNA_EOF, "f(%lld), m(%lld), status(%d)", f, m, fs->status);
+			fna_seq_free(r);
+			fna_close(fa);
+			fna_close(fs);
+		}
+		remove(filename[f]);
+	}
+	#undef _eq
+}
 
-	/* format detection (internal) */
-	assert(fna->file_format == FNA_GFA, "fna->file_format(%d)", fna->file_format);
+/* long sequences read into buffers of the final size: grown by steps, counted in the mapped window, and with hints */
+unittest()
+{
+	char const *filename = "test_fna_len_hint.fa";
+	char const *fai_filename = "test_fna_len_hint.fa.fai";
+	int64_t const lens[3] = { 8 * FNA_GROW_MIN_LEN + 4097, 7, 8 * FNA_GROW_MIN_LEN };
 
-	fna_close(fna);
+	/* three records, multi-line, the reference kept in memory */
+	lmm_kvec_t(char) ref;
+	lmm_kv_init(NULL, ref);
+	FILE *fp = fopen(filename, "w");
+	for(int64_t i = 0; i < 3; i++) {
+		fprintf(fp, ">r%d\n", (int)i);
+		for(int64_t j = 0; j < lens[i]; j++) {
+			char const c = unittest_random_base();
+			lmm_kv_push(NULL, ref, c);
+			fputc(c, fp);
+			if(j % 60 == 59 || j + 1 == lens[i]) { fputc('\n', fp); }
+		}
+	}
+	fclose(fp);
+	remove(fai_filename);
+
+	/* the record ends at most a block of the compaction kernel after the terminator of seq */
+	#define _size(_s)		( ((struct fna_seq_intl_s *)(_s))->size )
+	#define _tail(_s)		( (uint64_t)((uint8_t const *)(_s)->s.segment.qual.ptr + 1 - (uint8_t const *)(_s)) )
+	int const encode[3] = { FNA_ASCII, FNA_2BITPACKED, FNA_4BIT };
+	for(int64_t e = 0; e < 3; e++) {
+		for(int64_t mode = 0; mode < 4; mode++) {
+			/* grown by steps, counted in the mapped window, with .fai, with fna_set_len_hint */
+			if(mode == 2) { assert(fna_build_index(filename) == FNA_SUCCESS); }
+			if(mode == 3) { remove(fai_filename); }
+
+			fna_t *fe = fna_init(filename, FNA_PARAMS(.seq_encode = encode[e], .options = (mode == 1) ? FNA_MMAP : 0, .tail_margin = 16));
+			assert(fe != NULL, "e(%lld), mode(%lld)", e, mode);
+			assert(((struct fna_context_s *)fe)->fai == NULL, "e(%lld), mode(%lld)", e, mode);
+
+			int64_t off = 0;
+			for(int64_t i = 0; i < 3; i++) {
+				/* the mapped window ignores the hint, which must not be left for the next record */
+				if(mode == 1 || mode == 3) { assert(fna_set_len_hint(fe, (mode == 3) ? lens[i] : 1) == FNA_SUCCESS); }
+				fna_seq_t *b = fna_read(fe);
+				assert(b != NULL, "e(%lld), mode(%lld), i(%lld)", e, mode, i);
+				assert(((struct fna_context_s *)fe)->len_hint < 0, "e(%lld), mode(%lld), i(%lld)", e, mode, i);
+				assert(b->s.segment.seq.len == lens[i], "e(%lld), mode(%lld), i(%lld), len(%lld)", e, mode, i, b->s.segment.seq.len);
+
+				/* compared against the reference, encoded base by base */
+				int64_t diff = 0;
+				for(int64_t j = 0; j < lens[i]; j++) {
+					uint8_t const *p = b->s.segment.seq.ptr, c = lmm_kv_at(ref, off + j);
+					diff += (encode[e] == FNA_ASCII) ? p[j] != c
+						: (encode[e] == FNA_2BITPACKED) ? ((p[j / 4]>>(2 * (j % 4))) & 0x03) != fna_encode_2bit(c)
+						: p[j] != fna_encode_4bit(c);
+				}
+				assert(diff == 0, "e(%lld), mode(%lld), i(%lld), diff(%lld)", e, mode, i, diff);
 
-	/** cleanup file */
-	remove(gfa_filename);
-	return;
+				/* no slack of doubling on long ones */
+				assert(lens[i] < FNA_COMPACT_MAX_BLOCK || _size(b) <= _tail(b) + 16 + FNA_COMPACT_MAX_BLOCK + FNA_BUF_MARGIN,
+					"e(%lld), mode(%lld), i(%lld), size(%llu), tail(%llu)", e, mode, i, _size(b), _tail(b));
+				fna_seq_free(b);
+				off += lens[i];
+			}
+			assert(fna_read(fe) == NULL, "e(%lld), mode(%lld)", e, mode);
+
+			/* .fai is loaded on the first long record, and its file is opened again by fna_fetch */
+			struct fna_fai_s const *fai = ((struct fna_context_s *)fe)->fai;
+			assert((fai != NULL) == (mode == 2), "e(%lld), mode(%lld)", e, mode);
+			if(mode == 2) {
+				assert(fai->fd < 0, "e(%lld)", e);
+				fna_seq_t *f = fna_fetch(fe, "r1", 0, 7);
+				assert(f != NULL && f->s.segment.seq.len == 7, "e(%lld)", e);
+				assert(fai->fd >= 0, "e(%lld)", e);
+				fna_seq_free(f);
+			}
+			fna_close(fe);
+		}
+	}
+	#undef _size
+	#undef _tail
+
+	/* no hints on the threads */
+	fna_t *fs = fna_init(filename, FNA_PARAMS(.options = FNA_SHARED));
+	assert(fna_set_len_hint(fs, 100) == FNA_ERROR_UNSUPPORTED_VERSION);
+	fna_close(fs);
+
+	lmm_kv_destroy(NULL, ref);
+	remove(filename);
+	remove(fai_filename);
 }
 
-/* large sequence */
+/* fna_read_batch, compared against fna_read */
 unittest()
 {
-	char const *filename = "test.fa";
-
-	/* dump */
-	zf_t *fp = zfopen(filename, "w");
-	for(int64_t i = 0; i < 100; i++) {
-		char *seq = unittest_generate_random_sequence(100000);
-		char *base = seq;
+	char const *fastq_filename = "test_fna_batch.fq";
+	char const *gfa_filename = "test_fna_batch.gfa";
+	int64_t const cnt = 1000, len = 150;
+
+	FILE *fp = fopen(fastq_filename, "w");
+	for(int64_t i = 0; i < cnt; i++) {
+		fprintf(fp, "@r%d%s\n", (int)i, (i % 3 == 0) ? " c" : "");
+		for(int64_t j = 0; j < len - (i % 7); j++) { fputc(unittest_random_base(), fp); }
+		fprintf(fp, "\n+\n");
+		for(int64_t j = 0; j < len - (i % 7); j++) { fputc('I' - (j % 10), fp); }
+		fputc('\n', fp);
+	}
+	fclose(fp);
+	assert(fdump(gfa_filename,
+		"H\tVN:Z:1.0\n"
+		"S\t11\tACCTT\n"
+		"L\t11\t+\t12\t-\t4M\n"
+		"S\t12\tTCAAGG\n"
+		"P\t14\t11+,12-\t4M\n"
+		"L\t12\t-\t13\t+\t*\n"
+		"C\t12\t+\t11\t-\t1\t5M\n"));
+
+	struct {
+		char const *filename;
+		uint16_t options;
+		int64_t max_records, max_bytes;
+	} const conf[] = {
+		{ fastq_filename, 0, 1, 0 },
+		{ fastq_filename, 0, 300, 0 },
+		{ fastq_filename, 0, 100000, 16 * 1024 },
+		{ fastq_filename, FNA_MMAP, 300, 0 },
+		{ fastq_filename, FNA_SKIP_QUAL, 300, 64 * 1024 },
+		{ gfa_filename, 0, 3, 0 }
+	};
 
-		zfprintf(fp, "> seq%lld\n", i);
-		while(*seq != '\0') {
-			for(int64_t j = 0; j < 80; j++) {
-				zfputc(fp, *seq++);
-				if(*seq == '\0') { break; }
+	#define _eq(_a, _b)	( (_a).len == (_b).len && memcmp((_a).ptr, (_b).ptr, (_a).len) == 0 )
+	for(int64_t c = 0; c < (int64_t)(sizeof(conf) / sizeof(conf[0])); c++) {
+		fna_params_t const params = { .options = conf[c].options, .head_margin = 8, .seq_tail_margin = 3 };
+		fna_t *fs = fna_init(conf[c].filename, &params);
+		fna_t *fb = fna_init(conf[c].filename, &params);
+		assert(fs != NULL && fb != NULL, "fs(%p), fb(%p)", fs, fb);
+
+		fna_batch_t *batch;
+		int64_t i = 0;
+		while((batch = fna_read_batch(fb, conf[c].max_records, conf[c].max_bytes)) != NULL) {
+			assert(batch->cnt > 0 && batch->cnt <= conf[c].max_records, "c(%lld), cnt(%lld)", c, batch->cnt);
+			for(int64_t j = 0; j < batch->cnt; j++, i++) {
+				fna_seq_t *a = fna_read(fs), *b = batch->seq[j];
+				assert(a != NULL, "c(%lld), i(%lld)", c, i);
+				assert(((uintptr_t)b & 0x07) == 0, "c(%lld), i(%lld), b(%p)", c, i, b);
+				assert((uint8_t *)b > (uint8_t *)batch && (uint8_t *)b < (uint8_t *)batch + batch->size, "c(%lld), i(%lld)", c, i);
+				assert(a->type == b->type, "c(%lld), i(%lld)", c, i);
+				if(a->type == FNA_SEGMENT) {
+					assert(_eq(a->s.segment.name, b->s.segment.name), "c(%lld), i(%lld)", c, i);
+					assert(_eq(a->s.segment.comment, b->s.segment.comment), "c(%lld), i(%lld)", c, i);
+					assert(_eq(a->s.segment.seq, b->s.segment.seq), "c(%lld), i(%lld)", c, i);
+					assert(_eq(a->s.segment.qual, b->s.segment.qual), "c(%lld), i(%lld)", c, i);
+				} else if(a->type == FNA_PATH) {
+					assert(_eq(a->s.path.name, b->s.path.name) && a->s.path.len == b->s.path.len, "c(%lld), i(%lld)", c, i);
+					for(int64_t k = 0; k < a->s.path.len; k++) {
+						assert(strcmp(a->s.path.name.ptr + a->s.path.seg_ofs[k], b->s.path.name.ptr + b->s.path.seg_ofs[k]) == 0, "c(%lld), i(%lld)", c, i);
+						assert(a->s.path.ori[k] == b->s.path.ori[k], "c(%lld), i(%lld)", c, i);
+					}
+					assert(_eq(a->s.path.overlap, b->s.path.overlap), "c(%lld), i(%lld)", c, i);
+				} else {
+					assert(_eq(a->s.link.src, b->s.link.src) && a->s.link.src_ori == b->s.link.src_ori, "c(%lld), i(%lld)", c, i);
+					assert(_eq(a->s.link.dst, b->s.link.dst) && a->s.link.dst_ori == b->s.link.dst_ori, "c(%lld), i(%lld)", c, i);
+					assert(_eq(a->s.link.cigar, b->s.link.cigar), "c(%lld), i(%lld)", c, i);
+					assert(a->type != FNA_CONTAINMENT || a->s.containment.pos == b->s.containment.pos, "c(%lld), i(%lld)", c, i);
+				}
+				fna_seq_free(a);
+				fna_seq_free(b);		/* no-op */
 			}
-			zfputc(fp, '\n');
+			fna_batch_free(batch);
 		}
-
-		free(base);
+		assert(fna_read(fs) == NULL, "c(%lld)", c);
+		assert(i == ((conf[c].filename == gfa_filename) ? 6 : cnt), "c(%lld), i(%lld)", c, i);
+		assert(fb->status == fs->status, "c(%lld), status(%d, %d)", c, fb->status, fs->status);
+		fna_close(fs);
+		fna_close(fb);
 	}
-	zfclose(fp);
+	#undef _eq
 
-	/* read */
-	fna_t *fna = fna_init(filename, NULL);
-	fna_seq_t *seq = NULL;
+	remove(fastq_filename);
+	remove(gfa_filename);
+}
 
-	int64_t i = 0;
-	while((seq = fna_read(fna)) != NULL) {
-		char buf[1024];
-		sprintf(buf, "seq%" PRId64 "", i++);
+/* reverse complement kernels, compared against the scalar one */
+unittest()
+{
+	uint8_t src[1024 + 16], dst[1024 + 16], ref[1024 + 16];
+	uint32_t const isa = fna_cpu_isa();
+
+	for(int encode = FNA_ASCII; encode <= FNA_4BITPACKED; encode++) {
+		int const packed = encode == FNA_2BITPACKED || encode == FNA_4BITPACKED;
+		int const bits = (encode == FNA_2BITPACKED) ? 2 : 4;
+		int const unpacked = (encode == FNA_2BITPACKED) ? FNA_2BIT : FNA_4BIT;
+
+		for(int64_t i = 0; i < 1000; i++) {
+			int64_t const len = rand() % 1024;
+			int64_t const size = fna_encoded_size(encode, len);
+			for(int64_t j = 0; j < size; j++) {
+				src[j] = (encode == FNA_ASCII || packed) ? rand() : (encode == FNA_2BIT) ? rand() % 4 : rand() % 16;
+			}
 
-		assert(strcmp(seq->s.segment.name.ptr, buf) == 0, "name(%s, %s)", seq->s.segment.name.ptr, buf);
-		assert(seq->s.segment.seq.len == 100000, "len(%lld)", seq->s.segment.seq.len);
+			/* reference, padding bits of packed ones are cleared */
+			memset(ref, 0, sizeof(ref));
+			for(int64_t j = 0; j < len; j++) {
+				if(packed) {
+					int64_t const k = (len - j - 1) * bits;
+					uint8_t const c = (src[k / 8]>>(k % 8)) & ((1<<bits) - 1);
+					ref[j * bits / 8] |= fna_comp_base(c, unpacked)<<((j * bits) % 8);
+				} else {
+					ref[j] = fna_comp_base(src[len - j - 1], encode);
+				}
+			}
 
-		fna_seq_free(seq);
+			for(struct fna_kernel_s const *const *k = fna_kernels; *k != NULL; k++) {
+				if(((*k)->isa & ~isa) != 0) { continue; }
+				memset(dst, 0xa5, sizeof(dst));
+				(*k)->revcomp(dst, src, len, encode);
+				assert(memcmp(dst, ref, size) == 0, "%s, encode(%d), len(%lld)", (*k)->name, encode, len);
+				assert(dst[size] == 0xa5, "%s, encode(%d), len(%lld)", (*k)->name, encode, len);
+			}
+		}
 	}
 
-	fna_close(fna);
-	remove(filename);
+	/* IUPAC codes and case */
+	char const *fw = "ACGTUNRYKMBVDHSWacgtunrykmbvdhsw-.*", *rc = "NNNwsdhbvkmrynaacgtWSDHBVKMRYNAACGT";
+	struct fna_kernel_s const *kernel = fna_kernel_select();
+	kernel->revcomp(dst, (uint8_t const *)fw, strlen(fw), FNA_ASCII);
+	assert(strcmp((char const *)dst, rc) == 0, "%s", dst);
 }
 
-#if 0
 /**
  * sequence handling
  */
 unittest()
 {
-	char const *fasta_filename = "test_fna_40.fa";
-	char const *fasta_content = ">test0\nAACA\n";
-	int32_t const margin = 32;
+	char const *fastq_filename = "test_fna_40.fq";
+	char const *fastq_content = "@test0 c\nAACA\n+\nABCD\n";
+	int32_t const margin = 32, seq_margin = 16;
 	char const *magic[3] = {
 		"The quick brown fox jumps over the lazy dog.",
 		"Lorem ipsum dolor sit amet, consectetur adipisicing elit,",
 		"ETAOIN SHRDLU CMFWYP VBGKQJ XZ  "
 	};
-	assert(fdump(fasta_filename, fasta_content));
-	assert(fcmp(fasta_filename, strlen(fasta_content), (uint8_t const *)fasta_content));
+	assert(fdump(fastq_filename, fastq_content));
 
-	fna_t *fna = fna_init(fasta_filename,
-		FNA_PARAMS(
-			.head_margin = margin,
-			.tail_margin = margin
-		));
-	assert(fna != NULL, "fna(%p)", fna);
+	#define _str(_x)		( strndup((char const *)(_x).ptr, (_x).len) )
+	#define _eq(_x, _s)		( (_x).len == (int64_t)strlen(_s) && strncmp((char const *)(_x).ptr, (_s), (_x).len) == 0 )
+	#define _head(_s)		( (char const *)(_s) - margin )
+	#define _view(_s)		( (((struct fna_seq_intl_s const *)(_s))->flags & FNA_VIEW_QUAL) != 0 )
+	#define _tail(_s)		( (char const *)(_s)->s.segment.qual.ptr + (_s)->s.segment.qual.len + 1 )
+	#define _seq_tail(_s)	( (char const *)(_s)->s.segment.seq.ptr + fna_encoded_size(FNA_ASCII, (_s)->s.segment.seq.len) )
+	for(int64_t mode = 0; mode < 2; mode++) {
+		fna_t *fna = fna_init(fastq_filename,
+			FNA_PARAMS(
+				.options = (mode == 1) ? FNA_MMAP : 0,
+				.head_margin = margin,
+				.tail_margin = margin,
+				.seq_head_margin = seq_margin,
+				.seq_tail_margin = seq_margin
+			));
+		assert(fna != NULL, "mode(%lld)", mode);
+
+		fna_seq_t *seq = fna_read(fna);
+		assert(seq != NULL, "mode(%lld)", mode);
+
+		/* duplicate, fields viewing the file are copied into the record */
+		fna_seq_t *dup = fna_duplicate(seq);
+		assert(((struct fna_seq_intl_s *)dup)->flags == 0, "flags(%x)", ((struct fna_seq_intl_s *)dup)->flags);
+		assert(_eq(dup->s.segment.name, "test0"), "name(%s)", _str(dup->s.segment.name));
+		assert(_eq(dup->s.segment.comment, "c"), "comment(%s)", _str(dup->s.segment.comment));
+		assert(strcmp((char const *)dup->s.segment.seq.ptr, "AACA") == 0, "dup(%s)", _str(dup->s.segment.seq));
+		assert(strcmp((char const *)dup->s.segment.qual.ptr, "ABCD") == 0, "qual(%s)", _str(dup->s.segment.qual));
+		assert(dup->s.segment.seq.len == 4, "len(%lld)", dup->s.segment.seq.len);
+
+		/* generate reverse complement */
+		fna_seq_t *rev = fna_revcomp(dup);
+		assert(_eq(rev->s.segment.name, "test0"), "name(%s)", _str(rev->s.segment.name));
+		assert(strcmp((char const *)rev->s.segment.seq.ptr, "TGTT") == 0, "rev(%s)", _str(rev->s.segment.seq));
+		assert(strcmp((char const *)rev->s.segment.qual.ptr, "DCBA") == 0, "qual(%s)", _str(rev->s.segment.qual));
+		assert(rev->s.segment.seq.len == 4, "len(%lld)", rev->s.segment.seq.len);
+
+		/* fill margins with magic */
+		fna_seq_t *s[3] = { seq, dup, rev };
+		for(int64_t i = 0; i < 3; i++) {
+			memcpy((void *)_head(s[i]), magic[i], margin);
+			if(!_view(s[i])) { memcpy((void *)_tail(s[i]), magic[i], margin); }
+		}
 
-	fna_seq_t *seq = fna_read(fna);
-	/* fill margin with magic */
-	memcpy((void *)seq - margin, magic[0], margin);
-	memcpy((void *)(seq + 1), magic[0], margin);
-
-	/* duplicate */
-	fna_seq_t *dup = fna_duplicate(seq);
-	memcpy((void *)dup - margin, magic[1], margin);
-	memcpy((void *)(dup + 1), magic[1], margin);
-	assert(strcmp(dup->name, "test0") == 0, "name(%s)", dup->name);
-	assert(strcmp((char const *)dup->seq, "AACA") == 0, "dup(%s)", (char const *)dup->seq);
-	assert(dup->len == 4, "len(%lld)", dup->len);
-
-	/* generate reverse complement */
-	fna_seq_t *rev = fna_revcomp(dup);
-	memcpy((void *)rev - margin, magic[2], margin);
-	memcpy((void *)(rev + 1), magic[2], margin);
-	assert(strcmp(rev->name, "test0") == 0, "name(%s)", rev->name);
-	assert(strcmp((char const *)rev->seq, "TGTT") == 0, "rev(%s)", (char const *)rev->seq);
-	assert(rev->len == 4, "len(%lld)", rev->len);
-
-	/* append */
-	fna_append(dup, dup);
-	assert(strcmp(dup->name, "test0") == 0, "name(%s)", dup->name);
-	assert(strcmp((char const *)dup->seq, "AACAAACA") == 0, "dup(%s)", (char const *)dup->seq);
-	assert(dup->len == 8, "len(%lld)", dup->len);
-
-	/* append reverse complement */
-	fna_append_revcomp(rev, rev);
-	assert(strcmp(rev->name, "test0") == 0, "name(%s)", rev->name);
-	assert(strcmp((char const *)rev->seq, "TGTTAACA") == 0, "rev(%s)", (char const *)rev->seq);
-	assert(rev->len == 8, "len(%lld)", rev->len);
-
-	/* check margin */
-	assert(((struct fna_seq_intl_s *)seq)->head_margin == margin,
-		"margin(%d)", ((struct fna_seq_intl_s *)seq)->head_margin);
-	assert(((struct fna_seq_intl_s *)dup)->head_margin == margin,
-		"margin(%d)", ((struct fna_seq_intl_s *)seq)->head_margin);
-	assert(((struct fna_seq_intl_s *)rev)->head_margin == margin,
-		"margin(%d)", ((struct fna_seq_intl_s *)seq)->head_margin);
-
-	assert(strncmp((char const *)seq - margin, magic[0], margin) == 0, "");
-	assert(strncmp((char const *)dup - margin, magic[1], margin) == 0, "");
-	assert(strncmp((char const *)rev - margin, magic[2], margin) == 0, "");
-
-	assert(((struct fna_seq_intl_s *)seq)->tail_margin == margin,
-		"margin(%d)", ((struct fna_seq_intl_s *)seq)->tail_margin);
-	assert(((struct fna_seq_intl_s *)dup)->tail_margin == margin,
-		"margin(%d)", ((struct fna_seq_intl_s *)seq)->tail_margin);
-	assert(((struct fna_seq_intl_s *)rev)->tail_margin == margin,
-		"margin(%d)", ((struct fna_seq_intl_s *)seq)->tail_margin);
-
-	assert(strncmp((char const *)(seq + 1), magic[0], margin) == 0, "");
-	assert(strncmp((char const *)(dup + 1), magic[1], margin) == 0, "");
-	assert(strncmp((char const *)(rev + 1), magic[2], margin) == 0, "");
+		/* append */
+		fna_append(dup, dup);
+		assert(_eq(dup->s.segment.name, "test0"), "name(%s)", _str(dup->s.segment.name));
+		assert(strcmp((char const *)dup->s.segment.seq.ptr, "AACAAACA") == 0, "dup(%s)", _str(dup->s.segment.seq));
+		assert(strcmp((char const *)dup->s.segment.qual.ptr, "ABCDABCD") == 0, "qual(%s)", _str(dup->s.segment.qual));
+		assert(dup->s.segment.seq.len == 8, "len(%lld)", dup->s.segment.seq.len);
+
+		/* seq margins of the appended seq are writable */
+		memset((void *)(dup->s.segment.seq.ptr - seq_margin), 0xff, seq_margin);
+		memset((void *)_seq_tail(dup), 0xff, seq_margin);
+
+		/* append reverse complement, twice to move the appended buffers */
+		fna_append_revcomp(rev, rev);
+		assert(strcmp((char const *)rev->s.segment.seq.ptr, "TGTTAACA") == 0, "rev(%s)", _str(rev->s.segment.seq));
+		assert(strcmp((char const *)rev->s.segment.qual.ptr, "DCBAABCD") == 0, "qual(%s)", _str(rev->s.segment.qual));
+		fna_append_revcomp(rev, seq);
+		assert(strcmp((char const *)rev->s.segment.seq.ptr, "TGTTAACATGTT") == 0, "rev(%s)", _str(rev->s.segment.seq));
+		assert(strcmp((char const *)rev->s.segment.qual.ptr, "DCBAABCDDCBA") == 0, "qual(%s)", _str(rev->s.segment.qual));
+		assert(rev->s.segment.seq.len == 12, "len(%lld)", rev->s.segment.seq.len);
+
+		/* check margin, the record stays where it was */
+		for(int64_t i = 0; i < 3; i++) {
+			struct fna_seq_intl_s const *r = (struct fna_seq_intl_s const *)s[i];
+			assert(r->head_margin == margin && r->tail_margin == margin, "i(%lld), margin(%d, %d)", i, r->head_margin, r->tail_margin);
+			assert(r->seq_head_margin == seq_margin && r->seq_tail_margin == seq_margin, "i(%lld)", i);
+			assert(strncmp(_head(s[i]), magic[i], margin) == 0, "i(%lld)", i);
+		}
+		assert(_view(seq) || strncmp(_tail(seq), magic[0], margin) == 0, "");
 
-	/* cleanup */
-	fna_seq_free(seq);
-	fna_seq_free(dup);
-	fna_seq_free(rev);
+		/* mismatched encodings */
+		fna_t *fe = fna_init(fastq_filename, FNA_PARAMS(.seq_encode = FNA_2BIT));
+		fna_seq_t *e = fna_read(fe);
+		fna_append(dup, e);
+		assert(dup->s.segment.seq.len == 8, "len(%lld)", dup->s.segment.seq.len);
+		fna_seq_free(e);
+		fna_close(fe);
 
-	fna_close(fna);
-	remove(fasta_filename);
+		/* cleanup */
+		fna_seq_free(seq);
+		fna_seq_free(dup);
+		fna_seq_free(rev);
+		fna_close(fna);
+	}
+	#undef _str
+	#undef _eq
+	#undef _head
+	#undef _view
+	#undef _tail
+	#undef _seq_tail
+	remove(fastq_filename);
 }
-#endif
+
+/* duplicate / revcomp / append in all encodings, compared base by base */
+unittest()
+{
+	char const *filename = "test_fna_revcomp.fa";
+	int64_t const cnt = 50;
+
+	lmm_kvec_t(char) ref;
+	lmm_kv_init(NULL, ref);
+	lmm_kvec_t(int64_t) lens;
+	lmm_kv_init(NULL, lens);
+	FILE *fp = fopen(filename, "w");
+	for(int64_t i = 0; i < cnt; i++) {
+		int64_t const len = (i < 8) ? i : rand() % 1000;
+		lmm_kv_push(NULL, lens, len);
+		fprintf(fp, ">r%d\n", (int)i);
+		for(int64_t j = 0; j < len; j++) {
+			char const c = unittest_random_base();
+			lmm_kv_push(NULL, ref, c);
+			fputc(c, fp);
+			if(j % 60 == 59 || j + 1 == len) { fputc('\n', fp); }
+		}
+		if(len == 0) { fputc('\n', fp); }
+	}
+	fclose(fp);
+
+	#define _at(_e, _p, _j) ( \
+		  ((_e) == FNA_2BITPACKED) ? ((_p)[(_j) / 4]>>(2 * ((_j) % 4))) & 0x03 \
+		: ((_e) == FNA_4BITPACKED) ? ((_p)[(_j) / 2]>>(4 * ((_j) % 2))) & 0x0f \
+		: (_p)[_j] \
+	)
+	#define _enc(_e, _c) ( \
+		  ((_e) == FNA_ASCII) ? (uint8_t)(_c) \
+		: ((_e) == FNA_2BIT || (_e) == FNA_2BITPACKED) ? fna_encode_2bit(_c) \
+		: fna_encode_4bit(_c) \
+	)
+	#define _comp(_e, _c)	( fna_comp_base((_c), ((_e) == FNA_2BITPACKED) ? FNA_2BIT : ((_e) == FNA_4BITPACKED) ? FNA_4BIT : (_e)) )
+	for(int encode = FNA_ASCII; encode <= FNA_4BITPACKED; encode++) {
+		for(int64_t mode = 0; mode < 2; mode++) {
+			fna_t *fna = fna_init(filename, FNA_PARAMS(.seq_encode = encode, .options = (mode == 1) ? FNA_MMAP : 0, .seq_tail_margin = 8));
+			assert(fna != NULL, "encode(%d), mode(%lld)", encode, mode);
+
+			/* every record is appended forward and reverse-complemented to acc */
+			fna_seq_t *acc = NULL;
+			int64_t off = 0, acc_len = 0, diff = 0;
+			for(int64_t i = 0; i < cnt; i++) {
+				int64_t const len = lmm_kv_at(lens, i);
+				char const *r = &lmm_kv_at(ref, off);
+				fna_seq_t *seq = fna_read(fna);
+				assert(seq != NULL && seq->s.segment.seq.len == len, "encode(%d), mode(%lld), i(%lld)", encode, mode, i);
+
+				fna_seq_t *dup = fna_duplicate(seq);
+				fna_seq_t *rev = fna_revcomp(seq);
+				for(int64_t j = 0; j < len; j++) {
+					diff += _at(encode, dup->s.segment.seq.ptr, j) != _enc(encode, r[j]);
+					diff += _at(encode, rev->s.segment.seq.ptr, j) != _comp(encode, _enc(encode, r[len - j - 1]));
+				}
+				if(encode == FNA_ASCII) {
+					diff += dup->s.segment.seq.ptr[len] != '\0';
+					diff += rev->s.segment.seq.ptr[len] != '\0';
+				}
+				assert(diff == 0, "encode(%d), mode(%lld), i(%lld), diff(%lld)", encode, mode, i, diff);
+
+				if(acc == NULL) {
+					acc = dup;
+				} else {
+					fna_append(acc, dup);
+					fna_seq_free(dup);
+				}
+				fna_append_revcomp(acc, seq);
+				acc_len += 2 * len;
+				assert(acc->s.segment.seq.len == acc_len, "encode(%d), mode(%lld), i(%lld)", encode, mode, i);
+
+				fna_seq_free(rev);
+				fna_seq_free(seq);
+				off += len;
+			}
+
+			/* r0 rc(r0) r1 rc(r1) ... */
+			off = 0;
+			int64_t pos = 0;
+			uint8_t const *p = acc->s.segment.seq.ptr;
+			for(int64_t i = 0; i < cnt; i++) {
+				int64_t const len = lmm_kv_at(lens, i);
+				char const *r = &lmm_kv_at(ref, off);
+				for(int64_t j = 0; j < len; j++) {
+					diff += _at(encode, p, pos + j) != _enc(encode, r[j]);
+					diff += _at(encode, p, pos + len + j) != _comp(encode, _enc(encode, r[len - j - 1]));
+				}
+				pos += 2 * len;
+				off += len;
+			}
+			if(encode == FNA_ASCII) { diff += p[pos] != '\0'; }
+			if(encode == FNA_2BITPACKED || encode == FNA_4BITPACKED) {
+				int64_t const bits = (encode == FNA_2BITPACKED) ? 2 : 4;
+				diff += (p[pos * bits / 8]>>((pos * bits) % 8)) != 0;		/* padding */
+			}
+			assert(diff == 0, "encode(%d), mode(%lld), diff(%lld)", encode, mode, diff);
+
+			fna_seq_free(acc);
+			fna_close(fna);
+		}
+	}
+	#undef _at
+	#undef _enc
+	#undef _comp
+
+	lmm_kv_destroy(NULL, ref);
+	lmm_kv_destroy(NULL, lens);
+	remove(filename);
+}
+
+/* FNA_EMIT_REVCOMP, compared against the forward reader base by base */
+unittest()
+{
+	char const *filename[2] = { "test_fna_emit_revcomp.fa", "test_fna_emit_revcomp.fq" };
+	int64_t const cnt = 500;
+
+	/* multi-line records of odd lengths, a long FASTA one at the tail read in chunks */
+	for(int64_t f = 0; f < 2; f++) {
+		FILE *fp = fopen(filename[f], "w");
+		for(int64_t i = 0; i < cnt; i++) {
+			int64_t len = (i % 50 == 0) ? 0 : (f == 0 && i == cnt - 1) ? 2 * FNA_GROW_MIN_LEN + 3 : 1 + rand() % 1000;
+			fprintf(fp, (f == 0) ? ">s%d\n" : "@s%d\n", (int)i);
+			for(int64_t j = 0; j < len; j++) {
+				fputc((rand() % 32 == 0) ? 'N' : unittest_random_base(), fp);
+				if(j % 60 == 59 && j + 1 < len) { fputc('\n', fp); }
+			}
+			if(f == 1) {
+				fprintf(fp, "\n+\n");
+				for(int64_t j = 0; j < len; j++) { fputc('!' + rand() % 64, fp); }
+			}
+			fputc('\n', fp);
+		}
+		fclose(fp);
+	}
+
+	struct { uint32_t options; uint16_t threads; int encode; } const modes[] = {
+		{ 0, 0, FNA_ASCII },
+		{ FNA_MMAP, 0, FNA_ASCII },
+		{ 0, 0, FNA_2BITPACKED },
+		{ FNA_MMAP, 0, FNA_4BITPACKED },
+		{ 0, 2, FNA_2BIT },
+		{ 0, 0, FNA_4BIT },
+		{ FNA_SKIP_QUAL, 0, FNA_ASCII }
+	};
+
+	#define _at(_e, _p, _j) ( \
+		  ((_e) == FNA_2BITPACKED) ? ((_p)[(_j) / 4]>>(2 * ((_j) % 4))) & 0x03 \
+		: ((_e) == FNA_4BITPACKED) ? ((_p)[(_j) / 2]>>(4 * ((_j) % 2))) & 0x0f \
+		: (_p)[_j] \
+	)
+	#define _comp(_e, _c)	( fna_comp_base((_c), ((_e) == FNA_2BITPACKED) ? FNA_2BIT : ((_e) == FNA_4BITPACKED) ? FNA_4BIT : (_e)) )
+	#define _diff(_e, _a, _b) ({ \
+		int64_t const _len = (_a)->s.segment.seq.len, _qlen = (_a)->s.segment.qual.len; \
+		uint8_t const *_p = (_a)->s.segment.seq.ptr, *_q = (_b)->s.segment.seq.ptr; \
+		int64_t _d = (_b)->s.segment.seq.len != 2 * _len; \
+		for(int64_t _j = 0; _d == 0 && _j < _len; _j++) { \
+			_d += _at(_e, _q, _j) != _at(_e, _p, _j); \
+			_d += _at(_e, _q, _len + _j) != _comp(_e, _at(_e, _p, _len - _j - 1)); \
+		} \
+		if((_e) == FNA_ASCII) { _d += _q[2 * _len] != '\0'; } \
+		_p = (_a)->s.segment.qual.ptr; _q = (_b)->s.segment.qual.ptr; \
+		_d += (_b)->s.segment.qual.len != 2 * _qlen; \
+		for(int64_t _j = 0; _d == 0 && _j < _qlen; _j++) { \
+			_d += _at(_e, _q, _j) != _at(_e, _p, _j); \
+			_d += _at(_e, _q, _qlen + _j) != _at(_e, _p, _qlen - _j - 1); \
+		} \
+		_d; \
+	})
+	for(int64_t f = 0; f < 2; f++) {
+		for(int64_t m = 0; m < (int64_t)(sizeof(modes) / sizeof(modes[0])); m++) {
+			int const e = modes[m].encode;
+			fna_t *fa = fna_init(filename[f], FNA_PARAMS(.seq_encode = e, .options = modes[m].options & FNA_SKIP_QUAL));
+			fna_t *fs = fna_init(filename[f], FNA_PARAMS(
+				.seq_encode = e,
+				.options = modes[m].options | FNA_EMIT_REVCOMP,
+				.threads = modes[m].threads,
+				.seq_tail_margin = 8
+			));
+			assert(fa != NULL && fs != NULL, "f(%lld), m(%lld)", f, m);
+
+			/* every other record through fna_read_into */
+			fna_seq_t *a, *b, *r = NULL;
+			int64_t i = 0;
+			while((a = fna_read(fa)) != NULL) {
+				b = (i % 2 == 0) ? fna_read(fs) : (r = fna_read_into(fs, r));
+				assert(b != NULL, "f(%lld), m(%lld), i(%lld)", f, m, i);
+				assert(a->s.segment.name.len == b->s.segment.name.len, "f(%lld), m(%lld), i(%lld)", f, m, i);
+
+				int64_t const d = _diff(e, a, b);
+				assert(d == 0, "f(%lld), m(%lld), i(%lld), len(%lld, %lld), qual(%lld, %lld)", f, m, i,
+					a->s.segment.seq.len, b->s.segment.seq.len, a->s.segment.qual.len, b->s.segment.qual.len);
+
+				fna_seq_free(a);
+				if(i % 2 == 0) { fna_seq_free(b); }
+				i++;
+			}
+			assert(i == cnt, "f(%lld), m(%lld), i(%lld)", f, m, i);
+			assert(fna_read(fs) == NULL, "f(%lld), m(%lld)", f, m);
+			fna_seq_free(r);
+			fna_close(fa);
+			fna_close(fs);
+		}
+	}
+
+	/* fna_fetch emits both strands as well */
+	assert(fna_build_index(filename[0]) == FNA_SUCCESS);
+	for(int64_t m = 0; m < (int64_t)(sizeof(modes) / sizeof(modes[0])); m++) {
+		int const e = modes[m].encode;
+		fna_t *fa = fna_init(filename[0], FNA_PARAMS(.seq_encode = e));
+		fna_t *fs = fna_init(filename[0], FNA_PARAMS(.seq_encode = e, .options = FNA_EMIT_REVCOMP));
+		fna_seq_t *a = fna_fetch(fa, "s7", 3, 120), *b = fna_fetch(fs, "s7", 3, 120);
+		assert(a != NULL && b != NULL, "m(%lld)", m);
+		assert(_diff(e, a, b) == 0, "m(%lld), len(%lld, %lld)", m, a->s.segment.seq.len, b->s.segment.seq.len);
+		fna_seq_free(a);
+		fna_seq_free(b);
+		fna_close(fa);
+		fna_close(fs);
+	}
+	#undef _at
+	#undef _comp
+	#undef _diff
+
+	char fai_filename[64];
+	sprintf(fai_filename, "%s.fai", filename[0]);
+	remove(fai_filename);
+	remove(filename[0]);
+	remove(filename[1]);
+}
+
+#endif /* !FNA_KERNEL_ONLY */
 
 /**
  * end of fna.c
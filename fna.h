@@ -18,8 +18,38 @@
  *   Basic readers:
  *     fna_t *fna_init(char const *path, int pack);
  *     fna_seq_t *fna_read(fna_t const *fna, fna_seq_t *seq);
+ *     fna_seq_t *fna_try_read(fna_t *fna);
+ *     fna_seq_t *fna_read_into(fna_t *fna, fna_seq_t *seq);
+ *     fna_batch_t *fna_read_batch(fna_t *fna, int64_t max_records, int64_t max_bytes);
+ *     void fna_batch_free(fna_batch_t *batch);
  *     void fna_seq_free(fna_seq_t *seq);
  *     void fna_close(fna_t *fna);
+ *     int fna_set_len_hint(fna_t *fna, int64_t len);
+ *
+ *   Checkpoints:
+ *     int fna_tell(fna_t *fna, fna_pos_t *pos);
+ *     int fna_seek(fna_t *fna, fna_pos_t const *pos);
+ *
+ *   Paired-end reader:
+ *     fna_pair_t *fna_init_pair(char const *path1, char const *path2, fna_params_t const *params);
+ *     fna_batch_t *fna_read_pair(fna_pair_t *pair, int64_t max_pairs, int64_t max_bytes);
+ *     void fna_close_pair(fna_pair_t *pair);
+ *
+ *   Random access (uncompressed or bgzipped FASTA):
+ *     int fna_build_index(char const *path);
+ *     fna_seq_t *fna_fetch(fna_t *fna, char const *name, int64_t start, int64_t end);
+ *
+ *   Parallel readers (uncompressed FASTA / FASTQ):
+ *     int64_t fna_split(char const *path, int64_t n, uint64_t *offs);
+ *     fna_t *fna_init_range(char const *path, fna_params_t const *params, uint64_t begin, uint64_t end);
+ *     int fna_read_parallel(char const *path, fna_params_t const *params, int64_t n, int (*worker)(fna_t *, int64_t, void *), void *arg);
+ *
+ *   GFA graphs:
+ *     int64_t fna_segment_id(fna_t const *fna, char const *name);
+ *     char const *fna_segment_name(fna_t const *fna, int64_t id);
+ *     int64_t fna_segment_count(fna_t const *fna);
+ *     fna_graph_t *fna_load_graph(char const *path, fna_params_t const *params);
+ *     void fna_graph_free(fna_graph_t *graph);
  *
  *   Sequence duplicators:
  *     fna_seq_t *fna_duplicate(fna_seq_t const *seq);
@@ -72,16 +102,73 @@ enum fna_format {
  * @enum fna_options
  */
 enum fna_options {
-	FNA_SKIP_QUAL 	= 1
+	FNA_SKIP_QUAL 	= 1,
+	FNA_MMAP		= 2,	/** map uncompressed FASTA / FASTQ and return views into the mapping, see below */
+	FNA_UNORDERED	= 4,	/** records may come out of file order when parsed on threads */
+	FNA_SHARED		= 8,	/** fna_read and fna_try_read may be called from many threads, see below */
+	FNA_SKIP_SEQ	= 16,	/** header-only scan of FASTA / FASTQ, see below */
+	FNA_EMIT_REVCOMP = 32,	/** both strands of FASTA / FASTQ records, see below */
+	FNA_INTERN_NAMES = 64	/** dense ids of GFA segment names, see below */
 };
 
+/**
+ * FNA_SKIP_SEQ: FASTA / FASTQ records come with name, comment and seq.len, but the bases
+ * are counted without being stored (seq points to an empty sequence of the encoding) and
+ * qual is skipped as with FNA_SKIP_QUAL. fna_fetch always returns the bases. with FNA_MMAP
+ * the scan touches each byte of the file once, so it runs at the speed of the storage.
+ */
+
+/**
+ * FNA_EMIT_REVCOMP: seq of FASTA / FASTQ records (and of fna_fetch) holds the forward strand
+ * followed by its reverse complement in the same encoding, so seq.len is twice the length
+ * of the read; qual holds the forward string followed by the reversed one. the reverse
+ * strand is built by the parser right after the forward one, hence seq and qual are never
+ * views with FNA_MMAP. ignored with FNA_SKIP_SEQ.
+ */
+
+/**
+ * FNA_INTERN_NAMES: segment names of GFA records are numbered from 0 in the order they first
+ * appear, in 'S' lines or in the references of 'L', 'C', and 'P' lines, with a hash table kept
+ * in the context. the id comes in the id field of the name (segment.name, link.src / dst, and
+ * containment.src / dst) and in path.seg_id of the steps; it is -1 on these names without the
+ * option. fna_segment_id and fna_segment_name look up the table, which the parser keeps
+ * updating in the caller. not available with FNA_SHARED, whose parser runs on its own thread
+ * (fna_init fails).
+ */
+
+/**
+ * FNA_MMAP: an uncompressed regular file is mmapped instead of being read through zf
+ * (compressed files and pipes fall back to zf silently). name and comment of FASTA /
+ * FASTQ records, and seq and qual of single-line ASCII records, then point into the
+ * mapping: they are NOT null-terminated and stay valid until fna_close. fields that
+ * need conversion (multi-line or non-ASCII sequences) are copied as usual.
+ */
+
+/**
+ * threads > 1 on an uncompressed FASTA / FASTQ (not mapped, no custom lmm): the file is cut
+ * into chunks of a few megabytes at record heads (see fna_split), the chunks are parsed on
+ * the threads, and fna_read hands the records back in file order (in the order the chunks
+ * are finished with FNA_UNORDERED).
+ */
+
+/**
+ * FNA_SHARED: records are parsed on a thread of the context into a bounded lock-free queue,
+ * which readers on any number of threads pop with fna_read (waits for a record) or fna_try_read
+ * (returns NULL if none is ready). the reader threads must not call the other functions on the
+ * context concurrently, except fna_read_into and fna_read_batch, which copy the records out of
+ * the queue. records are freed on the reader threads, so a custom lmm must be thread-safe.
+ */
+
 /**
  * @enum fna_seq_type
- * @brief distinguish struct fna_seq_s with struct fna_link_s
+ * @brief distinguish the bodies of struct fna_seq_s; FASTA / FASTQ records and GFA 'S' lines
+ * are segments, 'L', 'C', and 'P' lines are links, containments, and paths.
  */
 enum fna_seq_type {
 	FNA_SEGMENT 	= 1,
-	FNA_LINK		= 2
+	FNA_LINK		= 2,
+	FNA_CONTAINMENT	= 3,
+	FNA_PATH		= 4
 };
 
 /**
@@ -109,7 +196,8 @@ struct fna_params_s {
 	uint16_t tail_margin;		/** margin at the tail of fna_seq_t	*/
 	uint16_t seq_head_margin;	/** margin at the head of seq buffer */
 	uint16_t seq_tail_margin;	/** margin at the tail of seq buffer */
-	uint16_t reserved[2];
+	uint16_t threads;			/** 0: read in the caller, 1: read ahead in a thread, >1: uncompressed FASTA / FASTQ are parsed in chunks, or BGZF blocks are inflated, on that many threads */
+	uint16_t reserved[1];
 	void *lmm;					/** lmm memory manager */
 };
 typedef struct fna_params_s fna_params_t;
@@ -138,6 +226,7 @@ typedef struct fna_s fna_t;
 struct fna_str_s {
 	char const *ptr;
 	int32_t len;
+	int32_t id;					/** segment names only, see FNA_INTERN_NAMES */
 };
 
 /**
@@ -178,6 +267,33 @@ struct fna_link_s {
 	int32_t _pad[2];
 };
 
+/**
+ * @struct fna_containment_s
+ * @brief dst is contained in src at pos; the fields shared with fna_link_s are at the same offsets
+ */
+struct fna_containment_s {
+	struct fna_str_s src;		/** container */
+	struct fna_str_s dst;		/** contained */
+	int32_t src_ori;			/** 0: forward, 1: reverse */
+	int32_t dst_ori;			/** 0: forward, 1: reverse */
+	struct fna_cigar_s cigar;
+	int64_t pos;				/** leftmost position of dst on src */
+};
+
+/**
+ * @struct fna_path_s
+ * @brief steps of a path, in the record body: the name of the i-th step is name.ptr + seg_ofs[i]
+ * (null-terminated) and its orientation is ori[i]. overlap is the comma-separated list as is.
+ */
+struct fna_path_s {
+	struct fna_str_s name;
+	int64_t len;				/** number of steps */
+	int64_t const *seg_ofs;		/** offsets of the step names from name.ptr, len elements */
+	uint8_t const *ori;			/** 0: forward, 1: reverse, len elements */
+	int32_t const *seg_id;		/** ids of the steps with FNA_INTERN_NAMES, NULL without */
+	struct fna_cigar_s overlap;
+};
+
 /**
  * @struct fna_seq_s
  *
@@ -188,14 +304,86 @@ struct fna_seq_s {
 	uint8_t type;
 	uint8_t seq_encode;			/** one of fna_flag_encode */
 	uint16_t options;
+	uint32_t reserved2;
 	union fna_seq_body_u {
 		struct fna_segment_s segment;
 		struct fna_link_s link;
+		struct fna_containment_s containment;
+		struct fna_path_s path;
 	} s;
 	uint16_t reserved3[4];
+	uint64_t reserved4;
 };
 typedef struct fna_seq_s fna_seq_t;
 
+/**
+ * @struct fna_batch_s
+ *
+ * @brief records read at once by fna_read_batch, all in a single arena
+ */
+struct fna_batch_s {
+	void *reserved1;
+	fna_seq_t **seq;			/** array of records, released with the batch (fna_seq_free is a no-op on them) */
+	int64_t cnt;				/** number of records */
+	int64_t size;				/** size of the arena in bytes */
+};
+typedef struct fna_batch_s fna_batch_t;
+
+/**
+ * @struct fna_pair_s
+ *
+ * @brief paired-end reader, see fna_init_pair
+ */
+struct fna_pair_s {
+	fna_t *fna[2];				/** readers of R1 and R2, fna[1] == fna[0] on interleaved input */
+	int32_t status;				/** see enum fna_status */
+	uint32_t reserved;
+};
+typedef struct fna_pair_s fna_pair_t;
+
+/**
+ * @struct fna_pos_s
+ *
+ * @brief position of a reader, saved by fna_tell and restored by fna_seek
+ */
+struct fna_pos_s {
+	uint64_t offset;			/** head of the next record in the decompressed stream */
+	uint64_t reserved;
+};
+typedef struct fna_pos_s fna_pos_t;
+
+/**
+ * @struct fna_graph_arc_s
+ */
+struct fna_graph_arc_s {
+	uint32_t v;					/** head vertex, id << 1 | ori */
+	uint32_t overlap;			/** length of the overlap on the segment of the tail vertex */
+};
+
+/**
+ * @struct fna_graph_s
+ *
+ * @brief a whole GFA graph loaded by fna_load_graph. vertices are oriented segments, id << 1 | ori
+ * with the ids of FNA_INTERN_NAMES; a link (a, oa, b, ob) makes the arc (a, oa) -> (b, ob) and its
+ * complement (b, !ob) -> (a, !oa), and the arcs leaving vertex u are adj[adj_ofs[u], adj_ofs[u + 1])
+ * sorted by the head. all the fields are in a few arrays released by fna_graph_free.
+ */
+struct fna_graph_s {
+	int64_t seg_cnt;			/** number of segments, 'S' lines and names referenced by links */
+	int64_t arc_cnt;			/** two for each link */
+	uint8_t seq_encode;			/** one of fna_flag_encode */
+	uint8_t reserved1[7];
+	char const *name;			/** segment names, null-terminated; the name of segment i is name + name_ofs[i] */
+	int64_t const *name_ofs;
+	uint8_t const *seq;			/** sequences of the segments, each as in fna_seq_t, at seq + seq_ofs[i] */
+	int64_t const *seq_ofs;
+	int64_t const *seq_len;		/** zero for segments without an 'S' line */
+	int64_t const *adj_ofs;		/** 2 * seg_cnt + 1 elements */
+	struct fna_graph_arc_s const *adj;
+	void *reserved2;
+};
+typedef struct fna_graph_s fna_graph_t;
+
 /**
  * @fn fna_init
  *
@@ -208,6 +396,42 @@ typedef struct fna_seq_s fna_seq_t;
  */
 fna_t *fna_init(char const *path, fna_params_t const *params);
 
+/**
+ * @fn fna_init_range
+ *
+ * @brief create a sequence reader context on the byte range [begin, end) of an uncompressed file
+ *
+ * @param[in] begin, end : a range from fna_split (begin must be at a record head)
+ *
+ * @return a pointer to the context, NULL if an error occurred (compressed files are not supported)
+ */
+fna_t *fna_init_range(char const *path, fna_params_t const *params, uint64_t begin, uint64_t end);
+
+/**
+ * @fn fna_split
+ *
+ * @brief partition an uncompressed FASTA or 4-line FASTQ file into at most n byte ranges at record heads.
+ * each split is moved forward to the first line starting with '>' (FASTA), or the first line that
+ * passes the 4-line check ('@' line, sequence, '+' line, quality of the same length, then another
+ * '@' line) (FASTQ).
+ *
+ * @param[out] offs : n + 1 elements; range i is [offs[i], offs[i + 1])
+ *
+ * @return the number of ranges, negative fna_status on error
+ */
+int64_t fna_split(char const *path, int64_t n, uint64_t *offs);
+
+/**
+ * @fn fna_read_parallel
+ *
+ * @brief split the file into n ranges and call worker on each range on its own thread, with its own context
+ * (available if built with pthread)
+ *
+ * @return zero if all the workers returned zero, the first nonzero return value (or fna_status) otherwise
+ */
+int fna_read_parallel(char const *path, fna_params_t const *params, int64_t n,
+	int (*worker)(fna_t *fna, int64_t i, void *arg), void *arg);
+
 /**
  * @fn fna_close
  *
@@ -233,31 +457,211 @@ void *fna_set_lmm(fna_t *fna, void *lmm);
  */
 fna_seq_t *fna_read(fna_t *fna);
 
+/**
+ * @fn fna_try_read
+ *
+ * @brief read a sequence if one is ready (never waits on a FNA_SHARED context, same as fna_read otherwise)
+ *
+ * @return a pointer to a sequence object, NULL if none is ready or the file pointer reached the end (status is FNA_EOF then).
+ */
+fna_seq_t *fna_try_read(fna_t *fna);
+
+/**
+ * @fn fna_read_into
+ *
+ * @brief read a sequence, reusing the buffer of a record returned by fna_read or fna_read_into
+ *
+ * @param[in] fna : a pointer to the context
+ * @param[in] seq : the previous record (or NULL), must not be used after the call
+ *
+ * @return a pointer to a sequence object, NULL if the file pointer reached the end (seq is freed then).
+ */
+fna_seq_t *fna_read_into(fna_t *fna, fna_seq_t *seq);
+
+/**
+ * @fn fna_read_batch
+ *
+ * @brief read many records into a single arena
+ *
+ * @param[in] fna : a pointer to the context
+ * @param[in] max_records : maximum number of records in the batch
+ * @param[in] max_bytes : the batch is closed after the record which makes the arena exceed this, unlimited if <= 0
+ *
+ * @return a pointer to a batch object, NULL if the file pointer reached the end.
+ */
+fna_batch_t *fna_read_batch(fna_t *fna, int64_t max_records, int64_t max_bytes);
+
+/**
+ * @fn fna_batch_free
+ *
+ * @brief clean up batch object and the records in it
+ */
+void fna_batch_free(fna_batch_t *batch);
+
+/**
+ * @fn fna_set_len_hint
+ *
+ * @brief tell the sequence length of the next FASTA record, which is then read into a buffer of
+ * its final size. the hint is dropped once a record is read, whatever the format or mode. <path>.fai,
+ * if present, gives the lengths of long sequences in the same way; it is loaded on the first
+ * sequence longer than 1 Mbp. mapped files (FNA_MMAP) count them in the mapping. other long sequences grow their
+ * buffer in place by steps of up to 32 Mbp, which realloc remaps without copying the bases on glibc,
+ * and are trimmed to the record at the end.
+ *
+ * @return FNA_SUCCESS, FNA_ERROR_UNSUPPORTED_VERSION on contexts parsing on threads (pooled or FNA_SHARED)
+ */
+int fna_set_len_hint(fna_t *fna, int64_t len);
+
+/**
+ * @fn fna_build_index
+ *
+ * @brief build a samtools-compatible index (<path>.fai) of an uncompressed or bgzipped FASTA,
+ * with the offsets of the BGZF blocks (<path>.gzi) for the latter
+ *
+ * @return FNA_SUCCESS, FNA_ERROR_BROKEN_FORMAT if lines of a sequence are not of the same width
+ */
+int fna_build_index(char const *path);
+
+/**
+ * @fn fna_fetch
+ *
+ * @brief read bases [start, end) (0-based, clipped to the sequence length) of a sequence without
+ * scanning the file. <path>.fai (and <path>.gzi on BGZF) is loaded on the first call (built and
+ * saved if missing or older than the file); only the BGZF blocks covering the range are inflated.
+ * the sequential reader is not affected. not available on other compressed files.
+ *
+ * @return a record with the name and the bases in seq_encode of the context (released with
+ * fna_seq_free), NULL if name is not found or the file could not be indexed
+ */
+fna_seq_t *fna_fetch(fna_t *fna, char const *name, int64_t start, int64_t end);
+
+/**
+ * @fn fna_tell
+ *
+ * @brief save the position of the next record, which may be written to disk and passed to
+ * fna_seek on another context opened on the same file with the same params
+ *
+ * @return FNA_SUCCESS, FNA_ERROR_UNSUPPORTED_VERSION on FNA_SHARED contexts and pooled FNA_UNORDERED ones
+ */
+int fna_tell(fna_t *fna, fna_pos_t *pos);
+
+/**
+ * @fn fna_seek
+ *
+ * @brief resume reading at a position from fna_tell. uncompressed files are read from the position
+ * directly; BGZF files from the block containing it (located with <path>.gzi if present, or from
+ * the block headers, without inflating the blocks before); other compressed files are inflated
+ * from the head and discarded up to the position. not thread-safe on FNA_SHARED contexts.
+ *
+ * @return FNA_SUCCESS, or fna_status if the file could not be reopened (the context is left as it was)
+ */
+int fna_seek(fna_t *fna, fna_pos_t const *pos);
+
+/**
+ * @fn fna_segment_id
+ *
+ * @brief id of a GFA segment name (FNA_INTERN_NAMES)
+ *
+ * @return the id, -1 if the name has not appeared yet or the option is not set
+ */
+int64_t fna_segment_id(fna_t const *fna, char const *name);
+
+/**
+ * @fn fna_segment_name
+ *
+ * @brief name of a GFA segment id (FNA_INTERN_NAMES), valid until the next record is read
+ *
+ * @return the null-terminated name, NULL if id is out of the range; the ids are in [0, fna_segment_count)
+ */
+char const *fna_segment_name(fna_t const *fna, int64_t id);
+
+/**
+ * @fn fna_segment_count
+ *
+ * @brief number of ids given so far (FNA_INTERN_NAMES)
+ */
+int64_t fna_segment_count(fna_t const *fna);
+
+/**
+ * @fn fna_load_graph
+ *
+ * @brief load 'S' and 'L' lines of a GFA file into a fna_graph_t in a single pass: sequences are
+ * appended to one store in seq_encode of params (FNA_2BITPACKED or FNA_4BITPACKED keep it compact)
+ * and links are gathered, then counting-sorted into the adjacency on params->threads threads.
+ * 'C' and 'P' lines are skipped. the overlap lengths are taken from the cigars (zero for "*").
+ * the graph takes 16 bytes per link and 40 bytes per segment besides the names and the sequences;
+ * loading takes 16 bytes per link and the name table (up to 32 bytes per segment) more at the peak.
+ *
+ * @return the graph, NULL if the file could not be read as GFA
+ */
+fna_graph_t *fna_load_graph(char const *path, fna_params_t const *params);
+
+/**
+ * @fn fna_graph_free
+ */
+void fna_graph_free(fna_graph_t *graph);
+
+/**
+ * @fn fna_init_pair
+ *
+ * @brief open paired-end reads
+ *
+ * @param[in] path1, path2 : R1 and R2, or interleaved pairs in path1 if path2 is NULL
+ * @param[in] params : applied to both files (threads = 1 reads each file ahead on its own thread)
+ *
+ * @return a pointer to the pair reader, NULL if either file could not be opened
+ */
+fna_pair_t *fna_init_pair(char const *path1, char const *path2, fna_params_t const *params);
+
+/**
+ * @fn fna_read_pair
+ *
+ * @brief read pairs in lockstep into a single arena. mates are seq[2 * i] (R1) and seq[2 * i + 1] (R2),
+ * and their names are checked to match up to the "/1" and "/2" suffixes.
+ *
+ * @return a batch (released with fna_batch_free), NULL if no pair remains, or if a mate is
+ * missing or mates are named differently (status is FNA_ERROR_BROKEN_FORMAT then).
+ */
+fna_batch_t *fna_read_pair(fna_pair_t *pair, int64_t max_pairs, int64_t max_bytes);
+
+/**
+ * @fn fna_close_pair
+ *
+ * @brief clean up pair reader
+ */
+void fna_close_pair(fna_pair_t *pair);
+
 /**
  * @fn fna_append
  *
- * @brief concatenate src sesquence after dst sequence
+ * @brief concatenate src sequence (and qual) after dst sequence. dst stays where it is;
+ * its seq and qual are moved to a buffer out of the record, with the seq margins kept.
+ * nothing is done when the encodings differ, either record was read with FNA_SKIP_SEQ,
+ * or dst belongs to a batch.
  */
 void fna_append(fna_seq_t *dst, fna_seq_t const *src);
 
 /**
  * @fn fna_duplicate
  *
- * @brief duplicate sequence
+ * @brief duplicate sequence into a record with the same margins; fields viewing the
+ * mapped file (FNA_MMAP) are copied. returns NULL for GFA records other than segments.
  */
 fna_seq_t *fna_duplicate(fna_seq_t const *seq);
 
 /**
  * @fn fna_append_revcomp
  *
- * @brief append reverse complemented sequence after the given sequence
+ * @brief append reverse complemented sequence after the given sequence, qual is reversed.
+ * the restrictions of fna_append apply.
  */
 void fna_append_revcomp(fna_seq_t *seq, fna_seq_t const *src);
 
 /**
  * @fn fna_revcomp
  *
- * @brief make reverse complemented sequence
+ * @brief make reverse complemented sequence, in any encoding; IUPAC codes are
+ * complemented and the case is kept for FNA_ASCII. returns NULL for GFA records other than segments.
  */
 fna_seq_t *fna_revcomp(fna_seq_t const *seq);
 